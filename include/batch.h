@@ -0,0 +1,61 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * batch.h	Unattended runs: cycle budget, key scripts and mounted images
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_BATCH_H_INCLUDED_)
+#define	_BATCH_H_INCLUDED_
+
+#include "system.h"
+#include "image.h"
+#include "osd.h"
+#include "machine.h"
+
+/** @brief maximum size of a keyboard matrix */
+#define	BATCH_MATRIX	16
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief set up an unattended run from the command line options
+ *
+ * -c cycles	stop after running a number of CPU cycles
+ * -k file	type the keys from a key script
+ * -fd0..-fd3 file	mount a floppy disk image
+ * -cas file	mount a cassette image
+ * -rec file	record the host keyboard's changes of the key matrix (not with -rw)
+ * -play file	play back a key recording instead of the host keyboard
+ */
+extern int batch_init(int argc, char **argv,
+	void (*keydn)(void *cookie, osd_key_t *),
+	void (*keyup)(void *cookie, osd_key_t *),
+	uint8_t *keymap, uint32_t size);
+
+/** @brief key down callback for the host keyboard (records or ignores keys) */
+extern void batch_key_dn(void *cookie, osd_key_t *key);
+
+/** @brief key up callback for the host keyboard (records or ignores keys) */
+extern void batch_key_up(void *cookie, osd_key_t *key);
+
+/** @brief return non zero when the cycle budget is used up */
+extern int batch_done(void);
+
+/** @brief print the result of an unattended run */
+extern void batch_result(void);
+
+/** @brief return the hash of the screen printed by the last batch_result() */
+extern uint32_t batch_screen(void);
+
+/** @brief close the key recording and free the key events */
+extern void batch_exit(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_BATCH_H_INCLUDED_) */
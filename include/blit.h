@@ -10,6 +10,24 @@
 
 #include "system.h"
 
+/******************************************************************************
+ *
+ *	SIMD palette and gray to RGB blitters (blit_simd.c)
+ *
+ ******************************************************************************/
+#define	BLIT_SIMD_NONE	0
+#define	BLIT_SIMD_SSE2	1
+#define	BLIT_SIMD_AVX2	2
+
+extern int blit_simd_level;
+
+extern int blit_simd_detect(void);
+
+extern int blit_simd_to_rgb(int bits, int rgba,
+	uint8_t *dst, int dx, int dy, uint32_t dstride,
+	uint8_t *src, int sx, int sy, uint32_t sstride,
+	int w, int h, const uint32_t *colors, int alpha);
+
 /******************************************************************************
  *
  *	GRAY1 source
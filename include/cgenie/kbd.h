@@ -11,6 +11,8 @@
 
 #include "osd.h"
 
+/** @brief register the keyboard state */
+extern void cgenie_kbd_init(void);
 /** @brief reset the keyboard */
 extern void cgenie_kbd_reset(void);
 /** @brief keyboard matrix */
@@ -0,0 +1,25 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * main.h	Colour Genie emulation entry point
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_CGENIE_MAIN_H_INCLUDED_)
+#define _CGENIE_MAIN_H_INCLUDED_
+
+#include "system.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/** @brief run a Colour Genie on the current machine with the command line options */
+int cgenie_run(int argc, char **argv);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_CGENIE_MAIN_H_INCLUDED_) */
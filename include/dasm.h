@@ -22,7 +22,7 @@ typedef enum {
 }	dasm_type_t;
 
 typedef struct {
-	uint16_t addr;
+	uint32_t addr;
 	dasm_type_t type;
 	char *comment;
 }	dasm_t;
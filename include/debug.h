@@ -0,0 +1,42 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * debug.h	PC breakpoints, memory and I/O watchpoints
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_DEBUG_H_INCLUDED_)
+#define	_DEBUG_H_INCLUDED_
+
+#include "system.h"
+#include "machine.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief set up breakpoints and watchpoints from the command line options
+ *
+ * -bp addr		break before executing the instruction at addr
+ * -wr first[-last]	watch memory reads (not opcode fetches)
+ * -ww first[-last]	watch memory writes
+ * -wi first[-last]	watch I/O port reads (the low 8 bits of the port)
+ * -wo first[-last]	watch I/O port writes (the low 8 bits of the port)
+ *
+ * Every hit prints the address, the data and the CPU state.
+ * Call this after the memory map is installed and the basic block
+ * cache is enabled, and before rewind_init(), since both of these
+ * replace the page entries as well.
+ */
+extern int debug_init(int argc, char **argv);
+
+/** @brief remove the watchpoints and breakpoints */
+extern void debug_exit(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_DEBUG_H_INCLUDED_) */
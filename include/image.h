@@ -77,6 +77,15 @@ void img_set_geometry(struct img_s *img,
 struct img_s *img_fopen(const char *filename, uint32_t major, const char *mode);
 void img_fclose(struct img_s *img);
 
+/* max. number of mountable images per major type */
+#define	IMG_MAX_MOUNT	4
+
+/* mount a file as the image of a major/minor type (before it is first used) */
+int img_mount(uint32_t major, uint32_t minor, const char *filename);
+
+/* return the filename mounted for a major/minor type, or NULL */
+const char *img_mounted(uint32_t major, uint32_t minor);
+
 /* rename an image to filename.BAK, unlinking an existing backup */
 int img_backup(const char *filename, uint32_t major);
 
@@ -0,0 +1,149 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * machine.h	Machine context: the state of one emulated machine
+ *
+ * All of the CPU, memory, memory map, scheduler and display state of an
+ * emulated machine lives in a machine_t. There is one machine per thread,
+ * fixed: each thread has its own machine_t, and code refers to its fields
+ * through the machine pointer, for example machine->mem or
+ * machine->cycles_total. A program running several machines runs each of
+ * them on a thread of its own and calls machine_exit() when it is done.
+ *
+ * Device and driver modules keep their private state in MACHINE_LOCAL
+ * (thread local) variables too, so it always belongs to the machine of
+ * the same thread.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_MACHINE_H_INCLUDED_)
+#define	_MACHINE_H_INCLUDED_
+
+#include "system.h"
+#include "timer.h"
+#include "z80.h"
+
+/** @brief storage class for per machine state private to a module */
+#define	MACHINE_LOCAL	__thread
+
+/** @brief basic block cache state (private to the Z80 core) */
+struct z80_bc_s;
+
+/** @brief execution profile (private to the Z80 core) */
+struct z80_prof_s;
+
+/** @brief display, input and audio state (private to the osd layer) */
+struct osd_s;
+
+typedef struct machine_s {
+	/** @brief Z80 CPU context */
+	z80_cpu_t cpu;
+	/** @brief current cycle count (incrementing from 0 to cycle count per frame) */
+	int cc;
+	/** @brief DMA cycle count (stolen from Z80 CPU) */
+	int dma;
+
+	/** @brief memory */
+	uint8_t mem[MEMSIZE];
+	/** @brief memory read handlers */
+	uint8_t (*rd_mem[L1SIZE])(uint32_t addr);
+	/** @brief memory write handlers */
+	void (*wr_mem[L1SIZE])(uint32_t addr, uint8_t data);
+	/** @brief direct pointers to pages without side effects on read (or NULL) */
+	uint8_t *rd_ptr[L1SIZE];
+	/** @brief direct pointers to pages without side effects on write (or NULL) */
+	uint8_t *wr_ptr[L1SIZE];
+	/** @brief I/O read handlers */
+	uint8_t (*rd_io[L1SIZE])(uint32_t addr);
+	/** @brief I/O write handlers */
+	void (*wr_io[L1SIZE])(uint32_t addr, uint8_t data);
+
+	/** @brief time at the start of the current time slice */
+	tmr_time_t now;
+	/** @brief cycles to run in the current time slice */
+	int cycles;
+	/** @brief end of the time slice while the Z80 core steps single instructions */
+	int cycles_step;
+	/** @brief sum of cycles during the last frame */
+	int cycles_this_frame;
+	/** @brief sum of all cycles run */
+	uint64_t cycles_total;
+	/** @brief binary min-heap of timers ordered by expire */
+	tmr_t *timers[MAX_TMR];
+	/** @brief number of timers */
+	uint32_t ti;
+	/** @brief CPU clock rate in Hz */
+	uint32_t hz;
+	/** @brief nanoseconds per CPU cycle in 32.32 fixed point */
+	uint64_t ns_per_cc;
+	/** @brief time when the CPU clock rate was last set */
+	tmr_time_t base;
+	/** @brief whole seconds of CPU cycles since base */
+	uint64_t secs;
+	/** @brief CPU cycles since base in excess of secs (always < hz) */
+	uint32_t ticks;
+
+	/** @brief non zero if the basic block cache is enabled */
+	int blocks;
+	/** @brief bitmap of memory locations covered by cached basic blocks */
+	uint8_t bc_map[MEMSIZE/8];
+	/** @brief basic block cache, allocated by z80_bc_enable() */
+	struct z80_bc_s *bc;
+	/** @brief first address of the current basic block */
+	uint32_t bc_pc;
+	/** @brief length of the current basic block (0 if there is none) */
+	uint32_t bc_len;
+	/** @brief code bytes of the current basic block */
+	const uint8_t *bc_code;
+	/** @brief non zero if idle PC ranges are defined */
+	int idle;
+	/** @brief bitmap of idle PC addresses */
+	uint8_t idle_map[MEMSIZE/8];
+	/** @brief execution profile, allocated by z80_prof_enable() (NULL if off) */
+	struct z80_prof_s *prof;
+	/** @brief entries before a basic block is translated by the JIT (0 if off) */
+	uint32_t jit;
+	/** @brief bitmap of pages with PC breakpoints (L1SIZE is 64) */
+	uint64_t bp_pages;
+	/** @brief bitmap of PC breakpoint addresses */
+	uint8_t bp_map[MEMSIZE/8];
+	/** @brief function called when a breakpoint is hit */
+	void (*bp_hit)(uint32_t pc);
+	/** @brief function called before every instruction (NULL if off) */
+	void (*trace)(z80_cpu_t *cpu);
+
+	/** @brief display state, allocated by osd_init() and freed by osd_exit() */
+	struct osd_s *osd;
+}	machine_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/** @brief the machine of this thread */
+extern MACHINE_LOCAL machine_t machine_this;
+
+/** @brief pointer to the machine of this thread */
+#define	machine	(&machine_this)
+
+/** @brief free the timers, block cache and profile of this thread's machine */
+extern void machine_exit(void);
+
+/**
+ * @brief install the memory and I/O maps of the current machine
+ *
+ * The rd_page and wr_page tables give the offsets into mem for pages
+ * which can be accessed directly, or U32INVALID for pages with side effects.
+ */
+extern void machine_map(uint8_t (* const rd[L1SIZE])(uint32_t),
+	void (* const wr[L1SIZE])(uint32_t, uint8_t),
+	const uint32_t rd_page[L1SIZE], const uint32_t wr_page[L1SIZE],
+	uint8_t (* const rdio[L1SIZE])(uint32_t),
+	void (* const wrio[L1SIZE])(uint32_t, uint8_t));
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_MACHINE_H_INCLUDED_) */
@@ -73,6 +73,9 @@ extern int32_t mc6845_init(uint32_t num, ifc6845_t *config);
 
 void mc6845_set_clock(uint32_t chip, uint32_t freq);
 
+uint32_t mc6845_get_chars_total(uint32_t chip);
+uint32_t mc6845_get_lines_total(uint32_t chip);
+uint32_t mc6845_get_total_adjust(uint32_t chip);
 uint32_t mc6845_get_char_columns(uint32_t chip);
 uint32_t mc6845_get_char_height(uint32_t chip);
 uint32_t mc6845_get_char_lines(uint32_t chip);
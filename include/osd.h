@@ -73,6 +73,26 @@ typedef struct osd_widget_s {
 	uint32_t br1;
 }	osd_widget_t;
 
+/** @brief Defines the osd_dirty_t type: a grid of modified tiles */
+typedef struct osd_dirty_s {
+	/** @brief width in pixels */
+	int32_t w;
+	/** @brief height in pixels */
+	int32_t h;
+	/** @brief width in tiles */
+	uint32_t cols;
+	/** @brief height in tiles */
+	uint32_t rows;
+	/** @brief 32 bit words per row of tiles */
+	uint32_t words;
+	/** @brief first row of tiles with a dirty tile */
+	uint32_t top;
+	/** @brief last row of tiles with a dirty tile + 1 (0 if none) */
+	uint32_t bottom;
+	/** @brief one bit per tile, followed by the same size of scratch space */
+	uint32_t *bits;
+}	osd_dirty_t;
+
 /** @brief Defines the osd_bitmap_t type */
 typedef struct osd_bitmap_s {
 	/** @brief x coordinate on screen */
@@ -89,12 +109,8 @@ typedef struct osd_bitmap_s {
 	int32_t xscale;
 	/** @brief y scaling factor */
 	int32_t yscale;
-	/** @brief number of dirty rectangles */
-	uint32_t dirty_count;
-	/** @brief maximum number of dirty rectangles */
-	uint32_t dirty_alloc;
-	/** @brief dirty rectangles */
-	SDL_Rect *dirty;
+	/** @brief dirty tiles */
+	osd_dirty_t dirty;
 	/** @brief bitmap widgets */
 	osd_widget_t *widgets;
 	/** @brief OS dependent bitmap data */
@@ -148,8 +164,6 @@ extern "C" {
 	(p)->unused = 0; \
 } while (0)
 
-extern osd_bitmap_t *frame;
-
 /* OS helpers */
 extern void osd_die(const char *fmt, ...);
 extern int32_t osd_init(int (*resize)(int32_t,int32_t),
@@ -162,6 +176,10 @@ extern void osd_exit(void);
 /* VIDEO primitives */
 extern int32_t osd_bitmap_alloc(osd_bitmap_t **pbitmap, int32_t width, int32_t height, int32_t depth);
 extern void osd_bitmap_free(osd_bitmap_t **pbitmap);
+extern uint32_t osd_bitmap_hash(osd_bitmap_t *bitmap);
+extern uint8_t *osd_bitmap_lock(osd_bitmap_t *bitmap, int32_t *pitch);
+extern void osd_bitmap_unlock(osd_bitmap_t *bitmap);
+extern void osd_bitmap_mark(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t h);
 
 extern int32_t osd_widget_alloc(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t h,
 	int32_t r, int32_t g, int32_t b, widget_style_t style, int32_t id, const char *text);
@@ -185,6 +203,7 @@ extern void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src,
 
 /* VIDEO interface */
 extern int32_t osd_get_scale(void);
+extern osd_bitmap_t *osd_frame(void);
 extern void osd_set_display(int32_t w, int32_t h);
 extern int32_t osd_open_display(int32_t w, int32_t h, const char *title);
 extern int32_t osd_get_display(int32_t *w, int32_t *h);
@@ -0,0 +1,52 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * rewind.h	Rewind buffer of delta compressed snapshots
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_REWIND_H_INCLUDED_)
+#define	_REWIND_H_INCLUDED_
+
+#include "system.h"
+#include "machine.h"
+
+/** @brief default size of the rewind buffer in megabytes */
+#define	REWIND_MB	4
+
+/** @brief maximum number of snapshots kept */
+#define	REWIND_MAX	8192
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief set up the rewind buffer from the command line options
+ *
+ * -rw frames	take a snapshot every number of frames
+ * -rwmb mb	size of the rewind buffer in megabytes (REWIND_MB)
+ *
+ * Call this after the memory map is installed and all state is
+ * registered (and loaded), since it takes the first snapshot.
+ */
+extern int rewind_init(int argc, char **argv);
+
+/** @brief count a frame (call from the frame timer) */
+extern void rewind_frame(void);
+
+/** @brief step back to the previous snapshot (hotkey) */
+extern void rewind_step(void);
+
+/** @brief take a snapshot or step back if due (call between time slices) */
+extern void rewind_poll(void);
+
+/** @brief free the rewind buffer */
+extern void rewind_exit(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_REWIND_H_INCLUDED_) */
@@ -0,0 +1,85 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * state.h	Machine save states
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_STATE_H_INCLUDED_)
+#define	_STATE_H_INCLUDED_
+
+#include "system.h"
+#include "machine.h"
+
+/** @brief save state file magic */
+#define	STATE_MAGIC	"Z80STATE"
+
+/**
+ * @brief save state format version
+ *
+ * Increment this whenever the meaning of a registered item changes
+ * without a change of its size.
+ */
+#define	STATE_VERSION	1
+
+/** @brief state_size/save_mem/load_mem flag: leave out the machine's memory */
+#define	STATE_NO_MEM	1
+
+/** @brief register a variable, array or structure of a module instance */
+#define	STATE_ITEM(module, instance, item) \
+	state_register(module, instance, #item, &(item), sizeof(item))
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief set up save states from the command line options
+ *
+ * -ls file	load a save state before starting
+ * -ss file	save the state to file when exiting
+ * -cp cycles	also save the state to the -ss file every number of cycles
+ */
+extern int state_init(int argc, char **argv);
+
+/** @brief load the state given with -ls (call after all modules registered) */
+extern int state_start(void);
+
+/** @brief save a checkpoint if it is due (call between time slices) */
+extern void state_poll(void);
+
+/** @brief save the state given with -ss */
+extern void state_exit(void);
+
+/** @brief register plain data (no pointers) of a module instance */
+extern int state_register(const char *module, uint32_t instance,
+	const char *name, void *data, uint32_t size);
+
+/** @brief register a timer: its expiry, period and parameter are saved */
+extern int state_register_timer(const char *module, uint32_t instance,
+	const char *name, tmr_t **timer);
+
+/** @brief register functions to call before saving and after loading a state */
+extern int state_register_hooks(void (*presave)(void), void (*postload)(void));
+
+/** @brief return the size of a save state in bytes */
+extern uint32_t state_size(int flags);
+
+/** @brief save the state to a buffer of state_size() bytes */
+extern int state_save_mem(uint8_t *buff, uint32_t size, int flags);
+
+/** @brief load the state from a buffer */
+extern int state_load_mem(const uint8_t *buff, uint32_t size, int flags);
+
+/** @brief save the state to a file */
+extern int state_save(const char *filename);
+
+/** @brief load the state from a file */
+extern int state_load(const char *filename);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_STATE_H_INCLUDED_) */
@@ -0,0 +1,74 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * stats.h	Host time and emulated cycle statistics
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_STATS_H_INCLUDED_)
+#define	_STATS_H_INCLUDED_
+
+#include "system.h"
+#include "machine.h"
+
+/** @brief number of frames kept for the rolling histogram */
+#define	STATS_FRAMES	1024
+
+/** @brief number of log2 histogram buckets (1us ... 16ms and more) */
+#define	STATS_BUCKETS	16
+
+/** @brief where host time is spent */
+typedef enum {
+	/** @brief executing Z80 instructions (z80_execute) */
+	STATS_CPU,
+	/** @brief timer callbacks (devices, audio) */
+	STATS_TIMER,
+	/** @brief rendering the video frame */
+	STATS_VIDEO,
+	/** @brief encoding PNG/MNG frames */
+	STATS_MNG,
+	/** @brief presenting the frame and polling SDL events */
+	STATS_PRESENT,
+	/** @brief waiting for the next frame when throttled */
+	STATS_THROTTLE,
+	/** @brief number of categories */
+	STATS_MAX
+}	stats_cat_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/** @brief non zero if statistics are collected */
+extern MACHINE_LOCAL int stats_on;
+
+/** @brief start charging host time to a category (nests) */
+#define	STATS_ENTER(cat)	if (stats_on) stats_enter(cat)
+
+/** @brief stop charging host time to the innermost category */
+#define	STATS_LEAVE()		if (stats_on) stats_leave()
+
+/** @brief enable statistics from the command line options (-S file) */
+extern int stats_init(int argc, char **argv);
+
+/** @brief write the statistics to the file given with -S and stop collecting */
+extern void stats_exit(void);
+
+/** @brief charge host time to a category until the matching stats_leave() */
+extern void stats_enter(stats_cat_t cat);
+
+/** @brief return to the category active before the last stats_enter() */
+extern void stats_leave(void);
+
+/** @brief end a frame which ran a number of CPU cycles */
+extern void stats_frame(uint32_t cc);
+
+/** @brief write the statistics of the last frames as a histogram */
+extern void stats_dump(FILE *fp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_STATS_H_INCLUDED_) */
@@ -79,34 +79,30 @@ typedef enum {
 /** @brief lookup table shift for memory and I/O */
 #define	L1SHIFT		10
 
-extern uint8_t mem[MEMSIZE];
-
-/** @brief array of function pointers: read from memory */
-extern uint8_t (*rd_mem[L1SIZE])(uint32_t addr);
-
-/** @brief array of function pointers: write to memory */
-extern void (*wr_mem[L1SIZE])(uint32_t addr, uint8_t data);
+/** @brief lookup table mask for the offset into a page */
+#define	L1MASK		((1 << L1SHIFT) - 1)
 
 /** @brief read from memory */
-#define	program_read_byte(addr) rd_mem[(addr)>>L1SHIFT](addr)
+#define	program_read_byte(addr) \
+	(NULL != machine->rd_ptr[(addr)>>L1SHIFT] ? \
+		machine->rd_ptr[(addr)>>L1SHIFT][(addr)&L1MASK] : \
+		machine->rd_mem[(addr)>>L1SHIFT](addr))
 
 /** @brief write to memory */
 #define	program_write_byte(addr,data) do { \
-	wr_mem[(addr)>>L1SHIFT](addr,data); \
+	uint8_t *wr_page = machine->wr_ptr[(addr)>>L1SHIFT]; \
+	if (NULL != wr_page) \
+		wr_page[(addr)&L1MASK] = (data); \
+	else \
+		machine->wr_mem[(addr)>>L1SHIFT](addr,data); \
 } while (0)
 
-/** @brief array of function pointers: read from memory */
-extern uint8_t (*rd_io[L1SIZE])(uint32_t addr);
-
-/** @brief array of function pointers: write to memory */
-extern void (*wr_io[L1SIZE])(uint32_t addr, uint8_t data);
-
 /** @brief read from memory */
-#define	io_read_byte(addr) rd_io[(addr)>>L1SHIFT](addr)
+#define	io_read_byte(addr) machine->rd_io[(addr)>>L1SHIFT](addr)
 
 /** @brief write to memory */
 #define	io_write_byte(addr,data) do { \
-	wr_io[(addr)>>L1SHIFT](addr,data); \
+	machine->wr_io[(addr)>>L1SHIFT](addr,data); \
 } while (0)
 
 /** @brief XXX: fixme */
@@ -10,7 +10,6 @@
 #define _TMR_H_INCLUDED_
 
 #include "system.h"
-#include "z80.h"
 
 typedef int64_t tmr_time_t;
 
@@ -25,18 +24,16 @@ typedef struct {
 	uint32_t param;
 	/** @brief callback function */
 	void (*callback)(uint32_t param);
+	/** @brief position in the scheduler's heap */
+	uint32_t index;
 }	tmr_t;
 
+#include "z80.h"
+
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
-/** @brief cycles to run in the current timeslice */
-extern int cycles;
-
-/** @brief cycles to run in the current timeslice */
-extern int cycles_this_frame;
-
 #define	TIME_IN_NSEC(n) ((double)(n)/1e9)
 #define	TIME_IN_USEC(n) ((double)(n)/1e6)
 #define	TIME_IN_MSEC(n) ((double)(n)/1e3)
@@ -52,6 +49,9 @@ extern int cycles_this_frame;
 /** @brief current time */
 extern tmr_time_t time_now(void);
 
+/** @brief set the CPU clock rate in Hz */
+extern void tmr_set_clock(double clock);
+
 /** @brief allocate a new timer */
 extern tmr_t *tmr_alloc(void (*callback)(uint32_t), tmr_time_t t, uint32_t param, tmr_time_t r);
 
@@ -67,6 +67,13 @@ extern tmr_time_t tmr_elapsed(tmr_t *timer);
 /** @brief adjust the time when a timer expires, the parameter, and the reset time */
 extern int tmr_adjust(tmr_t *timer, tmr_time_t t, uint32_t param, tmr_time_t r);
 
+/** @brief restore a timer saved at heap position index (call tmr_rebuild() when done) */
+extern int tmr_restore(tmr_t *timer, tmr_time_t fired, tmr_time_t expire,
+	tmr_time_t restart, uint32_t param, uint32_t index);
+
+/** @brief restore the heap order after timers were restored */
+extern void tmr_rebuild(void);
+
 /** @brief return the next timer event */
 extern tmr_t *tmr_next_event(void);
 
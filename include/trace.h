@@ -0,0 +1,90 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * trace.h	Compressed execution trace recorder
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_TRACE_H_INCLUDED_)
+#define	_TRACE_H_INCLUDED_
+
+#include "system.h"
+
+/** @brief magic at the start of a trace file (followed by a version byte) */
+#define	TRACE_MAGIC	"Z80TRACE"
+
+/** @brief trace file format version */
+#define	TRACE_VERSION	1
+
+/** @brief size of a buffer handed to the writer thread */
+#define	TRACE_BUFSIZE	(1 << 20)
+
+/** @brief number of buffers */
+#define	TRACE_BUFS	8
+
+/** @brief maximum size of a record */
+#define	TRACE_RECMAX	64
+
+/**
+ * A record is written before every instruction:
+ *	varint	mask		TRACE_PC, TRACE_CODE, TRACE_REG(n) bits
+ *	varint	cycles		CPU cycles since the previous record
+ *	uint16	pc		if TRACE_PC: the PC was not pc + length of
+ *				the previous instruction
+ *	uint8	code[4]		if TRACE_CODE: the bytes at pc differ from
+ *				the last ones recorded for this pc
+ *	uint16	reg[n]		for each TRACE_REG(n) bit: the register changed
+ * Varints are 7 bits per byte, least significant first, bit 7 set if
+ * more bytes follow; words are little endian. R is only recorded when it
+ * is not the previous R plus the M1 cycles of the previous instruction.
+ * The registers of a record are those after the previous instruction,
+ * and the last record is written when the trace ends.
+ */
+#define	TRACE_PC	(1 << 0)
+#define	TRACE_CODE	(1 << 1)
+#define	TRACE_REG(n)	(1 << (2 + (n)))
+
+typedef enum {
+	TRACE_AF,
+	TRACE_BC,
+	TRACE_DE,
+	TRACE_HL,
+	TRACE_IX,
+	TRACE_IY,
+	TRACE_SP,
+	TRACE_AF2,
+	TRACE_BC2,
+	TRACE_DE2,
+	TRACE_HL2,
+	TRACE_IR,	/* I in the high, R in the low byte */
+	TRACE_IFF,	/* IFF1, IFF2 in bits 0 and 1, IM in bits 2 and 3 */
+	TRACE_REGS
+}	trace_reg_t;
+
+/** @brief R after an instruction starting with op, given R before it */
+#define	TRACE_R_NEXT(r,op) (((r) & 0x80) | (((r) + \
+	(0xcb == (op) || 0xed == (op) || 0xdd == (op) || 0xfd == (op) ? 2 : 1)) & 0x7f))
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief start recording a trace from the command line options
+ *
+ * -trace file	write a gzip compressed trace of every instruction to file
+ *
+ * Records are built in memory and compressed and written by a
+ * background thread. Decode the file with z80trace.
+ */
+extern int trace_init(int argc, char **argv);
+
+/** @brief write the pending records and close the trace */
+extern void trace_exit(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_TRACE_H_INCLUDED_) */
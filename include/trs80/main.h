@@ -0,0 +1,25 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * main.h	Tandy TRS-80 emulation entry point
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#if !defined(_TRS80_MAIN_H_INCLUDED_)
+#define _TRS80_MAIN_H_INCLUDED_
+
+#include "system.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/** @brief run a Tandy TRS-80 on the current machine with the command line options */
+int trs80_run(int argc, char **argv);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* !defined(_TRS80_MAIN_H_INCLUDED_) */
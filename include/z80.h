@@ -30,6 +30,9 @@ typedef union {
 }	bwdq_t;
 #endif
 
+/** @brief basic block cache state (private to the Z80 core) */
+struct z80_bc_s;
+
 typedef enum {
 	Z80_PC, Z80_SP, Z80_AF, Z80_BC, Z80_DE, Z80_HL, Z80_IX, Z80_IY,
 	Z80_EA, Z80_MP, Z80_AF2, Z80_BC2, Z80_DE2, Z80_HL2, Z80_R, Z80_I,
@@ -78,20 +81,30 @@ typedef struct {
 	uint8_t	iff;
 	/** @brief pending interrupt request */
 	uint8_t	irq;
+	/** @brief lazy flags: kind of the operation with pending flags (0 for none) */
+	uint8_t	lf_op;
+	/** @brief lazy flags: eagerly computed flags (checking only) */
+	uint8_t	lf_f;
+	/** @brief lazy flags: first operand */
+	uint32_t lf_a;
+	/** @brief lazy flags: second operand */
+	uint32_t lf_val;
+	/** @brief lazy flags: result */
+	uint32_t lf_res;
 }	z80_cpu_t;
 
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
-/** @brief Z80 CPU context */
-extern z80_cpu_t z80;
-
-/** @brief current cycle count (incrementing from 0 to cycle count per frame) */
-extern int z80_cc;
+/** @brief name of the opcode dispatch engine ("switch" or "threaded") */
+extern const char z80_dispatch[];
 
-/** @brief DMA cycle count (stolen from Z80 CPU) */
-extern int z80_dma;
+/** @brief invalidate cached basic blocks if a memory location is covered */
+#define	Z80_BC_CHECK(addr) do { \
+	if (machine->bc_map[(addr)/8] & (1 << ((addr)%8))) \
+		z80_bc_invalidate(addr); \
+} while (0)
 
 /** @brief shorthand name for program space read byte */
 #define	RD_MEM(addr) program_read_byte(addr)
@@ -108,6 +121,61 @@ extern int z80_dma;
 /** @brief get a Z80 CPU register */
 extern uint32_t z80_get_reg(z80_cpu_t *cpu, uint32_t id);
 
+/** @brief enable the basic block cache for a range of memory */
+extern int z80_bc_enable(uint32_t base, uint32_t size);
+
+/** @brief invalidate all cached basic blocks covering a memory location */
+extern void z80_bc_invalidate(uint32_t addr);
+
+/** @brief flush the basic block cache */
+extern void z80_bc_flush(void);
+
+/** @brief free a basic block cache (see machine_exit()) */
+extern void z80_bc_free(struct z80_bc_s *bc);
+
+/** @brief default number of entries before a basic block is translated (-j) */
+#define	Z80_JIT_HOT	16
+
+/**
+ * @brief translate basic blocks entered a number of times to host code
+ *
+ * The basic block cache must be enabled first. Returns -1 if it is not,
+ * or if the JIT is not available for this host or build (Z80_JIT).
+ */
+extern int z80_jit_enable(uint32_t hot);
+
+/** @brief define a range of idle PC addresses */
+extern int z80_idle_range(uint32_t first, uint32_t last);
+
+/** @brief load idle PC ranges from a file */
+extern int z80_idle_load(const char *filename);
+
+/**
+ * @brief set a PC breakpoint
+ *
+ * hit() is called with the PC before the instruction at pc executes.
+ * Only instructions on pages with breakpoints are checked, and the
+ * JIT does not run blocks on these pages.
+ */
+extern int z80_break_set(uint32_t pc, void (*hit)(uint32_t pc));
+
+/** @brief clear a PC breakpoint */
+extern int z80_break_clr(uint32_t pc);
+
+/**
+ * @brief call a function before every instruction (NULL to stop)
+ *
+ * The function sees the registers after the previous instruction and
+ * the PC of the next one. The JIT does not run while this is set.
+ */
+extern void z80_trace_hook(void (*fn)(z80_cpu_t *cpu));
+
+/** @brief start collecting an execution profile */
+extern int z80_prof_enable(void);
+
+/** @brief write the execution profile to a file */
+extern int z80_prof_write(const char *filename);
+
 /** @brief execute a number of cycles */
 extern int z80_execute(z80_cpu_t *cpu);
 
@@ -124,4 +192,6 @@ extern int z80_interrupt(z80_cpu_t *cpu, int type);
 }
 #endif
 
+#include "machine.h"
+
 #endif	/* !defined(_Z80_H_INCLUDED_) */
@@ -7,7 +7,9 @@
  *  Tatsuyuki Satoh, Fabrice Frances, Nicola Salmoria.
  *
  ****************************************************************************/
+#include <stddef.h>
 #include "ay8910.h"
+#include "state.h"
 
 #define	PSG_DEBUG 0
 
@@ -103,7 +105,7 @@ enum {
 #define AY_PORTA	chip.regs[REG_PORTA]
 #define AY_PORTB	chip.regs[REG_PORTB]
 
-static chip_ay8910_t chip;
+static MACHINE_LOCAL chip_ay8910_t chip;
 
 static void ay8910_update(int16_t *buffer, uint32_t length);
 
@@ -780,6 +782,11 @@ int ay8910_start(const ifc_ay8910_t *ifc)
 		return rc;
 	build_mixer_table();
 
+	/* the registers, counters and noise generator (latch up to prng) */
+	state_register("ay8910", 0, "chip", &chip.latch,
+		offsetof(chip_ay8910_t, prng) + sizeof(chip.prng) -
+		offsetof(chip_ay8910_t, latch));
+
 	return 0;
 }
 
@@ -0,0 +1,409 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * batch.c	Unattended runs: cycle budget, key scripts and mounted images
+ *
+ * A key script has one step per line: a delay in milliseconds after
+ * the previous step, followed by the text to type. The escapes \n
+ * (ENTER), \e (BREAK), \b (LEFT), \t (RIGHT) and \\ are recognized.
+ * Lines starting with a '#' are comments.
+ *
+ *	# answer MEM SIZE?, then load and run the program on the mounted tape
+ *	2000 \n
+ *	4000 cload\n
+ *	20000 run\n
+ *
+ * A key recording (-rec) has one line per change of the keyboard matrix
+ * caused by the host keyboard: the emulated time in nanoseconds and the
+ * bits which changed, as hex bytes of the matrix XOR before and after.
+ * Playing it back (-play) toggles the same bits at the same emulated
+ * times and ignores the host keyboard, so a replay does not depend on
+ * the host's speed, throttled or not. Keys which reset the machine are
+ * not recorded.
+ *
+ * -rec can not be combined with the rewind buffer (-rw). Stepping back
+ * puts the machine and the emulated time back to a snapshot, which a
+ * recording of key matrix changes at emulated times can not express,
+ * so batch_init() fails instead of writing a recording which does not
+ * replay.
+ *
+ *	# key matrix changes: time in ns, XOR of the matrix
+ *	2160000000 0000000000000004
+ *	2220000000 0000000000000004
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "batch.h"
+#include "state.h"
+
+/** @brief time a scripted key is held down */
+#define	KEY_HOLD	tmr_double_to_time(TIME_IN_MSEC(60))
+
+/** @brief time between two scripted keys */
+#define	KEY_GAP		tmr_double_to_time(TIME_IN_MSEC(60))
+
+typedef struct {
+	/** @brief time when the key event happens */
+	tmr_time_t time;
+	/** @brief unicode of the key */
+	uint32_t unicode;
+	/** @brief non zero for key down, zero for key up */
+	int down;
+}	batch_key_t;
+
+typedef struct {
+	/** @brief time when the key matrix changes */
+	tmr_time_t time;
+	/** @brief bits of the key matrix which change */
+	uint8_t bits[BATCH_MATRIX];
+}	batch_play_t;
+
+/** @brief number of cycles to run (0 for no limit) */
+static MACHINE_LOCAL uint64_t budget;
+
+/** @brief scripted key events */
+static MACHINE_LOCAL batch_key_t *keys;
+
+/** @brief number of scripted key events */
+static MACHINE_LOCAL uint32_t nkeys;
+
+/** @brief next scripted key event */
+static MACHINE_LOCAL uint32_t ikey;
+
+/** @brief timer for the next scripted key event */
+static MACHINE_LOCAL tmr_t *key_timer;
+
+/** @brief the machine's key down callback */
+static MACHINE_LOCAL void (*key_dn)(void *cookie, osd_key_t *);
+
+/** @brief the machine's key up callback */
+static MACHINE_LOCAL void (*key_up)(void *cookie, osd_key_t *);
+
+/** @brief the machine's keyboard matrix */
+static MACHINE_LOCAL uint8_t *matrix;
+
+/** @brief size of the keyboard matrix */
+static MACHINE_LOCAL uint32_t matrix_size;
+
+/** @brief key recording being written */
+static MACHINE_LOCAL FILE *rec;
+
+/** @brief key matrix changes played back */
+static MACHINE_LOCAL batch_play_t *play;
+
+/** @brief number of key matrix changes played back */
+static MACHINE_LOCAL uint32_t nplay;
+
+/** @brief next key matrix change played back */
+static MACHINE_LOCAL uint32_t iplay;
+
+/** @brief timer for the next key matrix change played back */
+static MACHINE_LOCAL tmr_t *play_timer;
+
+/** @brief hash of the screen printed by batch_result() */
+static MACHINE_LOCAL uint32_t screen;
+
+/** @brief append a key event to the script */
+static int batch_key_add(tmr_time_t time, uint32_t unicode, int down)
+{
+	batch_key_t *tmp;
+
+	if (0 == (nkeys % 64)) {
+		tmp = realloc(keys, (nkeys + 64) * sizeof(batch_key_t));
+		if (NULL == tmp)
+			return -1;
+		keys = tmp;
+	}
+	keys[nkeys].time = time;
+	keys[nkeys].unicode = unicode;
+	keys[nkeys].down = down;
+	nkeys++;
+	return 0;
+}
+
+/** @brief timer callback: send the key events which are due */
+static void batch_key(uint32_t param)
+{
+	osd_key_t key;
+
+	while (ikey < nkeys && keys[ikey].time <= time_now()) {
+		memset(&key, 0, sizeof(key));
+		key.flags = OSD_KEY_SYM | OSD_KEY_UNICODE;
+		key.sym = keys[ikey].unicode;
+		key.unicode = keys[ikey].unicode;
+		if (keys[ikey].down)
+			(*key_dn)(NULL, &key);
+		else
+			(*key_up)(NULL, &key);
+		ikey++;
+	}
+	if (ikey < nkeys)
+		tmr_reset(key_timer, keys[ikey].time - time_now());
+}
+
+/** @brief load a key script */
+static int batch_keys_load(const char *filename)
+{
+	char line[256], *src;
+	tmr_time_t time = time_now();
+	uint32_t unicode;
+	FILE *fp;
+
+	fp = fopen(filename, "r");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	while (NULL != fgets(line, sizeof(line), fp)) {
+		if ('#' == line[0] || '\n' == line[0] || '\0' == line[0])
+			continue;	/* comment or empty line */
+		time += tmr_double_to_time(TIME_IN_MSEC(strtoul(line, &src, 10)));
+		if (' ' == *src || '\t' == *src)
+			src++;
+		for (/* */; '\0' != *src && '\n' != *src; src++) {
+			unicode = (uint8_t)*src;
+			if ('\\' == unicode && '\0' != src[1]) {
+				switch (*++src) {
+				case 'n': unicode = 13; break;
+				case 'e': unicode = 27; break;
+				case 'b': unicode = 8; break;
+				case 't': unicode = 9; break;
+				default: unicode = (uint8_t)*src;
+				}
+			}
+			if (batch_key_add(time, unicode, 1) < 0)
+				break;
+			time += KEY_HOLD;
+			if (batch_key_add(time, unicode, 0) < 0)
+				break;
+			time += KEY_GAP;
+		}
+	}
+	fclose(fp);
+	if (0 == nkeys)
+		return 0;
+	key_timer = tmr_alloc(batch_key, keys[0].time - time_now(), 0, time_zero);
+	if (NULL == key_timer)
+		return -1;
+	STATE_ITEM("batch", 0, ikey);
+	state_register_timer("batch", 0, "key_timer", &key_timer);
+	return 0;
+}
+
+/** @brief write a key matrix change to the recording */
+static void batch_rec(const uint8_t *before)
+{
+	uint32_t i, changed = 0;
+
+	for (i = 0; i < matrix_size; i++)
+		changed |= before[i] ^ matrix[i];
+	if (0 == changed)
+		return;
+	fprintf(rec, "%lld ", (long long)time_now());
+	for (i = 0; i < matrix_size; i++)
+		fprintf(rec, "%02x", before[i] ^ matrix[i]);
+	fprintf(rec, "\n");
+	fflush(rec);
+}
+
+/** @brief timer callback: apply the key matrix changes which are due */
+static void batch_play(uint32_t param)
+{
+	uint32_t i;
+
+	while (iplay < nplay && play[iplay].time <= time_now()) {
+		for (i = 0; i < matrix_size; i++)
+			matrix[i] ^= play[iplay].bits[i];
+		iplay++;
+	}
+	if (iplay < nplay)
+		tmr_reset(play_timer, play[iplay].time - time_now());
+}
+
+/** @brief load a key recording */
+static int batch_play_load(const char *filename)
+{
+	char line[256], *src;
+	batch_play_t *tmp;
+	uint32_t i, bits;
+	FILE *fp;
+
+	fp = fopen(filename, "r");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	while (NULL != fgets(line, sizeof(line), fp)) {
+		if ('#' == line[0] || '\n' == line[0] || '\0' == line[0])
+			continue;	/* comment or empty line */
+		if (0 == (nplay % 64)) {
+			tmp = realloc(play, (nplay + 64) * sizeof(batch_play_t));
+			if (NULL == tmp)
+				break;
+			play = tmp;
+		}
+		memset(&play[nplay], 0, sizeof(batch_play_t));
+		play[nplay].time = strtoll(line, &src, 10);
+		while (' ' == *src || '\t' == *src)
+			src++;
+		for (i = 0; i < matrix_size && 1 == sscanf(src, "%2x", &bits); i++, src += 2)
+			play[nplay].bits[i] = (uint8_t)bits;
+		nplay++;
+	}
+	fclose(fp);
+	if (0 == nplay)
+		return 0;
+	play_timer = tmr_alloc(batch_play, play[0].time - time_now(), 0, time_zero);
+	if (NULL == play_timer)
+		return -1;
+	STATE_ITEM("batch", 0, iplay);
+	state_register_timer("batch", 0, "play_timer", &play_timer);
+	return 0;
+}
+
+/** @brief start a key recording */
+static int batch_rec_open(const char *filename)
+{
+	rec = fopen(filename, "w");
+	if (NULL == rec) {
+		perror(filename);
+		return -1;
+	}
+	fprintf(rec, "# key matrix changes: time in ns, XOR of the matrix\n");
+	return 0;
+}
+
+/** @brief key down callback for the host keyboard */
+void batch_key_dn(void *cookie, osd_key_t *key)
+{
+	uint8_t before[BATCH_MATRIX];
+
+	if (NULL != play)
+		return;
+	if (NULL == rec) {
+		(*key_dn)(cookie, key);
+		return;
+	}
+	memcpy(before, matrix, matrix_size);
+	(*key_dn)(cookie, key);
+	batch_rec(before);
+}
+
+/** @brief key up callback for the host keyboard */
+void batch_key_up(void *cookie, osd_key_t *key)
+{
+	uint8_t before[BATCH_MATRIX];
+
+	if (NULL != play)
+		return;
+	if (NULL == rec) {
+		(*key_up)(cookie, key);
+		return;
+	}
+	memcpy(before, matrix, matrix_size);
+	(*key_up)(cookie, key);
+	batch_rec(before);
+}
+
+/** @brief set up an unattended run from the command line options */
+int batch_init(int argc, char **argv,
+	void (*keydn)(void *cookie, osd_key_t *),
+	void (*keyup)(void *cookie, osd_key_t *),
+	uint8_t *keymap, uint32_t size)
+{
+	const char *recname = NULL;
+	uint32_t rw = 0;
+	int i;
+
+	if (size > BATCH_MATRIX)
+		return -1;
+	key_dn = keydn;
+	key_up = keyup;
+	matrix = keymap;
+	matrix_size = size;
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-c")) {
+			budget = strtoull(argv[++i], NULL, 0);
+			continue;
+		}
+		if (!strcmp(argv[i], "-k")) {
+			if (batch_keys_load(argv[++i]) < 0)
+				return -1;
+			continue;
+		}
+		if (!strcmp(argv[i], "-rec")) {
+			recname = argv[++i];
+			continue;
+		}
+		if (!strcmp(argv[i], "-rw")) {
+			rw = strtoul(argv[++i], NULL, 0);
+			continue;
+		}
+		if (!strcmp(argv[i], "-play")) {
+			if (batch_play_load(argv[++i]) < 0)
+				return -1;
+			continue;
+		}
+		if (!strncmp(argv[i], "-fd", 3) && argv[i][3] >= '0' && argv[i][3] <= '3') {
+			if (img_mount(IMG_TYPE_FD, argv[i][3] - '0', argv[i + 1]) < 0)
+				return -1;
+			i++;
+			continue;
+		}
+		if (!strcmp(argv[i], "-cas")) {
+			if (img_mount(IMG_TYPE_CAS, 0, argv[++i]) < 0)
+				return -1;
+			continue;
+		}
+	}
+	if (NULL != recname) {
+		if (0 != rw) {
+			fprintf(stderr, "-rec %s: can not record with -rw\n", recname);
+			return -1;
+		}
+		if (batch_rec_open(recname) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/** @brief return non zero when the cycle budget is used up */
+int batch_done(void)
+{
+	return 0 != budget && machine->cycles_total >= budget;
+}
+
+/** @brief print the result of an unattended run */
+void batch_result(void)
+{
+	if (0 == budget)
+		return;
+	screen = osd_bitmap_hash(osd_frame());
+	printf("result: cycles=%llu screen=%08x\n",
+		(unsigned long long)machine->cycles_total, screen);
+	fflush(stdout);
+}
+
+/** @brief return the hash of the screen printed by the last batch_result() */
+uint32_t batch_screen(void)
+{
+	return screen;
+}
+
+/** @brief close the key recording and free the key events */
+void batch_exit(void)
+{
+	if (NULL != rec) {
+		fclose(rec);
+		rec = NULL;
+	}
+	free(play);
+	play = NULL;
+	nplay = 0;
+	free(keys);
+	keys = NULL;
+	nkeys = 0;
+}
@@ -241,6 +241,9 @@ int blit_gray2_to_rgb8(
 	if (NULL == colors)
 		colors = gray2_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(2, 0, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_GRAY2_INIT;
 		DST_RGB8_INIT;
@@ -540,6 +543,9 @@ int blit_gray2_to_rgba8(
 	if (NULL == colors)
 		colors = gray2_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(2, 1, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_GRAY2_INIT;
 		DST_RGBA8_INIT;
@@ -241,6 +241,9 @@ int blit_pal4_to_rgb8(
 	if (NULL == colors)
 		colors = pal4_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(4, 0, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_PAL4_INIT;
 		DST_RGB8_INIT;
@@ -556,6 +559,9 @@ int blit_pal4_to_rgba8(
 	if (NULL == colors)
 		colors = pal4_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(4, 1, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_PAL4_INIT;
 		DST_RGBA8_INIT;
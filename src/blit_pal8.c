@@ -244,6 +244,9 @@ int blit_pal8_to_rgb8(
 	if (NULL == colors)
 		colors = pal8_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(8, 0, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_PAL8_INIT;
 		DST_RGB8_INIT;
@@ -569,6 +572,9 @@ int blit_pal8_to_rgba8(
 	if (NULL == colors)
 		colors = pal8_colors;
 	CLIPPING;
+	if (0 == blit_simd_to_rgb(8, 1, dst, dx, dy, dstride,
+		src, sx, sy, sstride, w, h, colors, alpha))
+		return 0;
 	for (y = 0; y < h; y++) {
 		SRC_PAL8_INIT;
 		DST_RGBA8_INIT;
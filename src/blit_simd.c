@@ -0,0 +1,311 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * blit_simd.c	SSE2 and AVX2 palette and gray to RGB blitters
+ *
+ * Converting the 1, 2, 4 and 8 bpp palette and gray sources to RGB or
+ * RGB + alpha with 8 bits per channel is where png_blit_from_*() spends
+ * its time when a snapshot or MNG frame is written. The scalar blitters
+ * for these pairs call blit_simd_to_rgb() first, which converts a row in
+ * chunks and two steps: the packed source pixels are expanded to one
+ * index byte per pixel, and the indices are looked up in a table of the
+ * colors already in destination byte order.
+ *
+ * SSE2 has no byte shuffle, so its lookup assembles four table entries
+ * per store. AVX2 looks up palettes of up to 16 colors with a byte
+ * shuffle on each color plane, and gathers from the table otherwise.
+ * The instruction set is chosen at runtime the first time it is needed.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "blit.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define	HAVE_SIMD	1
+#define	TARGET_SSE2	__attribute__((target("sse2")))
+#define	TARGET_AVX2	__attribute__((target("avx2")))
+#else
+#define	HAVE_SIMD	0
+#endif
+
+/** @brief pixels converted per chunk of a row (a multiple of 8) */
+#define	CHUNK		1024
+
+/** @brief narrower blits are not worth setting up the table */
+#define	MIN_WIDTH	64
+
+/** @brief instruction set used, or -1 to detect it on first use */
+int blit_simd_level = -1;
+
+#if HAVE_SIMD
+
+typedef struct {
+	/** @brief colors as R, G, B, alpha bytes in memory order */
+	uint32_t tab[256];
+	/** @brief R, G, B and alpha planes of the first 16 colors */
+	uint8_t plane[4][16];
+	/** @brief number of colors */
+	int ncolors;
+	/** @brief non zero for RGB + alpha destinations */
+	int rgba;
+}	lut_t;
+
+/** @brief build the lookup table for a blit */
+static void lut_init(lut_t *lut, int bits, int rgba, const uint32_t *colors, int alpha)
+{
+	uint32_t c;
+	int i;
+
+	lut->ncolors = 1 << bits;
+	lut->rgba = rgba;
+	for (i = 0; i < lut->ncolors; i++) {
+		c = colors[i];
+		lut->tab[i] = ((c >> 16) & 0xff) | (c & 0xff00) |
+			((c & 0xff) << 16) | ((uint32_t)(alpha & 0xff) << 24);
+	}
+	memset(lut->plane, 0, sizeof(lut->plane));
+	for (i = 0; i < lut->ncolors && i < 16; i++) {
+		lut->plane[0][i] = (uint8_t)lut->tab[i];
+		lut->plane[1][i] = (uint8_t)(lut->tab[i] >> 8);
+		lut->plane[2][i] = (uint8_t)(lut->tab[i] >> 16);
+		lut->plane[3][i] = (uint8_t)(lut->tab[i] >> 24);
+	}
+}
+
+/** @brief expand nbytes of packed MSB first pixels to one index per byte */
+static TARGET_SSE2 void expand_sse2(uint8_t *idx, const uint8_t *src, int nbytes, int bits)
+{
+	const __m128i m1 = _mm_set1_epi8(1);
+	const __m128i m3 = _mm_set1_epi8(3);
+	const __m128i m15 = _mm_set1_epi8(15);
+	const __m128i bit = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+		1, 2, 4, 8, 16, 32, 64, -128);
+	__m128i v, q[4], p, a, b;
+	int i, j, k, ppb = 8 / bits;
+	uint32_t s;
+
+	for (i = 0; i + 16 <= nbytes; i += 16) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		switch (bits) {
+		case 1:
+			/* replicate each byte 8 times and test one bit per copy */
+			a = _mm_unpacklo_epi8(v, v);
+			b = _mm_unpackhi_epi8(v, v);
+			q[0] = _mm_unpacklo_epi16(a, a);
+			q[1] = _mm_unpackhi_epi16(a, a);
+			q[2] = _mm_unpacklo_epi16(b, b);
+			q[3] = _mm_unpackhi_epi16(b, b);
+			for (j = 0; j < 4; j++) {
+				p = _mm_unpacklo_epi32(q[j], q[j]);
+				p = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(p, bit), bit), m1);
+				_mm_storeu_si128((__m128i *)idx, p);
+				p = _mm_unpackhi_epi32(q[j], q[j]);
+				p = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(p, bit), bit), m1);
+				_mm_storeu_si128((__m128i *)(idx + 16), p);
+				idx += 32;
+			}
+			break;
+		case 2:
+			q[0] = _mm_and_si128(_mm_srli_epi16(v, 6), m3);
+			q[1] = _mm_and_si128(_mm_srli_epi16(v, 4), m3);
+			q[2] = _mm_and_si128(_mm_srli_epi16(v, 2), m3);
+			q[3] = _mm_and_si128(v, m3);
+			a = _mm_unpacklo_epi8(q[0], q[1]);
+			b = _mm_unpacklo_epi8(q[2], q[3]);
+			_mm_storeu_si128((__m128i *)idx, _mm_unpacklo_epi16(a, b));
+			_mm_storeu_si128((__m128i *)(idx + 16), _mm_unpackhi_epi16(a, b));
+			a = _mm_unpackhi_epi8(q[0], q[1]);
+			b = _mm_unpackhi_epi8(q[2], q[3]);
+			_mm_storeu_si128((__m128i *)(idx + 32), _mm_unpacklo_epi16(a, b));
+			_mm_storeu_si128((__m128i *)(idx + 48), _mm_unpackhi_epi16(a, b));
+			idx += 64;
+			break;
+		case 4:
+			a = _mm_and_si128(_mm_srli_epi16(v, 4), m15);
+			b = _mm_and_si128(v, m15);
+			_mm_storeu_si128((__m128i *)idx, _mm_unpacklo_epi8(a, b));
+			_mm_storeu_si128((__m128i *)(idx + 16), _mm_unpackhi_epi8(a, b));
+			idx += 32;
+			break;
+		}
+	}
+	for (/* */; i < nbytes; i++) {
+		s = src[i];
+		for (k = 0; k < ppb; k++) {
+			*idx++ = (uint8_t)((s >> (8 - bits)) & ((1 << bits) - 1));
+			s <<= bits;
+		}
+	}
+}
+
+/** @brief look up n indices and store them as RGB or RGB + alpha pixels */
+static TARGET_SSE2 void lookup_sse2(uint8_t *d, const uint8_t *idx, int n, const lut_t *lut)
+{
+	const uint32_t *tab = lut->tab;
+	const __m128i lo = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+	const __m128i hi = _mm_set_epi32(0x00ffffff, 0, 0x00ffffff, 0);
+	__m128i v;
+	int i = 0;
+
+	if (lut->rgba) {
+		for (/* */; i + 4 <= n; i += 4, d += 16) {
+			v = _mm_set_epi32(tab[idx[i+3]], tab[idx[i+2]], tab[idx[i+1]], tab[idx[i+0]]);
+			_mm_storeu_si128((__m128i *)d, v);
+		}
+		for (/* */; i < n; i++, d += 4)
+			memcpy(d, &tab[idx[i]], 4);
+		return;
+	}
+	/* pack two pixels into 6 bytes of each half; the stores overlap the next pixel */
+	for (/* */; i + 5 <= n; i += 4, d += 12) {
+		v = _mm_set_epi32(tab[idx[i+3]], tab[idx[i+2]], tab[idx[i+1]], tab[idx[i+0]]);
+		v = _mm_or_si128(_mm_and_si128(v, lo), _mm_srli_epi64(_mm_and_si128(v, hi), 8));
+		_mm_storel_epi64((__m128i *)d, v);
+		_mm_storel_epi64((__m128i *)(d + 6), _mm_unpackhi_epi64(v, v));
+	}
+	for (/* */; i < n; i++, d += 3)
+		memcpy(d, &tab[idx[i]], 3);
+}
+
+/** @brief store 8 pixels; RGB stores write 4 bytes beyond the 24 bytes */
+static TARGET_AVX2 void store_avx2(uint8_t *d, __m256i v, int rgba)
+{
+	const __m256i pack = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	if (rgba) {
+		_mm256_storeu_si256((__m256i *)d, v);
+		return;
+	}
+	v = _mm256_shuffle_epi8(v, pack);
+	_mm_storeu_si128((__m128i *)d, _mm256_castsi256_si128(v));
+	_mm_storeu_si128((__m128i *)(d + 12), _mm256_extracti128_si256(v, 1));
+}
+
+/** @brief look up n indices and store them as RGB or RGB + alpha pixels */
+static TARGET_AVX2 void lookup_avx2(uint8_t *d, const uint8_t *idx, int n, const lut_t *lut)
+{
+	const int bpp = lut->rgba ? 4 : 3;
+	/* RGB stores need two more pixels to overwrite */
+	const int over = lut->rgba ? 0 : 2;
+	__m256i r, g, b, a, x, rg, ba, p[4];
+	int i = 0;
+
+	if (lut->ncolors <= 16) {
+		r = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->plane[0]));
+		g = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->plane[1]));
+		b = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->plane[2]));
+		a = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->plane[3]));
+		for (/* */; i + 32 + over <= n; i += 32, d += 32 * bpp) {
+			x = _mm256_loadu_si256((const __m256i *)(idx + i));
+			rg = _mm256_unpacklo_epi8(_mm256_shuffle_epi8(r, x), _mm256_shuffle_epi8(g, x));
+			ba = _mm256_unpacklo_epi8(_mm256_shuffle_epi8(b, x), _mm256_shuffle_epi8(a, x));
+			/* pixels 0-3 + 16-19 and 4-7 + 20-23 */
+			p[0] = _mm256_unpacklo_epi16(rg, ba);
+			p[1] = _mm256_unpackhi_epi16(rg, ba);
+			rg = _mm256_unpackhi_epi8(_mm256_shuffle_epi8(r, x), _mm256_shuffle_epi8(g, x));
+			ba = _mm256_unpackhi_epi8(_mm256_shuffle_epi8(b, x), _mm256_shuffle_epi8(a, x));
+			/* pixels 8-11 + 24-27 and 12-15 + 28-31 */
+			p[2] = _mm256_unpacklo_epi16(rg, ba);
+			p[3] = _mm256_unpackhi_epi16(rg, ba);
+			store_avx2(d, _mm256_permute2x128_si256(p[0], p[1], 0x20), lut->rgba);
+			store_avx2(d + 8 * bpp, _mm256_permute2x128_si256(p[2], p[3], 0x20), lut->rgba);
+			store_avx2(d + 16 * bpp, _mm256_permute2x128_si256(p[0], p[1], 0x31), lut->rgba);
+			store_avx2(d + 24 * bpp, _mm256_permute2x128_si256(p[2], p[3], 0x31), lut->rgba);
+		}
+	}
+	for (/* */; i + 8 + over <= n; i += 8, d += 8 * bpp) {
+		x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(idx + i)));
+		store_avx2(d, _mm256_i32gather_epi32((const int *)lut->tab, x, 4), lut->rgba);
+	}
+	for (/* */; i < n; i++, d += bpp)
+		memcpy(d, &lut->tab[idx[i]], bpp);
+}
+
+#endif	/* HAVE_SIMD */
+
+/**
+ * @brief detect the best instruction set the blitters can use
+ *
+ * @result BLIT_SIMD_AVX2, BLIT_SIMD_SSE2 or BLIT_SIMD_NONE
+ */
+int blit_simd_detect(void)
+{
+#if HAVE_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return BLIT_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return BLIT_SIMD_SSE2;
+#endif
+	return BLIT_SIMD_NONE;
+}
+
+/**
+ * @brief bit block transfer from a palette or gray source to rgb8 or rgba8
+ *
+ * Called by the scalar blitters after clipping, with the same arguments.
+ *
+ * @param bits source bits per pixel (1, 2, 4 or 8)
+ * @param rgba non zero for an rgba8, zero for an rgb8 destination
+ * @param dst destination memory
+ * @param dx destination x
+ * @param dy destination y
+ * @param dstride destination memory stride per scanline
+ * @param src source memory
+ * @param sx source x
+ * @param sy source y
+ * @param sstride source memory stride per scanline
+ * @param w width
+ * @param h height
+ * @param colors source colors
+ * @param alpha destination alpha
+ * @result 0 if the blit was done, -1 if the scalar code has to do it
+ */
+int blit_simd_to_rgb(int bits, int rgba,
+	uint8_t *dst, int dx, int dy, uint32_t dstride,
+	uint8_t *src, int sx, int sy, uint32_t sstride,
+	int w, int h, const uint32_t *colors, int alpha)
+{
+#if HAVE_SIMD
+	uint8_t idx[CHUNK + 16];
+	void (*lookup)(uint8_t *, const uint8_t *, int, const lut_t *);
+	const uint8_t *s;
+	uint8_t *d;
+	lut_t lut;
+	int x, y, n, ppb, skip, nbytes;
+
+	if (blit_simd_level < 0)
+		blit_simd_level = blit_simd_detect();
+	if (BLIT_SIMD_NONE == blit_simd_level || w < MIN_WIDTH || sx < 0 || sy < 0)
+		return -1;
+	lookup = BLIT_SIMD_AVX2 == blit_simd_level ? lookup_avx2 : lookup_sse2;
+	lut_init(&lut, bits, rgba, colors, alpha);
+	ppb = 8 / bits;
+
+	for (y = 0; y < h; y++) {
+		s = src + (uint32_t)(sy + y) * sstride;
+		d = dst + (uint32_t)(dy + y) * dstride + (uint32_t)dx * (rgba ? 4 : 3);
+		for (x = 0; x < w; x += n) {
+			if (8 == bits) {
+				n = w - x;
+				lookup(d, s + sx + x, n, &lut);
+			} else {
+				/* after the first chunk the source is byte aligned */
+				skip = (sx + x) % ppb;
+				n = w - x < CHUNK - skip ? w - x : CHUNK - skip;
+				nbytes = (skip + n + ppb - 1) / ppb;
+				expand_sse2(idx, s + (sx + x) / ppb, nbytes, bits);
+				lookup(d, idx + skip, n, &lut);
+			}
+			d += n * (rgba ? 4 : 3);
+		}
+	}
+	return 0;
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,191 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * blitbench.c	Palette and gray to RGB blitter benchmark
+ *
+ * Converts random images of a few widths with each of the blitters that
+ * have SSE2 and AVX2 versions, once for every instruction set the host
+ * supports, and reports the million pixels per second. Before timing a
+ * blitter it checks that all instruction sets produce the same bytes as
+ * the scalar code, also for unaligned source and destination x, and that
+ * none of them writes outside the destination rectangle.
+ *
+ *	blitbench [-p pixels]
+ *
+ * -p pixels	number of pixels to convert per measurement
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include <sys/time.h>
+#include "blit.h"
+
+/** @brief default number of pixels to convert per measurement */
+#define	DEFAULT_PIXELS	8000000
+
+/** @brief rows of the test images */
+#define	ROWS		64
+
+/** @brief destination bytes after each row which must not be written */
+#define	GUARD		32
+
+typedef int (*blit_fn)(uint8_t *dst, int dx, int dy, uint32_t dstride,
+	uint8_t *src, int sx, int sy, uint32_t sstride,
+	int w, int h, uint32_t *colors, int alpha);
+
+typedef struct {
+	/** @brief name of the conversion */
+	const char *name;
+	/** @brief blitter */
+	blit_fn fn;
+	/** @brief source bits per pixel */
+	int bits;
+	/** @brief destination bytes per pixel */
+	int bpp;
+}	blitter_t;
+
+static const blitter_t blitters[] = {
+	{"pal1>rgb8",	blit_pal1_to_rgb8,	1, 3},
+	{"pal1>rgba8",	blit_pal1_to_rgba8,	1, 4},
+	{"pal2>rgb8",	blit_pal2_to_rgb8,	2, 3},
+	{"pal2>rgba8",	blit_pal2_to_rgba8,	2, 4},
+	{"pal4>rgb8",	blit_pal4_to_rgb8,	4, 3},
+	{"pal4>rgba8",	blit_pal4_to_rgba8,	4, 4},
+	{"pal8>rgb8",	blit_pal8_to_rgb8,	8, 3},
+	{"pal8>rgba8",	blit_pal8_to_rgba8,	8, 4},
+	{"gray1>rgb8",	blit_gray1_to_rgb8,	1, 3},
+	{"gray1>rgba8",	blit_gray1_to_rgba8,	1, 4},
+	{"gray2>rgb8",	blit_gray2_to_rgb8,	2, 3},
+	{"gray2>rgba8",	blit_gray2_to_rgba8,	2, 4},
+	{"gray4>rgb8",	blit_gray4_to_rgb8,	4, 3},
+	{"gray4>rgba8",	blit_gray4_to_rgba8,	4, 4},
+	{"gray8>rgb8",	blit_gray8_to_rgb8,	8, 3},
+	{"gray8>rgba8",	blit_gray8_to_rgba8,	8, 4},
+};
+
+static const int widths[] = {16, 64, 320, 800, 1920, 4096};
+
+static const char *level_names[] = {"scalar", "sse2", "avx2"};
+
+/** @brief random colors with an unused top byte, like SDL_Color */
+static uint32_t colors[256];
+
+/** @brief return the host time in microseconds */
+static uint64_t usecs(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000ull + tv.tv_usec;
+}
+
+/** @brief blit an image with every level and compare with the scalar result */
+static int verify(const blitter_t *b, int w, int levels,
+	uint8_t *src, uint32_t sstride, uint8_t *ref, uint8_t *dst)
+{
+	static const int offsets[][2] = {{0, 0}, {1, 0}, {3, 2}, {5, 1}, {7, 3}};
+	uint32_t dstride = (w + 8) * b->bpp + GUARD;
+	size_t size = (size_t)dstride * ROWS;
+	int level, i, sx, dx;
+
+	for (i = 0; i < (int)(sizeof(offsets) / sizeof(offsets[0])); i++) {
+		sx = offsets[i][0];
+		dx = offsets[i][1];
+		blit_simd_level = BLIT_SIMD_NONE;
+		memset(ref, 0x5a, size);
+		b->fn(ref, dx, 0, dstride, src, sx, 0, sstride, w, ROWS, colors, 0xc3);
+		for (level = BLIT_SIMD_SSE2; level < levels; level++) {
+			blit_simd_level = level;
+			memset(dst, 0x5a, size);
+			b->fn(dst, dx, 0, dstride, src, sx, 0, sstride, w, ROWS, colors, 0xc3);
+			if (memcmp(ref, dst, size)) {
+				printf("%-12s %5d %-6s sx:%d dx:%d FAIL\n",
+					b->name, w, level_names[level], sx, dx);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/** @brief convert an image repeatedly and return the million pixels per second */
+static double measure(const blitter_t *b, int w, int level, uint64_t pixels,
+	uint8_t *src, uint32_t sstride, uint8_t *dst)
+{
+	uint32_t dstride = (w + 8) * b->bpp + GUARD;
+	uint64_t done, t0, t1;
+
+	blit_simd_level = level;
+	t0 = usecs();
+	for (done = 0; done < pixels; done += (uint64_t)w * ROWS)
+		b->fn(dst, 0, 0, dstride, src, 0, 0, sstride, w, ROWS, colors, 0xff);
+	t1 = usecs();
+	return t1 > t0 ? done / (double)(t1 - t0) : 0.0;
+}
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "usage: %s [-p pixels]\n", argv[0]);
+	fprintf(stderr, "-p pixels   number of pixels to convert per measurement (%u)\n",
+		DEFAULT_PIXELS);
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t pixels = DEFAULT_PIXELS;
+	int maxw = widths[sizeof(widths) / sizeof(widths[0]) - 1];
+	uint32_t sstride = maxw + 16;
+	size_t dsize = (size_t)((maxw + 8) * 4 + GUARD) * ROWS;
+	uint8_t *src, *ref, *dst;
+	double mps[3];
+	int levels, level, i, n, rc = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-p") && i + 1 < argc)
+			pixels = strtoull(argv[++i], NULL, 0);
+		else {
+			usage(argv);
+			return 1;
+		}
+	}
+
+	src = malloc((size_t)sstride * ROWS);
+	ref = malloc(dsize);
+	dst = malloc(dsize);
+	if (NULL == src || NULL == ref || NULL == dst) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	srand(1);
+	for (i = 0; i < (int)sstride * ROWS; i++)
+		src[i] = (uint8_t)rand();
+	for (i = 0; i < 256; i++)
+		colors[i] = ((uint32_t)rand() << 8 ^ (uint32_t)rand()) & 0xffffff;
+
+	levels = blit_simd_detect() + 1;
+	printf("%-12s %5s", "blitter", "width");
+	for (level = 0; level < levels; level++)
+		printf(" %10s", level_names[level]);
+	printf("  Mpixel/s\n");
+
+	for (i = 0; i < (int)(sizeof(blitters) / sizeof(blitters[0])); i++) {
+		const blitter_t *b = &blitters[i];
+		for (n = 0; n < (int)(sizeof(widths) / sizeof(widths[0])); n++) {
+			/* room for the source x offsets of the tests */
+			uint32_t stride = (widths[n] * b->bits + 7) / 8 + 8;
+			if (verify(b, widths[n], levels, src, stride, ref, dst) < 0) {
+				rc = 1;
+				continue;
+			}
+			for (level = 0; level < levels; level++)
+				mps[level] = measure(b, widths[n], level, pixels, src, stride, dst);
+			printf("%-12s %5d", b->name, widths[n]);
+			for (level = 0; level < levels; level++)
+				printf(" %10.1f", mps[level]);
+			printf("  x%.2f\n", mps[0] > 0 ? mps[levels - 1] / mps[0] : 0.0);
+		}
+	}
+	free(dst);
+	free(ref);
+	free(src);
+	return rc;
+}
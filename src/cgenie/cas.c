@@ -5,6 +5,7 @@
  * $Id: cas.c,v 1.3 2005/12/21 02:40:54 pullmoll Exp $
  ****************************************************************************/
 #include "cgenie/cas.h"
+#include "state.h"
 
 #define	CAS_DEBUG	0
 
@@ -60,13 +61,43 @@ typedef struct cgenie_cas_s {
 
 	uint8_t get_bit;
 
+	/* non zero if the input and output files are open (save states) */
+	uint8_t open[2];
+
 }	cgenie_cas_t;
 
-static cgenie_cas_t cas;
+static MACHINE_LOCAL cgenie_cas_t cas;
 
 /* a prototype to be called from cgenie_stop_machine */
 static void cas_put_close(void);
 
+/* save state: remember which files are open */
+static void cas_presave(void)
+{
+	cas.open[0] = NULL != cas.get_img;
+	cas.open[1] = NULL != cas.put_img;
+}
+
+/* save state: open or close the files (the tape data is in the buffer) */
+static void cas_postload(void)
+{
+	const char *tape = img_mounted(IMG_TYPE_CAS, 0);
+
+	if (NULL != cas.get_img && !cas.open[0]) {
+		img_fclose(cas.get_img);
+		cas.get_img = NULL;
+	} else if (NULL == cas.get_img && cas.open[0]) {
+		cas.get_img = img_fopen(NULL != tape ? tape : cas.name,
+			IMG_TYPE_CAS, "rb");
+	}
+	if (NULL != cas.put_img && !cas.open[1]) {
+		img_fclose(cas.put_img);
+		cas.put_img = NULL;
+	} else if (NULL == cas.put_img && cas.open[1]) {
+		cas.put_img = img_fopen(cas.name, IMG_TYPE_CAS, "wb");
+	}
+}
+
 
 int cgenie_cas_init(void)
 {
@@ -75,6 +106,21 @@ int cgenie_cas_init(void)
 	if (NULL == cas.buff)
 		return -1;
 
+	STATE_ITEM("cas", 0, cas.name);
+	STATE_ITEM("cas", 0, cas.offs);
+	STATE_ITEM("cas", 0, cas.size);
+	STATE_ITEM("cas", 0, cas.count);
+	STATE_ITEM("cas", 0, cas.put_bitcnt);
+	STATE_ITEM("cas", 0, cas.get_bitcnt);
+	STATE_ITEM("cas", 0, cas.shiftreg);
+	STATE_ITEM("cas", 0, cas.bit_time);
+	STATE_ITEM("cas", 0, cas.in_sync);
+	STATE_ITEM("cas", 0, cas.put_time);
+	STATE_ITEM("cas", 0, cas.get_time);
+	STATE_ITEM("cas", 0, cas.get_bit);
+	STATE_ITEM("cas", 0, cas.open);
+	state_register("cas", 0, "cas.buff", cas.buff, BUFF_SIZE);
+	state_register_hooks(cas_presave, cas_postload);
 	return 0;
 }
 
@@ -131,7 +177,7 @@ static void cas_put_bit(void)
 {
 	tmr_time_t now = time_now();
 	tmr_time_t diff = now - cas.put_time;
-	tmr_time_t limit = TIMING_CONST * mem[0x4310] + 4 * mem[0x4311];
+	tmr_time_t limit = TIMING_CONST * machine->mem[0x4310] + 4 * machine->mem[0x4311];
 
 	/* remember the cycle count of this write */
 	cas.put_time = now;
@@ -269,6 +315,8 @@ static void cas_get_byte(void)
  *******************************************************************/
 static void cas_get_open(void)
 {
+	/* a mounted tape is read regardless of the name */
+	const char *tape = img_mounted(IMG_TYPE_CAS, 0);
 	char *p;
 	int i;
 
@@ -278,18 +326,18 @@ static void cas_get_open(void)
 	cas.count = 0;
 
 	/* extract name from input buffer */
-	sprintf(cas.name, "%-6.6s", mem + 0x41e8);
+	sprintf(cas.name, "%-6.6s", machine->mem + 0x41e8);
 	p = strchr(cas.name, ' ');
 	if (NULL != p)
 		*p = '\0';
-	if (cas.name[0] == ' ')
+	if (cas.name[0] == ' ' && NULL == tape)
 		return;
 	for (i = 0; i < strlen(cas.name); i++)
 		cas.name[i] = tolower((uint8_t)cas.name[i]);
 	strcat(cas.name, ".cas");
 
 	LOG((LL,"CGENIE","cas_get_open '%s'\n", cas.name));
-	cas.get_img = img_fopen(cas.name, IMG_TYPE_CAS, "rb");
+	cas.get_img = img_fopen(NULL != tape ? tape : cas.name, IMG_TYPE_CAS, "rb");
 	if (NULL == cas.get_img)
 		return;
 
@@ -313,7 +361,7 @@ static void cas_get_open(void)
 static void cas_get_bit(void)
 {
 	tmr_time_t now = time_now();
-	tmr_time_t limit = TIMING_CONST * mem[0x4312];
+	tmr_time_t limit = TIMING_CONST * machine->mem[0x4312];
 	tmr_time_t diff = now - cas.get_time;
 
 	/* remember the cycle count of this read */
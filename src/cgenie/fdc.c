@@ -7,6 +7,7 @@
  *
  ***************************************************************************************/
 #include "cgenie/fdc.h"
+#include "state.h"
 
 #define	FDC_DEBUG	1
 #if	FDC_DEBUG
@@ -23,8 +24,8 @@
 
 #define IRQ_TIMER	0x80
 #define IRQ_FDC 	0x40
-static uint8_t irq_status = 0;
-static int fdc_enabled;
+static MACHINE_LOCAL uint8_t irq_status = 0;
+static MACHINE_LOCAL int fdc_enabled;
 
 typedef struct pdrive_s {
 	uint8_t ddsl;   /* Disk Directory Start Lump (lump number of GAT) */
@@ -199,7 +200,7 @@ static int init_drive(uint32_t drive)
 		drive, 'A'+found));
 
 	/* XXX: patch mem to contain useful pdrive parameters */
-	pd = (pdrive_t *)&mem[PDRIVE_BASE + drive * 10];
+	pd = (pdrive_t *)&machine->mem[PDRIVE_BASE + drive * 10];
 	pd->ddsl = ps->ddsl;
 	pd->gatl = ps->gatl;
 	pd->steprt = ps->steprt;
@@ -237,7 +238,7 @@ int cgenie_fdc_init(void)
 	for (drive = 0; drive < 4; drive++)
 		init_drive(drive);
 	for (drive = 0; drive < 4; drive++) {
-		pd = (pdrive_t *)&mem[PDRIVE_BASE + drive * 10];
+		pd = (pdrive_t *)&machine->mem[PDRIVE_BASE + drive * 10];
 		LOG((LL,"CGENIE","pd%x: %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x\n",
 			drive,
 			pd->ddsl, pd->gatl, pd->steprt, pd->tracks, pd->spt,
@@ -245,6 +246,8 @@ int cgenie_fdc_init(void)
 	}
 
 	fdc_enabled += 1;
+	STATE_ITEM("fdc", 0, irq_status);
+	STATE_ITEM("fdc", 0, fdc_enabled);
 	return 0;
 }
 
@@ -286,13 +289,13 @@ uint8_t cgenie_irq_status_r(uint32_t offset)
 void cgenie_timer_interrupt(void)
 {
 	irq_status |= IRQ_TIMER;
-	z80_interrupt(&z80, 2);
+	z80_interrupt(&machine->cpu, 2);
 }
 
 void cgenie_fdc_interrupt(void)
 {
 	irq_status |= IRQ_FDC;
-	z80_interrupt(&z80, 2);
+	z80_interrupt(&machine->cpu, 2);
 }
 
 void cgenie_fdc_callback(uint32_t event)
@@ -9,6 +9,13 @@
 #include "z80.h"
 #include "z80dasm.h"
 #include "timer.h"
+#include "batch.h"
+#include "stats.h"
+#include "state.h"
+#include "rewind.h"
+#include "debug.h"
+#include "trace.h"
+#include "cgenie/main.h"
 #include "cgenie/kbd.h"
 #include "cgenie/cas.h"
 #include "cgenie/fdc.h"
@@ -55,19 +62,19 @@ const char cgenie_chr[] = "cgenie.chr";
 #define	EXT_ROM_SIZE	0x1000
 
 /** @brief Video RAM dirty flags */
-static uint32_t *video_ram_dirty;
+static MACHINE_LOCAL uint32_t *video_ram_dirty;
 
 /** @brief Colour RAM dirty flags */
-static uint32_t *colour_ram_dirty;
+static MACHINE_LOCAL uint32_t *colour_ram_dirty;
 
 /** @brief Font RAM dirty flags */
-static uint32_t *font_ram_dirty;
+static MACHINE_LOCAL uint32_t *font_ram_dirty;
 
 /** @brief redraw all */
-static uint32_t dirty_all;
+static MACHINE_LOCAL uint32_t dirty_all;
 
 /** @brief redraw full frame */
-static uint32_t frame_redraw;
+static MACHINE_LOCAL uint32_t frame_redraw;
 
 /** @brief video memory (16K at 0x4000) */
 #define	VIDEO_RAM_BASE	0x4000
@@ -81,8 +88,68 @@ static uint32_t frame_redraw;
 #define	FONT_RAM_BASE	0xf400
 #define	FONT_RAM_SIZE	0x0400
 
-/** @brief rendered font */
-static osd_bitmap_t *font;
+/** @brief CPU clock in Hz */
+#define	CPU_CLOCK	2216800
+
+/** @brief CPU cycles per MC6845 character clock (1.1084 MHz) */
+#define	CHAR_CC		2
+
+/** @brief maximum number of scanlines in the stall table */
+#define	STALL_LINES	512
+
+/** @brief number of character codes (256 ROM + 128 font RAM) */
+#define	GLYPH_CODES	384
+
+/** @brief number of glyphs in the glyph cache */
+#define	GLYPH_SLOTS	512
+
+/** @brief glyph cache key of a code and colour attribute */
+#define	GLYPH_KEY(code,attr)	((code) * 16 + (attr))
+
+/** @brief glyph cache slot is unused */
+#define	GLYPH_NONE	0xffff
+
+typedef struct {
+	/** @brief GLYPH_KEY of the glyph in this slot, or GLYPH_NONE */
+	uint16_t key;
+	/** @brief previous (more recently used) slot, or -1 */
+	int16_t prev;
+	/** @brief next (less recently used) slot, or -1 */
+	int16_t next;
+}	glyph_slot_t;
+
+/** @brief glyph cache slot of each GLYPH_KEY, or -1 */
+static MACHINE_LOCAL int16_t glyph_map[GLYPH_CODES * 16];
+
+/** @brief glyph cache slots */
+static MACHINE_LOCAL glyph_slot_t glyph_lru[GLYPH_SLOTS];
+
+/** @brief most recently used glyph cache slot */
+static MACHINE_LOCAL int32_t glyph_head = -1;
+
+/** @brief least recently used glyph cache slot */
+static MACHINE_LOCAL int32_t glyph_tail = -1;
+
+/** @brief glyph cache pixels: glyph_size bytes per slot */
+static MACHINE_LOCAL uint8_t *glyph_pixels;
+
+/** @brief glyph width, height and bits per pixel the cache was built for */
+static MACHINE_LOCAL int32_t glyph_w, glyph_h, glyph_bpp;
+
+/** @brief bytes per glyph row and per glyph in the cache */
+static MACHINE_LOCAL uint32_t glyph_pitch, glyph_size;
+
+/** @brief graphics pixels per video RAM byte */
+#define	GFX_PPB		4
+
+/** @brief gfx_shown entry of a pixel which has to be drawn */
+#define	GFX_NONE	0xff
+
+/** @brief graphics pixels last presented: GFX_PPB per displayed byte, row by row */
+static MACHINE_LOCAL uint8_t *gfx_shown;
+
+/** @brief number of entries in gfx_shown */
+static MACHINE_LOCAL uint32_t gfx_size;
 
 typedef enum {
 	C_GRAY,
@@ -105,67 +172,67 @@ typedef enum {
 }	cgenie_colour_t;
 
 /** @brief text mode palette colors */
-static uint32_t pal_txt[16+1];
+static MACHINE_LOCAL uint32_t pal_txt[16+1];
 
 /** @brief graphics mode palette colors */
-static uint32_t pal_gfx[4];
+static MACHINE_LOCAL uint32_t pal_gfx[4];
 
 /** @brief non-zero if in graphics mod */
-static uint32_t gfx_mode;
+static MACHINE_LOCAL uint32_t gfx_mode;
 
 /** @brief character generator base address (0x00 or 0x80) */
-static uint32_t font_base[4];
+static MACHINE_LOCAL uint32_t font_base[4];
 
 /** @brief character generator raw data */
-static uint8_t chargen[256 * 8];
+static MACHINE_LOCAL uint8_t chargen[256 * 8];
 
 /** @brief font glyph width */
-static int32_t font_w = 8;
+static MACHINE_LOCAL int32_t font_w = 8;
 
 /** @brief font glyph height */
-static int32_t font_h = 8;
+static MACHINE_LOCAL int32_t font_h = 8;
 
 /** @brief screen character columns */
-static uint32_t screen_w = 40;
+static MACHINE_LOCAL uint32_t screen_w = 40;
 
 /** @brief screen character rows */
-static uint32_t screen_h = 25;
+static MACHINE_LOCAL uint32_t screen_h = 25;
 
 /** @brief character pixel rows */
-static uint32_t char_h = 8;
+static MACHINE_LOCAL uint32_t char_h = 8;
 
 /** @brief horizontal sync position */
-static uint32_t hpos = 4;
+static MACHINE_LOCAL uint32_t hpos = 4;
 
 /** @brief vertical sync position */
-static uint32_t vpos = 3;
+static MACHINE_LOCAL uint32_t vpos = 3;
 
 /** @brief screen character columns (changed) */
-static uint32_t screen_w_changed;
+static MACHINE_LOCAL uint32_t screen_w_changed;
 
 /** @brief screen character rows (changed) */
-static uint32_t screen_h_changed;
+static MACHINE_LOCAL uint32_t screen_h_changed;
 
 /** @brief character pixel rows (changed) */
-static uint32_t char_h_changed;
+static MACHINE_LOCAL uint32_t char_h_changed;
 
 /** @brief horizontal sync position (last frame) */
-static uint32_t hpos_old;
+static MACHINE_LOCAL uint32_t hpos_old;
 
 /** @brief vertical sync position (last frame) */
-static uint32_t vpos_old;
+static MACHINE_LOCAL uint32_t vpos_old;
 
 /** @brief frame buffer width */
-static int32_t frame_w = 8 * SCREENW;
+static MACHINE_LOCAL int32_t frame_w = 8 * SCREENW;
 
 /** @brief frame buffer height */
-static int32_t frame_h = 8 * SCREENH;
+static MACHINE_LOCAL int32_t frame_h = 8 * SCREENH;
 
 /** @brief screen x offset */
-static int32_t screen_x = 8 * 3;
+static MACHINE_LOCAL int32_t screen_x = 8 * 3;
 
 /** @brief screen y offset */
-static int32_t screen_y = 8 * 2;
+static MACHINE_LOCAL int32_t screen_y = 8 * 2;
 
 #define	PORT_FF_CAS	(1<<0)
 #define	PORT_FF_BGRD	(1<<2)
@@ -177,26 +244,35 @@ static int32_t screen_y = 8 * 2;
 #define	PORT_FF_BGRD_ALL (PORT_FF_BGRD|PORT_FF_BGRD_0|PORT_FF_BGRD_1)
 
 /** @brief port 0xff value */
-static uint8_t port_ff = 0xff;
+static MACHINE_LOCAL uint8_t port_ff = 0xff;
 
 /** @brief frame timer (50 Hz) */
-static tmr_t *frame_timer;
+static MACHINE_LOCAL tmr_t *frame_timer;
 
 /** @brief clock timer (40 Hz) */
-static tmr_t *clock_timer;
+static MACHINE_LOCAL tmr_t *clock_timer;
+
+/** @brief CRTC geometry the stall table was built for */
+static MACHINE_LOCAL uint64_t stall_geometry;
 
-/** @brief scanline timer (16525 Hz) */
-static tmr_t *scan_timer;
+/** @brief CPU cycles per scanline */
+static MACHINE_LOCAL uint32_t stall_line_cc = 1;
+
+/** @brief number of scanlines per frame in the stall table */
+static MACHINE_LOCAL uint32_t stall_lines;
+
+/** @brief CPU cycles from the start of each scanline while the CRTC fetches (0 if blank) */
+static MACHINE_LOCAL uint16_t stall_cc[STALL_LINES];
 
 /** @brief non zero if the emulation stops */
-int stop;
+MACHINE_LOCAL int stop;
 
 /** @brief beam positions when an access conflict occured */
 #define	CONFLICT_MAX	256
-uint32_t conflict_pos[CONFLICT_MAX];
+MACHINE_LOCAL uint32_t conflict_pos[CONFLICT_MAX];
 
 /** @brief number of conflicts this frame */
-uint32_t conflict_cnt;
+MACHINE_LOCAL uint32_t conflict_cnt;
 
 typedef enum {
 	CPU_NONE,
@@ -231,6 +307,8 @@ static __inline int get_font_ram_dirty(uint32_t offset);
 static void video_bgd(uint8_t r, uint8_t g, uint8_t b);
 static void video_font_base(uint32_t which, uint32_t base);
 static void video_mode(uint32_t enable);
+static void glyph_flush(void);
+static void glyph_invalidate(uint32_t code);
 static uint8_t rd_rom(uint32_t offset);
 static uint8_t rd_ram(uint32_t offset);
 static uint8_t rd_kbd(uint32_t offset);
@@ -260,10 +338,9 @@ static uint8_t cgenie_port_b_r(uint32_t offset);
 static void cgenie_port_a_w(uint32_t offset, uint8_t data);
 static void cgenie_port_b_w(uint32_t offset, uint8_t data);
 static void cgenie_clock(uint32_t param);
-static void cgenie_scan(uint32_t param);
 
 /** @brief memory read handlers */
-uint8_t (*rd_mem[L1SIZE])(uint32_t offset) = {
+static uint8_t (* const cgenie_rd_mem[L1SIZE])(uint32_t offset) = {
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 0000-0fff */
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 1000-1fff */
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 2000-2fff */
@@ -283,7 +360,7 @@ uint8_t (*rd_mem[L1SIZE])(uint32_t offset) = {
 };
 
 /** @brief memory write handlers */
-void (*wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
+static void (* const cgenie_wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 0000-0fff */
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 1000-1fff */
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 2000-2fff */
@@ -302,8 +379,48 @@ void (*wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_col,	wr_chr,	wr_nop,	wr_fdc	/* f000-ffff */
 };
 
+/** @brief memory read pointers (offset into mem, U32INVALID for pages with side effects) */
+static const uint32_t cgenie_rd_ptr[L1SIZE] = {
+	0x0000,	0x0400,	0x0800,	0x0c00,	/* 0000-0fff */
+	0x1000,	0x1400,	0x1800,	0x1c00,	/* 1000-1fff */
+	0x2000,	0x2400,	0x2800,	0x2c00,	/* 2000-2fff */
+	0x3000,	0x3400,	0x3800,	0x3c00,	/* 3000-3fff */
+	0x4000,	0x4400,	0x4800,	0x4c00,	/* 4000-4fff */
+	0x5000,	0x5400,	0x5800,	0x5c00,	/* 5000-5fff */
+	0x6000,	0x6400,	0x6800,	0x6c00,	/* 6000-6fff */
+	0x7000,	0x7400,	0x7800,	0x7c00,	/* 7000-7fff */
+	0x8000,	0x8400,	0x8800,	0x8c00,	/* 8000-8fff */
+	0x9000,	0x9400,	0x9800,	0x9c00,	/* 9000-9fff */
+	0xa000,	0xa400,	0xa800,	0xac00,	/* a000-afff */
+	0xb000,	0xb400,	0xb800,	0xbc00,	/* b000-bfff */
+	0xc000,	0xc400,	0xc800,	0xcc00,	/* c000-cfff */
+	0xd000,	0xd400,	0xd800,	0xdc00,	/* d000-dfff */
+	0xe000,	0xe400,	0xe800,	0xec00,	/* e000-efff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID	/* f000-ffff */
+};
+
+/** @brief memory write pointers (offset into mem, U32INVALID for pages with side effects) */
+static const uint32_t cgenie_wr_ptr[L1SIZE] = {
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 0000-0fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 1000-1fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 2000-2fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 3000-3fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 4000-4fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 5000-5fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 6000-6fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 7000-7fff */
+	0x8000,	0x8400,	0x8800,	0x8c00,	/* 8000-8fff */
+	0x9000,	0x9400,	0x9800,	0x9c00,	/* 9000-9fff */
+	0xa000,	0xa400,	0xa800,	0xac00,	/* a000-afff */
+	0xb000,	0xb400,	0xb800,	0xbc00,	/* b000-bfff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* c000-cfff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* d000-dfff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* e000-efff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID	/* f000-ffff */
+};
+
 /** @brief I/O space read handlers */
-uint8_t (*rd_io[L1SIZE])(uint32_t offset) = {
+static uint8_t (* const cgenie_rd_io[L1SIZE])(uint32_t offset) = {
 	rd_port,rd_port,rd_port,rd_port,/* 0000-0fff */
 	rd_port,rd_port,rd_port,rd_port,/* 1000-1fff */
 	rd_port,rd_port,rd_port,rd_port,/* 2000-2fff */
@@ -323,7 +440,7 @@ uint8_t (*rd_io[L1SIZE])(uint32_t offset) = {
 };
 
 /** @brief I/O space write handlers */
-void (*wr_io[L1SIZE])(uint32_t offset, uint8_t data) = {
+static void (* const cgenie_wr_io[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_port,wr_port,wr_port,wr_port,/* 0000-0fff */
 	wr_port,wr_port,wr_port,wr_port,/* 1000-1fff */
 	wr_port,wr_port,wr_port,wr_port,/* 2000-2fff */
@@ -363,7 +480,7 @@ static ifc_ay8910_t ay8910 = {
 /** @brief reset the system */
 void sys_reset(reset_t how)
 {
-	z80_cpu_t *cpu = &z80;
+	z80_cpu_t *cpu = &machine->cpu;
 	switch (how) {
 	case SYS_IRQ:
 		z80_interrupt(cpu, 2);
@@ -437,18 +554,18 @@ void sys_cpu_panel_init(void *bitmap)
 void sys_cpu_panel_update(void *bitmap)
 {
 	osd_bitmap_t *cpu_panel = (osd_bitmap_t *)bitmap;
-	osd_widget_text(cpu_panel, CPU_BC,  "BC: %04x", z80_get_reg(&z80, Z80_BC));
-	osd_widget_text(cpu_panel, CPU_DE,  "DE: %04x", z80_get_reg(&z80, Z80_DE));
-	osd_widget_text(cpu_panel, CPU_HL,  "HL: %04x", z80_get_reg(&z80, Z80_HL));
-	osd_widget_text(cpu_panel, CPU_AF,  "AF: %04x", z80_get_reg(&z80, Z80_AF));
-	osd_widget_text(cpu_panel, CPU_IX,  "IX: %04x", z80_get_reg(&z80, Z80_IX));
-	osd_widget_text(cpu_panel, CPU_IY,  "IY: %04x", z80_get_reg(&z80, Z80_IY));
-	osd_widget_text(cpu_panel, CPU_SP,  "SP: %04x", z80_get_reg(&z80, Z80_SP));
-	osd_widget_text(cpu_panel, CPU_PC,  "PC: %04x", z80_get_reg(&z80, Z80_PC));
-	osd_widget_text(cpu_panel, CPU_BC2, "BC' %04x", z80_get_reg(&z80, Z80_BC2));
-	osd_widget_text(cpu_panel, CPU_DE2, "DE' %04x", z80_get_reg(&z80, Z80_DE2));
-	osd_widget_text(cpu_panel, CPU_HL2, "HL' %04x", z80_get_reg(&z80, Z80_HL2));
-	osd_widget_text(cpu_panel, CPU_AF2, "AF' %04x", z80_get_reg(&z80, Z80_AF2));
+	osd_widget_text(cpu_panel, CPU_BC,  "BC: %04x", z80_get_reg(&machine->cpu, Z80_BC));
+	osd_widget_text(cpu_panel, CPU_DE,  "DE: %04x", z80_get_reg(&machine->cpu, Z80_DE));
+	osd_widget_text(cpu_panel, CPU_HL,  "HL: %04x", z80_get_reg(&machine->cpu, Z80_HL));
+	osd_widget_text(cpu_panel, CPU_AF,  "AF: %04x", z80_get_reg(&machine->cpu, Z80_AF));
+	osd_widget_text(cpu_panel, CPU_IX,  "IX: %04x", z80_get_reg(&machine->cpu, Z80_IX));
+	osd_widget_text(cpu_panel, CPU_IY,  "IY: %04x", z80_get_reg(&machine->cpu, Z80_IY));
+	osd_widget_text(cpu_panel, CPU_SP,  "SP: %04x", z80_get_reg(&machine->cpu, Z80_SP));
+	osd_widget_text(cpu_panel, CPU_PC,  "PC: %04x", z80_get_reg(&machine->cpu, Z80_PC));
+	osd_widget_text(cpu_panel, CPU_BC2, "BC' %04x", z80_get_reg(&machine->cpu, Z80_BC2));
+	osd_widget_text(cpu_panel, CPU_DE2, "DE' %04x", z80_get_reg(&machine->cpu, Z80_DE2));
+	osd_widget_text(cpu_panel, CPU_HL2, "HL' %04x", z80_get_reg(&machine->cpu, Z80_HL2));
+	osd_widget_text(cpu_panel, CPU_AF2, "AF' %04x", z80_get_reg(&machine->cpu, Z80_AF2));
 }
 
 /** @brief mark a video RAM location dirty */
@@ -523,13 +640,64 @@ static __inline int get_font_ram_dirty(uint32_t offset)
 	return ((dirty_all | font_ram_dirty[o / 32]) & (1 << b)) ? 1 : 0;
 }
 
+/** @brief rebuild the stall table if the CRTC geometry changed */
+static void video_stall_table(void)
+{
+	uint32_t total = mc6845_get_chars_total(0);
+	uint32_t columns = mc6845_get_char_columns(0);
+	uint32_t height = mc6845_get_char_height(0);
+	uint32_t lines = mc6845_get_lines_total(0) * height + mc6845_get_total_adjust(0);
+	uint32_t active = mc6845_get_char_lines(0) * height;
+	uint64_t geometry = ((uint64_t)total << 48) | ((uint64_t)columns << 32) |
+		((uint64_t)lines << 16) | active;
+	uint32_t line;
+
+	if (geometry == stall_geometry)
+		return;
+	stall_geometry = geometry;
+
+	if (columns > total)
+		columns = total;
+	stall_line_cc = total * CHAR_CC;
+	stall_lines = lines < STALL_LINES ? lines : STALL_LINES;
+	for (line = 0; line < stall_lines; line++)
+		stall_cc[line] = line < active ? columns * CHAR_CC : 0;
+}
+
+/**
+ * @brief stall the CPU when accessing video RAM while the CRTC fetches from it
+ *
+ * The raster position is the number of CPU cycles since the start of the
+ * frame, split into scanline and cycle within the scanline. During the
+ * displayed part of a scanline the CRTC owns the bus for each character
+ * clock, and the CPU waits until the character fetch in progress is done.
+ * Returns the beam position (scanline * columns + column) * 8 + pixel,
+ * or -1 if the access fell into the borders or the blanking.
+ */
+static int32_t video_stall(void)
+{
+	tmr_time_t elapsed = tmr_elapsed(frame_timer);
+	uint32_t cc, line, x;
+
+	if (elapsed < 0)
+		return -1;
+	cc = (uint32_t)((uint64_t)elapsed * CPU_CLOCK / 1000000000ull);
+	line = cc / stall_line_cc;
+	x = cc % stall_line_cc;
+	if (line >= stall_lines || x >= stall_cc[line])
+		return -1;
+	machine->cc += CHAR_CC - x % CHAR_CC;
+	return (int32_t)((line * screen_w + x / CHAR_CC) * 8 + x % CHAR_CC * 8 / CHAR_CC);
+}
+
 /** @brief simulate a bus conflict when accessing the character generator RAM */
 static void video_conflict(void)
 {
-	uint32_t chars = screen_w * screen_h * char_h * 8;
-	uint32_t pos = (uint32_t)(tmr_elapsed(frame_timer) * chars / frame_timer->restart);
+	int32_t pos = video_stall();
+	if (pos < 0)
+		return;
 	if (conflict_cnt < CONFLICT_MAX) {
-		conflict_pos[conflict_cnt] = pos;
+		conflict_pos[conflict_cnt] = (uint32_t)pos;
 		conflict_cnt++;
 	}
 }
@@ -538,6 +706,8 @@ static void video_conflict(void)
 static void video_bgd(uint8_t r, uint8_t g, uint8_t b)
 {
 	pal_gfx[0] = pal_txt[C_BACKGROUND] = osd_rgb(r, g, b);
+	/* the glyphs of non palette frames contain the colour */
+	glyph_flush();
 	/* mark everything dirty */
 	dirty_all = (uint32_t)-1;
 }
@@ -557,7 +727,7 @@ static void video_font_base(uint32_t which, uint32_t base)
 	/* calculate the character code range that changed */
 	which *= 64;
 	for (i = 0; i < size; i++, offs = (offs + 1) % VIDEO_RAM_SIZE) {
-		if (which == (mem[VIDEO_RAM_BASE + offs] & 0xc0))
+		if (which == (machine->mem[VIDEO_RAM_BASE + offs] & 0xc0))
 			set_video_ram_dirty(offs);
 	}
 }
@@ -575,13 +745,13 @@ static void video_mode(uint32_t enable)
 /** @brief read from ROM address */
 static uint8_t rd_rom(uint32_t offset)
 {
-	return mem[offset];
+	return machine->mem[offset];
 }
 
 /** @brief read from RAM address */
 static uint8_t rd_ram(uint32_t offset)
 {
-	return mem[offset];
+	return machine->mem[offset];
 }
 
 /** @brief read from keyboard (memory mapped 8x8 matrix) */
@@ -611,15 +781,16 @@ static uint8_t rd_kbd(uint32_t offset)
 /** @brief read colour RAM (bits 7-4 are floating) */
 static uint8_t rd_col(uint32_t offset)
 {
-	uint8_t data = mem[offset];
-	data |= z80.mp.byte.b1 & 0xf0;
+	uint8_t data = machine->mem[offset];
+	video_stall();
+	data |= machine->cpu.mp.byte.b1 & 0xf0;
 	return data;
 }
 
 /** @brief read character generator RAM  */
 static uint8_t rd_chr(uint32_t offset)
 {
-	uint8_t data = mem[offset];
+	uint8_t data = machine->mem[offset];
 	video_conflict();
 	return data;
 }
@@ -627,7 +798,7 @@ static uint8_t rd_chr(uint32_t offset)
 /** @brief read from memory mapped I/O registers */
 static uint8_t rd_fdc(uint32_t offset)
 {
-	uint8_t data = z80.mp.byte.b0;
+	uint8_t data = machine->cpu.mp.byte.b0;
 
 	switch (offset) {
 	case 0xffe0:
@@ -655,7 +826,8 @@ static void wr_rom(uint32_t offset, uint8_t data)
 /** @brief write to RAM memory address */
 static void wr_ram(uint32_t offset, uint8_t data)
 {
-	mem[offset] = data;
+	machine->mem[offset] = data;
+	Z80_BC_CHECK(offset);
 }
 
 
@@ -668,10 +840,11 @@ static void wr_nop(uint32_t offset, uint8_t data)
 /** @brief write to colour RAM */
 static void wr_col(uint32_t offset, uint8_t data)
 {
+	video_stall();
 	data %= 16;		/* only the lower 4 bits are used */
-	if (data == mem[offset])
+	if (data == machine->mem[offset])
 		return;
-	mem[offset] = data;
+	machine->mem[offset] = data;
 	set_colour_ram_dirty(offset);
 }
 
@@ -679,19 +852,22 @@ static void wr_col(uint32_t offset, uint8_t data)
 static void wr_chr(uint32_t offset, uint8_t data)
 {
 	video_conflict();
-	if (data == mem[offset])
+	if (data == machine->mem[offset])
 		return;
-	mem[offset] = data;
+	machine->mem[offset] = data;
 	set_font_ram_dirty(offset/8);
+	glyph_invalidate(256 + (offset / 8) % 128);
 }
 
 /** @brief write to video RAM address */
 static void wr_vid(uint32_t offset, uint8_t data)
 {
-	if (data == mem[offset])
+	video_stall();
+	if (data == machine->mem[offset])
 		return;
-	mem[offset] = data;
+	machine->mem[offset] = data;
 	set_video_ram_dirty(offset);
+	Z80_BC_CHECK(offset);
 }
 
 /** @brief write to memory mapped I/O range (floppy disc motors and controller) */
@@ -835,24 +1011,206 @@ static uint32_t cgenie_video_addr_changed(uint32_t chip, uint32_t frame_base_old
 	for (i = 0; i < size; i++) {
 		uint32_t o0 = (frame_base_old + i) % VIDEO_RAM_SIZE;
 		uint32_t o1 = (frame_base_new + i) % VIDEO_RAM_SIZE;
-		if (mem[VIDEO_RAM_BASE + o0] != mem[VIDEO_RAM_BASE + o1])
+		if (machine->mem[VIDEO_RAM_BASE + o0] != machine->mem[VIDEO_RAM_BASE + o1])
 			set_video_ram_dirty(o1);
 		/* for text mode mark colour dirties */
 		else if (gfx_mode == 0 && /* TODO ignore empty chars */
-			(mem[COLOUR_RAM_BASE + (o0 % COLOUR_RAM_SIZE)] % 16) !=
-			(mem[COLOUR_RAM_BASE + (o1 % COLOUR_RAM_SIZE)] % 16))
+			(machine->mem[COLOUR_RAM_BASE + (o0 % COLOUR_RAM_SIZE)] % 16) !=
+			(machine->mem[COLOUR_RAM_BASE + (o1 % COLOUR_RAM_SIZE)] % 16))
 			set_colour_ram_dirty(o1);
 	}
 	return 0;
 }
 
+/** @brief return the frame pixel value of a text palette colour */
+static uint32_t video_pixel(uint32_t index)
+{
+	osd_bitmap_t *frame = osd_frame();
+	/* the frame's palette is pal_txt */
+	if (8 == frame->bpp)
+		return index;
+	return osd_color(frame, osd_get_r(pal_txt[index]),
+		osd_get_g(pal_txt[index]), osd_get_b(pal_txt[index]));
+}
+
+/** @brief unlink a glyph cache slot from the LRU list */
+static void glyph_unlink(int32_t n)
+{
+	glyph_slot_t *slot = &glyph_lru[n];
+
+	if (slot->prev >= 0)
+		glyph_lru[slot->prev].next = slot->next;
+	else
+		glyph_head = slot->next;
+	if (slot->next >= 0)
+		glyph_lru[slot->next].prev = slot->prev;
+	else
+		glyph_tail = slot->prev;
+}
+
+/** @brief link a glyph cache slot at the head (1) or tail (0) of the LRU list */
+static void glyph_link(int32_t n, int head)
+{
+	glyph_slot_t *slot = &glyph_lru[n];
+
+	if (head) {
+		slot->prev = -1;
+		slot->next = glyph_head;
+		if (glyph_head >= 0)
+			glyph_lru[glyph_head].prev = n;
+		else
+			glyph_tail = n;
+		glyph_head = n;
+	} else {
+		slot->next = -1;
+		slot->prev = glyph_tail;
+		if (glyph_tail >= 0)
+			glyph_lru[glyph_tail].next = n;
+		else
+			glyph_head = n;
+		glyph_tail = n;
+	}
+}
+
+/** @brief drop all glyphs from the cache */
+static void glyph_flush(void)
+{
+	int32_t n;
+
+	memset(glyph_map, 0xff, sizeof(glyph_map));
+	glyph_head = glyph_tail = -1;
+	for (n = 0; n < GLYPH_SLOTS; n++) {
+		glyph_lru[n].key = GLYPH_NONE;
+		glyph_link(n, 0);
+	}
+}
+
+/** @brief drop the glyphs of a character code in all colours */
+static void glyph_invalidate(uint32_t code)
+{
+	uint32_t attr;
+	int32_t n;
+
+	for (attr = 0; attr < 16; attr++) {
+		n = glyph_map[GLYPH_KEY(code, attr)];
+		if (n < 0)
+			continue;
+		glyph_map[GLYPH_KEY(code, attr)] = -1;
+		glyph_lru[n].key = GLYPH_NONE;
+		glyph_unlink(n);
+		glyph_link(n, 0);
+	}
+}
+
+/**
+ * @brief set up the glyph cache for the current glyph size and frame format
+ *
+ * The cache holds glyphs of one size and pixel format only; it is
+ * flushed whenever one of them changes.
+ */
+static int glyph_setup(void)
+{
+	osd_bitmap_t *frame = osd_frame();
+	uint8_t *pixels;
+	uint32_t pitch;
+
+	if (glyph_w == font_w && glyph_h == font_h && glyph_bpp == frame->bpp)
+		return 0;
+	pitch = font_w * ((frame->bpp + 7) / 8);
+	pixels = realloc(glyph_pixels, GLYPH_SLOTS * pitch * font_h);
+	if (NULL == pixels)
+		return -1;
+	glyph_pixels = pixels;
+	glyph_pitch = pitch;
+	glyph_size = pitch * font_h;
+	glyph_w = font_w;
+	glyph_h = font_h;
+	glyph_bpp = frame->bpp;
+	glyph_flush();
+	return 0;
+}
+
+/** @brief expand a glyph in a colour into a glyph cache slot */
+static void glyph_expand(int32_t n, uint32_t code, uint32_t attr)
+{
+	const uint8_t *bits;
+	uint8_t *dst = glyph_pixels + n * glyph_size;
+	uint32_t fg = video_pixel(attr);
+	uint32_t bg = video_pixel(C_BACKGROUND);
+	uint32_t px;
+	int32_t x, y, bytes = (glyph_bpp + 7) / 8;
+
+	if (code < 256)
+		bits = &chargen[FONT_H * code];
+	else
+		bits = &machine->mem[FONT_RAM_BASE + FONT_H * (code - 256)];
+	for (y = 0; y < glyph_h; y++) {
+		uint8_t row = bits[y * FONT_H / glyph_h];
+		for (x = 0; x < glyph_w; x++, dst += bytes) {
+			px = (row >> (7 - x * FONT_W / glyph_w)) & 1 ? fg : bg;
+			switch (bytes) {
+			case 1:
+				dst[0] = (uint8_t)px;
+				break;
+			case 2:
+				*(uint16_t *)dst = (uint16_t)px;
+				break;
+			case 3:
+				dst[0] = (uint8_t)px;
+				dst[1] = (uint8_t)(px >> 8);
+				dst[2] = (uint8_t)(px >> 16);
+				break;
+			default:
+				*(uint32_t *)dst = px;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief return the pixels of a glyph in a colour
+ *
+ * The result is glyph_h rows of glyph_pitch bytes in the frame's format.
+ * It stays valid until GLYPH_SLOTS other glyphs were looked up.
+ */
+static const uint8_t *glyph_get(uint32_t code, uint32_t attr)
+{
+	uint32_t key = GLYPH_KEY(code, attr);
+	int32_t n = glyph_map[key];
+
+	if (n < 0) {
+		/* recycle the least recently used slot */
+		n = glyph_tail;
+		if (GLYPH_NONE != glyph_lru[n].key)
+			glyph_map[glyph_lru[n].key] = -1;
+		glyph_lru[n].key = key;
+		glyph_map[key] = n;
+		glyph_expand(n, code, attr);
+	}
+	if (n != glyph_head) {
+		glyph_unlink(n);
+		glyph_link(n, 1);
+	}
+	return glyph_pixels + n * glyph_size;
+}
+
+/**
+ * @brief render the dirty text cells
+ *
+ * Runs of dirty cells in a character row are copied from the glyph cache
+ * straight into the frame, one scanline at a time, and each run is marked
+ * as one dirty rectangle.
+ */
 static void video_text(void)
 {
+	osd_bitmap_t *frame = osd_frame();
 	uint32_t offs = mc6845_get_start(0);
-	uint32_t x, y, x0, y0, ct, ch, px;
-	uint32_t data;
-	uint32_t attr;
-	uint32_t pal2[2];
+	uint32_t x, x1, y, n, ct, ch, o;
+	int32_t x0, y0, py, lo, hi, pitch, bytes, cursor_x0 = 0, cursor_y0 = 0;
+	uint32_t data, attr, cursor_attr = 0, cursor_hit = 0;
+	const uint8_t *glyph[256];
+	uint8_t *pixels, *dst;
 	mc6845_cursor_t cursor;
 
 	mc6845_get_cursor(0, &cursor);
@@ -861,61 +1219,205 @@ static void video_text(void)
 	if (cursor.bottom >= char_h)
 		cursor.bottom = char_h - 1;
 
-	pal2[0] = pal_txt[C_BACKGROUND];
-	for (y = 0; y < screen_h; y++) {
+	if (glyph_setup() < 0)
+		return;
+	bytes = (glyph_bpp + 7) / 8;
+	pixels = osd_bitmap_lock(frame, &pitch);
+	if (NULL == pixels)
+		return;
+	for (y = 0; y < screen_h; y++, offs = (offs + screen_w) % VIDEO_RAM_SIZE) {
 		y0 = screen_y + y * font_h;
-		for (x = 0; x < screen_w; x++, offs = (offs + 1) % VIDEO_RAM_SIZE) {
-			if (0 == get_video_ram_dirty(offs) &&
-				0 == get_colour_ram_dirty(offs))
-				continue;
-			x0 = screen_x + x * font_w;
-			res_video_ram_dirty(offs);
-			data = mem[VIDEO_RAM_BASE + offs];
-			data = data + font_base[data / 64];
-			attr = mem[COLOUR_RAM_BASE + offs % COLOUR_RAM_SIZE] % 16;
-			pal2[1] = pal_txt[attr];
-			osd_pattern(frame, font, x0, y0, data, 2, pal2, font_w, font_h);
-			if (0 == cursor.on)
-				continue;
-			if (offs != cursor.pos)
+		for (x = 0; x < screen_w; x = x1) {
+			/* collect a run of dirty cells */
+			for (x1 = x; x1 < screen_w && x1 - x < 256; x1++) {
+				o = (offs + x1) % VIDEO_RAM_SIZE;
+				if (0 == get_video_ram_dirty(o) &&
+					0 == get_colour_ram_dirty(o))
+					break;
+				res_video_ram_dirty(o);
+				data = machine->mem[VIDEO_RAM_BASE + o];
+				data = data + font_base[data / 64];
+				attr = machine->mem[COLOUR_RAM_BASE + o % COLOUR_RAM_SIZE] % 16;
+				glyph[x1 - x] = glyph_get(data, attr);
+				if (cursor.on && o == cursor.pos) {
+					set_video_ram_dirty(o);
+					cursor_hit = 1;
+					cursor_x0 = screen_x + x1 * font_w;
+					cursor_y0 = y0;
+					cursor_attr = attr;
+				}
+			}
+			if (x1 == x) {
+				x1++;
 				continue;
-			set_video_ram_dirty(offs);
-			ct = cursor.top * font_h / char_h;
-			ch = (cursor.bottom + 1 - cursor.top) * font_h / char_h;
-			px = osd_color(frame, osd_get_r(pal2[1]), osd_get_g(pal2[1]), osd_get_b(pal2[1]));
-			osd_fillrect(frame, x0, y0 + ct, font_w, ch, px);
+			}
+			for (py = 0; py < font_h; py++) {
+				if (y0 + py < 0 || y0 + py >= frame->h)
+					continue;
+				dst = pixels + (y0 + py) * pitch;
+				x0 = screen_x + x * font_w;
+				for (n = 0; n < x1 - x; n++, x0 += font_w) {
+					const uint8_t *src = glyph[n] + py * glyph_pitch;
+					lo = x0 < 0 ? -x0 : 0;
+					hi = x0 + font_w > frame->w ? frame->w - x0 : font_w;
+					if (lo < hi)
+						memcpy(dst + (x0 + lo) * bytes, src + lo * bytes,
+							(hi - lo) * bytes);
+				}
+			}
+			osd_bitmap_mark(frame, screen_x + x * font_w, y0,
+				(x1 - x) * font_w, font_h);
+		}
+	}
+	osd_bitmap_unlock(frame);
+
+	if (cursor_hit) {
+		ct = cursor.top * font_h / char_h;
+		ch = (cursor.bottom + 1 - cursor.top) * font_h / char_h;
+		osd_fillrect(frame, cursor_x0, cursor_y0 + ct, font_w, ch,
+			video_pixel(cursor_attr));
+	}
+}
+
+/**
+ * @brief set up the presented graphics pixels for the current geometry
+ *
+ * All pixels are unknown after the number of displayed bytes changed.
+ */
+static int gfx_setup(void)
+{
+	uint8_t *shown;
+	uint32_t size = screen_w * screen_h * GFX_PPB;
+
+	if (size == gfx_size)
+		return 0;
+	shown = realloc(gfx_shown, size);
+	if (NULL == shown)
+		return -1;
+	gfx_shown = shown;
+	gfx_size = size;
+	memset(gfx_shown, GFX_NONE, gfx_size);
+	return 0;
+}
+
+/** @brief redraw the graphics pixels of a video RAM byte even if unchanged */
+static void gfx_forget(uint32_t offset)
+{
+	uint32_t pos = (offset + VIDEO_RAM_SIZE - mc6845_get_start(0)) % VIDEO_RAM_SIZE;
+
+	if (pos * GFX_PPB < gfx_size)
+		memset(gfx_shown + pos * GFX_PPB, GFX_NONE, GFX_PPB);
+}
+
+/** @brief write w pixels into a frame scanline, clipped to width pixels */
+static __inline void gfx_hline(uint8_t *dst, int32_t width, int32_t x, int32_t w, int32_t bytes, uint32_t px)
+{
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (x + w > width)
+		w = width - x;
+	for (dst += x * bytes; w > 0; w--, dst += bytes) {
+		switch (bytes) {
+		case 1:
+			dst[0] = (uint8_t)px;
+			break;
+		case 2:
+			*(uint16_t *)dst = (uint16_t)px;
+			break;
+		case 3:
+			dst[0] = (uint8_t)px;
+			dst[1] = (uint8_t)(px >> 8);
+			dst[2] = (uint8_t)(px >> 16);
+			break;
+		default:
+			*(uint32_t *)dst = px;
+			break;
 		}
 	}
 }
 
+/**
+ * @brief render the changed graphics pixels
+ *
+ * Each row of video RAM bytes containing a dirty byte is decoded into a
+ * row of 2 bit pixels and compared with the pixels last presented there.
+ * Only the spans of changed pixels are written into the frame, and each
+ * span is marked as one dirty rectangle.
+ */
 static void video_graphics(void)
 {
+	osd_bitmap_t *frame = osd_frame();
 	uint32_t offs = mc6845_get_start(0);
-	uint32_t x, y, x0, y0;
-	uint32_t w = font_w / 4;
-	uint32_t h = char_h * font_h / FONT_H;
+	int32_t w = font_w / GFX_PPB;
+	int32_t h = char_h * font_h / FONT_H;
+	uint32_t cols = screen_w * GFX_PPB;
 	uint32_t pal[4];
-	uint32_t data, i;
+	uint8_t row[256 * GFX_PPB];
+	uint8_t *shown, *pixels;
+	uint32_t data, dirty, x, y, o, p, p1, i;
+	int32_t x0, x1, y0, py, pitch, bytes;
+
+	if (gfx_setup() < 0)
+		return;
+	/* cgenie_frame() just cleared the screen to the background colour */
+	if (dirty_all)
+		memset(gfx_shown, 0, gfx_size);
 
 	for (i = 0; i < 4; i++) {
 		data = pal_gfx[i];
 		pal[i] = osd_color(frame, osd_get_r(data), osd_get_g(data), osd_get_b(data));
 	}
 
-	for (y = 0; y < screen_h * h; y += h) {
-		y0 = screen_y + y;
-		for (x = 0; x < screen_w; x++, offs = (offs + 1) % VIDEO_RAM_SIZE) {
-			if (0 == get_video_ram_dirty(offs))
+	bytes = (frame->bpp + 7) / 8;
+	pixels = osd_bitmap_lock(frame, &pitch);
+	if (NULL == pixels)
+		return;
+	for (y = 0; y < screen_h; y++, offs = (offs + screen_w) % VIDEO_RAM_SIZE) {
+		dirty = 0;
+		for (x = 0; x < screen_w; x++) {
+			o = (offs + x) % VIDEO_RAM_SIZE;
+			if (0 == get_video_ram_dirty(o))
+				continue;
+			res_video_ram_dirty(o);
+			dirty = 1;
+		}
+		if (0 == dirty)
+			continue;
+
+		/* decode the whole row */
+		for (x = 0; x < screen_w; x++) {
+			data = machine->mem[VIDEO_RAM_BASE + (offs + x) % VIDEO_RAM_SIZE];
+			row[x * GFX_PPB + 0] = (data >> 6) & 3;
+			row[x * GFX_PPB + 1] = (data >> 4) & 3;
+			row[x * GFX_PPB + 2] = (data >> 2) & 3;
+			row[x * GFX_PPB + 3] = (data >> 0) & 3;
+		}
+
+		shown = gfx_shown + y * cols;
+		y0 = screen_y + y * h;
+		for (p = 0; p < cols; p = p1) {
+			if (row[p] == shown[p]) {
+				p1 = p + 1;
 				continue;
-			res_video_ram_dirty(offs);
-			x0 = screen_x + x * font_w;
-			data = mem[VIDEO_RAM_BASE + offs];
-			osd_fillrect(frame, x0 + 0*w, y0, w, h, pal[(data >> 6) & 3]);
-			osd_fillrect(frame, x0 + 1*w, y0, w, h, pal[(data >> 4) & 3]);
-			osd_fillrect(frame, x0 + 2*w, y0, w, h, pal[(data >> 2) & 3]);
-			osd_fillrect(frame, x0 + 3*w, y0, w, h, pal[(data >> 0) & 3]);
+			}
+			/* a span of changed pixels */
+			for (p1 = p + 1; p1 < cols && row[p1] != shown[p1]; p1++)
+				;
+			memcpy(shown + p, row + p, p1 - p);
+			for (py = y0 < 0 ? -y0 : 0; py < h && y0 + py < frame->h; py++) {
+				uint8_t *dst = pixels + (y0 + py) * pitch;
+				for (i = p; i < p1; i++)
+					gfx_hline(dst, frame->w, screen_x + (i / GFX_PPB) * font_w + (i % GFX_PPB) * w,
+						w, bytes, pal[row[i]]);
+			}
+			x0 = screen_x + (p / GFX_PPB) * font_w + (p % GFX_PPB) * w;
+			x1 = screen_x + ((p1 - 1) / GFX_PPB) * font_w + ((p1 - 1) % GFX_PPB) * w + w;
+			osd_bitmap_mark(frame, x0, y0, x1 - x0, h);
 		}
 	}
+	osd_bitmap_unlock(frame);
 }
 
 static int cgenie_resize(int32_t w, int32_t h)
@@ -932,26 +1434,9 @@ static int cgenie_resize(int32_t w, int32_t h)
 	screen_x = hs * fw;
 	screen_y = vs * char_h * fh / FONT_H;
 
-	if (fw != font_w || fh != font_h) {
-		font_w = fw;
-		font_h = fh;
-
-		osd_bitmap_free(&font);
-		osd_bitmap_alloc(&font, font_w * 16, font_h * 24, 8);
-		osd_set_colors(font, pal_txt, 17);
-		osd_render_font(font,
-			chargen,	/* bitmap data */
-			0,		/* first code */
-			256 + 128,	/* count */
-			FONT_W,		/* font width */
-			FONT_H,		/* font height */
-			font_w,		/* scaled font width */
-			font_h,		/* scaled font height */
-			1,		/* line skew */
-			1,		/* bits per pixel */
-			NULL);		/* palette */
-	}
-	osd_set_colors(frame, pal_txt, 17);
+	font_w = fw;
+	font_h = fh;
+	osd_set_colors(osd_frame(), pal_txt, 17);
 	osd_set_colors(NULL, pal_txt, 17);
 
 	dirty_all = (uint32_t)-1;
@@ -966,12 +1451,16 @@ static int cgenie_resize_ext(int32_t w, int32_t h)
 
 static void cgenie_frame(uint32_t param)
 {
+	osd_bitmap_t *frame = osd_frame();
 	uint32_t ch, i, n, size, frame_base;
 
 	ay8910_update_stream();
 
-	osd_display_frequency((uint64_t)50.0 * cycles_this_frame);
-	cycles_this_frame = 0;
+	osd_display_frequency((uint64_t)50.0 * machine->cycles_this_frame);
+	STATS_ENTER(STATS_VIDEO);
+	stats_frame(machine->cycles_this_frame);
+	rewind_frame();
+	machine->cycles_this_frame = 0;
 
 	if (screen_h_changed != mc6845_get_char_lines(0)) {
 		screen_h_changed = mc6845_get_char_lines(0);
@@ -1009,25 +1498,14 @@ static void cgenie_frame(uint32_t param)
 	frame_base = mc6845_get_start(0);
 	size = mc6845_get_char_lines(0) * mc6845_get_char_columns(0);
 
-	/* render modified character generator codes */
+	/* redraw the cells showing modified character generator codes */
 	for (ch = 0; ch < 128; ch++) {
 		if (0 == frame_redraw && 0 == get_font_ram_dirty(ch))
 			continue;
 		res_font_ram_dirty(ch);
-		osd_render_font(font,
-			&mem[FONT_RAM_BASE + FONT_H * ch],
-			256 + ch,	/* first code */
-			1,		/* count */
-			FONT_W,		/* font width */
-			FONT_H,		/* font height */
-			font_w,		/* scaled font width */
-			font_h,		/* scaled font height */
-			1,		/* skew */
-			1,		/* bits per pixel */
-			NULL);		/* palette */
 		for (i = 0; i < size; i++) {
 			uint32_t o1 = (frame_base + i) % VIDEO_RAM_SIZE;
-			if (128 + ch != mem[VIDEO_RAM_BASE + o1])
+			if (128 + ch != machine->mem[VIDEO_RAM_BASE + o1])
 				continue;
 			set_video_ram_dirty(o1);
 		}
@@ -1084,6 +1562,8 @@ static void cgenie_frame(uint32_t param)
 	hpos_old = hpos;
 	vpos_old = vpos;
 
+	video_stall_table();
+
 	/* add flicker caused by accessing the character generator RAM */
 	if (screen_w > 0 && char_h > 0 && conflict_cnt > 0) {
 		uint32_t white = osd_color(frame, 255, 255, 255);
@@ -1103,10 +1583,12 @@ static void cgenie_frame(uint32_t param)
 			osd_fillrect(NULL, x0, y0, w, h, white);
 			osd_fillrect(frame, x0, y0, w, h, white);
 			set_video_ram_dirty(addr);
+			gfx_forget(addr);
 		}
 	}
 	conflict_cnt = 0;
 
+	STATS_LEAVE();
 	stop = osd_update(osd_skip_next_frame());
 }
 
@@ -1139,10 +1621,6 @@ static int cgenie_screen(void)
 	if (NULL == font_ram_dirty)
 		return -1;
 
-	font = calloc(1, sizeof(osd_bitmap_t));
-	if (NULL == font)
-		return -1;
-
 	mc6845_init(1, &mc6845);
 	frame_w = SCREENW * font_w;
 	frame_h = SCREENH * font_h;
@@ -1157,7 +1635,6 @@ static int cgenie_screen(void)
 	}
 	font_w = FONT_W * osd_get_scale();
 	font_h = FONT_H * osd_get_scale();
-	osd_bitmap_alloc(&font, font_w * 16, font_h * 24, 8);
 
 	pal_txt[C_GRAY       ] = osd_rgb(15*4,15*4,15*4);
 	pal_txt[C_CYAN       ] = osd_rgb(0*4,48*4,48*4);
@@ -1176,8 +1653,7 @@ static int cgenie_screen(void)
 	pal_txt[C_MAGENTA    ] = osd_rgb(58*4, 0*4,58*4);
 	pal_txt[C_BRIGHTWHITE] = osd_rgb(63*4,63*4,63*4);
 	pal_txt[C_BACKGROUND ] = osd_rgb(   0,   0,   0);
-	osd_set_colors(font, pal_txt, 17);
-	osd_set_colors(frame, pal_txt, 17);
+	osd_set_colors(osd_frame(), pal_txt, 17);
 	osd_set_colors(NULL, pal_txt, 17);
 
 	pal_gfx[0] = pal_txt[C_BACKGROUND ];
@@ -1190,18 +1666,6 @@ static int cgenie_screen(void)
 	font_base[2] = 0x00;
 	font_base[3] = 0x00;
 
-	osd_render_font(font,
-		chargen,	/* bitmap data */
-		0,		/* first code */
-		256,		/* count */
-		FONT_W,		/* font width */
-		FONT_H,		/* font height */
-		font_w,		/* scaled font width */
-		font_h,		/* scaled font height */
-		1,		/* line skew */
-		1,		/* bits per pixel */
-		NULL);		/* palette */
-
 	return 0;
 }
 
@@ -1210,6 +1674,9 @@ static int cgenie_memory(void)
 	char filename[FILENAME_MAX];
 	FILE *fp;
 
+	machine_map(cgenie_rd_mem, cgenie_wr_mem, cgenie_rd_ptr, cgenie_wr_ptr,
+		cgenie_rd_io, cgenie_wr_io);
+
 	snprintf(filename, sizeof(filename), "%s/%s",
 		sys_get_name(), cgenie_rom);
 	fp = fopen(filename, "rb");
@@ -1217,7 +1684,7 @@ static int cgenie_memory(void)
 		printf("%s not found\n", filename);
 		return -1;
 	}
-	if (MAIN_ROM_SIZE != fread(&mem[MAIN_ROM_BASE], 1, MAIN_ROM_SIZE, fp)) {
+	if (MAIN_ROM_SIZE != fread(&machine->mem[MAIN_ROM_BASE], 1, MAIN_ROM_SIZE, fp)) {
 		printf("%s too small (expected 0x%x)\n", filename, MAIN_ROM_SIZE);
 		return -1;
 	}
@@ -1230,7 +1697,7 @@ static int cgenie_memory(void)
 		printf("%s not found\n", filename);
 		return -1;
 	}
-	if (DOS_ROM_SIZE != fread(&mem[DOS_ROM_BASE], 1, DOS_ROM_SIZE, fp)) {
+	if (DOS_ROM_SIZE != fread(&machine->mem[DOS_ROM_BASE], 1, DOS_ROM_SIZE, fp)) {
 		printf("%s too small (expected 0x%x)\n", filename, DOS_ROM_SIZE);
 		return -1;
 	}
@@ -1244,7 +1711,7 @@ static int cgenie_memory(void)
 		printf("%s not found\n", filename);
 		return -1;
 	}
-	if (EXT_ROM_SIZE != fread(&mem[EXT_ROM_BASE], 1, EXT_ROM_SIZE, fp)) {
+	if (EXT_ROM_SIZE != fread(&machine->mem[EXT_ROM_BASE], 1, EXT_ROM_SIZE, fp)) {
 		printf("%s too small (expected 0x%x)\n", filename, EXT_ROM_SIZE);
 		return -1;
 	}
@@ -1285,23 +1752,76 @@ static void cgenie_clock(uint32_t param)
 	cgenie_timer_interrupt();
 }
 
-static void cgenie_scan(uint32_t param)
+/** @brief save state: redraw the whole frame after loading */
+static void cgenie_postload(void)
 {
-	/* steal cycles for the video DMA (screen width RAM accesses) */
-	z80_dma += screen_w;
+	frame_redraw = 1;
+	dirty_all = (uint32_t)-1;
+	glyph_flush();
+	stall_geometry = 0;
+	video_stall_table();
 }
 
-int main(int argc, char **argv)
+/** @brief register the state of the video and I/O */
+static void cgenie_state(void)
+{
+	STATE_ITEM("cgenie", 0, pal_txt);
+	STATE_ITEM("cgenie", 0, pal_gfx);
+	STATE_ITEM("cgenie", 0, gfx_mode);
+	STATE_ITEM("cgenie", 0, font_base);
+	STATE_ITEM("cgenie", 0, screen_w);
+	STATE_ITEM("cgenie", 0, screen_h);
+	STATE_ITEM("cgenie", 0, char_h);
+	STATE_ITEM("cgenie", 0, hpos);
+	STATE_ITEM("cgenie", 0, vpos);
+	STATE_ITEM("cgenie", 0, screen_w_changed);
+	STATE_ITEM("cgenie", 0, screen_h_changed);
+	STATE_ITEM("cgenie", 0, char_h_changed);
+	STATE_ITEM("cgenie", 0, hpos_old);
+	STATE_ITEM("cgenie", 0, vpos_old);
+	STATE_ITEM("cgenie", 0, port_ff);
+	STATE_ITEM("cgenie", 0, conflict_pos);
+	STATE_ITEM("cgenie", 0, conflict_cnt);
+	state_register_timer("cgenie", 0, "frame_timer", &frame_timer);
+	state_register_timer("cgenie", 0, "clock_timer", &clock_timer);
+	state_register_hooks(NULL, cgenie_postload);
+}
+
+/**
+ * @brief run a Colour Genie on the current machine
+ *
+ * Sets up the display, memory, devices and the batch, stats, state and
+ * debug options from the command line and runs until the user quits or
+ * the -c cycle budget is used up.
+ *
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @result returns 0 on success, or the number of the step which failed
+ */
+int cgenie_run(int argc, char **argv)
 {
-	z80_cpu_t *cpu = &z80;
+	z80_cpu_t *cpu = &machine->cpu;
 	int dumpmem;
+	int blocks;
+	int jit;
+	int idle;
+	const char *profile;
 	int i;
 
-	for (i = 1, dumpmem = 0; i < argc; i++)
+	for (i = 1, dumpmem = 0, blocks = 0, jit = 0, idle = 0, profile = NULL; i < argc; i++) {
 		if (!strcmp(argv[i], "-d"))
 			dumpmem = 1;
+		if (!strcmp(argv[i], "-b"))
+			blocks = 1;
+		if (!strcmp(argv[i], "-j"))
+			blocks = jit = 1;
+		if (!strcmp(argv[i], "-i"))
+			idle = 1;
+		if (!strcmp(argv[i], "-P") && i + 1 < argc)
+			profile = argv[i + 1];
+	}
 
-	if (osd_init(cgenie_resize_ext, NULL, cgenie_key_dn, cgenie_key_up, argc, argv))
+	if (osd_init(cgenie_resize_ext, NULL, batch_key_dn, batch_key_up, argc, argv))
 		return 1;
 	osd_set_refresh_rate(50.0);
 
@@ -1317,8 +1837,45 @@ int main(int argc, char **argv)
 		printf("ROM loading: failed\n");
 		return 3;
 	}
+	if (batch_init(argc, argv, cgenie_key_dn, cgenie_key_up,
+		cgenie_kbd_map(), 8) < 0) {
+		printf("Batch setup: failed\n");
+		return 4;
+	}
+	if (stats_init(argc, argv) < 0) {
+		printf("Stats setup: failed\n");
+		return 5;
+	}
+	if (state_init(argc, argv) < 0) {
+		printf("State setup: failed\n");
+		return 7;
+	}
 
 	z80_reset(cpu);
+	if (blocks) {
+		/* cache code from ROM, video RAM and RAM, but not from I/O */
+		z80_bc_enable(0x0000, COLOUR_RAM_BASE);
+	}
+	if (jit && z80_jit_enable(Z80_JIT_HOT) < 0)
+		printf("JIT: not available, using the interpreter\n");
+	if (idle) {
+		char filename[FILENAME_MAX];
+		snprintf(filename, sizeof(filename), "%s/%s.idle",
+			sys_get_name(), sys_get_name());
+		z80_idle_load(filename);
+	}
+	if (NULL != profile && z80_prof_enable() < 0) {
+		printf("Profile setup: failed\n");
+		return 6;
+	}
+	if (debug_init(argc, argv) < 0) {
+		printf("Debug setup: failed\n");
+		return 8;
+	}
+	if (trace_init(argc, argv) < 0) {
+		printf("Trace setup: failed\n");
+		return 9;
+	}
 	cgenie_cas_init();
 	cgenie_fdc_init();
 	frame_redraw = 1;
@@ -1326,15 +1883,35 @@ int main(int argc, char **argv)
 		0, tmr_double_to_time(TIME_IN_MSEC(20)));
 	clock_timer = tmr_alloc(cgenie_clock, tmr_double_to_time(TIME_IN_MSEC(25)),
 		0, tmr_double_to_time(TIME_IN_MSEC(25)));
-	scan_timer = tmr_alloc(cgenie_scan, tmr_double_to_time(TIME_IN_HZ(8000)),
-		0, tmr_double_to_time(TIME_IN_HZ(8000)));
+	cgenie_kbd_init();
+	cgenie_state();
+	if (state_start() < 0) {
+		printf("State loading: failed\n");
+		return 7;
+	}
+	if (rewind_init(argc, argv) < 0) {
+		printf("Rewind setup: failed\n");
+		return 7;
+	}
 
-	while (!stop)
-		tmr_run_cpu(cpu, 2216800.0);
+	while (!stop && !batch_done()) {
+		tmr_run_cpu(cpu, CPU_CLOCK);
+		state_poll();
+		rewind_poll();
+	}
+	batch_result();
+	batch_exit();
+	rewind_exit();
+	debug_exit();
+	trace_exit();
+	state_exit();
+	stats_exit();
+	if (NULL != profile)
+		z80_prof_write(profile);
 
 	if (dumpmem) {
 		FILE *fp = fopen("cgenie.mem", "wb");
-		fwrite(mem, 1, MEMSIZE, fp);
+		fwrite(machine->mem, 1, MEMSIZE, fp);
 		fclose(fp);
 	}
 
@@ -1343,3 +1920,10 @@ int main(int argc, char **argv)
 	osd_exit();
 	return 0;
 }
+
+#if	!defined(NO_MAIN)
+int main(int argc, char **argv)
+{
+	return cgenie_run(argc, argv);
+}
+#endif
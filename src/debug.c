@@ -0,0 +1,256 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * debug.c	PC breakpoints, memory and I/O watchpoints
+ *
+ * Breakpoints are kept by the Z80 core in a bitmap of addresses, and
+ * only instructions on pages with a breakpoint are checked.
+ *
+ * Watchpoints replace the rd_mem/wr_mem entries (and clear the direct
+ * pointers) of the pages containing watched addresses with wrappers,
+ * which report the access and pass it on to the page's original handler
+ * or pointer. I/O watchpoints replace all rd_io/wr_io entries, since
+ * the high byte of a port address is whatever is in B or A.
+ *
+ * When nothing is armed no page entry is replaced and the run loop
+ * does not check anything.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "debug.h"
+
+/** @brief non zero if watchpoints are installed */
+static MACHINE_LOCAL int enabled;
+
+/** @brief bitmap of watched memory reads */
+static MACHINE_LOCAL uint8_t rd_map[MEMSIZE/8];
+
+/** @brief bitmap of watched memory writes */
+static MACHINE_LOCAL uint8_t wr_map[MEMSIZE/8];
+
+/** @brief bitmap of watched I/O port reads */
+static MACHINE_LOCAL uint8_t in_map[256/8];
+
+/** @brief bitmap of watched I/O port writes */
+static MACHINE_LOCAL uint8_t out_map[256/8];
+
+/** @brief the pages' read handlers while a wrapper is installed */
+static MACHINE_LOCAL uint8_t (*orig_rd[L1SIZE])(uint32_t addr);
+
+/** @brief the pages' direct read pointers while a wrapper is installed */
+static MACHINE_LOCAL uint8_t *orig_rd_ptr[L1SIZE];
+
+/** @brief the pages' write handlers while a wrapper is installed */
+static MACHINE_LOCAL void (*orig_wr[L1SIZE])(uint32_t addr, uint8_t data);
+
+/** @brief the pages' direct write pointers while a wrapper is installed */
+static MACHINE_LOCAL uint8_t *orig_wr_ptr[L1SIZE];
+
+/** @brief the pages' I/O read handlers while a wrapper is installed */
+static MACHINE_LOCAL uint8_t (*orig_in[L1SIZE])(uint32_t addr);
+
+/** @brief the pages' I/O write handlers while a wrapper is installed */
+static MACHINE_LOCAL void (*orig_out[L1SIZE])(uint32_t addr, uint8_t data);
+
+#define	TEST(map,n)	((map)[(n) / 8] & (1 << ((n) % 8)))
+
+/** @brief report a watchpoint hit */
+static void debug_hit(const char *what, uint32_t addr, uint8_t data)
+{
+	printf("watch: %s %04x %02x\n", what, addr, data);
+	z80_dump_state(&machine->cpu);
+}
+
+/** @brief report a breakpoint hit */
+static void debug_break(uint32_t pc)
+{
+	printf("break: %04x\n", pc);
+	z80_dump_state(&machine->cpu);
+}
+
+/** @brief memory read wrapper */
+static uint8_t debug_rd(uint32_t addr)
+{
+	uint32_t page = addr >> L1SHIFT;
+	uint8_t data;
+
+	if (NULL != orig_rd_ptr[page])
+		data = orig_rd_ptr[page][addr & L1MASK];
+	else
+		data = (*orig_rd[page])(addr);
+	/* opcode and argument fetches read from PC */
+	if (TEST(rd_map, addr) && addr != z80_get_reg(&machine->cpu, Z80_PC))
+		debug_hit("rd", addr, data);
+	return data;
+}
+
+/** @brief memory write wrapper */
+static void debug_wr(uint32_t addr, uint8_t data)
+{
+	uint32_t page = addr >> L1SHIFT;
+
+	if (TEST(wr_map, addr))
+		debug_hit("wr", addr, data);
+	if (NULL != orig_wr_ptr[page])
+		orig_wr_ptr[page][addr & L1MASK] = data;
+	else
+		(*orig_wr[page])(addr, data);
+}
+
+/** @brief I/O read wrapper */
+static uint8_t debug_in(uint32_t addr)
+{
+	uint8_t data = (*orig_in[addr >> L1SHIFT])(addr);
+
+	if (TEST(in_map, addr & 0xff))
+		debug_hit("in", addr, data);
+	return data;
+}
+
+/** @brief I/O write wrapper */
+static void debug_out(uint32_t addr, uint8_t data)
+{
+	if (TEST(out_map, addr & 0xff))
+		debug_hit("out", addr, data);
+	(*orig_out[addr >> L1SHIFT])(addr, data);
+}
+
+/** @brief parse an address range first[-last] in hex */
+static int debug_range(const char *arg, uint32_t size, uint32_t *first, uint32_t *last)
+{
+	char *end;
+
+	*first = strtoul(arg, &end, 16);
+	*last = *first;
+	if ('-' == *end)
+		*last = strtoul(end + 1, &end, 16);
+	if (end == arg || '\0' != *end || *first > *last || *last >= size) {
+		printf("Debug: invalid range '%s'\n", arg);
+		return -1;
+	}
+	return 0;
+}
+
+/** @brief mark a range in a bitmap */
+static void debug_mark(uint8_t *map, uint32_t first, uint32_t last)
+{
+	uint32_t n;
+
+	for (n = first; n <= last; n++)
+		map[n / 8] |= 1 << (n % 8);
+}
+
+/** @brief return non zero if any address of a page is marked */
+static int debug_page(const uint8_t *map, uint32_t page)
+{
+	uint32_t n;
+
+	for (n = page << L1SHIFT; n < (page + 1) << L1SHIFT; n += 8)
+		if (map[n / 8])
+			return 1;
+	return 0;
+}
+
+/** @brief install the wrappers on the pages with watched addresses */
+static void debug_arm(void)
+{
+	uint32_t page, n;
+	int io_rd = 0, io_wr = 0;
+
+	for (n = 0; n < sizeof(in_map); n++) {
+		io_rd |= in_map[n];
+		io_wr |= out_map[n];
+	}
+	for (page = 0; page < L1SIZE; page++) {
+		if (debug_page(rd_map, page)) {
+			orig_rd[page] = machine->rd_mem[page];
+			orig_rd_ptr[page] = machine->rd_ptr[page];
+			machine->rd_mem[page] = debug_rd;
+			machine->rd_ptr[page] = NULL;
+		}
+		if (debug_page(wr_map, page)) {
+			orig_wr[page] = machine->wr_mem[page];
+			orig_wr_ptr[page] = machine->wr_ptr[page];
+			machine->wr_mem[page] = debug_wr;
+			machine->wr_ptr[page] = NULL;
+		}
+		if (io_rd) {
+			orig_in[page] = machine->rd_io[page];
+			machine->rd_io[page] = debug_in;
+		}
+		if (io_wr) {
+			orig_out[page] = machine->wr_io[page];
+			machine->wr_io[page] = debug_out;
+		}
+	}
+}
+
+/** @brief set up breakpoints and watchpoints from the command line options */
+int debug_init(int argc, char **argv)
+{
+	uint32_t first, last;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-bp")) {
+			if (debug_range(argv[++i], MEMSIZE, &first, &last) < 0)
+				return -1;
+			while (first <= last)
+				z80_break_set(first++, debug_break);
+		} else if (!strcmp(argv[i], "-wr")) {
+			if (debug_range(argv[++i], MEMSIZE, &first, &last) < 0)
+				return -1;
+			debug_mark(rd_map, first, last);
+			enabled = 1;
+		} else if (!strcmp(argv[i], "-ww")) {
+			if (debug_range(argv[++i], MEMSIZE, &first, &last) < 0)
+				return -1;
+			debug_mark(wr_map, first, last);
+			enabled = 1;
+		} else if (!strcmp(argv[i], "-wi")) {
+			if (debug_range(argv[++i], 256, &first, &last) < 0)
+				return -1;
+			debug_mark(in_map, first, last);
+			enabled = 1;
+		} else if (!strcmp(argv[i], "-wo")) {
+			if (debug_range(argv[++i], 256, &first, &last) < 0)
+				return -1;
+			debug_mark(out_map, first, last);
+			enabled = 1;
+		}
+	}
+	if (enabled)
+		debug_arm();
+	return 0;
+}
+
+/** @brief remove the watchpoints and breakpoints */
+void debug_exit(void)
+{
+	uint32_t page;
+
+	for (page = 0; page < L1SIZE; page++) {
+		if (debug_rd == machine->rd_mem[page]) {
+			machine->rd_mem[page] = orig_rd[page];
+			machine->rd_ptr[page] = orig_rd_ptr[page];
+		}
+		if (debug_wr == machine->wr_mem[page]) {
+			machine->wr_mem[page] = orig_wr[page];
+			machine->wr_ptr[page] = orig_wr_ptr[page];
+		}
+		if (debug_in == machine->rd_io[page])
+			machine->rd_io[page] = orig_in[page];
+		if (debug_out == machine->wr_io[page])
+			machine->wr_io[page] = orig_out[page];
+	}
+	memset(machine->bp_map, 0, sizeof(machine->bp_map));
+	machine->bp_pages = 0;
+	memset(rd_map, 0, sizeof(rd_map));
+	memset(wr_map, 0, sizeof(wr_map));
+	memset(in_map, 0, sizeof(in_map));
+	memset(out_map, 0, sizeof(out_map));
+	enabled = 0;
+}
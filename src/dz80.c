@@ -32,6 +32,52 @@ uint32_t nalloc = 0;
 #define	COMMENT_COLUMN	48
 #define	MAX_COLUMN	76
 
+static int cmp_defs(const void *p1, const void *p2)
+{
+	const uint32_t i1 = *(const uint32_t *)p1;
+	const uint32_t i2 = *(const uint32_t *)p2;
+	if (dasm[i1].addr != dasm[i2].addr)
+		return dasm[i1].addr < dasm[i2].addr ? -1 : 1;
+	return i1 < i2 ? -1 : i1 > i2 ? 1 : 0;
+}
+
+/**
+ * @brief sort the definitions by address and terminate them
+ *
+ * Definitions from several files (e.g. a hand written .def and a
+ * profile written by z80_prof_write()) are merged. Entries with the
+ * same address keep the order in which they were loaded, so the first
+ * file decides the type. An entry past the end of memory stops the
+ * linear scans of get_dasm() and get_length().
+ */
+static int sort_defs(void)
+{
+	uint32_t *idx, i;
+	dasm_t *tmp;
+
+	idx = calloc(ndasm + 1, sizeof(uint32_t));
+	tmp = calloc(ndasm + 1, sizeof(dasm_t));
+	if (NULL == idx || NULL == tmp) {
+		perror("sort_defs: calloc()");
+		free(idx);
+		free(tmp);
+		return -1;
+	}
+	for (i = 0; i < ndasm; i++)
+		idx[i] = i;
+	qsort(idx, ndasm, sizeof(uint32_t), cmp_defs);
+	for (i = 0; i < ndasm; i++)
+		tmp[i] = dasm[idx[i]];
+	tmp[ndasm].addr = 0x10000;
+	tmp[ndasm].type = DASM_NONE;
+	tmp[ndasm].comment = "";
+	free(idx);
+	free(dasm);
+	dasm = tmp;
+	nalloc = ndasm + 1;
+	return 0;
+}
+
 int load_defs(const char *filename)
 {
 	char line[1024], *eol, *src;
@@ -117,7 +163,8 @@ int load_defs(const char *filename)
 		d->comment = strdup(src);
 		ndasm++;
 	}
-	return 0;
+	fclose(fp);
+	return sort_defs();
 }
 
 const dasm_t *get_dasm(uint32_t addr)
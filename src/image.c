@@ -7,6 +7,7 @@
  *
  *****************************************************************************/
 #include "image.h"
+#include "machine.h"
 
 #define	IMG_DEBUG	1
 
@@ -48,7 +49,10 @@ typedef struct img_s {
 	void (*drive_ready_callback)(struct img_s *, uint32_t);
 }	img_t;
 
-static img_t *images = NULL;
+static MACHINE_LOCAL img_t *images = NULL;
+
+/* filenames of mounted images */
+static MACHINE_LOCAL char *mounts[IMG_TYPE_MAX][IMG_MAX_MOUNT];
 
 /*****************************************************************************
  * @brief search list of major/minor handles forn an initialized image
@@ -86,7 +90,11 @@ img_t *img_file(uint32_t major, uint32_t minor)
 	img->tag = IMG_TAG;
 	img->major = major;
 	img->minor = minor;
-	switch (img->major) {
+	if (NULL != img_mounted(major, minor)) {
+		snprintf(img->filename, sizeof(img->filename),
+			"%s", img_mounted(major, minor));
+		img->exists = (0 == stat(img->filename, &st));
+	} else switch (img->major) {
 	case IMG_TYPE_ROM:
 		snprintf(img->filename, sizeof(img->filename),
 			"%s/rom/rom%u.img",
@@ -568,7 +576,11 @@ img_t *img_fopen(const char *filename, uint32_t major, const char *mode)
 	img->tag = IMG_TAG;
 	img->major = major;
 	img->minor = 0;
-	switch (major) {
+	/* a filename with a path is used as is */
+	if (NULL != strchr(filename, '/')) {
+		snprintf(img->filename, sizeof(img->filename),
+			"%s", filename);
+	} else switch (major) {
 	case IMG_TYPE_ROM: /* ROM image */
 		snprintf(img->filename, sizeof(img->filename),
 			"%s/rom/%s", sys_get_name(), filename);
@@ -626,6 +638,50 @@ img_t *img_fopen(const char *filename, uint32_t major, const char *mode)
 	return img;
 }
 
+/*****************************************************************************
+ * img_mount
+ * Entry:
+ *	major number of device
+ *	minor number of device
+ *	filename of the image
+ * Return:
+ *	0 on success, -1 on error
+ * Description:
+ *	Mounts a file as the image for a major/minor type, overriding
+ *	the default filename. This must be done before the image handle
+ *	is first used through img_file().
+ *****************************************************************************/
+
+int img_mount(uint32_t major, uint32_t minor, const char *filename)
+{
+	if (major >= IMG_TYPE_MAX || minor >= IMG_MAX_MOUNT)
+		return -1;
+	free(mounts[major][minor]);
+	mounts[major][minor] = NULL;
+	if (NULL == filename)
+		return 0;
+	mounts[major][minor] = strdup(filename);
+	if (NULL == mounts[major][minor])
+		return -1;
+	return 0;
+}
+
+/*****************************************************************************
+ * img_mounted
+ * Entry:
+ *	major number of device
+ *	minor number of device
+ * Return:
+ *	filename of the mounted image, or NULL if there is none
+ *****************************************************************************/
+
+const char *img_mounted(uint32_t major, uint32_t minor)
+{
+	if (major >= IMG_TYPE_MAX || minor >= IMG_MAX_MOUNT)
+		return NULL;
+	return mounts[major][minor];
+}
+
 /*****************************************************************************
  * img_fclose
  * Entry:
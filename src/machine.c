@@ -0,0 +1,45 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * machine.c	Machine context
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "machine.h"
+
+/** @brief the machine of this thread */
+MACHINE_LOCAL machine_t machine_this;
+
+/** @brief free the timers, block cache and profile of this thread's machine */
+void machine_exit(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < machine->ti; i++)
+		free(machine->timers[i]);
+	machine->ti = 0;
+	z80_bc_free(machine->bc);
+	machine->bc = NULL;
+	free(machine->prof);
+	machine->prof = NULL;
+}
+
+/** @brief install the memory and I/O maps of the current machine */
+void machine_map(uint8_t (* const rd[L1SIZE])(uint32_t),
+	void (* const wr[L1SIZE])(uint32_t, uint8_t),
+	const uint32_t rd_page[L1SIZE], const uint32_t wr_page[L1SIZE],
+	uint8_t (* const rdio[L1SIZE])(uint32_t),
+	void (* const wrio[L1SIZE])(uint32_t, uint8_t))
+{
+	uint32_t page;
+
+	for (page = 0; page < L1SIZE; page++) {
+		machine->rd_mem[page] = rd[page];
+		machine->wr_mem[page] = wr[page];
+		machine->rd_ptr[page] = U32INVALID == rd_page[page] ? NULL : &machine->mem[rd_page[page]];
+		machine->wr_ptr[page] = U32INVALID == wr_page[page] ? NULL : &machine->mem[wr_page[page]];
+		machine->rd_io[page] = rdio[page];
+		machine->wr_io[page] = wrio[page];
+	}
+}
@@ -7,6 +7,7 @@
  *
  *****************************************************************************/
 #include "mc6845.h"
+#include "state.h"
 
 /*****************************************************************************
  *    This code emulates the functionality of the 6845 chip, and also
@@ -43,6 +44,7 @@
 #define CRTC6845_HORIZONTAL_SYNC REG(2)
 #define CRTC6845_HORIZONTAL_POS (CRTC6845_CHARS_TOTAL - CRTC6845_HORIZONTAL_SYNC)
 #define CRTC6845_LINES_TOTAL (REG(4) + 1)
+#define CRTC6845_TOTAL_ADJUST (REG(5) & 31)
 #define CRTC6845_CHAR_LINES REG(6)
 #define CRTC6845_VERTICAL_SYNC REG(7)
 #define CRTC6845_VERTICAL_POS (CRTC6845_LINES_TOTAL - CRTC6845_VERTICAL_SYNC)
@@ -72,7 +74,7 @@ typedef struct {
 	uint8_t ndx;
 	int32_t cursor_on;
 	int32_t cursor_count;
-	void *timer;
+	tmr_t *timer;
 }	mc6845_t;
 
 typedef struct regmask_s {
@@ -80,8 +82,8 @@ typedef struct regmask_s {
 	uint8_t read_mask;
 }	regmask_t;
 
-static mc6845_t *mc6845;
-static uint32_t num_chips;
+static MACHINE_LOCAL mc6845_t *mc6845;
+static MACHINE_LOCAL uint32_t num_chips;
 
 /***************************************************************************
  *
@@ -177,6 +179,12 @@ int32_t mc6845_init(uint32_t num, ifc6845_t *config)
 		mc6845[num].ifc = *config;
 		mc6845[num].timer = tmr_alloc(mc6845_timer_callback,
 			time_zero, num, tmr_double_to_time(TIME_IN_HZ(50.0/8)));
+		STATE_ITEM("mc6845", num, mc6845[num].ifc.freq);
+		STATE_ITEM("mc6845", num, mc6845[num].reg);
+		STATE_ITEM("mc6845", num, mc6845[num].ndx);
+		STATE_ITEM("mc6845", num, mc6845[num].cursor_on);
+		STATE_ITEM("mc6845", num, mc6845[num].cursor_count);
+		state_register_timer("mc6845", num, "timer", &mc6845[num].timer);
 
 		/* Hardwire the values which can't be changed in the PC1512 version */
 		if (config->type == M6845_TYPE_PC1512) {
@@ -218,6 +226,24 @@ static void mc6845_timer_callback(uint32_t chip)
 		(*crtc->ifc.cursor_changed)(chip, &cursor);
 }
 
+uint32_t mc6845_get_chars_total(uint32_t chip)
+{
+	mc6845_t *crtc = &mc6845[chip];
+	return CRTC6845_CHARS_TOTAL;
+}
+
+uint32_t mc6845_get_lines_total(uint32_t chip)
+{
+	mc6845_t *crtc = &mc6845[chip];
+	return CRTC6845_LINES_TOTAL;
+}
+
+uint32_t mc6845_get_total_adjust(uint32_t chip)
+{
+	mc6845_t *crtc = &mc6845[chip];
+	return CRTC6845_TOTAL_ADJUST;
+}
+
 uint32_t mc6845_get_char_columns(uint32_t chip) 
 { 
 	mc6845_t *crtc = &mc6845[chip];
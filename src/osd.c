@@ -6,33 +6,19 @@
  * Copyright Juergen Buchmueller <pullmoll@t-online.de>
  *
  *****************************************************************************/
+#include <pthread.h>
 #include "osd.h"
+#include "machine.h"
+#include "stats.h"
 
-osd_bitmap_t *frame = NULL;
+/** @brief log2 of the width and height of a dirty tile */
+#define	OSD_TILE_SHIFT	3
 
-static int32_t throttle = 1;
-static int32_t fullscreen = 0;
-static int32_t frameskip = 0;
-static int32_t autoframeskip = 1;
-static int32_t max_autoframeskip = 8;
-static int32_t start_video = 0;
-static int32_t scale = 2;
+/** @brief width and height of a dirty tile */
+#define	OSD_TILE	(1 << OSD_TILE_SHIFT)
 
-static SDL_Rect *dirty;
-static uint32_t dirty_count = 0;
-static uint32_t dirty_alloc = 0;
-
-static int32_t display_w;
-static int32_t display_h;
-
-static int32_t mousex;
-static int32_t mousey;
-static int32_t mouseb;
-
-static SDL_AudioSpec *audio_spec_desired;
-static SDL_AudioSpec *audio_spec_obtained;
-static uint32_t sample_rate = 48000;
-static double refresh_rate = 50.0;
+/** @brief maximum number of dirty rectangles per frame */
+#define	OSD_DIRTY_MAX	256
 
 #define	SBUFF_SIZE	16384
 typedef struct sbuff_s {
@@ -42,36 +28,11 @@ typedef struct sbuff_s {
 	int16_t buffer[SBUFF_SIZE];
 }	sbuff_t;
 
-static sbuff_t *sbuff;
-
-static char osd_title[256];
-
-static SDL_Surface *screen = NULL;
-static SDL_Cursor *cursor = NULL;
-
-static int (*resize_callback)(int32_t, int32_t) = NULL;
-
-static void (*keydn_callback)(void *cookie, osd_key_t *) = NULL;
-static void (*keyup_callback)(void *cookie, osd_key_t *) = NULL;
-static void *cookie_callback = NULL;
-
-static void (*keydn_osd_local)(void *cookie, osd_key_t *) = NULL;
-static void (*keyup_osd_local)(void *cookie, osd_key_t *) = NULL;
-static void *cookie_local = NULL;
-
-static osd_bitmap_t *font;
-
-static osd_bitmap_t *ctrl_panel;
-static int32_t ctrl_panel_on = 0;
-
-static osd_bitmap_t *cpu_panel;
-static int32_t cpu_panel_on = 0;
+#define	FRAMESKIP_LEVELS 12
 
-static size_t xngsize;
-static mng_t *mng;
+#define	UCLOCKS_PER_SEC 1000000
 
-#define	FONT_W	6
-#define	FONT_H	10
+typedef long uclock_t;
 
 typedef enum {
 	WID_NONE,
@@ -94,6 +55,97 @@ typedef struct {
 	widget_id_ctrl_t id;
 }	cookie_local_t;
 
+/**
+ * @brief display, input, audio and frame pacing state of a machine
+ *
+ * osd_init() allocates it for the current machine and osd_exit() frees it.
+ * SDL itself is shared by all machines of the process; when running
+ * headless each machine renders to its own offscreen screen surface.
+ * SDL has a single event queue, so only the machine which set up SDL
+ * reads it; it gets the keys of the one display and the quit request.
+ */
+typedef struct osd_s {
+	/** @brief the emulated machine's display bitmap */
+	osd_bitmap_t *frame;
+
+	int32_t throttle;
+	int32_t fullscreen;
+	int32_t frameskip;
+	int32_t autoframeskip;
+	int32_t max_autoframeskip;
+	int32_t start_video;
+	int32_t headless;
+	/** @brief non zero if this machine reads the SDL event queue */
+	int32_t events;
+	int32_t scale;
+
+	osd_dirty_t screen_dirty;
+	SDL_Rect dirty[OSD_DIRTY_MAX];
+	uint32_t dirty_count;
+
+	int32_t display_w;
+	int32_t display_h;
+
+	int32_t mousex;
+	int32_t mousey;
+	int32_t mouseb;
+
+	SDL_AudioSpec *audio_spec_desired;
+	SDL_AudioSpec *audio_spec_obtained;
+	uint32_t sample_rate;
+	double refresh_rate;
+
+	sbuff_t *sbuff;
+
+	char osd_title[256];
+
+	SDL_Surface *screen;
+	SDL_Cursor *cursor;
+
+	int (*resize_callback)(int32_t, int32_t);
+
+	void (*keydn_callback)(void *cookie, osd_key_t *);
+	void (*keyup_callback)(void *cookie, osd_key_t *);
+	void *cookie_callback;
+
+	void (*keydn_osd_local)(void *cookie, osd_key_t *);
+	void (*keyup_osd_local)(void *cookie, osd_key_t *);
+	void *cookie_local;
+	/** @brief cookie of the control panel's edit field */
+	cookie_local_t cookie_edit;
+
+	osd_bitmap_t *font;
+
+	osd_bitmap_t *ctrl_panel;
+	int32_t ctrl_panel_on;
+
+	osd_bitmap_t *cpu_panel;
+	int32_t cpu_panel_on;
+
+	size_t xngsize;
+	mng_t *mng;
+	/** @brief comment chunk of the MNG stream */
+	char mng_comment[256];
+	/** @brief author chunk of the MNG stream */
+	char mng_author[256];
+
+	int32_t frameskip_counter;
+	uclock_t prev_frames[FRAMESKIP_LEVELS];
+	uclock_t prev;
+	int32_t speed;
+	int32_t frameskipadjust;
+}	osd_t;
+
+/** @brief serializes the process wide SDL setup in osd_init() and osd_exit() */
+static pthread_mutex_t sdl_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief number of machines between osd_init() and osd_exit() */
+static int sdl_users;
+
+#define	FONT_W	6
+#define	FONT_H	10
+
+
 /****************************************
  * forward declarations
  ****************************************/
@@ -297,12 +349,6 @@ static const uint8_t chargen_6x10[] = {
 	0xff,  0x00,0x50,0x00,0x88,0x88,0x98,0x68,0x08,0x88,0x70
 };
 
-#define	FRAMESKIP_LEVELS 12
-
-#define	UCLOCKS_PER_SEC 1000000
-
-typedef long uclock_t;
-
 uclock_t uclock(void)
 {
 
@@ -316,90 +362,221 @@ uclock_t uclock(void)
 }
 
 /**
- * @brief add a dirty rectangle to the screen surface
- * @param dst destination rectangle
+ * @brief set up a grid of dirty tiles for a surface size
+ *
+ * @param d pointer to the grid
+ * @param w width of the surface
+ * @param h height of the surface
+ * @result returns 0 on success, -1 on error
  */
-static __inline void osd_screen_dirty(SDL_Rect *dst)
+static int osd_dirty_alloc(osd_dirty_t *d, int32_t w, int32_t h)
 {
-	SDL_Rect *r;
-	uint32_t n;
+	uint32_t cols = (w + OSD_TILE - 1) >> OSD_TILE_SHIFT;
+	uint32_t rows = (h + OSD_TILE - 1) >> OSD_TILE_SHIFT;
+	uint32_t words = (cols + 31) / 32;
+	uint32_t *bits;
 
-	if (NULL == screen)
-		return;
+	bits = realloc(d->bits, 2 * sizeof(uint32_t) * words * (rows ? rows : 1));
+	if (NULL == bits)
+		return -1;
+	memset(bits, 0, sizeof(uint32_t) * words * rows);
+	d->bits = bits;
+	d->w = w;
+	d->h = h;
+	d->cols = cols;
+	d->rows = rows;
+	d->words = words;
+	d->top = rows;
+	d->bottom = 0;
+	return 0;
+}
 
-	/* check if area is already dirty */
-	for (n = 0; n < dirty_count; n++) {
-		r = &dirty[n];
-		if (dst->y >= r->y &&
-			dst->y + dst->h <= r->y + r->h &&
-			dst->x >= r->x &&
-			dst->x + dst->w <= r->x + r->w) {
-				return;
-			}
-	}
-	/* try to combine the dirty rectangle with an existing one */
-	for (n = 0; n < dirty_count; n++) {
-		r = &dirty[n];
-		if (dst->y == r->y && dst->h == r->h) {
-			if (r->x + r->w == dst->x) {
-				r->w = r->w + dst->w;
-				if (r->x + r->w > screen->w)
-					r->w = screen->w - r->x;
-				return;
-			}
-			if (dst->x + dst->w == r->x) {
-				r->x = dst->x;
-				r->w = r->w + dst->w;
-				if (r->x + r->w > screen->w)
-					r->w = screen->w - r->x;
-				return;
-			}
-		}
-		if (dst->x == r->x && dst->w == r->w) {
-			if (r->y + r->h == dst->y) {
-				r->h = r->h + dst->h;
-				if (r->y + r->h > screen->h)
-					r->h = screen->h - r->y;
-				return;
-			}
-			if (dst->y + dst->h == r->y) {
-				r->y = dst->y;
-				r->h = r->h + dst->h;
-				if (r->y + r->h > screen->h)
-					r->h = screen->h - r->y;
-				return;
-			}
-		}
-	}
-	if (dirty_count >= dirty_alloc) {
-		dirty_alloc = dirty_alloc ? dirty_alloc * 2 : 32;
-		dirty = realloc(dirty, dirty_alloc * sizeof(SDL_Rect));
-		if (NULL == dirty)
-			osd_die("realloc() dirty rects");
-	}
-	memcpy(&dirty[dirty_count], dst, sizeof(*dst));
-	r = &dirty[dirty_count];
-	if (r->x < 0) {
-		r->w += r->x;
-		r->x = 0;
-	}
-	if (r->y < 0) {
-		r->h += r->y;
-		r->y = 0;
+/** @brief free a grid of dirty tiles */
+static void osd_dirty_free(osd_dirty_t *d)
+{
+	free(d->bits);
+	memset(d, 0, sizeof(*d));
+}
+
+/** @brief mark all tiles as clean */
+static void osd_dirty_clear(osd_dirty_t *d)
+{
+	if (d->top < d->bottom)
+		memset(d->bits + d->top * d->words, 0,
+			sizeof(uint32_t) * d->words * (d->bottom - d->top));
+	d->top = d->rows;
+	d->bottom = 0;
+}
+
+/** @brief set or clear the bits x0 to x1 - 1 of a row of tiles */
+static __inline void osd_dirty_fill(uint32_t *row, uint32_t x0, uint32_t x1, int set)
+{
+	uint32_t mask;
+
+	while (x0 < x1) {
+		mask = ~0u << (x0 % 32);
+		if (x1 - (x0 & ~31u) < 32)
+			mask &= ~(~0u << (x1 % 32));
+		if (set)
+			row[x0 / 32] |= mask;
+		else
+			row[x0 / 32] &= ~mask;
+		x0 = (x0 & ~31u) + 32;
 	}
-	if (r->x + r->w > screen->w) {
-		r->w = screen->w - r->x;
+}
+
+/** @brief return non zero if the bits x0 to x1 - 1 of a row of tiles are all set */
+static __inline int osd_dirty_test(const uint32_t *row, uint32_t x0, uint32_t x1)
+{
+	uint32_t mask;
+
+	while (x0 < x1) {
+		mask = ~0u << (x0 % 32);
+		if (x1 - (x0 & ~31u) < 32)
+			mask &= ~(~0u << (x1 % 32));
+		if (mask != (row[x0 / 32] & mask))
+			return 0;
+		x0 = (x0 & ~31u) + 32;
 	}
-	if (r->y + r->h > screen->h) {
-		r->h = screen->h - r->y;
+	return 1;
+}
+
+/** @brief return the first bit from x on which is set (val 1) or clear (val 0) */
+static __inline uint32_t osd_dirty_find(const uint32_t *row, uint32_t x, uint32_t cols, int val)
+{
+	uint32_t bits;
+
+	while (x < cols) {
+		bits = (val ? row[x / 32] : ~row[x / 32]) >> (x % 32);
+		if (0 != bits)
+			return x + __builtin_ctz(bits) < cols ? x + __builtin_ctz(bits) : cols;
+		x = (x & ~31u) + 32;
 	}
-	if (r->w <= 0 || r->h <= 0)
+	return cols;
+}
+
+/**
+ * @brief mark the tiles covering a rectangle as dirty
+ *
+ * @param d pointer to the grid
+ * @param dst rectangle, clipped to the grid's surface size
+ */
+static void osd_dirty_add(osd_dirty_t *d, SDL_Rect *dst)
+{
+	int32_t x0 = dst->x, y0 = dst->y;
+	int32_t x1 = dst->x + dst->w, y1 = dst->y + dst->h;
+	uint32_t y;
+
+	if (NULL == d->bits)
 		return;
-	if (r->x > screen->w || r->y > screen->h)
+	if (x0 < 0)
+		x0 = 0;
+	if (y0 < 0)
+		y0 = 0;
+	if (x1 > d->w)
+		x1 = d->w;
+	if (y1 > d->h)
+		y1 = d->h;
+	if (x0 >= x1 || y0 >= y1)
 		return;
-	dirty_count++;
+	x0 >>= OSD_TILE_SHIFT;
+	y0 >>= OSD_TILE_SHIFT;
+	x1 = (x1 - 1) >> OSD_TILE_SHIFT;
+	y1 = (y1 - 1) >> OSD_TILE_SHIFT;
+	for (y = y0; y <= (uint32_t)y1; y++)
+		osd_dirty_fill(d->bits + y * d->words, x0, x1 + 1, 1);
+	if ((uint32_t)y0 < d->top)
+		d->top = y0;
+	if ((uint32_t)y1 + 1 > d->bottom)
+		d->bottom = y1 + 1;
 }
 
+/**
+ * @brief merge the dirty tiles into rectangles
+ *
+ * Runs of dirty tiles in a row are extended downwards as long as the
+ * rows below have the same run dirty. If there would be more than max
+ * rectangles, the last one is the bounding box of the remaining tiles.
+ * The tiles stay dirty.
+ *
+ * @param d pointer to the grid
+ * @param rects array of max rectangles to fill
+ * @param max maximum number of rectangles
+ * @result number of rectangles
+ */
+static uint32_t osd_dirty_rects(osd_dirty_t *d, SDL_Rect *rects, uint32_t max)
+{
+	uint32_t *bits, *row;
+	uint32_t n = 0, x0, x1, y, y1, bx0, bx1, by0, by1;
+
+	if (d->top >= d->bottom || 0 == max)
+		return 0;
+	/* work on a copy of the dirty rows */
+	bits = d->bits + d->words * d->rows;
+	memcpy(bits + d->top * d->words, d->bits + d->top * d->words,
+		sizeof(uint32_t) * d->words * (d->bottom - d->top));
+
+	for (y = d->top; y < d->bottom; y++) {
+		row = bits + y * d->words;
+		for (x0 = osd_dirty_find(row, 0, d->cols, 1); x0 < d->cols;
+			x0 = osd_dirty_find(row, x1, d->cols, 1)) {
+			if (n + 1 == max) {
+				/* the bounding box of what is left */
+				bx0 = x0;
+				bx1 = x0 + 1;
+				by0 = y;
+				by1 = y + 1;
+				for (/* */; y < d->bottom; y++, x0 = 0) {
+					row = bits + y * d->words;
+					x0 = osd_dirty_find(row, x0, d->cols, 1);
+					if (x0 >= d->cols)
+						continue;
+					for (x1 = x0; x1 < d->cols; x1 = osd_dirty_find(row, x1, d->cols, 1)) {
+						x1 = osd_dirty_find(row, x1, d->cols, 0);
+						if (x1 > bx1)
+							bx1 = x1;
+					}
+					if (x0 < bx0)
+						bx0 = x0;
+					by1 = y + 1;
+				}
+				x0 = bx0;
+				x1 = bx1;
+				y = by0;
+				y1 = by1;
+			} else {
+				x1 = osd_dirty_find(row, x0, d->cols, 0);
+				for (y1 = y + 1; y1 < d->bottom; y1++) {
+					if (0 == osd_dirty_test(bits + y1 * d->words, x0, x1))
+						break;
+					osd_dirty_fill(bits + y1 * d->words, x0, x1, 0);
+				}
+			}
+			rects[n].x = x0 << OSD_TILE_SHIFT;
+			rects[n].y = y << OSD_TILE_SHIFT;
+			rects[n].w = ((x1 << OSD_TILE_SHIFT) < (uint32_t)d->w ?
+				(x1 << OSD_TILE_SHIFT) : (uint32_t)d->w) - rects[n].x;
+			rects[n].h = ((y1 << OSD_TILE_SHIFT) < (uint32_t)d->h ?
+				(y1 << OSD_TILE_SHIFT) : (uint32_t)d->h) - rects[n].y;
+			if (++n == max)
+				return n;
+		}
+	}
+	return n;
+}
+
+/**
+ * @brief add a dirty rectangle to the screen surface
+ * @param dst destination rectangle
+ */
+static __inline void osd_screen_dirty(SDL_Rect *dst)
+{
+	osd_t *osd = machine->osd;
+
+	if (NULL == osd->screen)
+		return;
+	osd_dirty_add(&osd->screen_dirty, dst);
+}
 
 /**
  * @brief update dirty rectangles from a bitmap to the screen
@@ -409,17 +586,18 @@ static __inline void osd_screen_dirty(SDL_Rect *dst)
  */
 static __inline void osd_bitmap_update(osd_bitmap_t *bitmap)
 {
-	SDL_Rect dst;
-	uint32_t n;
+	SDL_Rect rects[OSD_DIRTY_MAX], dst;
+	uint32_t n, count;
 
 	if (NULL == bitmap)
 		return;
 
-	for (n = 0; n < bitmap->dirty_count; n++) {
-		dst = bitmap->dirty[n];
+	count = osd_dirty_rects(&bitmap->dirty, rects, OSD_DIRTY_MAX);
+	osd_dirty_clear(&bitmap->dirty);
+	for (n = 0; n < count; n++) {
+		dst = rects[n];
 		osd_blit(NULL, bitmap, bitmap->x + dst.x, bitmap->y + dst.y, dst.w, dst.h, dst.x, dst.y);
 	}
-	bitmap->dirty_count = 0;
 }
 
 /**
@@ -430,79 +608,11 @@ static __inline void osd_bitmap_update(osd_bitmap_t *bitmap)
  */
 static __inline void osd_bitmap_dirty(osd_bitmap_t *bitmap, SDL_Rect *dst)
 {
-	SDL_Rect *r;
-	uint32_t n;
-
 	if (NULL == bitmap) {
 		osd_screen_dirty(dst);
 		return;
 	}
-
-	/* check if area is already dirty */
-	for (n = 0; n < bitmap->dirty_count; n++) {
-		r = &bitmap->dirty[n];
-		if (dst->y >= r->y &&
-			dst->y + dst->h <= r->y + r->h &&
-			dst->x >= r->x &&
-			dst->x + dst->w <= r->x + r->w) {
-				return;
-			}
-	}
-	/* try to combine the dirty rectangle with an existing one */
-	for (n = 0; n < bitmap->dirty_count; n++) {
-		r = &bitmap->dirty[n];
-		if (dst->y == r->y && dst->h == r->h) {
-			if (r->x + r->w == dst->x) {
-				r->w = r->w + dst->w;
-				return;
-			}
-			if (dst->x + dst->w == r->x) {
-				r->x = dst->x;
-				r->w = r->w + dst->w;
-				return;
-			}
-		}
-		if (dst->x == r->x && dst->w == r->w) {
-			if (r->y + r->h == dst->y) {
-				r->h = r->h + dst->h;
-				return;
-			}
-			if (dst->y + dst->h == r->y) {
-				r->y = dst->y;
-				r->h = r->h + dst->h;
-				return;
-			}
-		}
-	}
-	if (bitmap->dirty_count >= bitmap->dirty_alloc) {
-		bitmap->dirty_alloc = bitmap->dirty_alloc ? bitmap->dirty_alloc * 2 : 32;
-		bitmap->dirty = realloc(bitmap->dirty, bitmap->dirty_alloc * sizeof(SDL_Rect));
-		if (NULL == bitmap->dirty)
-			osd_die("realloc() dirty rects");
-	}
-	
-	memcpy(&bitmap->dirty[bitmap->dirty_count], dst, sizeof(*dst));
-	r = &bitmap->dirty[bitmap->dirty_count];
-	if (r->x < 0) {
-		r->w += r->x;
-		r->x = 0;
-	}
-	if (r->y < 0) {
-		r->h += r->y;
-		r->y = 0;
-	}
-	if (r->x + r->w > bitmap->w) {
-		r->w = bitmap->w - r->x;
-	}
-	if (r->y + r->h > bitmap->h) {
-		r->h = bitmap->h - r->y;
-	}
-	if (r->w <= 0 || r->h <= 0)
-		return;
-	if (r->x > bitmap->w || r->y > bitmap->h)
-		return;
-
-	bitmap->dirty_count++;
+	osd_dirty_add(&bitmap->dirty, dst);
 }
 
 /**
@@ -530,6 +640,7 @@ void osd_die(const char *fmt, ...)
  */
 int32_t osd_bitmap_alloc(osd_bitmap_t **pbitmap, int32_t width, int32_t height, int32_t depth)
 {
+	osd_t *osd = machine->osd;
 	osd_bitmap_t *bitmap;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Color palette[2];
@@ -541,11 +652,11 @@ int32_t osd_bitmap_alloc(osd_bitmap_t **pbitmap, int32_t width, int32_t height,
 		osd_die("calloc(%d,%d) failed\n", 1, sizeof(osd_bitmap_t));
 
 	if (-1 == width)
-		width = screen->w;
+		width = osd->screen->w;
 	if (-1 == height)
-		height = screen->h;
+		height = osd->screen->h;
 	if (-1 == depth)
-		depth = screen->format->BitsPerPixel;
+		depth = osd->screen->format->BitsPerPixel;
 
 	flags = SDL_SWSURFACE | SDL_ASYNCBLIT | SDL_SRCCOLORKEY;
 	rmask = 0;
@@ -606,6 +717,11 @@ int32_t osd_bitmap_alloc(osd_bitmap_t **pbitmap, int32_t width, int32_t height,
 		return -1;
 
 	memset(bitmap, 0, sizeof(*bitmap));
+	if (osd_dirty_alloc(&bitmap->dirty, width, height) < 0) {
+		SDL_FreeSurface(dst_surface);
+		free(bitmap);
+		return -1;
+	}
 	bitmap->w = width;
 	bitmap->h = height;
 	bitmap->bpp = depth;
@@ -623,6 +739,105 @@ int32_t osd_bitmap_alloc(osd_bitmap_t **pbitmap, int32_t width, int32_t height,
 	return 0;
 }
 
+/**
+ * @brief return a hash of the pixels of a bitmap
+ *
+ * @param bitmap pointer to the osd_bitmap_t structure to hash
+ * @result FNV-1a hash of the pixel data, row by row
+ */
+uint32_t osd_bitmap_hash(osd_bitmap_t *bitmap)
+{
+	SDL_Surface *surface;
+	uint32_t hash = 2166136261u;
+	const uint8_t *row;
+	int32_t x, y, bytes;
+
+	if (NULL == bitmap || NULL == bitmap->_private)
+		return 0;
+	surface = (SDL_Surface *)bitmap->_private;
+	if (NULL == surface->pixels)
+		return 0;
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+	bytes = surface->w * surface->format->BytesPerPixel;
+	for (y = 0; y < surface->h; y++) {
+		row = (const uint8_t *)surface->pixels + y * surface->pitch;
+		for (x = 0; x < bytes; x++)
+			hash = (hash ^ row[x]) * 16777619u;
+	}
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+	return hash;
+}
+
+/**
+ * @brief lock a bitmap for direct access to its pixels
+ *
+ * @param bitmap pointer to the osd_bitmap_t structure to lock
+ * @param pitch pointer to an int32_t receiving the bytes per row
+ * @result pointer to the top left pixel, or NULL if there are none
+ */
+uint8_t *osd_bitmap_lock(osd_bitmap_t *bitmap, int32_t *pitch)
+{
+	SDL_Surface *surface;
+
+	if (NULL == bitmap || NULL == bitmap->_private)
+		return NULL;
+	surface = (SDL_Surface *)bitmap->_private;
+	if (NULL == surface->pixels)
+		return NULL;
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+	*pitch = surface->pitch;
+	return (uint8_t *)surface->pixels;
+}
+
+/**
+ * @brief unlock a bitmap locked with osd_bitmap_lock()
+ *
+ * @param bitmap pointer to the osd_bitmap_t structure to unlock
+ */
+void osd_bitmap_unlock(osd_bitmap_t *bitmap)
+{
+	SDL_Surface *surface;
+
+	if (NULL == bitmap || NULL == bitmap->_private)
+		return;
+	surface = (SDL_Surface *)bitmap->_private;
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+}
+
+/**
+ * @brief mark a rectangle of a bitmap as modified
+ *
+ * Use this after writing to the pixels of a locked bitmap.
+ *
+ * @param bitmap pointer to the bitmap (NULL = screen surface)
+ * @param x left x coordinate of the rectangle
+ * @param y top y coordinate of the rectangle
+ * @param w width of the rectangle
+ * @param h height of the rectangle
+ */
+void osd_bitmap_mark(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+	SDL_Rect dst;
+
+	if (NULL == bitmap) {
+		dst.x = x;
+		dst.y = y;
+		dst.w = w;
+		dst.h = h;
+		osd_screen_dirty(&dst);
+		return;
+	}
+	dst.x = x * bitmap->xscale;
+	dst.y = y * bitmap->yscale;
+	dst.w = w * bitmap->xscale;
+	dst.h = h * bitmap->yscale;
+	osd_bitmap_dirty(bitmap, &dst);
+}
+
 /**
  * @brief free a bitmap handle
  *
@@ -649,12 +864,7 @@ void osd_bitmap_free(osd_bitmap_t **pbitmap)
 		SDL_FreeSurface(dst_surface);
 		bitmap->_private = NULL;
 	}
-	if (NULL != bitmap->dirty) {
-		free(bitmap->dirty);
-		bitmap->dirty = NULL;
-	}
-	bitmap->dirty_count = 0;
-	bitmap->dirty_alloc = 0;
+	osd_dirty_free(&bitmap->dirty);
 	free(bitmap);
 	*pbitmap = NULL;
 }
@@ -852,11 +1062,12 @@ int32_t osd_hittest(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t b)
  */
 uint32_t osd_color(osd_bitmap_t *bitmap, int32_t r, int32_t g, int32_t b)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface)
-		dst_surface = screen;
+		dst_surface = osd->screen;
 
 	if (NULL == dst_surface)
 		return 0;
@@ -876,11 +1087,12 @@ uint32_t osd_color(osd_bitmap_t *bitmap, int32_t r, int32_t g, int32_t b)
  */
 uint32_t osd_color_alpha(osd_bitmap_t *bitmap, int32_t r, int32_t g, int32_t b, int32_t a)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface)
-		dst_surface = screen;
+		dst_surface = osd->screen;
 
 	if (NULL == dst_surface)
 		return 0;
@@ -898,12 +1110,13 @@ uint32_t osd_color_alpha(osd_bitmap_t *bitmap, int32_t r, int32_t g, int32_t b,
  */
 void osd_set_clip(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t h)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect dst;
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 	}
 	if (0 == w && 0 == h) {
 		SDL_SetClipRect(dst_surface, NULL);
@@ -928,13 +1141,14 @@ void osd_set_clip(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t
  */
 void osd_putpixel(osd_bitmap_t *bitmap, int32_t x, int32_t y, uint32_t pixel)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect dst;
 
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 		dst.x = x;
 		dst.y = y;
 		dst.w = 1;
@@ -961,13 +1175,14 @@ void osd_putpixel(osd_bitmap_t *bitmap, int32_t x, int32_t y, uint32_t pixel)
  */
 uint32_t osd_getpixel(osd_bitmap_t *bitmap, int32_t x, int32_t y)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	uint8_t *p;
 
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 	} else {
 		x = x * bitmap->xscale;
 		y = y * bitmap->yscale;
@@ -1024,13 +1239,14 @@ uint32_t osd_getpixel(osd_bitmap_t *bitmap, int32_t x, int32_t y)
  */
 void osd_vline(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t h, uint32_t pixel)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect dst;
 
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 		dst.x = x;
 		dst.y = y;
 		dst.w = 1;
@@ -1060,13 +1276,14 @@ void osd_vline(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t h, uint32_t p
  */
 void osd_hline(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, uint32_t pixel)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect dst;
 
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 		dst.x = x;
 		dst.y = y;
 		dst.w = w;
@@ -1126,13 +1343,14 @@ void osd_framerect(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_
  */
 void osd_fillrect(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t pixel)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect dst;
 
 	if (NULL != bitmap)
 		dst_surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 		dst.x = x;
 		dst.y = y;
 		dst.w = w;
@@ -1166,6 +1384,7 @@ void osd_fillrect(osd_bitmap_t *bitmap, int32_t x, int32_t y, int32_t w, int32_t
  */
 void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
 {
+	osd_t *osd = machine->osd;
 	int32_t x, y, w, h, len;
 	uint32_t fg, tl0, br0, tl1, br1, black;
 	uint32_t colors[2], i;
@@ -1197,7 +1416,7 @@ void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
 		x = 2;
 		y = (widget->rect.h - h) / 2;
 		for (i = 0; i < strlen(widget->text); i++) {
-			osd_pattern(bitmap, font,
+			osd_pattern(bitmap, osd->font,
 				x + widget->rect.x,
 				y + widget->rect.y,
 				widget->text[i],
@@ -1234,7 +1453,7 @@ void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
 					colors[0] = black;
 					colors[1] = fg;
 				}
-				osd_pattern(bitmap, font, x, y, ch, 2, colors, FONT_W, FONT_H);
+				osd_pattern(bitmap, osd->font, x, y, ch, 2, colors, FONT_W, FONT_H);
 				x += FONT_W;
 			}
 		}
@@ -1283,7 +1502,7 @@ void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
 		x = widget->rect.h + 2;
 		y = (widget->rect.h - h) / 2;
 		for (i = 0; i < strlen(widget->text); i++) {
-			osd_pattern(bitmap, font,
+			osd_pattern(bitmap, osd->font,
 				x + widget->rect.x,
 				y + widget->rect.y,
 				widget->text[i],
@@ -1325,7 +1544,7 @@ void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
 			y++;
 		}
 		for (i = 0; i < strlen(widget->text); i++) {
-			osd_pattern(bitmap, font,
+			osd_pattern(bitmap, osd->font,
 				x + widget->rect.x,
 				y + widget->rect.y,
 				widget->text[i],
@@ -1345,6 +1564,7 @@ void osd_widget_update(osd_bitmap_t *bitmap, osd_widget_t *widget)
  */
 void osd_set_colors(osd_bitmap_t *bitmap, uint32_t *colors, uint32_t ncolors)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *surface = NULL;
 	SDL_Color palette[256];
 	uint32_t i;
@@ -1352,7 +1572,7 @@ void osd_set_colors(osd_bitmap_t *bitmap, uint32_t *colors, uint32_t ncolors)
 	if (NULL != bitmap)
 		surface = (SDL_Surface *)bitmap->_private;
 	if (NULL == surface)
-		surface = screen;
+		surface = osd->screen;
 	for (i = 0; i < ncolors; i++)
 		osd_u32_to_sdl_color(&palette[i], colors[i]);
 	SDL_SetColors(surface, palette, 0, ncolors);
@@ -1372,6 +1592,7 @@ void osd_set_colors(osd_bitmap_t *bitmap, uint32_t *colors, uint32_t ncolors)
  */
 void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t sx, int32_t sy, int32_t w, int32_t h, int32_t dx, int32_t dy)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *src_surface = NULL;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Rect src_rect, dst_rect;
@@ -1379,7 +1600,7 @@ void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t sx, int32_t sy, int3
 	if (NULL != src)
 		src_surface = (SDL_Surface *)src->_private;
 	if (NULL == src_surface) {
-		src_surface = screen;
+		src_surface = osd->screen;
 		/* source rectangle */
 		src_rect.x = sx;
 		src_rect.y = sy;
@@ -1395,7 +1616,7 @@ void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t sx, int32_t sy, int3
 	if (NULL != dst)
 		dst_surface = (SDL_Surface *)dst->_private;
 	if (NULL == dst_surface) {
-		dst_surface = screen;
+		dst_surface = osd->screen;
 		/* destination rectangle */
 		dst_rect.x = dx;
 		dst_rect.y = dy;
@@ -1411,7 +1632,7 @@ void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t sx, int32_t sy, int3
 
 	SDL_SetColorKey(src_surface, 0, 0);
 	SDL_BlitSurface(src_surface, &src_rect, dst_surface, &dst_rect);
-	if (dst_surface == screen)
+	if (dst_surface == osd->screen)
 		osd_screen_dirty(&dst_rect);
 	else
 		osd_bitmap_dirty(dst, &dst_rect);
@@ -1423,12 +1644,20 @@ void osd_blit(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t sx, int32_t sy, int3
  */
 int32_t osd_get_scale(void)
 {
-	return scale;
+	return machine->osd->scale;
+}
+
+/**
+ * @brief return the display bitmap of the current machine
+ */
+osd_bitmap_t *osd_frame(void)
+{
+	return machine->osd->frame;
 }
 
 static const char *humanize(size_t size)
 {
-	static char buff[32];
+	static MACHINE_LOCAL char buff[32];
 	size_t rem;
 	if (size < 1024) {
 		snprintf(buff, sizeof(buff), "%u", (unsigned)size);
@@ -1447,10 +1676,11 @@ static const char *humanize(size_t size)
 
 static int write_fp(void *cookie, uint8_t *data, int size)
 {
+	osd_t *osd = machine->osd;
 	int rc = 0;
 	if (size != fwrite(data, 1, size, (FILE *)cookie))
 		rc = -1;
-	xngsize += size;
+	osd->xngsize += size;
 	return rc;
 }
 
@@ -1459,14 +1689,13 @@ static int write_fp(void *cookie, uint8_t *data, int size)
  */
 int32_t osd_mng_start(void)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *surface;
-	static char comment[256];
-	static char author[256];
-	static char filename[FILENAME_MAX];
+	char filename[FILENAME_MAX];
 	FILE *fp;
 	int i;
 
-	if (NULL != mng)
+	if (NULL != osd->mng)
 		osd_mng_stop();
 
 	snprintf(filename, sizeof(filename), "%s/screen.mng",
@@ -1476,21 +1705,21 @@ int32_t osd_mng_start(void)
 		fprintf(stderr, "Cannot create osd_mng file '%s'\n", filename);
 		return -1;
 	}
-	surface = (SDL_Surface *)frame->_private;
-	mng = mng_create(frame->w, frame->h, refresh_rate, fp, write_fp);
-	if (NULL == mng) {
+	surface = (SDL_Surface *)osd->frame->_private;
+	osd->mng = mng_create(osd->frame->w, osd->frame->h, osd->refresh_rate, fp, write_fp);
+	if (NULL == osd->mng) {
 		fprintf(stderr, "Cannot create MNG stream (%s)\n", strerror(errno));
 		return -1;
 	}
 	for (i = 0; i < surface->format->palette->ncolors; i++) {
 		SDL_Color *p = &surface->format->palette->colors[i];
-		mng_set_palette(mng, i, PNG_RGB(p->r, p->g, p->b));
+		mng_set_palette(osd->mng, i, PNG_RGB(p->r, p->g, p->b));
 	}
-	snprintf(comment, sizeof(comment), "%s screen MNG", sys_get_name());
-	mng->comment = comment;
-	snprintf(author, sizeof(author), "Emulator osd.c");
-	mng->author = author;
-	xngsize = 0;
+	snprintf(osd->mng_comment, sizeof(osd->mng_comment), "%s screen MNG", sys_get_name());
+	osd->mng->comment = osd->mng_comment;
+	snprintf(osd->mng_author, sizeof(osd->mng_author), "Emulator osd.c");
+	osd->mng->author = osd->mng_author;
+	osd->xngsize = 0;
 	return 0;
 }
 
@@ -1499,42 +1728,44 @@ int32_t osd_mng_start(void)
  */
 int32_t osd_mng_stop(void)
 {
+	osd_t *osd = machine->osd;
 	char title[256];
 	FILE *fp;
 	off_t pos;
 	int frames;
 
-	if (NULL == mng)
+	if (NULL == osd->mng)
 		return -1;
 
-	fp = xng_get_cookie(mng);
+	fp = xng_get_cookie(osd->mng);
 	if (NULL == fp)
 		return -1;
 
-	frames = mng_get_fcount(mng);
+	frames = mng_get_fcount(osd->mng);
 
 	/* remember where we are and seek to the file pos where the MHDR is */
 	pos = ftell(fp);
 	fseek(fp, 8, SEEK_SET);
 
 	/* re-write the MHDR chunk with the (now) known counts */
-	mng_write_MHDR(mng);
+	mng_write_MHDR(osd->mng);
 
 	/* seek to where we were and finish the mng */
 	fseek(fp, pos, SEEK_SET);
-	mng_finish(mng);
+	mng_finish(osd->mng);
 
-	mng = NULL;
+	osd->mng = NULL;
 	fclose(fp);
 
 	snprintf(title, sizeof(title), "%s - %s [%d frames; %s]",
-			osd_title, "finished", frames, humanize(xngsize));
-	SDL_WM_SetCaption(title, osd_title);
+			osd->osd_title, "finished", frames, humanize(osd->xngsize));
+	SDL_WM_SetCaption(title, osd->osd_title);
 	return 0;
 }
 
 static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, int w, int h)
 {
+	osd_t *osd = machine->osd;
 	png_t *png;
 	int i, px, py;
 
@@ -1545,7 +1776,7 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
 	case 1:
 		switch (surface->format->BitsPerPixel) {
 		case 1:	/* monochrome surface */
-			png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
+			png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
 			if (NULL == png)
 				osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 			png_blit_from_gray1(png, 0, 0, x, y, w, h,
@@ -1553,7 +1784,7 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
 				(uint32_t*)surface->format->palette->colors, 0xff);
 			break;
 		case 2:	/* 4 grays surface */
-			png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
+			png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
 			if (NULL == png)
 				osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 			png_blit_from_gray2(png, 0, 0, x, y, w, h,
@@ -1561,7 +1792,7 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
 				(uint32_t*)surface->format->palette->colors, 0xff);
 			break;
 		case 4:	/* 16 grays surface */
-			png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
+			png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
 			if (NULL == png)
 				osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 			png_blit_from_gray4(png, 0, 0, x, y, w, h,
@@ -1569,7 +1800,7 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
 				(uint32_t*)surface->format->palette->colors, 0xff);
 			break;
 		case 8:	/* paletteized surface */
-			png = mng_append_png(mng, frame, x, y, w, h, COLOR_PALETTE, 8);
+			png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_PALETTE, 8);
 			if (NULL == png)
 				osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 			for (i = 0; i < surface->format->palette->ncolors; i++) {
@@ -1583,21 +1814,21 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
 		}
 		break;
 	case 3:	/* 8:8:8 RGB surface */
-		png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
+		png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
 		if (NULL == png)
 			osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 		png_blit_from_rgb8(png, 0, 0, x, y, w, h,
 			surface->pixels, surface->pitch, NULL, 0xff);
 		break;
 	case 4:	/* 8:8:8:8 RGB(A) surface */
-		png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBALPHA, 8);
+		png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBALPHA, 8);
 		if (NULL == png)
 			osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 		png_blit_from_rgba8(png, 0, 0, x, y, w, h,
 			surface->pixels, surface->pitch, NULL, 0xff);
 		break;
 	default:
-		png = mng_append_png(mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
+		png = mng_append_png(osd->mng, frame, x, y, w, h, COLOR_RGBTRIPLE, 8);
 		if (NULL == png)
 			osd_die("mng_append_png() failed (%s)\n", strerror(errno));
 		/* slow copy */
@@ -1617,51 +1848,53 @@ static void osd_mng_frame_write(SDL_Surface *surface, int frame, int x, int y, i
  */
 int32_t osd_mng_frame(void)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *surface;
 	char title[256];
 	int n, frames;
 
 	/* recording is off, or simulation is paused */
-	if (NULL == mng)
+	if (NULL == osd->mng)
 		return -1;
-	if (NULL == frame)
+	if (NULL == osd->frame)
 		return -1;
-	surface = (SDL_Surface *)frame->_private;
+	surface = (SDL_Surface *)osd->frame->_private;
 	if (NULL == surface)
 		return -1;
 
-	if (0 == dirty_count) {
+	if (0 == osd->dirty_count) {
 		osd_mng_frame_write(surface, 1, 0, 0, 1, 1);
 	} else {
-		for (n = 0; n < dirty_count; n++) {
-			SDL_Rect *r = &dirty[n];
+		for (n = 0; n < osd->dirty_count; n++) {
+			SDL_Rect *r = &osd->dirty[n];
 			osd_mng_frame_write(surface,
-				n + 1 == dirty_count ? 1 : 0,
+				n + 1 == osd->dirty_count ? 1 : 0,
 				r->x, r->y, r->w, r->h);
 		}
 	}
 
 	/* write the progress info to the border */
-	frames = mng_get_fcount(mng);
+	frames = mng_get_fcount(osd->mng);
 	snprintf(title, sizeof(title), "%s - %s [%d frames; %s]",
-		osd_title, "recording", frames, humanize(xngsize));
-	SDL_WM_SetCaption(title, osd_title);
+		osd->osd_title, "recording", frames, humanize(osd->xngsize));
+	SDL_WM_SetCaption(title, osd->osd_title);
 	return 0;
 }
 
 int32_t osd_save_snapshot(void)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *surface;
-	static uint32_t no;
+	static MACHINE_LOCAL uint32_t no;
 	char filename[FILENAME_MAX];
 	struct stat st;
 	FILE *fp = NULL;
 	png_t *png = NULL;
 	int32_t x, y, w, h, i, rc;
 
-	if (NULL == frame)
+	if (NULL == osd->frame)
 		return -1;
-	surface = (SDL_Surface *)frame->_private;
+	surface = (SDL_Surface *)osd->frame->_private;
 	if (NULL == surface)
 		return -1;
 	do {
@@ -1811,21 +2044,24 @@ static int32_t make_cursor(unsigned char *pix, unsigned char *msk,
 
 int32_t osd_get_display(int32_t *w, int32_t *h)
 {
-	if (NULL == screen)
+	osd_t *osd = machine->osd;
+
+	if (NULL == osd->screen)
 		return -1;
-	*w = screen->w;
-	*h = screen->h;
+	*w = osd->screen->w;
+	*h = osd->screen->h;
 	return 0;
 }
 
 void osd_set_display(int32_t w, int32_t h)
 {
-	display_w = w;
-	display_h = h;
+	machine->osd->display_w = w;
+	machine->osd->display_h = h;
 }
 
 int32_t osd_open_display(int32_t width, int32_t height, const char *title)
 {
+	osd_t *osd = machine->osd;
 	uint8_t bits[128];
 	uint8_t mask[128];
 	uint32_t bg, rmask, gmask, bmask, amask;
@@ -1845,87 +2081,101 @@ int32_t osd_open_display(int32_t width, int32_t height, const char *title)
 	amask = 0xff000000;
 #endif
 
-	flags = SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_RESIZABLE | (fullscreen ? SDL_FULLSCREEN : 0);
-	screen = SDL_SetVideoMode(width, height, 8, flags);
-	if (NULL == screen) {
-		osd_die("SDL_SetVideoMode(%d,%d,%d,0x%x) failed\n",
-			width, height, 8, flags);
+	if (osd->headless) {
+		/* the video mode is process wide: each machine gets its own surface */
+		flags = SDL_SWSURFACE;
+		osd->screen = SDL_CreateRGBSurface(flags, width, height, 8, 0, 0, 0, 0);
+		if (NULL == osd->screen) {
+			osd_die("SDL_CreateRGBSurface(0x%x,%d,%d,%d) failed\n",
+				flags, width, height, 8);
+		}
+	} else {
+		flags = SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_RESIZABLE | (osd->fullscreen ? SDL_FULLSCREEN : 0);
+		osd->screen = SDL_SetVideoMode(width, height, 8, flags);
+		if (NULL == osd->screen) {
+			osd_die("SDL_SetVideoMode(%d,%d,%d,0x%x) failed\n",
+				width, height, 8, flags);
+		}
 	}
+	if (osd_dirty_alloc(&osd->screen_dirty, osd->screen->w, osd->screen->h) < 0)
+		osd_die("osd_dirty_alloc(%d,%d) failed\n", osd->screen->w, osd->screen->h);
 
-	osd_bitmap_alloc(&frame, width, height, 8);
+	osd_bitmap_alloc(&osd->frame, width, height, 8);
 
-	osd_bitmap_alloc(&font, 16 * FONT_W, 16 * FONT_H, 8);
+	osd_bitmap_alloc(&osd->font, 16 * FONT_W, 16 * FONT_H, 8);
 	for (i = 0, src = chargen_6x10; i < 256; i++) {
 		if (i != *src)
 			continue;
 		src++;
-		osd_render_font(font, src, i, 1, FONT_W, FONT_H, FONT_W, FONT_H, 1, 1, NULL);
+		osd_render_font(osd->font, src, i, 1, FONT_W, FONT_H, FONT_W, FONT_H, 1, 1, NULL);
 		src += FONT_H;
 	}
 
-	osd_bitmap_alloc(&ctrl_panel, width, 20, 32);
-	ctrl_panel->x = 0;
-	ctrl_panel->y = 0;
-	osd_fillrect(ctrl_panel, 0, 0, ctrl_panel->w, ctrl_panel->h,
-		osd_color(ctrl_panel, 0xdf, 0xdf, 0xdf));
+	osd_bitmap_alloc(&osd->ctrl_panel, width, 20, 32);
+	osd->ctrl_panel->x = 0;
+	osd->ctrl_panel->y = 0;
+	osd_fillrect(osd->ctrl_panel, 0, 0, osd->ctrl_panel->w, osd->ctrl_panel->h,
+		osd_color(osd->ctrl_panel, 0xdf, 0xdf, 0xdf));
 
-	osd_bitmap_alloc(&cpu_panel, width, 28, 32);
-	cpu_panel->x = 0;
-	cpu_panel->y = screen->h - cpu_panel->h;
-	osd_fillrect(cpu_panel, 0, 0, cpu_panel->w, cpu_panel->h,
-		osd_color(cpu_panel, 0xdf, 0xdf, 0xdf));
+	osd_bitmap_alloc(&osd->cpu_panel, width, 28, 32);
+	osd->cpu_panel->x = 0;
+	osd->cpu_panel->y = osd->screen->h - osd->cpu_panel->h;
+	osd_fillrect(osd->cpu_panel, 0, 0, osd->cpu_panel->w, osd->cpu_panel->h,
+		osd_color(osd->cpu_panel, 0xdf, 0xdf, 0xdf));
 
 	x = 4;
 	y = 2;
 	w = 6;
 	h = 16;
-	osd_widget_alloc(ctrl_panel, x, y, 7*w, h, 0xef, 0x3f, 0x3f, BT_PUSH, WID_RESET, "Reset");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 7*w, h, 0xef, 0x3f, 0x3f, BT_PUSH, WID_RESET, "Reset");
 	x += 7*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_1X1, "1x1");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_1X1, "1x1");
 	x += 4*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_2X2, "2x2");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_2X2, "2x2");
 	x += 4*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_3X3, "3x3");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_3X3, "3x3");
 	x += 4*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_4X4, "4x4");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 4*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_4X4, "4x4");
 	x += 4*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_SNAPSHOT, "Snapshot");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_SNAPSHOT, "Snapshot");
 	x += 11*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_THROTTLE, "Throttle");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_THROTTLE, "Throttle");
 	x += 11*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_VIDEO, "Video");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_VIDEO, "Video");
 	x += 11*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_CPU_PANEL, "CPU panel");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_CHECK, WID_CPU_PANEL, "CPU panel");
 	x += 11*w + 2;
 #if	0
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_CASSETTE, "Cassette");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_CASSETTE, "Cassette");
 	x += 11*w + 2;
-	osd_widget_alloc(ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_FLOPPY, "Floppy");
+	osd_widget_alloc(osd->ctrl_panel, x, y, 11*w, h, 0xbf, 0xbf, 0xbf, BT_PUSH, WID_FLOPPY, "Floppy");
 	x += 11*w + 2;
 #endif
 	if (width > x) {
 		x = width - 30*w;
-		osd_widget_alloc(ctrl_panel, x, y, 12*w, h, 0xf0, 0xf0, 0xf0, BT_EDIT, WID_CASSETTE, "");
+		osd_widget_alloc(osd->ctrl_panel, x, y, 12*w, h, 0xf0, 0xf0, 0xf0, BT_EDIT, WID_CASSETTE, "");
 
 		x = width - 13*w;
-		osd_widget_alloc(ctrl_panel, x, y, 12*w, h, 0xbf, 0xbf, 0xbf, BT_STATIC, WID_FREQUENCY, "1 MHz");
+		osd_widget_alloc(osd->ctrl_panel, x, y, 12*w, h, 0xbf, 0xbf, 0xbf, BT_STATIC, WID_FREQUENCY, "1 MHz");
 	}
 
-	osd_widget_active(ctrl_panel, WID_THROTTLE, throttle);
-	osd_widget_active(ctrl_panel, WID_VIDEO, start_video);
-	osd_widget_active(ctrl_panel, WID_CPU_PANEL, cpu_panel_on);
+	osd_widget_active(osd->ctrl_panel, WID_THROTTLE, osd->throttle);
+	osd_widget_active(osd->ctrl_panel, WID_VIDEO, osd->start_video);
+	osd_widget_active(osd->ctrl_panel, WID_CPU_PANEL, osd->cpu_panel_on);
 
-	sys_cpu_panel_init(cpu_panel);
-	osd_bitmap_update(cpu_panel);
+	sys_cpu_panel_init(osd->cpu_panel);
+	osd_bitmap_update(osd->cpu_panel);
 
 	/* fill rect */
-	bg = SDL_MapRGB(screen->format, 0, 0, 0);
-	SDL_FillRect(screen, NULL, bg);
-	SDL_UpdateRect(screen, 0, 0, width, height);
+	bg = SDL_MapRGB(osd->screen->format, 0, 0, 0);
+	SDL_FillRect(osd->screen, NULL, bg);
+	SDL_UpdateRect(osd->screen, 0, 0, width, height);
 
 	if (NULL != title)
-		snprintf(osd_title, sizeof(osd_title), "%s", title);
-	SDL_WM_SetCaption(osd_title, osd_title);
+		snprintf(osd->osd_title, sizeof(osd->osd_title), "%s", title);
+	if (osd->headless)
+		return 0;
+	SDL_WM_SetCaption(osd->osd_title, osd->osd_title);
 
 	make_cursor(bits, mask, 12, 16,
 		"xx.........." \
@@ -1945,8 +2195,8 @@ int32_t osd_open_display(int32_t width, int32_t height, const char *title)
 		".....x##x..." \
 		"......xx....");
 
-	cursor = SDL_CreateCursor(bits, mask, 12, 16, 0, 0);
-	SDL_SetCursor(cursor);
+	osd->cursor = SDL_CreateCursor(bits, mask, 12, 16, 0, 0);
+	SDL_SetCursor(osd->cursor);
 	SDL_ShowCursor(1);
 
 	return 0;
@@ -1954,24 +2204,22 @@ int32_t osd_open_display(int32_t width, int32_t height, const char *title)
 
 int32_t osd_close_display(void)
 {
-	if (NULL != screen) {
-		SDL_FreeSurface(screen);
-		screen = NULL;
-	}
-	if (NULL != cursor) {
-		SDL_FreeCursor(cursor);
-		cursor = NULL;
+	osd_t *osd = machine->osd;
+
+	if (NULL != osd->screen) {
+		SDL_FreeSurface(osd->screen);
+		osd->screen = NULL;
 	}
-	osd_bitmap_free(&font);
-	osd_bitmap_free(&frame);
-	osd_bitmap_free(&ctrl_panel);
-	osd_bitmap_free(&cpu_panel);
-	if (NULL != dirty) {
-		free(dirty);
-		dirty = NULL;
+	if (NULL != osd->cursor) {
+		SDL_FreeCursor(osd->cursor);
+		osd->cursor = NULL;
 	}
-	dirty_count = 0;
-	dirty_alloc = 0;
+	osd_bitmap_free(&osd->font);
+	osd_bitmap_free(&osd->frame);
+	osd_bitmap_free(&osd->ctrl_panel);
+	osd_bitmap_free(&osd->cpu_panel);
+	osd_dirty_free(&osd->screen_dirty);
+	osd->dirty_count = 0;
 	return 0;
 }
 
@@ -2167,6 +2415,7 @@ int32_t osd_render_font(osd_bitmap_t *bitmap, const void *font,
 void osd_pattern(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t x, int32_t y, uint32_t code,
 	uint32_t ncolors, uint32_t *colors, uint32_t pw, uint32_t ph)
 {
+	osd_t *osd = machine->osd;
 	SDL_Surface *src_surface = NULL;
 	SDL_Surface *dst_surface = NULL;
 	SDL_Color palette[256];
@@ -2176,7 +2425,7 @@ void osd_pattern(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t x, int32_t y, uin
 	if (NULL != dst)
 		dst_surface = (SDL_Surface *)dst->_private;
 	if (NULL == dst_surface)
-		dst_surface = screen;
+		dst_surface = osd->screen;
 	if (NULL != src)
 		src_surface = (SDL_Surface *)src->_private;
 	if (NULL == src_surface)
@@ -2190,7 +2439,7 @@ void osd_pattern(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t x, int32_t y, uin
 	src_rect.y = (code / 16) * ph;
 	src_rect.w = pw;
 	src_rect.h = ph;
-	if (dst_surface == screen) {
+	if (dst_surface == osd->screen) {
 		/* destination rect screen */
 		dst_rect.x = x;
 		dst_rect.y = y;
@@ -2219,7 +2468,7 @@ void osd_pattern(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t x, int32_t y, uin
 		}
 	}
 	SDL_BlitSurface(src_surface, &src_rect, dst_surface, &dst_rect);
-	if (dst_surface == screen)
+	if (dst_surface == osd->screen)
 		osd_screen_dirty(&dst_rect);
 	else
 		osd_bitmap_dirty(dst, &dst_rect);
@@ -2227,22 +2476,24 @@ void osd_pattern(osd_bitmap_t *dst, osd_bitmap_t *src, int32_t x, int32_t y, uin
 
 int32_t osd_keys(SDL_KeyboardEvent *key)
 {
+	osd_t *osd = machine->osd;
+
 	/* RCTRL is for OSD keys */
 	if (0 == (key->keysym.mod & KMOD_RCTRL))
 		return 0;
 
 	if (key->keysym.sym == SDLK_RETURN) {
-		if (SDL_WM_ToggleFullScreen(screen))
-			fullscreen ^= 1;
-		SDL_ShowCursor(fullscreen ^ 1);
+		if (SDL_WM_ToggleFullScreen(osd->screen))
+			osd->fullscreen ^= 1;
+		SDL_ShowCursor(osd->fullscreen ^ 1);
 		return 1;
 	}
 
 	/* OSD+DELETE = toggle throttle */
 	if (key->keysym.sym == SDLK_DELETE ||
 		key->keysym.sym == SDLK_KP_PERIOD) {
-		throttle ^= 1;
-		osd_widget_active(ctrl_panel, WID_THROTTLE, throttle);
+		osd->throttle ^= 1;
+		osd_widget_active(osd->ctrl_panel, WID_THROTTLE, osd->throttle);
 		return 1;
 	}
 
@@ -2260,8 +2511,8 @@ int32_t osd_keys(SDL_KeyboardEvent *key)
 	/* OSD+SYSREQ = toggle CPU panel */
 	if (key->keysym.sym == SDLK_HOME ||
 		key->keysym.sym == SDLK_KP7) {
-		cpu_panel_on ^= 1;
-		osd_widget_active(ctrl_panel, WID_CPU_PANEL, cpu_panel_on);
+		osd->cpu_panel_on ^= 1;
+		osd_widget_active(osd->ctrl_panel, WID_CPU_PANEL, osd->cpu_panel_on);
 		return 1;
 	}
 
@@ -2277,6 +2528,7 @@ int32_t osd_keys(SDL_KeyboardEvent *key)
 
 int32_t osd_update(int32_t skip_this_frame)
 {
+	osd_t *osd = machine->osd;
 	SDL_Rect dst;
 	SDL_Event ev;
 	osd_key_t key;
@@ -2284,52 +2536,60 @@ int32_t osd_update(int32_t skip_this_frame)
 	int32_t w, h;
 
 
+	STATS_ENTER(STATS_PRESENT);
 	/* record video right from the start? */
-	if (start_video) {
-		start_video = 0;
+	if (osd->start_video) {
+		osd->start_video = 0;
 		osd_mng_start();
 	}
-	osd_bitmap_update(frame);
-	if (NULL != mng)
+	osd_bitmap_update(osd->frame);
+	osd->dirty_count = osd_dirty_rects(&osd->screen_dirty, osd->dirty, OSD_DIRTY_MAX);
+	if (NULL != osd->mng) {
+		STATS_ENTER(STATS_MNG);
 		osd_mng_frame();
+		STATS_LEAVE();
+	}
 
-	if (ctrl_panel_on)
-		osd_hittest(ctrl_panel, mousex, mousey, mouseb);
+	if (osd->ctrl_panel_on)
+		osd_hittest(osd->ctrl_panel, osd->mousex, osd->mousey, osd->mouseb);
 
 	if (0 == skip_this_frame) {
-		if (ctrl_panel_on) {
-			osd_blit(NULL, ctrl_panel, 0, 0, ctrl_panel->w, ctrl_panel->h, ctrl_panel->x, ctrl_panel->y);
-			dst.x = ctrl_panel->x;
-			dst.y = ctrl_panel->y;
-			dst.w = ctrl_panel->w;
-			dst.h = ctrl_panel->h;
-			osd_bitmap_dirty(frame, &dst);
+		if (osd->ctrl_panel_on) {
+			osd_blit(NULL, osd->ctrl_panel, 0, 0, osd->ctrl_panel->w, osd->ctrl_panel->h, osd->ctrl_panel->x, osd->ctrl_panel->y);
+			dst.x = osd->ctrl_panel->x;
+			dst.y = osd->ctrl_panel->y;
+			dst.w = osd->ctrl_panel->w;
+			dst.h = osd->ctrl_panel->h;
+			osd_bitmap_dirty(osd->frame, &dst);
 		}
-		if (cpu_panel_on) {
-			sys_cpu_panel_update(cpu_panel);
-			osd_hittest(cpu_panel, mousex, mousey, mouseb);
-			osd_blit(NULL, cpu_panel, 0, 0, cpu_panel->w, cpu_panel->h, cpu_panel->x, cpu_panel->y);
-			dst.x = cpu_panel->x;
-			dst.y = cpu_panel->y;
-			dst.w = cpu_panel->w;
-			dst.h = cpu_panel->h;
-			osd_bitmap_dirty(frame, &dst);
+		if (osd->cpu_panel_on) {
+			sys_cpu_panel_update(osd->cpu_panel);
+			osd_hittest(osd->cpu_panel, osd->mousex, osd->mousey, osd->mouseb);
+			osd_blit(NULL, osd->cpu_panel, 0, 0, osd->cpu_panel->w, osd->cpu_panel->h, osd->cpu_panel->x, osd->cpu_panel->y);
+			dst.x = osd->cpu_panel->x;
+			dst.y = osd->cpu_panel->y;
+			dst.w = osd->cpu_panel->w;
+			dst.h = osd->cpu_panel->h;
+			osd_bitmap_dirty(osd->frame, &dst);
 		}
-		if (dirty_count > 0) {
+		/* the panels may have added tiles */
+		osd->dirty_count = osd_dirty_rects(&osd->screen_dirty, osd->dirty, OSD_DIRTY_MAX);
+		if (osd->dirty_count > 0) {
 			/* update rectangles */
-			if (NULL != screen)
-				SDL_UpdateRects(screen, dirty_count, dirty);
-			dirty_count = 0;
+			if (NULL != osd->screen)
+				SDL_UpdateRects(osd->screen, osd->dirty_count, osd->dirty);
+			osd_dirty_clear(&osd->screen_dirty);
+			osd->dirty_count = 0;
 		}
 	}
 
-	while (SDL_PollEvent(&ev)) {
+	while (osd->events && SDL_PollEvent(&ev)) {
 		switch (ev.type) {
 		case SDL_VIDEORESIZE:
 			osd_close_display();
 			osd_open_display(ev.resize.w, ev.resize.h, NULL);
-			if (resize_callback)
-				(*resize_callback)(ev.resize.w, ev.resize.h);
+			if (osd->resize_callback)
+				(*osd->resize_callback)(ev.resize.w, ev.resize.h);
 			break;
 
 		case SDL_KEYDOWN:
@@ -2340,10 +2600,10 @@ int32_t osd_update(int32_t skip_this_frame)
 			key.sym = ev.key.keysym.sym;
 			key.mod = ev.key.keysym.mod;
 			key.unicode = ev.key.keysym.unicode;
-			if (keydn_osd_local) {
-				(*keydn_osd_local)(cookie_local, &key);
-			} else if (keydn_callback) {
-				(*keydn_callback)(cookie_callback, &key);
+			if (osd->keydn_osd_local) {
+				(*osd->keydn_osd_local)(osd->cookie_local, &key);
+			} else if (osd->keydn_callback) {
+				(*osd->keydn_callback)(osd->cookie_callback, &key);
 			}
 			break;
 
@@ -2354,110 +2614,110 @@ int32_t osd_update(int32_t skip_this_frame)
 			key.sym = ev.key.keysym.sym;
 			key.mod = ev.key.keysym.mod;
 			key.unicode = 0;
-			if (keyup_osd_local) {
-				(*keyup_osd_local)(cookie_local, &key);
-			} else if (keyup_callback) {
-				(*keyup_callback)(cookie_callback, &key);
+			if (osd->keyup_osd_local) {
+				(*osd->keyup_osd_local)(osd->cookie_local, &key);
+			} else if (osd->keyup_callback) {
+				(*osd->keyup_callback)(osd->cookie_callback, &key);
 			}
 			break;
 
 		case SDL_MOUSEMOTION:
-			mousex = ev.motion.x;
-			mousey = ev.motion.y;
-			mouseb = (mouseb & ~1) | (ev.motion.state & 1);
+			osd->mousex = ev.motion.x;
+			osd->mousey = ev.motion.y;
+			osd->mouseb = (osd->mouseb & ~1) | (ev.motion.state & 1);
 			break;
 
 		case SDL_MOUSEBUTTONDOWN:
-			mouseb |= 1 | (1 << ev.button.button);
+			osd->mouseb |= 1 | (1 << ev.button.button);
 			if (3 == ev.button.button)
-				ctrl_panel_on ^= 1;
-			if (!ctrl_panel_on)
+				osd->ctrl_panel_on ^= 1;
+			if (!osd->ctrl_panel_on)
 				break;
 
-			rc = osd_hittest(ctrl_panel, mousex, mousey, mouseb);
+			rc = osd_hittest(osd->ctrl_panel, osd->mousex, osd->mousey, osd->mouseb);
 			switch (rc) {
 			case WID_RESET:
 				sys_reset(SYS_RST);
 				break;
 			case WID_THROTTLE:
-				throttle ^= 1;
-				osd_widget_active(ctrl_panel, WID_THROTTLE, throttle);
+				osd->throttle ^= 1;
+				osd_widget_active(osd->ctrl_panel, WID_THROTTLE, osd->throttle);
 				break;
 			case WID_1X1:
-				w = display_w;
-				h = display_h;
+				w = osd->display_w;
+				h = osd->display_h;
 				osd_close_display();
 				osd_open_display(w, h, NULL);
-				if (resize_callback)
-					(*resize_callback)(w, h);
+				if (osd->resize_callback)
+					(*osd->resize_callback)(w, h);
 				break;
 			case WID_2X2:
-				w = 2 * display_w;
-				h = 2 * display_h;
+				w = 2 * osd->display_w;
+				h = 2 * osd->display_h;
 				osd_close_display();
 				osd_open_display(w, h, NULL);
-				if (resize_callback)
-					(*resize_callback)(w, h);
+				if (osd->resize_callback)
+					(*osd->resize_callback)(w, h);
 				break;
 			case WID_3X3:
-				w = 3 * display_w;
-				h = 3 * display_h;
+				w = 3 * osd->display_w;
+				h = 3 * osd->display_h;
 				osd_close_display();
 				osd_open_display(w, h, NULL);
-				if (resize_callback)
-					(*resize_callback)(w, h);
+				if (osd->resize_callback)
+					(*osd->resize_callback)(w, h);
 				break;
 			case WID_4X4:
-				w = 4 * display_w;
-				h = 4 * display_h;
+				w = 4 * osd->display_w;
+				h = 4 * osd->display_h;
 				osd_close_display();
 				osd_open_display(w, h, NULL);
-				if (resize_callback)
-					(*resize_callback)(w, h);
+				if (osd->resize_callback)
+					(*osd->resize_callback)(w, h);
 				break;
 			case WID_SNAPSHOT:
 				osd_save_snapshot();
 				break;
 			case WID_VIDEO:
-				if (NULL != mng) {
+				if (NULL != osd->mng) {
 					osd_mng_stop();
-					osd_widget_active(ctrl_panel, WID_VIDEO, 0);
+					osd_widget_active(osd->ctrl_panel, WID_VIDEO, 0);
 				} else {
 					osd_mng_start();
-					osd_widget_active(ctrl_panel, WID_VIDEO, 1);
+					osd_widget_active(osd->ctrl_panel, WID_VIDEO, 1);
 				}
 				break;
 			case WID_CPU_PANEL:
-				cpu_panel_on ^= 1;
-				osd_widget_active(ctrl_panel, WID_CPU_PANEL, cpu_panel_on);
+				osd->cpu_panel_on ^= 1;
+				osd_widget_active(osd->ctrl_panel, WID_CPU_PANEL, osd->cpu_panel_on);
 				break;
 
 			case WID_CASSETTE:
-				if (NULL == keydn_osd_local) {
-					static cookie_local_t cookie;
-
-					cookie.bitmap = ctrl_panel;
-					cookie.id = WID_CASSETTE;
-					keydn_osd_local = keydn_edit;
-					keyup_osd_local = keyup_edit;
-					cookie_local = (void *)&cookie;
-					osd_widget_active(ctrl_panel, WID_CASSETTE, 1);
+				if (NULL == osd->keydn_osd_local) {
+					osd->cookie_edit.bitmap = osd->ctrl_panel;
+					osd->cookie_edit.id = WID_CASSETTE;
+					osd->keydn_osd_local = keydn_edit;
+					osd->keyup_osd_local = keyup_edit;
+					osd->cookie_local = (void *)&osd->cookie_edit;
+					osd_widget_active(osd->ctrl_panel, WID_CASSETTE, 1);
 				}
 				break;
 			}
 			break;
 
 		case SDL_MOUSEBUTTONUP:
-			mouseb &= ~(1 | (1 << ev.button.button));
-			if (ctrl_panel_on)
-				osd_hittest(ctrl_panel, mousex, mousey, mouseb);
+			osd->mouseb &= ~(1 | (1 << ev.button.button));
+			if (osd->ctrl_panel_on)
+				osd_hittest(osd->ctrl_panel, osd->mousex, osd->mousey, osd->mouseb);
 			break;
 
 		case SDL_QUIT:
+			STATS_LEAVE();
 			return -1;
 		}
 	}
 
+	STATS_LEAVE();
 	return 0;
 }
 
@@ -2498,6 +2758,7 @@ static char *delete_char(char *src, int32_t offs)
 
 static void keydn_edit(void *cookie, osd_key_t *key)
 {
+	osd_t *osd = machine->osd;
 	cookie_local_t *c = (cookie_local_t *)cookie;
 	osd_widget_t *e;
 	int32_t len, w;
@@ -2510,9 +2771,9 @@ static void keydn_edit(void *cookie, osd_key_t *key)
 
 	switch (key->unicode) {
 	case 13:
-		keydn_osd_local = NULL;
-		keyup_osd_local = NULL;
-		cookie_local = NULL;
+		osd->keydn_osd_local = NULL;
+		osd->keyup_osd_local = NULL;
+		osd->cookie_local = NULL;
 		osd_widget_active(c->bitmap, c->id, 0);
 		return;
 	default:
@@ -2822,37 +3083,38 @@ const char *osd_key_name(osd_key_t *key)
 
 int32_t osd_mousex(void)
 {
-	return mousex;
+	return machine->osd->mousex;
 }
 
 int32_t osd_mousey(void)
 {
-	return mousey;
+	return machine->osd->mousey;
 }
 
 int32_t osd_mouseb(void)
 {
-	return mouseb;
+	return machine->osd->mouseb;
 }
 
 uint32_t osd_get_sample_rate(void)
 {
-	return sample_rate;
+	return machine->osd->sample_rate;
 }
 
 void osd_set_sample_rate(uint32_t rate)
 {
-	sample_rate = rate;
+	machine->osd->sample_rate = rate;
 }
 
 void osd_set_refresh_rate(double rate)
 {
-	refresh_rate = rate;
+	machine->osd->refresh_rate = rate;
 }
 
 uint32_t osd_update_audio_stream(int16_t *stream)
 {
-	sbuff_t *sb = (sbuff_t *)sbuff;
+	osd_t *osd = machine->osd;
+	sbuff_t *sb = (sbuff_t *)osd->sbuff;
 	int16_t *src, *dst;
 	int32_t size, copy;
 
@@ -2862,7 +3124,7 @@ uint32_t osd_update_audio_stream(int16_t *stream)
 	SDL_LockAudio();
 	src = (int16_t *)stream;
 	dst = sb->buffer + sb->head;
-	size = sample_rate / refresh_rate;
+	size = osd->sample_rate / osd->refresh_rate;
 	copy = sb->size - sb->head;
 	sb->head += size;
 	if (copy > size)
@@ -2915,99 +3177,105 @@ void osd_flush_audio_stream(void *userdata, uint8_t *stream, int32_t len)
 
 void osd_stop_audio_stream(void)
 {
+	osd_t *osd = machine->osd;
 	SDL_PauseAudio(1);
 
 	SDL_LockAudio();
-	if (NULL != sbuff) {
-		free(sbuff);
-		sbuff = NULL;
+	if (NULL != osd->sbuff) {
+		free(osd->sbuff);
+		osd->sbuff = NULL;
 	}
 
-	if (NULL != audio_spec_obtained) {
-		free(audio_spec_obtained);
-		audio_spec_obtained = NULL;
+	if (NULL != osd->audio_spec_obtained) {
+		free(osd->audio_spec_obtained);
+		osd->audio_spec_obtained = NULL;
 	}
 	SDL_UnlockAudio();
 }
 
 int32_t osd_start_audio_stream(int32_t stereo)
 {
+	osd_t *osd = machine->osd;
 	int32_t samples;
 	int32_t rc;
 
+	/* no audio output when running headless, the samples are dropped */
+	if (osd->headless)
+		return osd->sample_rate / osd->refresh_rate;
+
 	rc = SDL_InitSubSystem(SDL_INIT_AUDIO);
 	if (0 != rc) {
 		fprintf(stderr, "osd_start_audio_stream: SDL_InitSubSystem(SDL_INIT_AUDIO) failed (%d)\n", rc);
 		return -1;
 	}
 
-	sbuff = (sbuff_t *)calloc(1, sizeof(sbuff_t));
-	if (NULL == sbuff) {
+	osd->sbuff = (sbuff_t *)calloc(1, sizeof(sbuff_t));
+	if (NULL == osd->sbuff) {
 		fprintf(stderr, "osd_start_audio_stream: memory problem (%s)\n",
 			strerror(errno));
 		return -1;
 	}
 
-	audio_spec_desired = (SDL_AudioSpec *)calloc(1, sizeof(SDL_AudioSpec));
-	if (NULL == audio_spec_desired) {
+	osd->audio_spec_desired = (SDL_AudioSpec *)calloc(1, sizeof(SDL_AudioSpec));
+	if (NULL == osd->audio_spec_desired) {
 		fprintf(stderr, "osd_start_audio_stream: memory problem (%s)\n",
 			strerror(errno));
-		free(sbuff);
+		free(osd->sbuff);
 		return -1;
 	}
-	audio_spec_obtained = (SDL_AudioSpec *)calloc(1, sizeof(SDL_AudioSpec));
-	if (NULL == audio_spec_obtained) {
+	osd->audio_spec_obtained = (SDL_AudioSpec *)calloc(1, sizeof(SDL_AudioSpec));
+	if (NULL == osd->audio_spec_obtained) {
 		fprintf(stderr, "osd_start_audio_stream: memory problem (%s)\n",
 			strerror(errno));
-		free(sbuff);
+		free(osd->sbuff);
 		return -1;
 	}
 
-	audio_spec_desired->freq = sample_rate;
-	audio_spec_desired->format = AUDIO_S16SYS;
-	audio_spec_desired->channels = stereo ? 2 : 1;
-	audio_spec_desired->samples = SBUFF_SIZE / 16;
-	audio_spec_desired->callback = osd_flush_audio_stream;
-	audio_spec_desired->userdata = sbuff;
-	rc = SDL_OpenAudio(audio_spec_desired, audio_spec_obtained);
+	osd->audio_spec_desired->freq = osd->sample_rate;
+	osd->audio_spec_desired->format = AUDIO_S16SYS;
+	osd->audio_spec_desired->channels = stereo ? 2 : 1;
+	osd->audio_spec_desired->samples = SBUFF_SIZE / 16;
+	osd->audio_spec_desired->callback = osd_flush_audio_stream;
+	osd->audio_spec_desired->userdata = osd->sbuff;
+	rc = SDL_OpenAudio(osd->audio_spec_desired, osd->audio_spec_obtained);
 
 	if (rc) {
 		/* fail */
-		free(audio_spec_desired);
-		audio_spec_desired = NULL;
-		free(audio_spec_obtained);
-		audio_spec_obtained = NULL;
-		free(sbuff);
-		sbuff = NULL;
+		free(osd->audio_spec_desired);
+		osd->audio_spec_desired = NULL;
+		free(osd->audio_spec_obtained);
+		osd->audio_spec_obtained = NULL;
+		free(osd->sbuff);
+		osd->sbuff = NULL;
 		fprintf(stderr, "osd_start_audio_stream: SDL_OpenAudio failed (%s)\n",
 			strerror(errno));
 		return 0;
 	}
 
 	/* obtained sample rate */
-	sample_rate = audio_spec_obtained->freq;
-	samples = sample_rate / refresh_rate;
-	sbuff->size = SBUFF_SIZE;
-	sbuff->head = 0;
-	sbuff->tail = SBUFF_SIZE / 8;
+	osd->sample_rate = osd->audio_spec_obtained->freq;
+	samples = osd->sample_rate / osd->refresh_rate;
+	osd->sbuff->size = SBUFF_SIZE;
+	osd->sbuff->head = 0;
+	osd->sbuff->tail = SBUFF_SIZE / 8;
 
 #if	0
 	printf("--- rates\n");
-	printf("sample_rate:   %d\n", sample_rate);
-	printf("refresh_rate:  %g\n", refresh_rate);
+	printf("sample_rate:   %d\n", osd->sample_rate);
+	printf("refresh_rate:  %g\n", osd->refresh_rate);
 	printf("--- audio_spec_obtained\n");
-	printf("freq:          %d\n", audio_spec_obtained->freq);
-	printf("format:        0x%x\n", audio_spec_obtained->format);
-	printf("channels:      %d\n", audio_spec_obtained->channels);
-	printf("samples:       %d\n", audio_spec_obtained->samples);
-	printf("size:          %d\n", audio_spec_obtained->size);
-	printf("callback:      %p\n", audio_spec_obtained->callback);
-	printf("userdata:      %p\n", audio_spec_obtained->userdata);
+	printf("freq:          %d\n", osd->audio_spec_obtained->freq);
+	printf("format:        0x%x\n", osd->audio_spec_obtained->format);
+	printf("channels:      %d\n", osd->audio_spec_obtained->channels);
+	printf("samples:       %d\n", osd->audio_spec_obtained->samples);
+	printf("size:          %d\n", osd->audio_spec_obtained->size);
+	printf("callback:      %p\n", osd->audio_spec_obtained->callback);
+	printf("userdata:      %p\n", osd->audio_spec_obtained->userdata);
 
 	printf("--- sbuff\n");
-	printf("size:          %d\n", sbuff->size);
-	printf("head:          %d\n", sbuff->head);
-	printf("tail:          %d\n", sbuff->tail);
+	printf("size:          %d\n", osd->sbuff->size);
+	printf("head:          %d\n", osd->sbuff->head);
+	printf("tail:          %d\n", osd->sbuff->tail);
 	printf("--- samples per frame\n");
 	printf("samples:       %d\n", samples);
 #endif
@@ -3016,7 +3284,6 @@ int32_t osd_start_audio_stream(int32_t stereo)
 	return samples;
 }
 
-static int32_t frameskip_counter = 0;
 static const int32_t skiptable[FRAMESKIP_LEVELS][FRAMESKIP_LEVELS] = {
 	{ 0,0,0,0,0,0,0,0,0,0,0,0 },
 	{ 0,0,0,0,0,0,0,0,0,0,0,1 },
@@ -3047,10 +3314,6 @@ static const int32_t waittable[FRAMESKIP_LEVELS][FRAMESKIP_LEVELS] = {
 	{12,0,0,0,0,0,0,0,0,0,0,0 }
 };
 
-static uclock_t prev_frames[FRAMESKIP_LEVELS] = {0,0,0,0,0,0,0,0,0,0,0,0};
-static uclock_t prev = 0;
-static int32_t speed = 100;
-
 int32_t should_sleep_idle(void)
 {
 	return 1;
@@ -3058,28 +3321,31 @@ int32_t should_sleep_idle(void)
 
 int32_t osd_skip_next_frame(void)
 {
+	osd_t *osd = machine->osd;
 	uclock_t curr;
 	int32_t i;
 
-	if (skiptable[frameskip][frameskip_counter]) {
-		frameskip_counter = (frameskip_counter + 1) % FRAMESKIP_LEVELS;
-		return skiptable[frameskip][frameskip_counter];
+	if (skiptable[osd->frameskip][osd->frameskip_counter]) {
+		osd->frameskip_counter = (osd->frameskip_counter + 1) % FRAMESKIP_LEVELS;
+		return skiptable[osd->frameskip][osd->frameskip_counter];
 	}
 
 	/* now wait until it's time to update the screen */
-	if (throttle) {
+	if (osd->throttle) {
 		uclock_t target, target2;
 
+		STATS_ENTER(STATS_THROTTLE);
+
 		/* wait until enough time has passed since last frame... */
-		target = prev + waittable[frameskip][frameskip_counter] *
-			UCLOCKS_PER_SEC / refresh_rate;
+		target = osd->prev + waittable[osd->frameskip][osd->frameskip_counter] *
+			UCLOCKS_PER_SEC / osd->refresh_rate;
 
 		/* ... OR since FRAMESKIP_LEVELS frames ago. This way,
 		 * if a frame takes longer than the allotted time,
 		 * we can compensate in the following frames.
 		 */
-		target2 = prev_frames[frameskip_counter] +
-			FRAMESKIP_LEVELS * UCLOCKS_PER_SEC / refresh_rate;
+		target2 = osd->prev_frames[osd->frameskip_counter] +
+			FRAMESKIP_LEVELS * UCLOCKS_PER_SEC / osd->refresh_rate;
 
 		if (target - target2 > 0)
 			target = target2;
@@ -3093,7 +3359,7 @@ int32_t osd_skip_next_frame(void)
 		 */
 		if ((target - curr) > (UCLOCKS_PER_SEC / 2)) {
 			for (i = 0; i < FRAMESKIP_LEVELS; i++)
-				prev_frames[i] = curr;
+				osd->prev_frames[i] = curr;
 		} else {
 			while ((curr - target) < 0) {
 				curr = uclock();
@@ -3102,66 +3368,66 @@ int32_t osd_skip_next_frame(void)
 					usleep(100);
 			}
 		}
+		STATS_LEAVE();
 
 	} else {
 		curr = uclock();
 	}
 
-	if (frameskip_counter == 0 &&
-		0 != (curr - prev_frames[frameskip_counter])) {
+	if (osd->frameskip_counter == 0 &&
+		0 != (curr - osd->prev_frames[osd->frameskip_counter])) {
 			int32_t divdr;
 
-			divdr = refresh_rate *
-				(curr - prev_frames[frameskip_counter]) /
+			divdr = osd->refresh_rate *
+				(curr - osd->prev_frames[osd->frameskip_counter]) /
 				(100 * FRAMESKIP_LEVELS);
-			speed = (UCLOCKS_PER_SEC + divdr/2) / divdr;
+			osd->speed = (UCLOCKS_PER_SEC + divdr/2) / divdr;
 	}
 
-	prev = curr;
-	for (i = 0;i < waittable[frameskip][frameskip_counter];i++)
-		prev_frames[(frameskip_counter + FRAMESKIP_LEVELS - i) %
+	osd->prev = curr;
+	for (i = 0;i < waittable[osd->frameskip][osd->frameskip_counter];i++)
+		osd->prev_frames[(osd->frameskip_counter + FRAMESKIP_LEVELS - i) %
 			FRAMESKIP_LEVELS] = curr;
 
-	if (throttle && autoframeskip && frameskip_counter == 0) {
-		static int32_t frameskipadjust;
-
-		if (speed >= 100) {
-			frameskipadjust++;
-			if (frameskipadjust > 1) {
-				frameskipadjust = 0;
-				if (frameskip > 0)
-					frameskip--;
+	if (osd->throttle && osd->autoframeskip && osd->frameskip_counter == 0) {
+		if (osd->speed >= 100) {
+			osd->frameskipadjust++;
+			if (osd->frameskipadjust > 1) {
+				osd->frameskipadjust = 0;
+				if (osd->frameskip > 0)
+					osd->frameskip--;
 			}
 		} else {
-			if (speed < 80) {
-				frameskipadjust -= (90 - speed) / 5;
+			if (osd->speed < 80) {
+				osd->frameskipadjust -= (90 - osd->speed) / 5;
 			} else {
 				/*
 				 * Don't push frameskip too far,
 				 * if we are close to 100% speed
 				 */
-				if (frameskip < 8)
-					frameskipadjust--;
+				if (osd->frameskip < 8)
+					osd->frameskipadjust--;
 			}
 
-			while (frameskipadjust <= -2) {
-				frameskipadjust += 2;
-				if (frameskip < max_autoframeskip)
-					frameskip++;
+			while (osd->frameskipadjust <= -2) {
+				osd->frameskipadjust += 2;
+				if (osd->frameskip < osd->max_autoframeskip)
+					osd->frameskip++;
 			}
 		}
 	}
 	
-	frameskip_counter = (frameskip_counter + 1) % FRAMESKIP_LEVELS;
-	return skiptable[frameskip][frameskip_counter];
+	osd->frameskip_counter = (osd->frameskip_counter + 1) % FRAMESKIP_LEVELS;
+	return skiptable[osd->frameskip][osd->frameskip_counter];
 }
 
 void osd_display_frequency(uint64_t frq)
 {
+	osd_t *osd = machine->osd;
 	uint32_t mhz = (uint32_t)(frq / 1000000ull);
 	uint32_t khz = (uint32_t)((frq / 1000ull) % 1000ull);
-	if (NULL != ctrl_panel)
-		osd_widget_text(ctrl_panel, WID_FREQUENCY, "%u.%03u MHz", mhz, khz);
+	if (NULL != osd->ctrl_panel)
+		osd_widget_text(osd->ctrl_panel, WID_FREQUENCY, "%u.%03u MHz", mhz, khz);
 }
 
 void osd_help(int argc, char **argv)
@@ -3180,6 +3446,30 @@ void osd_help(int argc, char **argv)
 	printf("-f|--fast      disable throttling to original speed\n");
 	printf("-v|--video     record MNG video right from the start\n");
 	printf("-s|--scale n   scale video display to n times 1:1\n");
+	printf("-n|--headless  run without display and audio output\n");
+	printf("-c cycles      stop after running a number of CPU cycles\n");
+	printf("-k file        type the keys from a key script\n");
+	printf("-fd0..3 file   mount a floppy disk image\n");
+	printf("-cas file      mount a cassette image\n");
+	printf("-rec file      record the keyboard with emulated time stamps\n");
+	printf("-play file     play back a keyboard recording (-rec)\n");
+	printf("-S file        write host time statistics to file (- for stdout)\n");
+	printf("-P file        write an opcode and PC profile to file (dz80 -d)\n");
+	printf("-b             cache decoded basic blocks of Z80 code\n");
+	printf("-j             translate hot code to host code (x86-64 JIT)\n");
+	printf("-i             skip the idle loops listed in %s/%s.idle\n",
+		program, program);
+	printf("-ls file       load a save state before starting\n");
+	printf("-ss file       save the state to file when exiting\n");
+	printf("-cp cycles     also save the state (-ss) every number of cycles\n");
+	printf("-rw frames     keep a snapshot every number of frames to rewind (F11)\n");
+	printf("-rwmb mb       size of the rewind buffer in megabytes (4)\n");
+	printf("-bp addr       print the CPU state before executing addr (hex)\n");
+	printf("-wr addr[-end] print memory reads from an address range (hex)\n");
+	printf("-ww addr[-end] print memory writes to an address range (hex)\n");
+	printf("-wi port[-end] print I/O port reads (hex)\n");
+	printf("-wo port[-end] print I/O port writes (hex)\n");
+	printf("-trace file    record every instruction to file (decode with z80trace)\n");
 }
 
 int32_t osd_init(int (*resize)(int32_t,int32_t),
@@ -3188,19 +3478,39 @@ int32_t osd_init(int (*resize)(int32_t,int32_t),
 	void (*keyup)(void *cookie, osd_key_t *),
 	int argc, char **argv)
 {
+	osd_t *osd;
 	int i;
 
+	osd = calloc(1, sizeof(osd_t));
+	if (NULL == osd) {
+		fprintf(stderr, "calloc(%d,%d) failed\n", 1, (int)sizeof(osd_t));
+		return -1;
+	}
+	osd->throttle = 1;
+	osd->autoframeskip = 1;
+	osd->max_autoframeskip = 8;
+	osd->scale = 2;
+	osd->sample_rate = 48000;
+	osd->refresh_rate = 50.0;
+	osd->speed = 100;
+
 	for (i = 1; i < argc; i++) {
 		if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
 			osd_help(argc, argv);
+			free(osd);
 			return -1;
 		}
 		if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--fast")) {
-			throttle = 0;
+			osd->throttle = 0;
+			continue;
+		}
+		if (!strcmp(argv[i], "-n") || !strcmp(argv[i], "--headless")) {
+			osd->headless = 1;
+			osd->throttle = 0;
 			continue;
 		}
 		if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--video")) {
-			start_video = 1;
+			osd->start_video = 1;
 			continue;
 		}
 		if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--scale")) {
@@ -3209,28 +3519,42 @@ int32_t osd_init(int (*resize)(int32_t,int32_t),
 				continue;
 			}
 			i++;
-			scale = strtoull(argv[i], NULL, 0);
-			if (scale < 1)
-				scale = 1;
-			if (scale > 5)
-				scale = 5;
+			osd->scale = strtoull(argv[i], NULL, 0);
+			if (osd->scale < 1)
+				osd->scale = 1;
+			if (osd->scale > 5)
+				osd->scale = 5;
 			continue;
 		}
 	}
 
-	resize_callback = resize;
-	cookie_callback = cookie;
-	keydn_callback = keydn;
-	keyup_callback = keyup;
-
-	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_NOPARACHUTE);
-	atexit(SDL_Quit);
+	osd->resize_callback = resize;
+	osd->cookie_callback = cookie;
+	osd->keydn_callback = keydn;
+	osd->keyup_callback = keyup;
+	machine->osd = osd;
+
+	/* SDL is set up by the first machine and shut down by the last one */
+	pthread_mutex_lock(&sdl_lock);
+	if (0 == sdl_users++) {
+		osd->events = 1;
+		if (osd->headless) {
+			/* name the dummy driver here: putenv("SDL_VIDEODRIVER")
+			 * would race with getenv() on other machines' threads */
+			SDL_Init(SDL_INIT_TIMER | SDL_INIT_NOPARACHUTE);
+			SDL_VideoInit("dummy", 0);
+		} else {
+			SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_NOPARACHUTE);
+		}
+		atexit(SDL_Quit);
 
-	SDL_EventState(SDL_KEYDOWN, SDL_ENABLE);
-	SDL_EventState(SDL_KEYUP, SDL_ENABLE);
-	SDL_EventState(SDL_QUIT, SDL_ENABLE);
-	SDL_EnableKeyRepeat(250,30);
-	SDL_EnableUNICODE(1);
+		SDL_EventState(SDL_KEYDOWN, SDL_ENABLE);
+		SDL_EventState(SDL_KEYUP, SDL_ENABLE);
+		SDL_EventState(SDL_QUIT, SDL_ENABLE);
+		SDL_EnableKeyRepeat(250,30);
+		SDL_EnableUNICODE(1);
+	}
+	pthread_mutex_unlock(&sdl_lock);
 
 #if	0
 	SDL_WM_GrabInput(SDL_GRAB_ON);
@@ -3242,5 +3566,14 @@ void osd_exit(void)
 {
 	osd_close_display();
 	osd_mng_stop();
-	SDL_Quit();
+	free(machine->osd);
+	machine->osd = NULL;
+
+	pthread_mutex_lock(&sdl_lock);
+	if (0 == --sdl_users) {
+		/* SDL_Quit() does not know about video set up by SDL_VideoInit() */
+		SDL_VideoQuit();
+		SDL_Quit();
+	}
+	pthread_mutex_unlock(&sdl_lock);
 }
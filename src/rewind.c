@@ -0,0 +1,366 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * rewind.c	Rewind buffer of delta compressed snapshots
+ *
+ * Every few frames a snapshot of the machine is taken. The memory is
+ * kept as 1K pages (the L1SIZE pages of the memory map), the rest of the
+ * machine as a save state without the memory (state_save_mem() with
+ * STATE_NO_MEM), split into 1K blocks as well. A reference copy holds
+ * the newest snapshot, and each snapshot in the ring stores only the
+ * blocks which changed since the one before, as the XOR of the old and
+ * new contents with runs of zeroes skipped. Applying a snapshot's
+ * deltas to the reference turns it back into the previous snapshot.
+ *
+ * The pages written to are found without comparing memory: after a
+ * snapshot, every page's write handler is replaced by a trap, and its
+ * direct write pointer is cleared. The first write to a page marks it
+ * dirty and puts back the page's handler and pointer, so each page
+ * costs one extra call per snapshot interval at most.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "rewind.h"
+#include "state.h"
+
+/** @brief size of a block */
+#define	BLOCK_SIZE	(1 << L1SHIFT)
+
+/** @brief worst case size of an encoded block (a 4 byte op per 5 bytes) */
+#define	BLOCK_MAX	(BLOCK_SIZE + 4 * (BLOCK_SIZE / 5 + 2))
+
+/** @brief zero bytes which end a literal run */
+#define	MIN_SKIP	4
+
+typedef struct {
+	/** @brief size of the snapshot including this header */
+	uint32_t size;
+	/** @brief number of changed blocks */
+	uint32_t nblocks;
+	/* followed by nblocks * { uint16_t block; uint16_t len; uint8_t delta[len]; } */
+}	rewind_snap_t;
+
+/** @brief non zero if the rewind buffer is enabled */
+static MACHINE_LOCAL int enabled;
+
+/** @brief frames between two snapshots */
+static MACHINE_LOCAL uint32_t interval;
+
+/** @brief frames since the last snapshot */
+static MACHINE_LOCAL uint32_t frames;
+
+/** @brief number of rewind steps requested */
+static MACHINE_LOCAL uint32_t steps;
+
+/** @brief maximum number of bytes kept in snapshots */
+static MACHINE_LOCAL uint64_t budget;
+
+/** @brief number of bytes kept in snapshots */
+static MACHINE_LOCAL uint64_t used;
+
+/** @brief ring of snapshots, oldest at head */
+static MACHINE_LOCAL rewind_snap_t *ring[REWIND_MAX];
+
+/** @brief index of the oldest snapshot */
+static MACHINE_LOCAL uint32_t head;
+
+/** @brief number of snapshots */
+static MACHINE_LOCAL uint32_t count;
+
+/** @brief pages written to since the last snapshot (L1SIZE is 64) */
+static MACHINE_LOCAL uint64_t dirty;
+
+/** @brief the pages' write handlers while the trap is installed */
+static MACHINE_LOCAL void (*trap_wr[L1SIZE])(uint32_t addr, uint8_t data);
+
+/** @brief the pages' direct write pointers while the trap is installed */
+static MACHINE_LOCAL uint8_t *trap_ptr[L1SIZE];
+
+/** @brief memory at the newest snapshot */
+static MACHINE_LOCAL uint8_t *ref_mem;
+
+/** @brief state without the memory at the newest snapshot */
+static MACHINE_LOCAL uint8_t *ref_state;
+
+/** @brief state captured for a new snapshot */
+static MACHINE_LOCAL uint8_t *new_state;
+
+/** @brief size of the state (a multiple of BLOCK_SIZE) */
+static MACHINE_LOCAL uint32_t state_blocks;
+
+/** @brief buffer for encoding a snapshot */
+static MACHINE_LOCAL uint8_t *work;
+
+/** @brief first write to a page since the last snapshot */
+static void rewind_trap(uint32_t addr, uint8_t data)
+{
+	uint32_t page = addr >> L1SHIFT;
+
+	dirty |= 1ull << page;
+	machine->wr_mem[page] = trap_wr[page];
+	machine->wr_ptr[page] = trap_ptr[page];
+	program_write_byte(addr, data);
+}
+
+/** @brief install the trap on all pages which are not dirty yet */
+static void rewind_arm(void)
+{
+	uint32_t page;
+
+	for (page = 0; page < L1SIZE; page++) {
+		if (rewind_trap == machine->wr_mem[page])
+			continue;
+		trap_wr[page] = machine->wr_mem[page];
+		trap_ptr[page] = machine->wr_ptr[page];
+		machine->wr_mem[page] = rewind_trap;
+		machine->wr_ptr[page] = NULL;
+	}
+	dirty = 0;
+}
+
+/** @brief remove the trap from all pages */
+static void rewind_disarm(void)
+{
+	uint32_t page;
+
+	for (page = 0; page < L1SIZE; page++) {
+		if (rewind_trap != machine->wr_mem[page])
+			continue;
+		machine->wr_mem[page] = trap_wr[page];
+		machine->wr_ptr[page] = trap_ptr[page];
+	}
+}
+
+/** @brief encode the XOR of two blocks, return the length */
+static uint32_t rewind_encode(uint8_t *dst, const uint8_t *a, const uint8_t *b)
+{
+	uint32_t len = 0, pos = 0, start, lit, run, i;
+
+	while (pos < BLOCK_SIZE) {
+		start = pos;
+		while (pos < BLOCK_SIZE && a[pos] == b[pos])
+			pos++;
+		if (pos == BLOCK_SIZE)
+			break;
+		lit = pos;
+		/* extend the literal over short runs of equal bytes */
+		for (run = 0; pos < BLOCK_SIZE && run < MIN_SKIP; pos++)
+			run = a[pos] == b[pos] ? run + 1 : 0;
+		pos -= run;
+		dst[len++] = (uint8_t)(lit - start);
+		dst[len++] = (uint8_t)((lit - start) >> 8);
+		dst[len++] = (uint8_t)(pos - lit);
+		dst[len++] = (uint8_t)((pos - lit) >> 8);
+		for (i = lit; i < pos; i++)
+			dst[len++] = a[i] ^ b[i];
+	}
+	return len;
+}
+
+/** @brief apply an encoded XOR to a block */
+static void rewind_decode(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	const uint8_t *end = src + len;
+	uint32_t pos = 0, n;
+
+	while (src < end) {
+		pos += src[0] | (src[1] << 8);
+		n = src[2] | (src[3] << 8);
+		src += 4;
+		while (n-- > 0)
+			dst[pos++] ^= *src++;
+	}
+}
+
+/** @brief append a changed block to the snapshot being built */
+static uint32_t rewind_block(uint32_t size, uint32_t block,
+	uint8_t *ref, const uint8_t *cur)
+{
+	uint32_t len = rewind_encode(work + size + 4, ref, cur);
+
+	work[size + 0] = (uint8_t)block;
+	work[size + 1] = (uint8_t)(block >> 8);
+	work[size + 2] = (uint8_t)len;
+	work[size + 3] = (uint8_t)(len >> 8);
+	memcpy(ref, cur, BLOCK_SIZE);
+	return size + 4 + len;
+}
+
+/** @brief drop the oldest snapshot */
+static void rewind_drop(void)
+{
+	used -= ring[head]->size;
+	free(ring[head]);
+	ring[head] = NULL;
+	head = (head + 1) % REWIND_MAX;
+	count--;
+}
+
+/** @brief take a snapshot */
+static void rewind_snapshot(void)
+{
+	rewind_snap_t *snap;
+	uint32_t size = sizeof(rewind_snap_t), nblocks = 0, page, b;
+
+	memset(new_state, 0, state_blocks * BLOCK_SIZE);
+	if (state_save_mem(new_state, state_blocks * BLOCK_SIZE, STATE_NO_MEM) < 0)
+		return;
+
+	for (page = 0; page < L1SIZE; page++) {
+		if (0 == (dirty & (1ull << page)))
+			continue;
+		if (0 == memcmp(&ref_mem[page * BLOCK_SIZE], &machine->mem[page * BLOCK_SIZE], BLOCK_SIZE))
+			continue;
+		size = rewind_block(size, page,
+			&ref_mem[page * BLOCK_SIZE], &machine->mem[page * BLOCK_SIZE]);
+		nblocks++;
+	}
+	for (b = 0; b < state_blocks; b++) {
+		if (0 == memcmp(&ref_state[b * BLOCK_SIZE], &new_state[b * BLOCK_SIZE], BLOCK_SIZE))
+			continue;
+		size = rewind_block(size, L1SIZE + b,
+			&ref_state[b * BLOCK_SIZE], &new_state[b * BLOCK_SIZE]);
+		nblocks++;
+	}
+	rewind_arm();
+
+	snap = malloc(size);
+	if (NULL == snap)
+		return;
+	memcpy(snap, work, size);
+	snap->size = size;
+	snap->nblocks = nblocks;
+
+	if (REWIND_MAX == count)
+		rewind_drop();
+	while (count > 0 && used + size > budget)
+		rewind_drop();
+	ring[(head + count) % REWIND_MAX] = snap;
+	count++;
+	used += size;
+}
+
+/**
+ * @brief go back one snapshot
+ *
+ * If the machine ran on since the newest snapshot, the first step goes
+ * back to that snapshot (the reference). Only a step taken right at the
+ * reference applies the newest snapshot's deltas and drops it.
+ */
+static void rewind_back(void)
+{
+	rewind_snap_t *snap;
+	const uint8_t *src;
+	uint32_t i, block, len;
+
+	if (count > 0 && 0 == frames && 0 == dirty) {
+		/* turn the reference into the snapshot before the newest */
+		snap = ring[(head + count - 1) % REWIND_MAX];
+		src = (const uint8_t *)(snap + 1);
+		for (i = 0; i < snap->nblocks; i++) {
+			block = src[0] | (src[1] << 8);
+			len = src[2] | (src[3] << 8);
+			src += 4;
+			if (block < L1SIZE)
+				rewind_decode(&ref_mem[block * BLOCK_SIZE], src, len);
+			else
+				rewind_decode(&ref_state[(block - L1SIZE) * BLOCK_SIZE], src, len);
+			src += len;
+		}
+		count--;
+		used -= snap->size;
+		free(snap);
+		ring[(head + count) % REWIND_MAX] = NULL;
+	}
+	memcpy(machine->mem, ref_mem, MEMSIZE);
+	state_load_mem(ref_state, state_blocks * BLOCK_SIZE, STATE_NO_MEM);
+	rewind_arm();
+	frames = 0;
+}
+
+/** @brief set up the rewind buffer from the command line options */
+int rewind_init(int argc, char **argv)
+{
+	uint32_t mb = REWIND_MB;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-rw"))
+			interval = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-rwmb"))
+			mb = strtoul(argv[++i], NULL, 0);
+	}
+	if (0 == interval)
+		return 0;
+
+	budget = (uint64_t)mb << 20;
+	state_blocks = (state_size(STATE_NO_MEM) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	ref_mem = malloc(MEMSIZE);
+	ref_state = calloc(state_blocks, BLOCK_SIZE);
+	new_state = calloc(state_blocks, BLOCK_SIZE);
+	work = malloc(sizeof(rewind_snap_t) + (L1SIZE + state_blocks) * (4 + BLOCK_MAX));
+	if (NULL == ref_mem || NULL == ref_state || NULL == new_state || NULL == work) {
+		rewind_exit();
+		return -1;
+	}
+	memcpy(ref_mem, machine->mem, MEMSIZE);
+	if (state_save_mem(ref_state, state_blocks * BLOCK_SIZE, STATE_NO_MEM) < 0) {
+		rewind_exit();
+		return -1;
+	}
+	rewind_arm();
+	enabled = 1;
+	return 0;
+}
+
+/** @brief count a frame (call from the frame timer) */
+void rewind_frame(void)
+{
+	frames++;
+}
+
+/** @brief step back to the previous snapshot (hotkey) */
+void rewind_step(void)
+{
+	steps++;
+}
+
+/** @brief take a snapshot or step back if due (call between time slices) */
+void rewind_poll(void)
+{
+	if (0 == enabled)
+		return;
+	if (steps > 0) {
+		steps--;
+		rewind_back();
+		return;
+	}
+	if (frames < interval)
+		return;
+	frames = 0;
+	rewind_snapshot();
+}
+
+/** @brief free the rewind buffer */
+void rewind_exit(void)
+{
+	if (enabled)
+		rewind_disarm();
+	while (count > 0)
+		rewind_drop();
+	free(ref_mem);
+	ref_mem = NULL;
+	free(ref_state);
+	ref_state = NULL;
+	free(new_state);
+	new_state = NULL;
+	free(work);
+	work = NULL;
+	enabled = 0;
+	interval = 0;
+	head = 0;
+	used = 0;
+}
@@ -0,0 +1,104 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * rewindtest.c	Rewind buffer checks
+ *
+ * Takes a snapshot after each of a few frames, each of which writes
+ * its number to memory and to a registered state variable, and then
+ * steps back. The first step must return to the newest snapshot if
+ * the machine ran on since it was taken, and each further step to
+ * the snapshot before.
+ *
+ * The program exits with status 1 if any check fails.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "rewind.h"
+#include "state.h"
+
+/** @brief address written to by every frame */
+#define	ADDR	0x1234
+
+/** @brief number of frames with a snapshot */
+#define	FRAMES	4
+
+/** @brief command line of the checks (a snapshot every frame) */
+static char *args[] = {
+	"rewindtest", "-rw", "1", NULL
+};
+
+/** @brief state variable written to by every frame */
+static uint32_t tick;
+
+/** @brief name of the system (the save states' machine name) */
+const char *sys_get_name(void)
+{
+	return "rewindtest";
+}
+
+static void wr_ram(uint32_t addr, uint8_t data)
+{
+	machine->mem[addr] = data;
+}
+
+/** @brief run a frame: write n to memory and to tick */
+static void frame(uint32_t n)
+{
+	program_write_byte(ADDR, n);
+	tick = n;
+	rewind_frame();
+}
+
+/** @brief step back once and check memory and state for the expected frame */
+static int step(const char *what, uint32_t n)
+{
+	int ok;
+
+	rewind_step();
+	rewind_poll();
+	ok = n == machine->mem[ADDR] && n == tick;
+	printf("%-10s mem=%u tick=%u expected %u%s\n", what,
+		machine->mem[ADDR], tick, n, ok ? " ok" : " FAIL");
+	return ok ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	int rc = 0;
+	uint32_t i;
+
+	for (i = 0; i < L1SIZE; i++) {
+		machine->wr_mem[i] = wr_ram;
+		machine->wr_ptr[i] = &machine->mem[i << L1SHIFT];
+	}
+	state_register("rewindtest", 0, "tick", &tick, sizeof(tick));
+	if (rewind_init(sizeof(args)/sizeof(args[0]) - 1, args) < 0) {
+		printf("rewind_init() failed\n");
+		return 1;
+	}
+
+	for (i = 1; i <= FRAMES; i++) {
+		frame(i);
+		rewind_poll();
+	}
+
+	/* run on past the newest snapshot: back to it, then to the ones before */
+	frame(FRAMES + 1);
+	if (step("ran on", FRAMES) < 0)
+		rc = 1;
+	if (step("back", FRAMES - 1) < 0)
+		rc = 1;
+	if (step("back", FRAMES - 2) < 0)
+		rc = 1;
+
+	/* only write memory, without a full frame */
+	program_write_byte(ADDR, 0xff);
+	if (step("dirty", FRAMES - 2) < 0)
+		rc = 1;
+	if (step("back", FRAMES - 3) < 0)
+		rc = 1;
+
+	rewind_exit();
+	return rc;
+}
@@ -0,0 +1,485 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * state.c	Machine save states
+ *
+ * Modules register the variables which make up their state, identified
+ * by a module name, an instance number and an item name. A save state
+ * is a header followed by one record per registered item:
+ *
+ *	char	 magic[8]	"Z80STATE"
+ *	uint32_t version	STATE_VERSION
+ *	uint32_t count		number of records
+ *	char	 machine[16]	sys_get_name()
+ *	count *	{ uint32_t id; uint32_t size; uint8_t data[size]; }
+ *
+ * The id is the FNV-1a hash of "module/instance/name". Values are stored
+ * in host byte order and the data is copied as is, so only plain data
+ * (no pointers) may be registered. Timers are stored by value, including
+ * their position in the scheduler's heap, so that timers expiring at the
+ * same time fire in the same order after a state was loaded.
+ *
+ * When loading, all records are checked before anything is changed.
+ * Records for items which are not registered are skipped, and items
+ * without a record keep their current value.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "state.h"
+
+/** @brief maximum number of presave/postload hook pairs */
+#define	STATE_HOOKS	16
+
+/** @brief size of the header */
+#define	STATE_HEADER	32
+
+/** @brief size of a record header */
+#define	STATE_RECORD	8
+
+typedef struct {
+	/** @brief hash of module, instance and name */
+	uint32_t id;
+	/** @brief size of the data */
+	uint32_t size;
+	/** @brief address of the data (NULL for a timer) */
+	void *data;
+	/** @brief address of the timer pointer (NULL for data) */
+	tmr_t **timer;
+}	state_item_t;
+
+typedef struct {
+	tmr_time_t fired;
+	tmr_time_t expire;
+	tmr_time_t restart;
+	uint32_t param;
+	/** @brief position in the scheduler's heap (U32INVALID if not scheduled) */
+	uint32_t index;
+}	state_timer_t;
+
+/** @brief registered items */
+static MACHINE_LOCAL state_item_t *items;
+
+/** @brief number of registered items */
+static MACHINE_LOCAL uint32_t nitems;
+
+/** @brief functions called before saving a state */
+static MACHINE_LOCAL void (*presave[STATE_HOOKS])(void);
+
+/** @brief functions called after loading a state */
+static MACHINE_LOCAL void (*postload[STATE_HOOKS])(void);
+
+/** @brief number of hook pairs */
+static MACHINE_LOCAL uint32_t nhooks;
+
+/** @brief file to load the state from before starting (-ls) */
+static MACHINE_LOCAL const char *load_filename;
+
+/** @brief file to save the state to (-ss) */
+static MACHINE_LOCAL const char *save_filename;
+
+/** @brief cycles between two checkpoints (-cp, 0 for none) */
+static MACHINE_LOCAL uint64_t checkpoint;
+
+/** @brief cycles_total when the next checkpoint is due */
+static MACHINE_LOCAL uint64_t checkpoint_next;
+
+/** @brief buffer for saving to a file */
+static MACHINE_LOCAL uint8_t *state_buff;
+
+/** @brief size of state_buff */
+static MACHINE_LOCAL uint32_t state_buff_size;
+
+/** @brief FNV-1a hash of a string, continuing from hash h */
+static uint32_t state_hash(uint32_t h, const char *s)
+{
+	while ('\0' != *s) {
+		h ^= (uint8_t)*s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/** @brief return the id of a module instance's item */
+static uint32_t state_id(const char *module, uint32_t instance, const char *name)
+{
+	char num[16];
+	uint32_t h = 2166136261u;
+
+	snprintf(num, sizeof(num), "/%u/", instance);
+	h = state_hash(h, module);
+	h = state_hash(h, num);
+	return state_hash(h, name);
+}
+
+/** @brief return the item with an id, or NULL if it is not registered */
+static state_item_t *state_find(uint32_t id)
+{
+	uint32_t i;
+
+	for (i = 0; i < nitems; i++)
+		if (id == items[i].id)
+			return &items[i];
+	return NULL;
+}
+
+/** @brief add or replace an item */
+static int state_add(uint32_t id, void *data, tmr_t **timer, uint32_t size)
+{
+	state_item_t *item, *tmp;
+
+	item = state_find(id);
+	if (NULL == item) {
+		if (0 == (nitems % 64)) {
+			tmp = realloc(items, (nitems + 64) * sizeof(state_item_t));
+			if (NULL == tmp)
+				return -1;
+			items = tmp;
+		}
+		item = &items[nitems++];
+	}
+	item->id = id;
+	item->size = size;
+	item->data = data;
+	item->timer = timer;
+	return 0;
+}
+
+/** @brief register plain data (no pointers) of a module instance */
+int state_register(const char *module, uint32_t instance,
+	const char *name, void *data, uint32_t size)
+{
+	if (NULL == data || 0 == size)
+		return -1;
+	return state_add(state_id(module, instance, name), data, NULL, size);
+}
+
+/** @brief register a timer: its expiry, period and parameter are saved */
+int state_register_timer(const char *module, uint32_t instance,
+	const char *name, tmr_t **timer)
+{
+	if (NULL == timer)
+		return -1;
+	return state_add(state_id(module, instance, name), NULL, timer,
+		sizeof(state_timer_t));
+}
+
+/** @brief register functions to call before saving and after loading a state */
+int state_register_hooks(void (*pre)(void), void (*post)(void))
+{
+	uint32_t i;
+
+	for (i = 0; i < nhooks; i++)
+		if (pre == presave[i] && post == postload[i])
+			return 0;
+	if (nhooks >= STATE_HOOKS)
+		return -1;
+	presave[nhooks] = pre;
+	postload[nhooks] = post;
+	nhooks++;
+	return 0;
+}
+
+/** @brief return non zero if an item is left out with flags */
+static __inline int state_skip(const state_item_t *item, int flags)
+{
+	return (flags & STATE_NO_MEM) && item->data == (void *)machine->mem;
+}
+
+/** @brief return the size of a save state in bytes */
+uint32_t state_size(int flags)
+{
+	uint32_t i, size = STATE_HEADER;
+
+	for (i = 0; i < nitems; i++)
+		if (!state_skip(&items[i], flags))
+			size += STATE_RECORD + items[i].size;
+	return size;
+}
+
+static __inline void put32(uint8_t *dst, uint32_t val)
+{
+	memcpy(dst, &val, sizeof(val));
+}
+
+static __inline uint32_t get32(const uint8_t *src)
+{
+	uint32_t val;
+	memcpy(&val, src, sizeof(val));
+	return val;
+}
+
+/** @brief save a timer to a record */
+static void state_save_timer(tmr_t *timer, uint8_t *dst)
+{
+	state_timer_t st;
+
+	memset(&st, 0, sizeof(st));
+	st.index = U32INVALID;
+	if (NULL != timer && timer->index < machine->ti &&
+		timer == machine->timers[timer->index]) {
+		st.fired = timer->fired;
+		st.expire = timer->expire;
+		st.restart = timer->restart;
+		st.param = timer->param;
+		st.index = timer->index;
+	}
+	memcpy(dst, &st, sizeof(st));
+}
+
+/** @brief save the state to a buffer of state_size() bytes */
+int state_save_mem(uint8_t *buff, uint32_t size, int flags)
+{
+	uint8_t *dst = buff;
+	uint32_t i, count;
+
+	if (size < state_size(flags))
+		return -1;
+	for (i = 0; i < nhooks; i++)
+		if (NULL != presave[i])
+			(*presave[i])();
+	/* compute pending lazy flags, so the state does not depend on the core */
+	z80_get_reg(&machine->cpu, Z80_AF);
+
+	memset(dst, 0, STATE_HEADER);
+	memcpy(dst, STATE_MAGIC, 8);
+	put32(dst + 8, STATE_VERSION);
+	strncpy((char *)dst + 16, sys_get_name(), 15);
+	dst += STATE_HEADER;
+
+	for (i = 0, count = 0; i < nitems; i++) {
+		if (state_skip(&items[i], flags))
+			continue;
+		count++;
+		put32(dst, items[i].id);
+		put32(dst + 4, items[i].size);
+		dst += STATE_RECORD;
+		if (NULL != items[i].timer)
+			state_save_timer(*items[i].timer, dst);
+		else
+			memcpy(dst, items[i].data, items[i].size);
+		dst += items[i].size;
+	}
+	put32(buff + 12, count);
+	return 0;
+}
+
+/** @brief load the state from a buffer */
+int state_load_mem(const uint8_t *buff, uint32_t size, int flags)
+{
+	const uint8_t *src, *end = buff + size;
+	state_item_t *item;
+	state_timer_t st;
+	uint32_t i, count, id, len;
+	char name[16];
+
+	if (size < STATE_HEADER || memcmp(buff, STATE_MAGIC, 8)) {
+		fprintf(stderr, "state: not a save state\n");
+		return -1;
+	}
+	if (STATE_VERSION != get32(buff + 8)) {
+		fprintf(stderr, "state: version %u is not supported\n", get32(buff + 8));
+		return -1;
+	}
+	memset(name, 0, sizeof(name));
+	memcpy(name, buff + 16, 15);
+	if (strncmp(name, sys_get_name(), 15)) {
+		fprintf(stderr, "state: saved by %s, not %s\n", name, sys_get_name());
+		return -1;
+	}
+	count = get32(buff + 12);
+
+	/* check all records before changing anything */
+	for (i = 0, src = buff + STATE_HEADER; i < count; i++) {
+		if (end - src < STATE_RECORD)
+			break;
+		id = get32(src);
+		len = get32(src + 4);
+		src += STATE_RECORD;
+		if ((uint32_t)(end - src) < len)
+			break;
+		item = state_find(id);
+		if (NULL != item && len != item->size) {
+			fprintf(stderr, "state: record %08x has size %u, expected %u\n",
+				id, len, item->size);
+			return -1;
+		}
+		src += len;
+	}
+	if (i < count) {
+		fprintf(stderr, "state: truncated after %u of %u records\n", i, count);
+		return -1;
+	}
+
+	for (i = 0, src = buff + STATE_HEADER; i < count; i++) {
+		id = get32(src);
+		len = get32(src + 4);
+		src += STATE_RECORD;
+		item = state_find(id);
+		if (NULL != item && state_skip(item, flags))
+			item = NULL;
+		if (NULL != item && NULL != item->timer) {
+			memcpy(&st, src, sizeof(st));
+			if (NULL != *item->timer && U32INVALID != st.index)
+				tmr_restore(*item->timer, st.fired, st.expire,
+					st.restart, st.param, st.index);
+		} else if (NULL != item) {
+			memcpy(item->data, src, len);
+		}
+		src += len;
+	}
+	tmr_rebuild();
+
+	for (i = 0; i < nhooks; i++)
+		if (NULL != postload[i])
+			(*postload[i])();
+	/* cached basic blocks may no longer match the memory */
+	z80_bc_flush();
+	return 0;
+}
+
+/** @brief save the state to a file */
+int state_save(const char *filename)
+{
+	char tmpname[FILENAME_MAX];
+	uint32_t size = state_size(0);
+	uint8_t *tmp;
+	FILE *fp;
+
+	if (size > state_buff_size) {
+		tmp = realloc(state_buff, size);
+		if (NULL == tmp)
+			return -1;
+		state_buff = tmp;
+		state_buff_size = size;
+	}
+	if (state_save_mem(state_buff, size, 0) < 0)
+		return -1;
+
+	/* write a temporary file, so a crash never leaves a partial state */
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+	fp = fopen(tmpname, "wb");
+	if (NULL == fp) {
+		perror(tmpname);
+		return -1;
+	}
+	if (size != fwrite(state_buff, 1, size, fp)) {
+		perror(tmpname);
+		fclose(fp);
+		remove(tmpname);
+		return -1;
+	}
+	if (0 != fclose(fp) || 0 != rename(tmpname, filename)) {
+		perror(filename);
+		remove(tmpname);
+		return -1;
+	}
+	return 0;
+}
+
+/** @brief load the state from a file */
+int state_load(const char *filename)
+{
+	uint8_t *buff;
+	long size;
+	FILE *fp;
+	int rc;
+
+	fp = fopen(filename, "rb");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (size <= 0) {
+		fclose(fp);
+		return -1;
+	}
+	buff = malloc(size);
+	if (NULL == buff) {
+		fclose(fp);
+		return -1;
+	}
+	if ((size_t)size != fread(buff, 1, size, fp)) {
+		perror(filename);
+		fclose(fp);
+		free(buff);
+		return -1;
+	}
+	fclose(fp);
+	rc = state_load_mem(buff, (uint32_t)size, 0);
+	free(buff);
+	return rc;
+}
+
+/** @brief set up save states from the command line options */
+int state_init(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-ls"))
+			load_filename = argv[++i];
+		else if (!strcmp(argv[i], "-ss"))
+			save_filename = argv[++i];
+		else if (!strcmp(argv[i], "-cp"))
+			checkpoint = strtoull(argv[++i], NULL, 0);
+	}
+	if (0 != checkpoint && NULL == save_filename) {
+		fprintf(stderr, "state: -cp needs a file to save to (-ss)\n");
+		return -1;
+	}
+
+	/* the CPU, memory and scheduler of the machine */
+	state_register("machine", 0, "cpu", &machine->cpu, sizeof(machine->cpu));
+	state_register("machine", 0, "dma", &machine->dma, sizeof(machine->dma));
+	state_register("machine", 0, "mem", machine->mem, sizeof(machine->mem));
+	state_register("machine", 0, "cycles_this_frame",
+		&machine->cycles_this_frame, sizeof(machine->cycles_this_frame));
+	state_register("machine", 0, "cycles_total",
+		&machine->cycles_total, sizeof(machine->cycles_total));
+	state_register("timer", 0, "now", &machine->now, sizeof(machine->now));
+	state_register("timer", 0, "hz", &machine->hz, sizeof(machine->hz));
+	state_register("timer", 0, "ns_per_cc",
+		&machine->ns_per_cc, sizeof(machine->ns_per_cc));
+	state_register("timer", 0, "base", &machine->base, sizeof(machine->base));
+	state_register("timer", 0, "secs", &machine->secs, sizeof(machine->secs));
+	state_register("timer", 0, "ticks", &machine->ticks, sizeof(machine->ticks));
+	return 0;
+}
+
+/** @brief load the state given with -ls (call after all modules registered) */
+int state_start(void)
+{
+	if (NULL != load_filename && state_load(load_filename) < 0)
+		return -1;
+	checkpoint_next = machine->cycles_total + checkpoint;
+	return 0;
+}
+
+/** @brief save a checkpoint if it is due (call between time slices) */
+void state_poll(void)
+{
+	if (0 == checkpoint || machine->cycles_total < checkpoint_next)
+		return;
+	checkpoint_next = machine->cycles_total + checkpoint;
+	state_save(save_filename);
+}
+
+/** @brief save the state given with -ss */
+void state_exit(void)
+{
+	if (NULL != save_filename)
+		state_save(save_filename);
+	free(state_buff);
+	state_buff = NULL;
+	state_buff_size = 0;
+	free(items);
+	items = NULL;
+	nitems = 0;
+	nhooks = 0;
+}
@@ -0,0 +1,273 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * stats.c	Host time and emulated cycle statistics
+ *
+ * The host time between stats_enter() and stats_leave() is charged to
+ * a category. Categories nest, and time is always charged to the
+ * innermost one, so a frame rendered from a timer callback counts as
+ * video, not as timer time. Time outside of any category is reported
+ * as "other". stats_frame() closes a frame: its per category times
+ * and CPU cycles go into a ring of the last STATS_FRAMES frames, from
+ * which the percentiles and log2 histograms are computed by stats_dump().
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include <time.h>
+#include "stats.h"
+
+/** @brief maximum nesting of categories */
+#define	STATS_DEPTH	8
+
+/** @brief columns of a frame record: categories, other and the whole frame */
+#define	STATS_OTHER	(STATS_MAX)
+#define	STATS_WALL	(STATS_MAX + 1)
+#define	STATS_COLS	(STATS_MAX + 2)
+
+typedef struct {
+	/** @brief host nanoseconds per column */
+	uint64_t ns[STATS_COLS];
+	/** @brief CPU cycles run during the frame */
+	uint32_t cc;
+}	stats_rec_t;
+
+static const char *stats_names[STATS_COLS] = {
+	"cpu", "timer", "video", "mng", "present", "throttle", "other", "frame"
+};
+
+static const char *stats_bucket_names[STATS_BUCKETS] = {
+	"1u", "2u", "4u", "8u", "16u", "32u", "64u", "128u",
+	"256u", "512u", "1m", "2m", "4m", "8m", "16m", "more"
+};
+
+/** @brief non zero if statistics are collected */
+MACHINE_LOCAL int stats_on;
+
+/** @brief file to write the statistics to when exiting ("-" for stdout) */
+static MACHINE_LOCAL char *stats_filename;
+
+/** @brief host time of the last category switch */
+static MACHINE_LOCAL uint64_t stats_last;
+
+/** @brief host time when the current frame started */
+static MACHINE_LOCAL uint64_t stats_start;
+
+/** @brief stack of active categories */
+static MACHINE_LOCAL int stats_stack[STATS_DEPTH];
+
+/** @brief number of active categories */
+static MACHINE_LOCAL int stats_depth;
+
+/** @brief host time per category in the current frame */
+static MACHINE_LOCAL uint64_t stats_cur[STATS_MAX];
+
+/** @brief host time per column since stats_init() */
+static MACHINE_LOCAL uint64_t stats_total[STATS_COLS];
+
+/** @brief CPU cycles since stats_init() */
+static MACHINE_LOCAL uint64_t stats_cc;
+
+/** @brief number of frames since stats_init() */
+static MACHINE_LOCAL uint64_t stats_frames;
+
+/** @brief ring of the last STATS_FRAMES frame records */
+static MACHINE_LOCAL stats_rec_t *stats_ring;
+
+/** @brief return the host time in nanoseconds */
+static __inline uint64_t stats_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/** @brief charge the time since the last switch to the innermost category */
+static __inline void stats_charge(uint64_t t)
+{
+	if (stats_depth > 0 && stats_depth <= STATS_DEPTH)
+		stats_cur[stats_stack[stats_depth - 1]] += t - stats_last;
+	stats_last = t;
+}
+
+/** @brief enable statistics from the command line options (-S file) */
+int stats_init(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-S") || i + 1 >= argc)
+			continue;
+		stats_filename = strdup(argv[i + 1]);
+		stats_ring = calloc(STATS_FRAMES, sizeof(stats_rec_t));
+		if (NULL == stats_filename || NULL == stats_ring) {
+			free(stats_filename);
+			free(stats_ring);
+			return -1;
+		}
+		stats_start = stats_last = stats_clock();
+		stats_on = 1;
+		break;
+	}
+	return 0;
+}
+
+/** @brief write the statistics to the file given with -S and stop collecting */
+void stats_exit(void)
+{
+	FILE *fp;
+
+	if (0 == stats_on)
+		return;
+	if (strcmp(stats_filename, "-")) {
+		fp = fopen(stats_filename, "w");
+		if (NULL == fp) {
+			perror(stats_filename);
+		} else {
+			stats_dump(fp);
+			fclose(fp);
+		}
+	} else {
+		stats_dump(stdout);
+	}
+	stats_on = 0;
+	free(stats_filename);
+	stats_filename = NULL;
+	free(stats_ring);
+	stats_ring = NULL;
+}
+
+/** @brief charge host time to a category until the matching stats_leave() */
+void stats_enter(stats_cat_t cat)
+{
+	stats_charge(stats_clock());
+	if (stats_depth < STATS_DEPTH)
+		stats_stack[stats_depth] = cat;
+	stats_depth++;
+}
+
+/** @brief return to the category active before the last stats_enter() */
+void stats_leave(void)
+{
+	stats_charge(stats_clock());
+	if (stats_depth > 0)
+		stats_depth--;
+}
+
+/** @brief end a frame which ran a number of CPU cycles */
+void stats_frame(uint32_t cc)
+{
+	stats_rec_t *rec;
+	uint64_t t, sum = 0;
+	int i;
+
+	if (0 == stats_on)
+		return;
+	t = stats_clock();
+	rec = &stats_ring[stats_frames % STATS_FRAMES];
+	stats_charge(t);
+	for (i = 0; i < STATS_MAX; i++) {
+		rec->ns[i] = stats_cur[i];
+		sum += stats_cur[i];
+		stats_cur[i] = 0;
+	}
+	rec->ns[STATS_WALL] = t - stats_start;
+	rec->ns[STATS_OTHER] = rec->ns[STATS_WALL] > sum ?
+		rec->ns[STATS_WALL] - sum : 0;
+	rec->cc = cc;
+	for (i = 0; i < STATS_COLS; i++)
+		stats_total[i] += rec->ns[i];
+	stats_cc += cc;
+	stats_frames++;
+	stats_start = t;
+}
+
+static int stats_cmp(const void *p1, const void *p2)
+{
+	const uint64_t a = *(const uint64_t *)p1;
+	const uint64_t b = *(const uint64_t *)p2;
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/** @brief return the histogram bucket for a time in nanoseconds */
+static int stats_bucket(uint64_t ns)
+{
+	uint64_t us = ns / 1000;
+	int b = 0;
+
+	while (us > 0 && b < STATS_BUCKETS - 1) {
+		us >>= 1;
+		b++;
+	}
+	return b;
+}
+
+/** @brief write the statistics of the last frames as a histogram */
+void stats_dump(FILE *fp)
+{
+	uint32_t hist[STATS_COLS][STATS_BUCKETS];
+	uint64_t *val;
+	uint64_t sum;
+	uint32_t i, n;
+	int c, b;
+
+	if (NULL == stats_ring || 0 == stats_frames) {
+		fprintf(fp, "stats: no frames\n");
+		return;
+	}
+	n = stats_frames < STATS_FRAMES ? (uint32_t)stats_frames : STATS_FRAMES;
+	val = calloc(n, sizeof(uint64_t));
+	if (NULL == val)
+		return;
+
+	fprintf(fp, "stats: %llu frames, %.3f s host, %llu cycles, %.3f MHz emulated\n",
+		(unsigned long long)stats_frames,
+		stats_total[STATS_WALL] / 1e9,
+		(unsigned long long)stats_cc,
+		stats_total[STATS_WALL] ?
+			stats_cc * 1e3 / stats_total[STATS_WALL] : 0.0);
+
+	for (i = 0, sum = 0; i < n; i++) {
+		val[i] = stats_ring[i].cc;
+		sum += val[i];
+	}
+	qsort(val, n, sizeof(uint64_t), stats_cmp);
+	fprintf(fp, "cycles per frame (last %u frames): mean %llu min %llu"
+		" p50 %llu p99 %llu max %llu\n", n,
+		(unsigned long long)(sum / n), (unsigned long long)val[0],
+		(unsigned long long)val[n / 2], (unsigned long long)val[n * 99 / 100],
+		(unsigned long long)val[n - 1]);
+
+	fprintf(fp, "host us per frame (last %u frames):\n", n);
+	fprintf(fp, "%-9s %6s %9s %9s %9s %9s %9s\n",
+		"category", "share", "mean", "p50", "p90", "p99", "max");
+	memset(hist, 0, sizeof(hist));
+	for (c = 0; c < STATS_COLS; c++) {
+		for (i = 0, sum = 0; i < n; i++) {
+			val[i] = stats_ring[i].ns[c];
+			sum += val[i];
+			hist[c][stats_bucket(val[i])]++;
+		}
+		qsort(val, n, sizeof(uint64_t), stats_cmp);
+		fprintf(fp, "%-9s %5.1f%% %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+			stats_names[c],
+			stats_total[STATS_WALL] ?
+				100.0 * stats_total[c] / stats_total[STATS_WALL] : 0.0,
+			sum / 1e3 / n, val[n / 2] / 1e3, val[n * 9 / 10] / 1e3,
+			val[n * 99 / 100] / 1e3, val[n - 1] / 1e3);
+	}
+
+	fprintf(fp, "frames per host time bucket (last %u frames, upper bound):\n", n);
+	fprintf(fp, "%-9s", "category");
+	for (b = 0; b < STATS_BUCKETS; b++)
+		fprintf(fp, " %5s", stats_bucket_names[b]);
+	fprintf(fp, "\n");
+	for (c = 0; c < STATS_COLS; c++) {
+		fprintf(fp, "%-9s", stats_names[c]);
+		for (b = 0; b < STATS_BUCKETS; b++)
+			fprintf(fp, " %5u", hist[c][b]);
+		fprintf(fp, "\n");
+	}
+	free(val);
+}
@@ -7,38 +7,123 @@
  *
  ***************************************************************************************/
 #include "timer.h"
+#include "stats.h"
 
-/** @brief current time */
-tmr_time_t now;
+/* the scheduler state of the current machine */
+#define	now		(machine->now)
+#define	timers		(machine->timers)
+#define	ti		(machine->ti)
+#define	tmr_hz		(machine->hz)
+#define	tmr_ns_per_cc	(machine->ns_per_cc)
+#define	tmr_base	(machine->base)
+#define	tmr_secs	(machine->secs)
+#define	tmr_ticks	(machine->ticks)
 
-/** @brief cycles to run in the current timeslice */
-int cycles = 0;
+/** @brief return non-zero if a timer is in the heap */
+static __inline int tmr_valid(tmr_t *timer)
+{
+	return NULL != timer && timer->index < ti && timer == timers[timer->index];
+}
 
-/** @brief sum of cycles during the last frame */
-int cycles_this_frame = 0;
+/** @brief store a timer at heap position i */
+static __inline void tmr_place(tmr_t *timer, uint32_t i)
+{
+	timers[i] = timer;
+	timer->index = i;
+}
 
-double tmr_clock = 0.0;
+/** @brief move the timer at heap position i up towards the root */
+static uint32_t tmr_sift_up(uint32_t i)
+{
+	tmr_t *timer = timers[i];
 
-static tmr_t *timers[MAX_TMR];
-static uint32_t ti;
-static volatile int adjust = 0;
+	while (i > 0) {
+		uint32_t parent = (i - 1) / 2;
+		if (timers[parent]->expire <= timer->expire)
+			break;
+		tmr_place(timers[parent], i);
+		i = parent;
+	}
+	tmr_place(timer, i);
+	return i;
+}
 
-/** @brief sort the list of timers by expire */
-int sort_time(const void *p1, const void *p2)
+/** @brief move the timer at heap position i down towards the leaves */
+static uint32_t tmr_sift_down(uint32_t i)
 {
-	const tmr_t *t1 = *(const tmr_t **)p1;
-	const tmr_t *t2 = *(const tmr_t **)p2;
-	if (t1->expire < t2->expire)
-		return -1;
-	if (t1->expire > t2->expire)
-		return +1;
-	return 0;
+	tmr_t *timer = timers[i];
+
+	for (;;) {
+		uint32_t child = 2 * i + 1;
+		if (child >= ti)
+			break;
+		if (child + 1 < ti && timers[child + 1]->expire < timers[child]->expire)
+			child++;
+		if (timer->expire <= timers[child]->expire)
+			break;
+		tmr_place(timers[child], i);
+		i = child;
+	}
+	tmr_place(timer, i);
+	return i;
+}
+
+/** @brief restore the heap order after a timer's expire changed */
+static void tmr_update(tmr_t *timer)
+{
+	uint32_t i = timer->index;
+
+	/* only sift down if the timer did not move up */
+	if (tmr_sift_up(i) == i)
+		tmr_sift_down(i);
 }
 
 /** @brief return the current time */
 tmr_time_t time_now(void)
 {
-	return now + tmr_double_to_time((double)z80_cc / tmr_clock);
+	return now + (tmr_time_t)(((uint64_t)machine->cc * tmr_ns_per_cc) >> 32);
+}
+
+/** @brief set the CPU clock rate in Hz */
+void tmr_set_clock(double clock)
+{
+	uint32_t hz = (uint32_t)(clock + 0.5);
+
+	if (hz == tmr_hz)
+		return;
+	/* count cycles from now on at the new rate */
+	tmr_base = now;
+	tmr_secs = 0;
+	tmr_ticks = 0;
+	tmr_hz = hz;
+	tmr_ns_per_cc = hz ? (1000000000ull << 32) / hz : 0;
+}
+
+/** @brief advance the time by a number of CPU cycles */
+static void tmr_advance(uint32_t cc)
+{
+	if (0 == tmr_hz)
+		return;
+	tmr_ticks += cc % tmr_hz;
+	tmr_secs += cc / tmr_hz;
+	if (tmr_ticks >= tmr_hz) {
+		tmr_ticks -= tmr_hz;
+		tmr_secs++;
+	}
+	/* exact: tmr_ticks * 10^9 fits into 64 bits */
+	now = tmr_base + (tmr_time_t)(tmr_secs * 1000000000ull +
+		(uint64_t)tmr_ticks * 1000000000ull / tmr_hz);
+}
+
+/** @brief return the number of CPU cycles until time dt has passed */
+static uint32_t tmr_cycles(tmr_time_t dt)
+{
+	if (dt <= 0)
+		return 0;
+	/* slices are never longer than one second */
+	if (dt > 1000000000)
+		dt = 1000000000;
+	return (uint32_t)(((uint64_t)dt * tmr_hz + 999999999ull) / 1000000000ull);
 }
 
 /** @brief allocate a new timer */
@@ -47,33 +132,37 @@ tmr_t *tmr_alloc(void (*callback)(uint32_t), tmr_time_t t, uint32_t param, tmr_t
 	tmr_t *timer;
 	if (ti >= MAX_TMR)
 		return NULL;
-	timers[ti] = timer = calloc(1, sizeof(tmr_t));
+	timer = calloc(1, sizeof(tmr_t));
 	if (NULL == timer)
 		return NULL;
-	ti++;
 	timer->expire = time_now() + t;
 	timer->restart = r;
 	timer->param = param;
 	timer->callback = callback;
-	cycles = z80_cc;
+	tmr_place(timer, ti);
+	ti++;
+	tmr_sift_up(timer->index);
+	machine->cycles = machine->cc;
 	return timer;
 }
 
 /** @brief remove a timer from the list */
 int tmr_remove(tmr_t *timer)
 {
-	uint32_t i, j;
+	uint32_t i;
 
-	for (i = 0; i < ti; i++)
-		if (timer == timers[i])
-			break;
-	if (i >= ti)
+	if (!tmr_valid(timer))
 		return -1;
 
-	free(timer);
-	for (j = i + 1; j < ti; j++)
-		timers[j - 1] = timers[j];
+	i = timer->index;
 	ti--;
+	if (i < ti) {
+		/* move the last timer into the hole */
+		tmr_place(timers[ti], i);
+		tmr_update(timers[i]);
+	}
+	timers[ti] = NULL;
+	free(timer);
 
 	return 0;
 }
@@ -81,12 +170,7 @@ int tmr_remove(tmr_t *timer)
 /** @brief return the elapsed time for a timer */
 tmr_time_t tmr_elapsed(tmr_t *timer)
 {
-	uint32_t i;
-
-	for (i = 0; i < ti; i++)
-		if (timer == timers[i])
-			break;
-	if (i >= ti)
+	if (!tmr_valid(timer))
 		return -1;
 
 	return time_now() - timer->fired;
@@ -95,11 +179,7 @@ tmr_time_t tmr_elapsed(tmr_t *timer)
 /** @brief reset the time when a timer expires */
 int tmr_reset(tmr_t *timer, tmr_time_t t)
 {
-	int i;
-	for (i = 0; i < ti; i++)
-		if (timer == timers[i])
-			break;
-	if (i >= ti)
+	if (!tmr_valid(timer))
 		return -1;
 
 	if (time_never == t) {
@@ -107,41 +187,70 @@ int tmr_reset(tmr_t *timer, tmr_time_t t)
 	} else {
 		timer->expire = time_now() + t;
 	}
-	cycles = z80_cc;
+	tmr_update(timer);
+	machine->cycles = machine->cc;
 	return 0;
 }
 
 /** @brief adjust the time when a timer expires */
 int tmr_adjust(tmr_t *timer, tmr_time_t t, uint32_t param, tmr_time_t r)
 {
-	int i;
-	for (i = 0; i < ti; i++)
-		if (timer == timers[i])
-			break;
-	if (i >= ti)
+	if (!tmr_valid(timer))
 		return -1;
 
 	timer->expire = time_now() + t;
 	timer->restart = r;
 	timer->param = param;
-	cycles = z80_cc;
+	tmr_update(timer);
+	machine->cycles = machine->cc;
+	return 0;
+}
+
+/** @brief restore a timer saved at heap position index (call tmr_rebuild() when done) */
+int tmr_restore(tmr_t *timer, tmr_time_t fired, tmr_time_t expire,
+	tmr_time_t restart, uint32_t param, uint32_t index)
+{
+	tmr_t *other;
+
+	if (!tmr_valid(timer))
+		return -1;
+
+	timer->fired = fired;
+	timer->expire = expire;
+	timer->restart = restart;
+	timer->param = param;
+	if (index < ti && index != timer->index) {
+		/* swap places with the timer at the saved position */
+		other = timers[index];
+		tmr_place(other, timer->index);
+		tmr_place(timer, index);
+	}
 	return 0;
 }
 
+/** @brief restore the heap order after timers were restored */
+void tmr_rebuild(void)
+{
+	uint32_t i;
+
+	for (i = ti / 2; i-- > 0; /* */)
+		tmr_sift_down(i);
+	machine->cycles = machine->cc;
+}
+
+/** @brief return the timer which expires next */
 tmr_t *tmr_next_event(void)
 {
 	if (0 == ti)
 		return NULL;
-	qsort(timers, ti, sizeof(tmr_t *), sort_time);
 	return timers[0];
 }
 
-/** @brief adjust time by dt nanoseconds and expire timers */
-void tmr_expire(tmr_time_t dt)
+/** @brief fire all timers which are due */
+static void tmr_fire(void)
 {
 	tmr_t *timer;
 
-	now += dt;
 	while (ti > 0 && NULL != (timer = timers[0])) {
 
 		if (timer->expire > now)
@@ -149,50 +258,62 @@ void tmr_expire(tmr_time_t dt)
 
 		timer->fired = now;
 
-		if (timer->callback)
+		if (timer->callback) {
+			STATS_ENTER(STATS_TIMER);
 			(*timer->callback)(timer->param);
+			STATS_LEAVE();
+		}
 
 		if (time_zero == timer->restart) {
-#if	0
 			/* one shot timer (timer->expire may be modified) */
-			if (timer->expire <= now) {
-				LOG((3,"TIMER","remove one-shot %p\n", timer));
-				tmr_remove(timer);
-			}
-#endif
-			continue;
-		}
-		if (time_never == timer->restart) {
+			if (timer->expire <= now)
+				timer->expire = time_never;
+		} else if (time_never == timer->restart) {
 			/* one shot timer that never expires */
 			timer->expire = time_never;
-			continue;
+		} else {
+			/* repeated timer */
+			timer->expire = now + timer->restart;
 		}
-		/* repeated timer */
-		timer->expire = now + timer->restart;
+		tmr_update(timer);
+	}
+}
+
+/** @brief adjust time by dt nanoseconds and expire timers */
+void tmr_expire(tmr_time_t dt)
+{
+	if (0 == tmr_hz) {
+		now += dt;
+		tmr_base = now;
+	} else {
+		tmr_advance(tmr_cycles(dt));
 	}
+	tmr_fire();
 }
 
 /** @brief run the CPU(s) for the next time slice */
 void tmr_run_cpu(void *context, double clock)
 {
 	z80_cpu_t *cpu = (z80_cpu_t *)context;
-	tmr_t *slice = tmr_next_event();
+	tmr_t *slice;
 	int ran;
 
-	tmr_clock = clock;
+	tmr_set_clock(clock);
 	slice = tmr_next_event();
 	if (NULL == slice)
 		return;
-	if (slice->expire <= now)
-		cycles = 1;
-	else
-		cycles = (int)(tmr_time_to_double(slice->expire - now) * clock) - adjust;
+	machine->cycles = tmr_cycles(slice->expire - now);
+	if (0 == machine->cycles)
+		machine->cycles = 1;
 #if	0
 	z80_dump_state(cpu);
 #endif
+	STATS_ENTER(STATS_CPU);
 	ran = z80_execute(cpu);
-	cycles_this_frame += ran;
-	z80_cc = 0;
-	adjust = (ran > cycles) ? ran - cycles : 0;
-	tmr_expire(tmr_double_to_time((double)ran / clock));
+	STATS_LEAVE();
+	machine->cycles_this_frame += ran;
+	machine->cycles_total += ran;
+	machine->cc = 0;
+	tmr_advance(ran);
+	tmr_fire();
 }
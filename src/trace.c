@@ -0,0 +1,286 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * trace.c	Compressed execution trace recorder
+ *
+ * Before every instruction the Z80 core calls trace_record(), which
+ * appends a record to the current buffer. A record holds the cycles
+ * since the previous record and only what the decoder can not predict:
+ * the PC if it did not simply advance, the opcode bytes if they are not
+ * the ones last recorded for this PC, and the registers which changed.
+ * Most records are a few bytes.
+ *
+ * Full buffers are handed to a background thread, which compresses them
+ * with zlib and writes them to the file, so the emulation only stalls if
+ * the writer falls behind by TRACE_BUFS buffers.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include <zlib.h>
+#include <SDL.h>
+#include "trace.h"
+#include "machine.h"
+
+typedef struct {
+	/** @brief compressed output file */
+	gzFile gz;
+	/** @brief writer thread */
+	SDL_Thread *thread;
+	/** @brief lock for head, tail and quit */
+	SDL_mutex *lock;
+	/** @brief signalled when head or tail or quit change */
+	SDL_cond *cond;
+	/** @brief buffers */
+	uint8_t *buf[TRACE_BUFS];
+	/** @brief number of bytes in the buffers */
+	uint32_t size[TRACE_BUFS];
+	/** @brief number of buffers written */
+	uint32_t head;
+	/** @brief number of buffers filled */
+	uint32_t tail;
+	/** @brief non zero when the writer thread should exit */
+	int quit;
+	/** @brief non zero if writing failed */
+	int error;
+
+	/* the rest is only used by the emulation thread */
+
+	/** @brief current buffer */
+	uint8_t *cur;
+	/** @brief number of bytes in the current buffer */
+	uint32_t pos;
+	/** @brief cycle stamp of the previous record */
+	uint64_t stamp;
+	/** @brief expected PC */
+	uint32_t pc_next;
+	/** @brief first opcode byte of the previous instruction */
+	uint32_t op;
+	/** @brief registers of the previous record */
+	uint16_t reg[TRACE_REGS];
+	/** @brief number of records */
+	uint64_t count;
+	/** @brief number of bytes */
+	uint64_t bytes;
+	/** @brief opcode bytes last recorded for each PC */
+	uint32_t code[MEMSIZE];
+	/** @brief length of the instruction at each PC (0 if not recorded yet) */
+	uint8_t len[MEMSIZE];
+}	trace_t;
+
+/** @brief the recorder of this machine (NULL if off) */
+static MACHINE_LOCAL trace_t *trace;
+
+/** @brief writer thread: compress and write the filled buffers */
+static int trace_writer(void *data)
+{
+	trace_t *t = (trace_t *)data;
+	uint32_t n;
+
+	SDL_LockMutex(t->lock);
+	for (;;) {
+		while (t->head == t->tail && 0 == t->quit)
+			SDL_CondWait(t->cond, t->lock);
+		if (t->head == t->tail)
+			break;
+		n = t->head % TRACE_BUFS;
+		SDL_UnlockMutex(t->lock);
+		if (gzwrite(t->gz, t->buf[n], t->size[n]) != (int)t->size[n])
+			t->error = 1;
+		SDL_LockMutex(t->lock);
+		t->head++;
+		SDL_CondSignal(t->cond);
+	}
+	SDL_UnlockMutex(t->lock);
+	return 0;
+}
+
+/** @brief hand the current buffer to the writer and wait for a free one */
+static void trace_flush(trace_t *t)
+{
+	SDL_LockMutex(t->lock);
+	t->size[t->tail % TRACE_BUFS] = t->pos;
+	t->tail++;
+	SDL_CondSignal(t->cond);
+	while (t->tail - t->head >= TRACE_BUFS)
+		SDL_CondWait(t->cond, t->lock);
+	SDL_UnlockMutex(t->lock);
+	t->bytes += t->pos;
+	t->cur = t->buf[t->tail % TRACE_BUFS];
+	t->pos = 0;
+}
+
+/** @brief append a varint */
+static __inline uint8_t *trace_varint(uint8_t *dst, uint64_t val)
+{
+	while (val >= 0x80) {
+		*dst++ = (uint8_t)(val | 0x80);
+		val >>= 7;
+	}
+	*dst++ = (uint8_t)val;
+	return dst;
+}
+
+/** @brief record the state before an instruction */
+static void trace_record(z80_cpu_t *cpu)
+{
+	trace_t *t = trace;
+	uint8_t rec[TRACE_RECMAX];
+	uint8_t *dst = rec;
+	uint16_t reg[TRACE_REGS];
+	uint32_t pc = cpu->pc.word.w0;
+	uint32_t code, mask = 0, r, n;
+	uint64_t stamp = machine->cycles_total + (uint32_t)machine->cc;
+	uint8_t buff[4];
+	char dasm[80];
+
+	code = machine->mem[pc] | (machine->mem[(pc + 1) % MEMSIZE] << 8) |
+		(machine->mem[(pc + 2) % MEMSIZE] << 16) | ((uint32_t)machine->mem[(pc + 3) % MEMSIZE] << 24);
+
+	reg[TRACE_AF] = (uint16_t)z80_get_reg(cpu, Z80_AF);
+	reg[TRACE_BC] = cpu->bc.word.w0;
+	reg[TRACE_DE] = cpu->de.word.w0;
+	reg[TRACE_HL] = cpu->hl.word.w0;
+	reg[TRACE_IX] = cpu->ix.word.w0;
+	reg[TRACE_IY] = cpu->iy.word.w0;
+	reg[TRACE_SP] = cpu->sp.word.w0;
+	reg[TRACE_AF2] = cpu->af2.word.w0;
+	reg[TRACE_BC2] = cpu->bc2.word.w0;
+	reg[TRACE_DE2] = cpu->de2.word.w0;
+	reg[TRACE_HL2] = cpu->hl2.word.w0;
+	reg[TRACE_IR] = (cpu->iv << 8) | (cpu->r & 0x7f) | cpu->r7;
+	reg[TRACE_IFF] = (cpu->iff & 3) | ((cpu->im & 3) << 2);
+
+	/* R counts the M1 cycles of the previous instruction */
+	r = TRACE_R_NEXT(t->reg[TRACE_IR], t->op);
+	t->reg[TRACE_IR] = (t->reg[TRACE_IR] & 0xff00) | r;
+
+	if (pc != t->pc_next)
+		mask |= TRACE_PC;
+	if (code != t->code[pc] || 0 == t->len[pc])
+		mask |= TRACE_CODE;
+	for (n = 0; n < TRACE_REGS; n++)
+		if (reg[n] != t->reg[n])
+			mask |= TRACE_REG(n);
+
+	dst = trace_varint(dst, mask);
+	dst = trace_varint(dst, stamp - t->stamp);
+	if (mask & TRACE_PC) {
+		*dst++ = (uint8_t)pc;
+		*dst++ = (uint8_t)(pc >> 8);
+	}
+	if (mask & TRACE_CODE) {
+		for (n = 0; n < 4; n++)
+			*dst++ = buff[n] = (uint8_t)(code >> (8 * n));
+		t->code[pc] = code;
+		t->len[pc] = (uint8_t)z80_dasm(dasm, pc, buff, buff);
+	}
+	for (n = 0; n < TRACE_REGS; n++) {
+		if (0 == (mask & TRACE_REG(n)))
+			continue;
+		*dst++ = (uint8_t)reg[n];
+		*dst++ = (uint8_t)(reg[n] >> 8);
+		t->reg[n] = reg[n];
+	}
+
+	t->stamp = stamp;
+	t->pc_next = (pc + t->len[pc]) % MEMSIZE;
+	t->op = code & 0xff;
+	t->count++;
+
+	memcpy(t->cur + t->pos, rec, dst - rec);
+	t->pos += dst - rec;
+	if (t->pos > TRACE_BUFSIZE - TRACE_RECMAX)
+		trace_flush(t);
+}
+
+/** @brief free the recorder */
+static void trace_free(trace_t *t)
+{
+	uint32_t n;
+
+	if (NULL != t->cond)
+		SDL_DestroyCond(t->cond);
+	if (NULL != t->lock)
+		SDL_DestroyMutex(t->lock);
+	if (NULL != t->gz)
+		gzclose(t->gz);
+	for (n = 0; n < TRACE_BUFS; n++)
+		free(t->buf[n]);
+	free(t);
+}
+
+/** @brief start recording a trace from the command line options */
+int trace_init(int argc, char **argv)
+{
+	const char *filename = NULL;
+	trace_t *t;
+	uint32_t n;
+	uint8_t version = TRACE_VERSION;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-trace"))
+			filename = argv[++i];
+	}
+	if (NULL == filename)
+		return 0;
+
+	t = calloc(1, sizeof(trace_t));
+	if (NULL == t)
+		return -1;
+	for (n = 0; n < TRACE_BUFS; n++) {
+		t->buf[n] = malloc(TRACE_BUFSIZE);
+		if (NULL == t->buf[n]) {
+			trace_free(t);
+			return -1;
+		}
+	}
+	/* fast compression: the writer has to keep up with the emulation */
+	t->gz = gzopen(filename, "wb1");
+	t->lock = SDL_CreateMutex();
+	t->cond = SDL_CreateCond();
+	if (NULL == t->gz || NULL == t->lock || NULL == t->cond) {
+		trace_free(t);
+		return -1;
+	}
+	gzwrite(t->gz, TRACE_MAGIC, strlen(TRACE_MAGIC));
+	gzwrite(t->gz, &version, 1);
+	/* the first record is relative to all registers and the PC zero */
+	t->cur = t->buf[0];
+	t->thread = SDL_CreateThread(trace_writer, t);
+	if (NULL == t->thread) {
+		trace_free(t);
+		return -1;
+	}
+	trace = t;
+	z80_trace_hook(trace_record);
+	return 0;
+}
+
+/** @brief write the pending records and close the trace */
+void trace_exit(void)
+{
+	trace_t *t = trace;
+
+	if (NULL == t)
+		return;
+	z80_trace_hook(NULL);
+	/* the registers after the last instruction */
+	trace_record(&machine->cpu);
+	trace_flush(t);
+	SDL_LockMutex(t->lock);
+	t->quit = 1;
+	SDL_CondSignal(t->cond);
+	SDL_UnlockMutex(t->lock);
+	SDL_WaitThread(t->thread, NULL);
+	if (t->error)
+		printf("Trace: write error\n");
+	printf("Trace: %llu instructions in %llu bytes (%.2f bytes each)\n",
+		(unsigned long long)t->count - 1, (unsigned long long)t->bytes,
+		t->count > 1 ? (double)t->bytes / (t->count - 1) : 0.0);
+	trace_free(t);
+	trace = NULL;
+}
@@ -7,6 +7,7 @@
  *
  ***************************************************************************************/
 #include "trs80/cas.h"
+#include "state.h"
 
 #define	CAS_DEBUG	1
 
@@ -66,13 +67,43 @@ typedef struct trs80_cas_s {
 	/** @brief value of the input bit */
 	uint8_t get_bit;
 
+	/** @brief non zero if the input and output files are open (save states) */
+	uint8_t open[2];
+
 }	trs80_cas_t;
 
-static trs80_cas_t cas;
+static MACHINE_LOCAL trs80_cas_t cas;
 
 /* a prototype to be called from trs80_stop_machine */
 static void cas_put_close(void);
 
+/* save state: remember which files are open */
+static void cas_presave(void)
+{
+	cas.open[0] = NULL != cas.get_img;
+	cas.open[1] = NULL != cas.put_img;
+}
+
+/* save state: open or close the files (the tape data is in the buffer) */
+static void cas_postload(void)
+{
+	const char *tape = img_mounted(IMG_TYPE_CAS, 0);
+
+	if (NULL != cas.get_img && !cas.open[0]) {
+		img_fclose(cas.get_img);
+		cas.get_img = NULL;
+	} else if (NULL == cas.get_img && cas.open[0]) {
+		cas.get_img = img_fopen(NULL != tape ? tape : cas.name,
+			IMG_TYPE_CAS, "rb");
+	}
+	if (NULL != cas.put_img && !cas.open[1]) {
+		img_fclose(cas.put_img);
+		cas.put_img = NULL;
+	} else if (NULL == cas.put_img && cas.open[1]) {
+		cas.put_img = img_fopen(cas.name, IMG_TYPE_CAS, "wb");
+	}
+}
+
 
 int trs80_cas_init(void)
 {
@@ -82,6 +113,22 @@ int trs80_cas_init(void)
 		return -1;
 
 	cas.size = BUFF_SIZE;
+	STATE_ITEM("cas", 0, cas.name);
+	STATE_ITEM("cas", 0, cas.offs);
+	STATE_ITEM("cas", 0, cas.size);
+	STATE_ITEM("cas", 0, cas.count);
+	STATE_ITEM("cas", 0, cas.put_bitcnt);
+	STATE_ITEM("cas", 0, cas.put_shiftreg);
+	STATE_ITEM("cas", 0, cas.get_bitcnt);
+	STATE_ITEM("cas", 0, cas.get_shiftreg);
+	STATE_ITEM("cas", 0, cas.bit_time);
+	STATE_ITEM("cas", 0, cas.in_sync);
+	STATE_ITEM("cas", 0, cas.get_time);
+	STATE_ITEM("cas", 0, cas.put_time);
+	STATE_ITEM("cas", 0, cas.get_bit);
+	STATE_ITEM("cas", 0, cas.open);
+	state_register("cas", 0, "cas.buff", cas.buff, BUFF_SIZE);
+	state_register_hooks(cas_presave, cas_postload);
 	return 0;
 }
 
@@ -261,6 +308,8 @@ static void cas_put_bit(uint8_t data)
  *******************************************************************/
 static void cas_get_open(void)
 {
+	/* a mounted tape is read regardless of the name */
+	const char *tape = img_mounted(IMG_TYPE_CAS, 0);
 #if	0
 	char *p;
 	int i;
@@ -271,7 +320,7 @@ static void cas_get_open(void)
 	cas.count = 0;
 
 	/* extract name from input buffer */
-	sprintf(cas.name, "%-6.6s", mem + 0x41e8);
+	sprintf(cas.name, "%-6.6s", machine->mem + 0x41e8);
 	p = strchr(cas.name, ' ');
 	if (NULL != p)
 		*p = '\0';
@@ -287,7 +336,7 @@ static void cas_get_open(void)
 	sprintf(cas.name, "bable.cas");
 #endif
 
-	cas.get_img = img_fopen(cas.name, IMG_TYPE_CAS, "rb");
+	cas.get_img = img_fopen(NULL != tape ? tape : cas.name, IMG_TYPE_CAS, "rb");
 	LOG((LL,"CAS","cas_get_open '%s' (0x%p)\n", cas.name, cas.get_img));
 	if (NULL == cas.get_img)
 		return;
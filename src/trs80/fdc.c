@@ -7,6 +7,7 @@
  *
  ***************************************************************************************/
 #include "trs80/fdc.h"
+#include "state.h"
 
 #define	FDC_DEBUG	1
 #if	FDC_DEBUG
@@ -23,8 +24,8 @@
 
 #define IRQ_TIMER	0x80
 #define IRQ_FDC 	0x40
-static uint8_t irq_status = 0;
-static int fdc_enabled;
+static MACHINE_LOCAL uint8_t irq_status = 0;
+static MACHINE_LOCAL int fdc_enabled;
 
 typedef struct pdrive_s {
 	uint8_t ddsl;   /* Disk Directory Start Lump (lump number of GAT) */
@@ -97,6 +98,8 @@ int trs80_fdc_init(void)
 
 	free(ddam);
 	fdc_enabled = 1;
+	STATE_ITEM("fdc", 0, irq_status);
+	STATE_ITEM("fdc", 0, fdc_enabled);
 	return 0;
 }
 
@@ -139,13 +142,13 @@ uint8_t trs80_irq_status_r(uint32_t offset)
 void trs80_timer_interrupt(void)
 {
 	irq_status |= IRQ_TIMER;
-	z80_interrupt(&z80, 2);
+	z80_interrupt(&machine->cpu, 2);
 }
 
 void trs80_fdc_interrupt(void)
 {
 	irq_status |= IRQ_FDC;
-	z80_interrupt(&z80, 2);
+	z80_interrupt(&machine->cpu, 2);
 }
 
 void trs80_fdc_callback(uint32_t event)
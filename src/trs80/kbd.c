@@ -7,9 +7,12 @@
  *
  ***************************************************************************************/
 #include "trs80/kbd.h"
+#include "machine.h"
+#include "state.h"
+#include "rewind.h"
 
 /** @brief keyboard matrix */
-static uint8_t keymap[8];
+static MACHINE_LOCAL uint8_t keymap[8];
 
 /** @brief dump keycodes of pressed/released keys */
 #define	DUMP_KEYCODE	0
@@ -49,7 +52,7 @@ K_0,		K_1,		K_2,		K_3,		K_4,		K_5,		K_6,		K_7,
 K_8,		K_9,		K_COLON,	K_SEMICOLON,	K_COMMA,	K_MINUS,	K_PERIOD,	K_SLASH,
 K_ENTER,	K_CLEAR,	K_BREAK,	K_UP,		K_DOWN,		K_LEFT,		K_RIGHT,	K_SPACE,
 K_SHIFT,	K_ALT,		K_PAGEUP,	K_PAGEDOWN,	K_INSERT,	K_DELETE,	K_CTRL,		K_END,
-K_SHIFTED,	K_NMI=128,	K_RST
+K_SHIFTED,	K_NMI=128,	K_RST,	K_REWIND
 }	trs80_keycode_t;
 
 typedef struct {
@@ -273,7 +276,7 @@ trs80_keymap_t map[] = {
 	{SDLK_F8,		K_UNDERSCORE | K_SHIFTED},
 	{SDLK_F9,		K_RST},
 	{SDLK_F10,		K_NMI},
-	{SDLK_F11,		K_NONE},
+	{SDLK_F11,		K_REWIND},
 	{SDLK_F12,		K_NONE},
 	{SDLK_F13,		K_NONE},
 	{SDLK_F14,		K_NONE},
@@ -309,8 +312,8 @@ trs80_keymap_t map[] = {
 	{SDLK_UNKNOWN,		K_NONE}
 };
 
-static trs80_keymap_t down[64];
-static int32_t ndown;
+static MACHINE_LOCAL trs80_keymap_t down[64];
+static MACHINE_LOCAL int32_t ndown;
 
 static void key_dn(osd_key_t *key, trs80_keycode_t code)
 {
@@ -357,6 +360,13 @@ static void key_up(osd_key_t *key)
 		keymap[K_SHIFT/8] &= ~(1 << (K_SHIFT % 8));
 }
 
+void trs80_kbd_init(void)
+{
+	STATE_ITEM("kbd", 0, keymap);
+	STATE_ITEM("kbd", 0, down);
+	STATE_ITEM("kbd", 0, ndown);
+}
+
 void trs80_kbd_reset(void)
 {
 	memset(keymap, 0, sizeof(keymap));
@@ -505,6 +515,9 @@ lookup:
 			case K_RST:
 				sys_reset(SYS_RST);
 				break;
+			case K_REWIND:
+				rewind_step();
+				break;
 			default:
 				key_dn(key, map[i].key);
 				break;
@@ -9,6 +9,13 @@
 #include "z80.h"
 #include "z80dasm.h"
 #include "timer.h"
+#include "batch.h"
+#include "stats.h"
+#include "state.h"
+#include "rewind.h"
+#include "debug.h"
+#include "trace.h"
+#include "trs80/main.h"
 #include "trs80/kbd.h"
 #include "trs80/cas.h"
 #include "trs80/fdc.h"
@@ -36,55 +43,55 @@ static const char trs80_chr[] = "trs80.chr";
 #define	VIDEO_RAM_SIZE	0x0400
 
 /** @brief character generator */
-static uint8_t chargen[256 * FONT_H];
+static MACHINE_LOCAL uint8_t chargen[256 * FONT_H];
 
 /** @brief bitmap containing the scaled font */
-static osd_bitmap_t *font = NULL;
+static MACHINE_LOCAL osd_bitmap_t *font = NULL;
 
 /** @brief font glyph width */
-static int32_t font_w = FONT_W;
+static MACHINE_LOCAL int32_t font_w = FONT_W;
 
 /** @brief font glyph height */
-static int32_t font_h = FONT_H;
+static MACHINE_LOCAL int32_t font_h = FONT_H;
 
 /** @brief left offset of first pixel */
-static int32_t screen_x = 0;
+static MACHINE_LOCAL int32_t screen_x = 0;
 
 /** @brief top offset of first pixel */
-static int32_t screen_y = 0;
+static MACHINE_LOCAL int32_t screen_y = 0;
 
 /** @brief TRS-80 port FF */
-static uint8_t port_ff;
+static MACHINE_LOCAL uint8_t port_ff;
 
 /** @brief video dirty flags */
-static uint32_t video_ram_dirty[VIDEO_RAM_SIZE/32];
+static MACHINE_LOCAL uint32_t video_ram_dirty[VIDEO_RAM_SIZE/32];
 
 /** @brief marks all video locations dirty */
-static uint32_t dirty_all;
+static MACHINE_LOCAL uint32_t dirty_all;
 
 /** @brief audio stream buffer */
-static int16_t *audio_stream;
+static MACHINE_LOCAL int16_t *audio_stream;
 
 /** @brief audio samples per frame */
-static int32_t audio_samples;
+static MACHINE_LOCAL int32_t audio_samples;
 
 /** @brief current position in audio stream buffer */
-static int32_t audio_pos;
+static MACHINE_LOCAL int32_t audio_pos;
 
 /** @brief current value to fill in audio stream buffer */
-static int16_t audio_value;
+static MACHINE_LOCAL int16_t audio_value;
 
 /** @brief frame timer (50 Hz) */
-static tmr_t *frame_timer;
+static MACHINE_LOCAL tmr_t *frame_timer;
 
 /** @brief clock timer (40 Hz) */
-static tmr_t *clock_timer;
+static MACHINE_LOCAL tmr_t *clock_timer;
 
 /** @brief colors for background and foreground */
-static uint32_t colors[2];
+static MACHINE_LOCAL uint32_t colors[2];
 
 /** @brief non zero if the emulation stops */
-int stop;
+MACHINE_LOCAL int stop;
 
 typedef enum {
 	CPU_NONE,
@@ -107,7 +114,7 @@ typedef enum {
 /** @brief reset the system */
 void sys_reset(reset_t how)
 {
-	z80_cpu_t *cpu = &z80;
+	z80_cpu_t *cpu = &machine->cpu;
 	switch (how) {
 	case SYS_IRQ:
 		z80_interrupt(cpu, 2);
@@ -177,18 +184,18 @@ void sys_cpu_panel_init(void *bitmap)
 void sys_cpu_panel_update(void *bitmap)
 {
 	osd_bitmap_t *cpu_panel = (osd_bitmap_t *)bitmap;
-	osd_widget_text(cpu_panel, CPU_BC,  "BC: %04x", z80_get_reg(&z80, Z80_BC));
-	osd_widget_text(cpu_panel, CPU_DE,  "DE: %04x", z80_get_reg(&z80, Z80_DE));
-	osd_widget_text(cpu_panel, CPU_HL,  "HL: %04x", z80_get_reg(&z80, Z80_HL));
-	osd_widget_text(cpu_panel, CPU_AF,  "AF: %04x", z80_get_reg(&z80, Z80_AF));
-	osd_widget_text(cpu_panel, CPU_IX,  "IX: %04x", z80_get_reg(&z80, Z80_IX));
-	osd_widget_text(cpu_panel, CPU_IY,  "IY: %04x", z80_get_reg(&z80, Z80_IY));
-	osd_widget_text(cpu_panel, CPU_SP,  "SP: %04x", z80_get_reg(&z80, Z80_SP));
-	osd_widget_text(cpu_panel, CPU_PC,  "PC: %04x", z80_get_reg(&z80, Z80_PC));
-	osd_widget_text(cpu_panel, CPU_BC2, "BC' %04x", z80_get_reg(&z80, Z80_BC2));
-	osd_widget_text(cpu_panel, CPU_DE2, "DE' %04x", z80_get_reg(&z80, Z80_DE2));
-	osd_widget_text(cpu_panel, CPU_HL2, "HL' %04x", z80_get_reg(&z80, Z80_HL2));
-	osd_widget_text(cpu_panel, CPU_AF2, "AF' %04x", z80_get_reg(&z80, Z80_AF2));
+	osd_widget_text(cpu_panel, CPU_BC,  "BC: %04x", z80_get_reg(&machine->cpu, Z80_BC));
+	osd_widget_text(cpu_panel, CPU_DE,  "DE: %04x", z80_get_reg(&machine->cpu, Z80_DE));
+	osd_widget_text(cpu_panel, CPU_HL,  "HL: %04x", z80_get_reg(&machine->cpu, Z80_HL));
+	osd_widget_text(cpu_panel, CPU_AF,  "AF: %04x", z80_get_reg(&machine->cpu, Z80_AF));
+	osd_widget_text(cpu_panel, CPU_IX,  "IX: %04x", z80_get_reg(&machine->cpu, Z80_IX));
+	osd_widget_text(cpu_panel, CPU_IY,  "IY: %04x", z80_get_reg(&machine->cpu, Z80_IY));
+	osd_widget_text(cpu_panel, CPU_SP,  "SP: %04x", z80_get_reg(&machine->cpu, Z80_SP));
+	osd_widget_text(cpu_panel, CPU_PC,  "PC: %04x", z80_get_reg(&machine->cpu, Z80_PC));
+	osd_widget_text(cpu_panel, CPU_BC2, "BC' %04x", z80_get_reg(&machine->cpu, Z80_BC2));
+	osd_widget_text(cpu_panel, CPU_DE2, "DE' %04x", z80_get_reg(&machine->cpu, Z80_DE2));
+	osd_widget_text(cpu_panel, CPU_HL2, "HL' %04x", z80_get_reg(&machine->cpu, Z80_HL2));
+	osd_widget_text(cpu_panel, CPU_AF2, "AF' %04x", z80_get_reg(&machine->cpu, Z80_AF2));
 }
 
 /** @brief mark a video RAM location dirty */
@@ -218,13 +225,13 @@ static __inline int get_video_ram_dirty(uint32_t offset, uint32_t mask)
 /** @brief read from ROM address */
 static uint8_t rd_rom(uint32_t offset)
 {
-	return mem[offset];
+	return machine->mem[offset];
 }
 
 /** @brief read from RAM address */
 static uint8_t rd_ram(uint32_t offset)
 {
-	return mem[offset];
+	return machine->mem[offset];
 }
 
 /** @brief read from keyboard (memory mapped 8x8 matrix) */
@@ -261,7 +268,7 @@ static uint8_t rd_nop(uint32_t offset)
 /** @brief read from memory mapped I/O registers */
 static uint8_t rd_fdc(uint32_t offset)
 {
-	uint8_t data = z80.mp.byte.b0;
+	uint8_t data = machine->cpu.mp.byte.b0;
 
 	switch (offset) {
 	case 0x37e0:
@@ -289,16 +296,18 @@ static void wr_rom(uint32_t offset, uint8_t data)
 /** @brief write to RAM memory address */
 static void wr_ram(uint32_t offset, uint8_t data)
 {
-	mem[offset] = data;
+	machine->mem[offset] = data;
+	Z80_BC_CHECK(offset);
 }
 
 /** @brief write to video RAM memory address */
 static void wr_vid(uint32_t offset, uint8_t data)
 {
-	if (data == mem[offset])
+	if (data == machine->mem[offset])
 		return;
-	mem[offset] = data;
+	machine->mem[offset] = data;
 	set_video_ram_dirty(offset, 1);
+	Z80_BC_CHECK(offset);
 }
 
 /** @brief write to nowhere (memory mapped keyboard) */
@@ -385,7 +394,7 @@ static void wr_port(uint32_t offset, uint8_t data)
 	}
 }
 
-uint8_t (*rd_mem[L1SIZE])(uint32_t offset) = {
+static uint8_t (* const trs80_rd_mem[L1SIZE])(uint32_t offset) = {
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 0000-0fff */
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 1000-1fff */
 	rd_rom,	rd_rom,	rd_rom,	rd_rom,	/* 2000-2fff */
@@ -404,7 +413,7 @@ uint8_t (*rd_mem[L1SIZE])(uint32_t offset) = {
 	rd_ram,	rd_ram,	rd_ram,	rd_ram	/* f000-ffff */
 };
 
-void (*wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
+static void (* const trs80_wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 0000-0fff */
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 1000-1fff */
 	wr_rom,	wr_rom,	wr_rom,	wr_rom,	/* 2000-2fff */
@@ -423,7 +432,45 @@ void (*wr_mem[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_ram,	wr_ram,	wr_ram,	wr_ram	/* f000-ffff */
 };
 
-uint8_t (*rd_io[L1SIZE])(uint32_t offset) = {
+static const uint32_t trs80_rd_ptr[L1SIZE] = {
+	0x0000,	0x0400,	0x0800,	0x0c00,	/* 0000-0fff */
+	0x1000,	0x1400,	0x1800,	0x1c00,	/* 1000-1fff */
+	0x2000,	0x2400,	0x2800,	0x2c00,	/* 2000-2fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	0x3c00,	/* 3000-3fff */
+	0x4000,	0x4400,	0x4800,	0x4c00,	/* 4000-4fff */
+	0x5000,	0x5400,	0x5800,	0x5c00,	/* 5000-5fff */
+	0x6000,	0x6400,	0x6800,	0x6c00,	/* 6000-6fff */
+	0x7000,	0x7400,	0x7800,	0x7c00,	/* 7000-7fff */
+	0x8000,	0x8400,	0x8800,	0x8c00,	/* 8000-8fff */
+	0x9000,	0x9400,	0x9800,	0x9c00,	/* 9000-9fff */
+	0xa000,	0xa400,	0xa800,	0xac00,	/* a000-afff */
+	0xb000,	0xb400,	0xb800,	0xbc00,	/* b000-bfff */
+	0xc000,	0xc400,	0xc800,	0xcc00,	/* c000-cfff */
+	0xd000,	0xd400,	0xd800,	0xdc00,	/* d000-dfff */
+	0xe000,	0xe400,	0xe800,	0xec00,	/* e000-efff */
+	0xf000,	0xf400,	0xf800,	0xfc00	/* f000-ffff */
+};
+
+static const uint32_t trs80_wr_ptr[L1SIZE] = {
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 0000-0fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 1000-1fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 2000-2fff */
+	U32INVALID,	U32INVALID,	U32INVALID,	U32INVALID,	/* 3000-3fff */
+	0x4000,	0x4400,	0x4800,	0x4c00,	/* 4000-4fff */
+	0x5000,	0x5400,	0x5800,	0x5c00,	/* 5000-5fff */
+	0x6000,	0x6400,	0x6800,	0x6c00,	/* 6000-6fff */
+	0x7000,	0x7400,	0x7800,	0x7c00,	/* 7000-7fff */
+	0x8000,	0x8400,	0x8800,	0x8c00,	/* 8000-8fff */
+	0x9000,	0x9400,	0x9800,	0x9c00,	/* 9000-9fff */
+	0xa000,	0xa400,	0xa800,	0xac00,	/* a000-afff */
+	0xb000,	0xb400,	0xb800,	0xbc00,	/* b000-bfff */
+	0xc000,	0xc400,	0xc800,	0xcc00,	/* c000-cfff */
+	0xd000,	0xd400,	0xd800,	0xdc00,	/* d000-dfff */
+	0xe000,	0xe400,	0xe800,	0xec00,	/* e000-efff */
+	0xf000,	0xf400,	0xf800,	0xfc00	/* f000-ffff */
+};
+
+static uint8_t (* const trs80_rd_io[L1SIZE])(uint32_t offset) = {
 	rd_port,rd_port,rd_port,rd_port,/* 0000-0fff */
 	rd_port,rd_port,rd_port,rd_port,/* 1000-1fff */
 	rd_port,rd_port,rd_port,rd_port,/* 2000-2fff */
@@ -442,7 +489,7 @@ uint8_t (*rd_io[L1SIZE])(uint32_t offset) = {
 	rd_port,rd_port,rd_port,rd_port,/* f000-ffff */
 };
 
-void (*wr_io[L1SIZE])(uint32_t offset, uint8_t data) = {
+static void (* const trs80_wr_io[L1SIZE])(uint32_t offset, uint8_t data) = {
 	wr_port,wr_port,wr_port,wr_port,/* 0000-0fff */
 	wr_port,wr_port,wr_port,wr_port,/* 1000-1fff */
 	wr_port,wr_port,wr_port,wr_port,/* 2000-2fff */
@@ -463,6 +510,7 @@ void (*wr_io[L1SIZE])(uint32_t offset, uint8_t data) = {
 
 void trs80_frame(uint32_t param)
 {
+	osd_bitmap_t *frame = osd_frame();
 	uint32_t offset;
 	uint8_t data;
 	int32_t sx, sy, dx, dy;
@@ -473,13 +521,16 @@ void trs80_frame(uint32_t param)
 	audio_pos = 0;
 	audio_stream[audio_pos] = audio_value;
 
-	osd_display_frequency((uint64_t)50.0 * cycles_this_frame);
-	cycles_this_frame = 0;
+	osd_display_frequency((uint64_t)50.0 * machine->cycles_this_frame);
+	STATS_ENTER(STATS_VIDEO);
+	stats_frame(machine->cycles_this_frame);
+	rewind_frame();
+	machine->cycles_this_frame = 0;
 
 	for (offset = 0; offset < VIDEO_RAM_SIZE; offset++) {
 		if (0 == get_video_ram_dirty(offset, 1))
 			continue;
-		data = mem[VIDEO_RAM_BASE + offset];
+		data = machine->mem[VIDEO_RAM_BASE + offset];
 
 		if (data < 0x20)
 			data |= 0x40;
@@ -493,6 +544,7 @@ void trs80_frame(uint32_t param)
 	memset(video_ram_dirty, 0, sizeof(video_ram_dirty));
 	dirty_all = 0;
 
+	STATS_LEAVE();
 	stop = osd_update(osd_skip_next_frame());
 }
 
@@ -629,7 +681,7 @@ int trs80_screen(void)
 		fprintf(stderr, "osd_open_display() failed\n");
 		return -1;
 	}
-	osd_set_colors(frame, colors, 2);
+	osd_set_colors(osd_frame(), colors, 2);
 	osd_set_colors(NULL, colors, 2);
 
 	trs80_resize(w, h);
@@ -654,7 +706,10 @@ int trs80_memory(void)
 	char filename[FILENAME_MAX];
 	FILE *fp;
 
-	memset(mem, 0, sizeof(mem));
+	machine_map(trs80_rd_mem, trs80_wr_mem, trs80_rd_ptr, trs80_wr_ptr,
+		trs80_rd_io, trs80_wr_io);
+
+	memset(machine->mem, 0, sizeof(machine->mem));
 
 	snprintf(filename, sizeof(filename), "%s/%s",
 		sys_get_name(), trs80_rom);
@@ -663,7 +718,7 @@ int trs80_memory(void)
 		printf("%s not found\n", filename);
 		return -1;
 	}
-	if (MAIN_ROM_SIZE != fread(mem, 1, MAIN_ROM_SIZE, fp)) {
+	if (MAIN_ROM_SIZE != fread(machine->mem, 1, MAIN_ROM_SIZE, fp)) {
 		printf("%s too small (expected %#x)\n", filename, MAIN_ROM_SIZE);
 		return -1;
 	}
@@ -677,17 +732,57 @@ void trs80_clock(uint32_t param)
 	trs80_timer_interrupt();
 }
 
-int main(int argc, char **argv)
+/** @brief save state: redraw the whole frame after loading */
+static void trs80_postload(void)
+{
+	dirty_all = (uint32_t)-1;
+}
+
+/** @brief register the state of the video and I/O */
+static void trs80_state(void)
+{
+	STATE_ITEM("trs80", 0, port_ff);
+	STATE_ITEM("trs80", 0, audio_value);
+	state_register_timer("trs80", 0, "clock_timer", &clock_timer);
+	state_register_timer("trs80", 0, "frame_timer", &frame_timer);
+	state_register_hooks(NULL, trs80_postload);
+}
+
+/**
+ * @brief run a Tandy TRS-80 on the current machine
+ *
+ * Sets up the display, memory, devices and the batch, stats, state and
+ * debug options from the command line and runs until the user quits or
+ * the -c cycle budget is used up.
+ *
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @result returns 0 on success, or the number of the step which failed
+ */
+int trs80_run(int argc, char **argv)
 {
-	z80_cpu_t *cpu = &z80;
+	z80_cpu_t *cpu = &machine->cpu;
 	int dumpmem;
+	int blocks;
+	int jit;
+	int idle;
+	const char *profile;
 	int i;
 
-	if (osd_init(trs80_resize, NULL, trs80_key_dn, trs80_key_up, argc, argv))
+	if (osd_init(trs80_resize, NULL, batch_key_dn, batch_key_up, argc, argv))
 		return 1;
-	for (i = 1, dumpmem = 0; i < argc; i++)
+	for (i = 1, dumpmem = 0, blocks = 0, jit = 0, idle = 0, profile = NULL; i < argc; i++) {
 		if (!strcmp(argv[i], "-d"))
 			dumpmem = 1;
+		if (!strcmp(argv[i], "-b"))
+			blocks = 1;
+		if (!strcmp(argv[i], "-j"))
+			blocks = jit = 1;
+		if (!strcmp(argv[i], "-i"))
+			idle = 1;
+		if (!strcmp(argv[i], "-P") && i + 1 < argc)
+			profile = argv[i + 1];
+	}
 
 	if (trs80_screen() < 0) {
 		printf("Screen init: failed\n");
@@ -703,20 +798,80 @@ int main(int argc, char **argv)
 		printf("ROM loading: failed\n");
 		return 3;
 	}
+	if (batch_init(argc, argv, trs80_key_dn, trs80_key_up,
+		trs80_kbd_map(), 8) < 0) {
+		printf("Batch setup: failed\n");
+		return 4;
+	}
+	if (stats_init(argc, argv) < 0) {
+		printf("Stats setup: failed\n");
+		return 5;
+	}
+	if (state_init(argc, argv) < 0) {
+		printf("State setup: failed\n");
+		return 7;
+	}
 	z80_reset(cpu);
+	if (blocks) {
+		/* cache code from ROM, video RAM and RAM, but not from I/O */
+		z80_bc_enable(0x0000, MAIN_ROM_SIZE);
+		z80_bc_enable(VIDEO_RAM_BASE, MEMSIZE - VIDEO_RAM_BASE);
+	}
+	if (jit && z80_jit_enable(Z80_JIT_HOT) < 0)
+		printf("JIT: not available, using the interpreter\n");
+	if (idle) {
+		char filename[FILENAME_MAX];
+		snprintf(filename, sizeof(filename), "%s/%s.idle",
+			sys_get_name(), sys_get_name());
+		z80_idle_load(filename);
+	}
+	if (NULL != profile && z80_prof_enable() < 0) {
+		printf("Profile setup: failed\n");
+		return 6;
+	}
+	if (debug_init(argc, argv) < 0) {
+		printf("Debug setup: failed\n");
+		return 8;
+	}
+	if (trace_init(argc, argv) < 0) {
+		printf("Trace setup: failed\n");
+		return 9;
+	}
 	trs80_cas_init();
 	trs80_fdc_init();
 	clock_timer = tmr_alloc(trs80_clock, tmr_double_to_time(TIME_IN_HZ(40)),
 		0, tmr_double_to_time(TIME_IN_HZ(40)));
 	frame_timer = tmr_alloc(trs80_frame, tmr_double_to_time(TIME_IN_HZ(50)),
 		0, tmr_double_to_time(TIME_IN_HZ(50)));
+	trs80_kbd_init();
+	trs80_state();
+	if (state_start() < 0) {
+		printf("State loading: failed\n");
+		return 7;
+	}
+	if (rewind_init(argc, argv) < 0) {
+		printf("Rewind setup: failed\n");
+		return 7;
+	}
 
-	while (!stop)
+	while (!stop && !batch_done()) {
 		tmr_run_cpu(cpu, 1747200.0);
+		state_poll();
+		rewind_poll();
+	}
+	batch_result();
+	batch_exit();
+	rewind_exit();
+	debug_exit();
+	trace_exit();
+	state_exit();
+	stats_exit();
+	if (NULL != profile)
+		z80_prof_write(profile);
 
 	if (dumpmem) {
 		FILE *fp = fopen("trs80.mem", "wb");
-		fwrite(mem, 1, MEMSIZE, fp);
+		fwrite(machine->mem, 1, MEMSIZE, fp);
 		fclose(fp);
 	}
 
@@ -725,3 +880,10 @@ int main(int argc, char **argv)
 	osd_exit();
 	return 0;
 }
+
+#if	!defined(NO_MAIN)
+int main(int argc, char **argv)
+{
+	return trs80_run(argc, argv);
+}
+#endif
@@ -0,0 +1,95 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * trs80test.c	Several TRS-80 machines on separate threads
+ *
+ * Runs the TRS-80 driver headless for a number of cycles on the machine
+ * of the main thread, then runs THREADS machines at the same time, each on
+ * a thread (and thus a machine) of its own. Every machine must end up with
+ * the same cycle count and screen hash as the single machine did.
+ *
+ * The program exits with status 1 if any machine differs. It loads the
+ * ROMs from trs80/ and must be run from the top level directory.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include <SDL.h>
+#include "trs80/main.h"
+#include "batch.h"
+#include "machine.h"
+
+/** @brief number of machines running at the same time */
+#define	THREADS	2
+
+/** @brief command line of every run */
+static char *args[] = {
+	"trs80", "-n", "-f", "-c", "20000000", NULL
+};
+
+typedef struct {
+	/** @brief exit status of trs80_run() */
+	int rc;
+	/** @brief cycles the machine ran */
+	uint64_t cycles;
+	/** @brief hash of the machine's final screen */
+	uint32_t screen;
+}	run_t;
+
+/** @brief run a TRS-80 on the machine of this thread and keep its result */
+static int run(void *cookie)
+{
+	run_t *r = (run_t *)cookie;
+
+	r->rc = trs80_run(sizeof(args)/sizeof(args[0]) - 1, args);
+	r->cycles = machine->cycles_total;
+	r->screen = batch_screen();
+	machine_exit();
+	return 0;
+}
+
+/** @brief print the result of a run and return -1 if it differs from the single run */
+static int result(const char *what, const run_t *r, const run_t *ref)
+{
+	int ok = 0 == r->rc && r->cycles == ref->cycles && r->screen == ref->screen;
+
+	printf("%-8s cycles=%llu screen=%08x%s\n", what,
+		(unsigned long long)r->cycles, r->screen, ok ? " ok" : " FAIL");
+	return ok ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	SDL_Thread *thread[THREADS];
+	run_t single, runs[THREADS];
+	char what[32];
+	int rc = 0;
+	int i;
+
+	memset(&single, 0, sizeof(single));
+	run(&single);
+	if (0 != single.rc || 0 == single.screen) {
+		printf("%-8s failed with status %d\n", "single", single.rc);
+		return 1;
+	}
+
+	memset(runs, 0, sizeof(runs));
+	for (i = 0; i < THREADS; i++) {
+		thread[i] = SDL_CreateThread(run, &runs[i]);
+		if (NULL == thread[i]) {
+			fprintf(stderr, "SDL_CreateThread() failed\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < THREADS; i++)
+		SDL_WaitThread(thread[i], NULL);
+
+	if (result("single", &single, &single) < 0)
+		rc = 1;
+	for (i = 0; i < THREADS; i++) {
+		snprintf(what, sizeof(what), "thread%d", i);
+		if (result(what, &runs[i], &single) < 0)
+			rc = 1;
+	}
+	return rc;
+}
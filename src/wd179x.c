@@ -7,6 +7,7 @@
  *
  ***************************************************************************************/
 #include "wd179x.h"
+#include "state.h"
 
 /***************************************************************************
  *
@@ -247,8 +248,11 @@ static void wd179x_read_track_callback(uint32_t chip);
 static void wd179x_write_track_callback(uint32_t chip);
 
 /* one wd controlling multiple drives */
-static chip_wd179x_t *chips;
-static uint32_t num_chips;
+static MACHINE_LOCAL chip_wd179x_t *chips;
+static MACHINE_LOCAL uint32_t num_chips;
+
+/** @brief current cylinder, motor and index state of the drives (save states) */
+static MACHINE_LOCAL uint32_t drives[4][3];
 
 /**************************************************************************/
 
@@ -417,6 +421,66 @@ void wd179x_reset(uint32_t chip)
 	wd179x_restore(chip, 0);
 }
 
+/** @brief save state: copy the drive state */
+static void wd179x_presave(void)
+{
+	struct img_s *img;
+	uint8_t drive;
+
+	for (drive = 0; drive < 4; drive++) {
+		img = wd179x_image(drive);
+		drives[drive][0] = img_get_flag(img, DRV_CURRENT_CYLINDER);
+		drives[drive][1] = img_get_flag(img, DRV_MOTOR_ON);
+		drives[drive][2] = img_get_flag(img, DRV_INDEX);
+	}
+}
+
+/** @brief save state: restore the drive state */
+static void wd179x_postload(void)
+{
+	struct img_s *img;
+	uint8_t drive;
+
+	for (drive = 0; drive < 4; drive++) {
+		img = wd179x_image(drive);
+		img_set_flag(img, DRV_CURRENT_CYLINDER, drives[drive][0]);
+		img_set_flag(img, DRV_MOTOR_ON, drives[drive][1]);
+		img_set_flag(img, DRV_INDEX, drives[drive][2]);
+	}
+}
+
+/** @brief register the state of a chip (the timers are reallocated by reset) */
+static void wd179x_state(uint32_t chip)
+{
+	chip_wd179x_t *w = &chips[chip];
+
+	STATE_ITEM("wd179x", chip, w->track_reg);
+	STATE_ITEM("wd179x", chip, w->track_new);
+	STATE_ITEM("wd179x", chip, w->data);
+	STATE_ITEM("wd179x", chip, w->command);
+	STATE_ITEM("wd179x", chip, w->command_type);
+	STATE_ITEM("wd179x", chip, w->sector);
+	STATE_ITEM("wd179x", chip, w->read_cmd);
+	STATE_ITEM("wd179x", chip, w->write_cmd);
+	STATE_ITEM("wd179x", chip, w->direction);
+	STATE_ITEM("wd179x", chip, w->status);
+	STATE_ITEM("wd179x", chip, w->status_drq);
+	STATE_ITEM("wd179x", chip, w->buffer);
+	STATE_ITEM("wd179x", chip, w->data_offset);
+	STATE_ITEM("wd179x", chip, w->data_count);
+	STATE_ITEM("wd179x", chip, w->dam_list);
+	STATE_ITEM("wd179x", chip, w->dam_cnt);
+	STATE_ITEM("wd179x", chip, w->sector_length);
+	STATE_ITEM("wd179x", chip, w->ddam);
+	STATE_ITEM("wd179x", chip, w->sector_data_id);
+	STATE_ITEM("wd179x", chip, w->drive);
+	STATE_ITEM("wd179x", chip, w->head);
+	STATE_ITEM("wd179x", chip, w->density);
+	state_register_timer("wd179x", chip, "misc_timer", &w->misc_timer);
+	state_register_timer("wd179x", chip, "busy_timer", &w->busy_timer);
+	state_register_timer("wd179x", chip, "seek_timer", &w->seek_timer);
+}
+
 int wd179x_init(uint32_t num, ifc_wd179x_t *config)
 {
 	uint32_t chip;
@@ -435,7 +499,10 @@ int wd179x_init(uint32_t num, ifc_wd179x_t *config)
 		w->callback = config->callback[chip];
 
 		wd179x_reset(chip);
+		wd179x_state(chip);
 	}
+	STATE_ITEM("wd179x", 0, drives);
+	state_register_hooks(wd179x_presave, wd179x_postload);
 	return 0;
 }
 
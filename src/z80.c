@@ -8,6 +8,42 @@
  ***************************************************************************************/
 #include "z80.h"
 
+#if !defined(Z80_LAZY_FLAGS)
+#define	Z80_LAZY_FLAGS	0
+#endif
+
+#if !defined(Z80_JIT)
+#define	Z80_JIT	0
+#endif
+
+#if	Z80_JIT && (!defined(__x86_64__) || defined(_WIN32) || Z80_LAZY_FLAGS)
+/* the JIT emits code for the System V x86-64 ABI and computes flags eagerly */
+#undef	Z80_JIT
+#define	Z80_JIT	0
+#endif
+
+#if	Z80_JIT
+#include <stddef.h>
+#include <sys/mman.h>
+#endif
+
+/** @brief current cycle count of the current machine */
+#define	z80_cc		(machine->cc)
+/** @brief DMA cycle count of the current machine */
+#define	z80_dma		(machine->dma)
+/** @brief non zero if the basic block cache is enabled */
+#define	z80_blocks	(machine->blocks)
+/** @brief bitmap of memory locations covered by cached basic blocks */
+#define	z80_bc_map	(machine->bc_map)
+/** @brief non zero if idle PC ranges are defined */
+#define	z80_idle	(machine->idle)
+/** @brief entries before a basic block is translated by the JIT */
+#define	z80_jit		(machine->jit)
+/** @brief bitmap of pages with PC breakpoints */
+#define	z80_bp_pages	(machine->bp_pages)
+/** @brief function called before every instruction */
+#define	z80_trace	(machine->trace)
+
 /** @brief 32 bit program counter */
 #define	dPC	cpu->pc.dword.d0
 /** @brief 32 bit stack pointer */
@@ -80,8 +116,15 @@
 #define	L	cpu->hl.byte.b0
 /** @brief accumulator */
 #define	A	cpu->af.byte.b1
+/** @brief flags (without pending lazy flags) */
+#define	F_RAW	cpu->af.byte.b0
+#if	Z80_LAZY_FLAGS
+/** @brief flags (pending lazy flags are computed first) */
+#define	F	(*LF_FLAGS(cpu))
+#else
 /** @brief flags */
-#define	F	cpu->af.byte.b0
+#define	F	F_RAW
+#endif
 /** @brief stack pointer hi */
 #define	SPH	cpu->sp.byte.b1
 /** @brief stack pointer lo */
@@ -130,10 +173,48 @@ typedef enum {
 
 #define	change_pc(addr)
 
+#if !defined(Z80_THREADED)
+#define	Z80_THREADED	0
+#endif
+
+#if	Z80_THREADED
+/*
+ * Threaded code dispatch using GCC's labels as values.
+ * Every opcode handler jumps directly to the handler of the next opcode
+ * through a per prefix page table of label addresses. The only check is
+ * for the end of the time slice: a pending interrupt request ends the
+ * slice, and while the profiler, trace, breakpoints or the JIT must see
+ * every fetch, z80_execute() ends it after each instruction (Z80_STEP).
+ */
+#define	DISPATCH(page,op)	goto *op_##page[op];
+#define	OP(page,n)		op_##page##_##n
+#define	OP_DEFAULT(page)	op_##page##_default
+#define	OP_ADDR(page,n)		&&op_##page##_##n
+#define	Z80_DISPATCH		"threaded"
+#define	NEXT_OP	do { \
+	if (__builtin_expect(z80_cc >= machine->cycles, 0)) \
+		goto next_op; \
+	op = FETCH_OP(cpu); \
+	cpu->r += 1; \
+	goto *op_xx[op]; \
+} while (0)
+#else
+/* Opcode dispatch using switch statements */
+#define	DISPATCH(page,op)	switch (op)
+#define	OP(page,n)		case n
+#define	OP_DEFAULT(page)	default
+#define	NEXT_OP			break
+#define	Z80_DISPATCH		"switch"
+#endif
+
 /**************************** prototypes ****************************/
 static __inline uint8_t RD_OP(z80_cpu_t *cpu);
+static __inline uint8_t FETCH_OP(z80_cpu_t *cpu);
 static __inline uint8_t RD_ARGB(z80_cpu_t *cpu);
 static __inline uint16_t RD_ARGW(z80_cpu_t *cpu);
+#if	Z80_LAZY_FLAGS
+static __inline uint8_t *LF_FLAGS(z80_cpu_t *cpu);
+#endif
 static __inline uint8_t INC(z80_cpu_t *cpu, uint8_t val);
 static __inline uint8_t DEC(z80_cpu_t *cpu, uint8_t val);
 static __inline uint8_t ADD(z80_cpu_t *cpu, uint8_t val);
@@ -168,20 +249,20 @@ static __inline void LDD(z80_cpu_t *cpu);
 static __inline void CPD(z80_cpu_t *cpu);
 static __inline void IND(z80_cpu_t *cpu);
 static __inline void OUTD(z80_cpu_t *cpu);
+static __inline void HALT(z80_cpu_t *cpu);
 static __inline void PUSH(z80_cpu_t *cpu, push_pop_t which);
 static __inline void POP(z80_cpu_t *cpu, push_pop_t which);
 
-/** @brief memory */
-uint8_t mem[MEMSIZE];
-
-/** @brief Z80 CPU context */
-z80_cpu_t z80;
-
-/** @brief Z80 CPU cycle count */
-int z80_cc;
+#if	Z80_LAZY_FLAGS > 1
+#define	Z80_FLAGS	"+lazycheck"
+#elif	Z80_LAZY_FLAGS
+#define	Z80_FLAGS	"+lazy"
+#else
+#define	Z80_FLAGS	""
+#endif
 
-/** @brief Z80 CPU stolen (by DMA) cycles */
-int z80_dma;
+/** @brief name of the opcode dispatch engine */
+const char z80_dispatch[] = Z80_DISPATCH Z80_FLAGS;
 
 static const uint8_t cc_op[0x100] = {
  4,10, 7, 6, 4, 4, 7, 4, 4,11, 7, 6, 4, 4, 7, 4,
@@ -292,29 +373,626 @@ static const uint8_t cc_ex[0x100] = {
  6, 0, 0, 0, 7, 0, 0, 2, 6, 0, 0, 0, 7, 0, 0, 2,
  6, 0, 0, 0, 7, 0, 0, 2, 6, 0, 0, 0, 7, 0, 0, 2};
 
-/** @brief read an opcode byte from memory */
+/** @brief maximum number of bytes in a cached basic block */
+#define	BC_MAXLEN	64
+
+/** @brief number of basic blocks in the cache before it is flushed */
+#define	BC_BLOCKS	4096
+
+/** @brief size of the buffer for code translated by the JIT */
+#define	JIT_CODE_SIZE	(8 << 20)
+
+typedef struct {
+	/** @brief address of the first byte of the block */
+	uint32_t pc;
+	/** @brief number of bytes in the block */
+	uint32_t len;
+	/** @brief pre-fetched opcode and argument bytes */
+	uint8_t code[BC_MAXLEN];
+#if	Z80_JIT
+	/** @brief number of times the block was entered */
+	uint32_t hits;
+	/** @brief cycles of all but the last instruction of the translated code */
+	int jit_cc;
+	/** @brief translated code (NULL if there is none) */
+	void (*jit)(machine_t *m);
+#endif
+}	z80_block_t;
+
+/** @brief basic block cache of a machine */
+struct z80_bc_s {
+	/** @brief pages of memory that may be cached */
+	uint8_t page[L1SIZE];
+	/** @brief basic block index (plus one) by start address */
+	uint16_t index[MEMSIZE];
+	/** @brief basic block pool */
+	z80_block_t pool[BC_BLOCKS];
+	/** @brief number of used basic blocks in the pool */
+	uint32_t used;
+#if	Z80_JIT
+	/** @brief buffer for translated code (JIT_CODE_SIZE bytes) */
+	uint8_t *jit_code;
+	/** @brief number of used bytes in the code buffer */
+	uint32_t jit_used;
+#endif
+};
+
+#define	bc_page		(machine->bc->page)
+#define	bc_index	(machine->bc->index)
+#define	bc_pool		(machine->bc->pool)
+#define	bc_used		(machine->bc->used)
+#define	bc_pc		(machine->bc_pc)
+#define	bc_len		(machine->bc_len)
+#define	bc_code		(machine->bc_code)
+#define	idle_map	(machine->idle_map)
+#define	bp_map		(machine->bp_map)
+
+/** @brief opcode tables of the profiler (one per cycle count table) */
+typedef enum {
+	PROF_OP,
+	PROF_CB,
+	PROF_ED,
+	PROF_XY,
+	PROF_XY_CB,
+	PROF_TABLES
+}	z80_prof_table_t;
+
+/** @brief execution profile of a machine */
+struct z80_prof_s {
+	/** @brief executions per PC */
+	uint64_t pc_count[MEMSIZE];
+	/** @brief cycles per PC */
+	uint64_t pc_cycles[MEMSIZE];
+	/** @brief executions per opcode table and opcode */
+	uint64_t op_count[PROF_TABLES][0x100];
+	/** @brief cycles per opcode table and opcode */
+	uint64_t op_cycles[PROF_TABLES][0x100];
+	/** @brief PC of the instruction being executed */
+	uint32_t pc;
+	/** @brief opcode table of the instruction being executed */
+	uint32_t table;
+	/** @brief opcode of the instruction being executed */
+	uint32_t op;
+	/** @brief cycle count when the instruction started */
+	int cc;
+	/** @brief non zero while an instruction is being executed */
+	int busy;
+};
+
+#define	z80_prof	(machine->prof)
+
+/**
+ * @brief non zero if every instruction must go through hook_fetch()
+ *
+ * The profiler, the trace and breakpoints see each execution of an
+ * instruction, so HALT, repeated block instructions and idle loops
+ * are not fast-forwarded while one of them is active.
+ */
+#define	HOOKED	(NULL != z80_prof || 0 != z80_bp_pages || NULL != z80_trace)
+
+#if	Z80_THREADED
+/**
+ * @brief machine->cycles while stepping single instructions
+ *
+ * Stepping keeps the real end of the time slice in machine->cycles_step.
+ * A timer or an interrupt request ending the slice meanwhile overwrites
+ * the marker, so next_op knows to return.
+ */
+#define	Z80_STEP	(-1)
+/** @brief end of the time slice, also while stepping */
+#define	SLICE_END	(Z80_STEP == machine->cycles ? machine->cycles_step : machine->cycles)
+#else
+#define	SLICE_END	(machine->cycles)
+#endif
+
+#if	Z80_JIT
+/** @brief non zero if the JIT is on and the next fetch starts a new block */
+#define	JIT_PENDING	(z80_jit && (uint32_t)(PC - bc_pc) >= bc_len)
+#else
+#define	JIT_PENDING	0
+#endif
+
+/** @brief return non zero if the instruction at code[] ends a basic block */
+static int bc_ends_block(const uint8_t *code)
+{
+	switch (code[0]) {
+	case 0x18:	/* JR	rel	*/
+	case 0x76:	/* HALT		*/
+	case 0xc3:	/* JP	nnnn	*/
+	case 0xc9:	/* RET		*/
+	case 0xe9:	/* JP	(HL)	*/
+		return 1;
+	case 0xc7: case 0xcf: case 0xd7: case 0xdf:
+	case 0xe7: case 0xef: case 0xf7: case 0xff:
+		return 1;	/* RST	n	*/
+	case 0xdd:
+	case 0xfd:
+		return 0xe9 == code[1];	/* JP	(IX/IY)	*/
+	case 0xed:
+		/* RETN and RETI */
+		return 0x45 == (code[1] & 0xc7);
+	}
+	return 0;
+}
+
+/** @brief translate the code at PC into a new basic block */
+static z80_block_t *bc_translate(z80_cpu_t *cpu)
+{
+	z80_block_t *blk;
+	uint8_t buff[4];
+	char dasm[80];
+	uint32_t pc, len, n, i;
+
+	if (bc_used >= BC_BLOCKS)
+		z80_bc_flush();
+
+	blk = &bc_pool[bc_used];
+	blk->pc = PC;
+	for (len = 0; len + sizeof(buff) <= BC_MAXLEN; len += n) {
+		pc = blk->pc + len;
+		for (i = 0; i < sizeof(buff); i++)
+			buff[i] = machine->mem[(pc + i) % MEMSIZE];
+		n = z80_dasm(dasm, pc, buff, buff) & 0xffff;
+		if (pc + n > MEMSIZE)
+			break;
+		if (0 == bc_page[pc >> L1SHIFT] || 0 == bc_page[(pc + n - 1) >> L1SHIFT])
+			break;
+		memcpy(&blk->code[len], &machine->mem[pc], n);
+		if (bc_ends_block(buff)) {
+			len += n;
+			break;
+		}
+	}
+	if (0 == len)
+		return NULL;
+
+	blk->len = len;
+#if	Z80_JIT
+	blk->hits = 0;
+	blk->jit_cc = 0;
+	blk->jit = NULL;
+#endif
+	for (pc = blk->pc; pc < blk->pc + len; pc++)
+		z80_bc_map[pc / 8] |= 1 << (pc % 8);
+	bc_index[blk->pc] = ++bc_used;
+	return blk;
+}
+
+/** @brief make the basic block starting at PC the current block, return it */
+static z80_block_t *bc_lookup(z80_cpu_t *cpu)
+{
+	z80_block_t *blk = NULL;
+
+	bc_len = 0;
+	if (0 == bc_page[PC >> L1SHIFT])
+		return NULL;
+	if (bc_index[PC])
+		blk = &bc_pool[bc_index[PC] - 1];
+	else
+		blk = bc_translate(cpu);
+	if (NULL == blk)
+		return NULL;
+	bc_pc = blk->pc;
+	bc_len = blk->len;
+	bc_code = blk->code;
+	return blk;
+}
+
+/** @brief invalidate all cached blocks covering a memory location */
+void z80_bc_invalidate(uint32_t addr)
+{
+	uint32_t pc = addr < BC_MAXLEN ? 0 : addr - BC_MAXLEN + 1;
+	z80_block_t *blk;
+
+	for (/* */; pc <= addr; pc++) {
+		if (0 == bc_index[pc])
+			continue;
+		blk = &bc_pool[bc_index[pc] - 1];
+		if (blk->pc + blk->len <= addr)
+			continue;
+		bc_index[pc] = 0;
+		if (blk->code == bc_code)
+			bc_len = 0;
+	}
+	z80_bc_map[addr / 8] &= ~(1 << (addr % 8));
+}
+
+/** @brief flush the basic block cache */
+void z80_bc_flush(void)
+{
+	bc_len = 0;
+	if (NULL == machine->bc)
+		return;
+	memset(bc_index, 0, sizeof(bc_index));
+	memset(z80_bc_map, 0, sizeof(z80_bc_map));
+	bc_used = 0;
+#if	Z80_JIT
+	machine->bc->jit_used = 0;
+#endif
+}
+
+/** @brief define a range of idle PC addresses */
+int z80_idle_range(uint32_t first, uint32_t last)
+{
+	uint32_t pc;
+
+	if (first > last || last >= MEMSIZE)
+		return -1;
+	for (pc = first; pc <= last; pc++)
+		idle_map[pc / 8] |= 1 << (pc % 8);
+	z80_idle = 1;
+	return 0;
+}
+
+/** @brief set a PC breakpoint */
+int z80_break_set(uint32_t pc, void (*hit)(uint32_t pc))
+{
+	if (pc >= MEMSIZE || NULL == hit)
+		return -1;
+	bp_map[pc / 8] |= 1 << (pc % 8);
+	z80_bp_pages |= 1ull << (pc >> L1SHIFT);
+	machine->bp_hit = hit;
+	machine->cycles = z80_cc;
+	return 0;
+}
+
+/** @brief clear a PC breakpoint */
+int z80_break_clr(uint32_t pc)
+{
+	uint32_t page = pc >> L1SHIFT;
+	uint32_t i;
+
+	if (pc >= MEMSIZE)
+		return -1;
+	bp_map[pc / 8] &= ~(1 << (pc % 8));
+	for (i = page << L1SHIFT; i < (page + 1) << L1SHIFT; i += 8)
+		if (bp_map[i / 8])
+			return 0;
+	z80_bp_pages &= ~(1ull << page);
+	return 0;
+}
+
+/** @brief call a function before every instruction (NULL to stop) */
+void z80_trace_hook(void (*fn)(z80_cpu_t *cpu))
+{
+	z80_trace = fn;
+	/* end the time slice so that z80_execute() sees the hook */
+	machine->cycles = z80_cc;
+}
+
+/**
+ * @brief load idle PC ranges from a file
+ *
+ * Each line contains the first and optionally the last address
+ * of a range in hex, followed by an optional comment. Lines
+ * starting with a '#' are comments.
+ */
+int z80_idle_load(const char *filename)
+{
+	char line[256], *src, *end;
+	uint32_t first, last;
+	FILE *fp;
+	int lno;
+
+	fp = fopen(filename, "r");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	lno = 0;
+	while (NULL != fgets(line, sizeof(line), fp)) {
+		lno++;
+		if ('#' == line[0] || '\n' == line[0] || '\0' == line[0])
+			continue;	/* comment or empty line */
+		first = strtoul(line, &src, 16);
+		if (src == line) {
+			fprintf(stderr, "error on line #%d (%s): missing address\n",
+				lno, filename);
+			continue;
+		}
+		last = strtoul(src, &end, 16);
+		if (end == src)
+			last = first;
+		if (z80_idle_range(first, last) < 0)
+			fprintf(stderr, "error on line #%d (%s): invalid range %04x-%04x\n",
+				lno, filename, first, last);
+	}
+	fclose(fp);
+	return 0;
+}
+
+/** @brief charge the cycles of the instruction being executed to the profile */
+static void prof_close(void)
+{
+	struct z80_prof_s *p = z80_prof;
+	uint32_t cc;
+
+	if (NULL == p || 0 == p->busy)
+		return;
+	cc = (uint32_t)(z80_cc - p->cc);
+	p->pc_cycles[p->pc] += cc;
+	p->op_cycles[p->table][p->op] += cc;
+	p->busy = 0;
+}
+
+/** @brief count the instruction at PC and charge the following cycles to it */
+static void prof_fetch(z80_cpu_t *cpu)
+{
+	struct z80_prof_s *p = z80_prof;
+	uint32_t pc = PC;
+	uint32_t op = machine->mem[pc];
+
+	prof_close();
+	p->table = PROF_OP;
+	switch (op) {
+	case 0xcb:
+		p->table = PROF_CB;
+		op = machine->mem[(pc + 1) % MEMSIZE];
+		break;
+	case 0xed:
+		p->table = PROF_ED;
+		op = machine->mem[(pc + 1) % MEMSIZE];
+		break;
+	case 0xdd:
+	case 0xfd:
+		op = machine->mem[(pc + 1) % MEMSIZE];
+		if (0xcb == op) {
+			p->table = PROF_XY_CB;
+			op = machine->mem[(pc + 3) % MEMSIZE];
+		} else {
+			p->table = PROF_XY;
+		}
+		break;
+	}
+	p->pc = pc;
+	p->op = op;
+	p->cc = z80_cc;
+	p->busy = 1;
+	p->pc_count[pc]++;
+	p->op_count[p->table][op]++;
+}
+
+/** @brief per instruction hook: trace, count the profile and check the breakpoints */
+static void hook_fetch(z80_cpu_t *cpu)
+{
+	if (NULL != z80_trace)
+		(*z80_trace)(cpu);
+	if (NULL != z80_prof)
+		prof_fetch(cpu);
+	if (((z80_bp_pages >> (PC >> L1SHIFT)) & 1) &&
+		(bp_map[PC / 8] & (1 << (PC % 8))))
+		(*machine->bp_hit)(PC);
+}
+
+/** @brief start collecting an execution profile */
+int z80_prof_enable(void)
+{
+	if (NULL == z80_prof) {
+		z80_prof = calloc(1, sizeof(struct z80_prof_s));
+		if (NULL == z80_prof)
+			return -1;
+	}
+	machine->cycles = z80_cc;
+	return 0;
+}
+
+/** @brief cycles to sort by in prof_cmp() */
+static MACHINE_LOCAL const uint64_t *prof_keys;
+
+/** @brief compare two indices into prof_keys[] by decreasing cycles */
+static int prof_cmp(const void *p1, const void *p2)
+{
+	const uint32_t i1 = *(const uint32_t *)p1;
+	const uint32_t i2 = *(const uint32_t *)p2;
+	if (prof_keys[i1] != prof_keys[i2])
+		return prof_keys[i1] > prof_keys[i2] ? -1 : 1;
+	return i1 < i2 ? -1 : i1 > i2 ? 1 : 0;
+}
+
+/** @brief sort the indices of the non zero counts by decreasing cycles */
+static uint32_t prof_sort(uint32_t *idx, const uint64_t *count,
+	const uint64_t *keys, uint32_t size)
+{
+	uint32_t i, n;
+
+	for (i = 0, n = 0; i < size; i++)
+		if (count[i])
+			idx[n++] = i;
+	prof_keys = keys;
+	qsort(idx, n, sizeof(uint32_t), prof_cmp);
+	return n;
+}
+
+/**
+ * @brief write the execution profile to a file
+ *
+ * The opcode and hot spot summaries are written as '#' comments,
+ * followed by one CODE line per executed PC, sorted by cycles.
+ * The file can be passed to dz80 -d to annotate a disassembly.
+ */
+int z80_prof_write(const char *filename)
+{
+	static const char *names[PROF_TABLES] = {"op", "cb", "ed", "xy", "xy_cb"};
+	struct z80_prof_s *p = z80_prof;
+	uint64_t total_cc = 0, total_count = 0;
+	uint32_t *idx, n, i, pc, op, t;
+	uint8_t buff[4];
+	char dasm[80];
+	FILE *fp;
+
+	if (NULL == p)
+		return -1;
+	prof_close();
+	fp = fopen(filename, "w");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	idx = calloc(MEMSIZE, sizeof(uint32_t));
+	if (NULL == idx) {
+		fclose(fp);
+		return -1;
+	}
+	for (pc = 0; pc < MEMSIZE; pc++) {
+		total_cc += p->pc_cycles[pc];
+		total_count += p->pc_count[pc];
+	}
+	if (0 == total_cc)
+		total_cc = 1;
+
+	fprintf(fp, "# Z80 execution profile: %llu instructions, %llu cycles\n",
+		(unsigned long long)total_count, (unsigned long long)total_cc);
+	fprintf(fp, "#\n# opcodes by cycles\n");
+	fprintf(fp, "# %-5s %-2s %12s %6s %12s  %s\n",
+		"table", "op", "cycles", "%", "count", "instruction");
+	n = prof_sort(idx, p->op_count[0], p->op_cycles[0], PROF_TABLES * 0x100);
+	for (i = 0; i < n; i++) {
+		t = idx[i] / 0x100;
+		op = idx[i] % 0x100;
+		memset(buff, 0, sizeof(buff));
+		switch (t) {
+		case PROF_OP:
+			buff[0] = op;
+			break;
+		case PROF_CB:
+		case PROF_ED:
+			buff[0] = PROF_CB == t ? 0xcb : 0xed;
+			buff[1] = op;
+			break;
+		case PROF_XY:
+			buff[0] = 0xdd;
+			buff[1] = op;
+			break;
+		case PROF_XY_CB:
+			buff[0] = 0xdd;
+			buff[1] = 0xcb;
+			buff[3] = op;
+			break;
+		}
+		z80_dasm(dasm, 0, buff, buff);
+		fprintf(fp, "# %-5s %02x %12llu %6.2f %12llu  %s\n",
+			names[t], op, (unsigned long long)p->op_cycles[t][op],
+			100.0 * p->op_cycles[t][op] / total_cc,
+			(unsigned long long)p->op_count[t][op], dasm);
+	}
+
+	fprintf(fp, "#\n# PCs by cycles\n");
+	n = prof_sort(idx, p->pc_count, p->pc_cycles, MEMSIZE);
+	for (i = 0; i < n; i++) {
+		pc = idx[i];
+		fprintf(fp, "%04x\tCODE\t%.2f%% cc=%llu n=%llu\n",
+			pc, 100.0 * p->pc_cycles[pc] / total_cc,
+			(unsigned long long)p->pc_cycles[pc],
+			(unsigned long long)p->pc_count[pc]);
+	}
+	free(idx);
+	fclose(fp);
+	return 0;
+}
+
+/** @brief enable the basic block cache for a range of memory */
+int z80_bc_enable(uint32_t base, uint32_t size)
+{
+	uint32_t page;
+
+	if (base + size > MEMSIZE)
+		return -1;
+	if (NULL == machine->bc) {
+		machine->bc = calloc(1, sizeof(struct z80_bc_s));
+		if (NULL == machine->bc)
+			return -1;
+	}
+	for (page = base >> L1SHIFT; page < (base + size) >> L1SHIFT; page++) {
+		bc_page[page] = 1;
+		/* writes must go through the handlers calling Z80_BC_CHECK() */
+		machine->wr_ptr[page] = NULL;
+	}
+	z80_blocks = 1;
+	return 0;
+}
+
+/** @brief translate basic blocks entered a number of times to host code */
+int z80_jit_enable(uint32_t hot)
+{
+#if	Z80_JIT
+	void *code;
+
+	if (NULL == machine->bc || 0 == hot)
+		return -1;
+	if (NULL == machine->bc->jit_code) {
+		code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (MAP_FAILED == code)
+			return -1;
+		machine->bc->jit_code = code;
+		machine->bc->jit_used = 0;
+	}
+	z80_jit = hot;
+	machine->cycles = z80_cc;
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/** @brief free a basic block cache */
+void z80_bc_free(struct z80_bc_s *bc)
+{
+	if (NULL == bc)
+		return;
+#if	Z80_JIT
+	if (NULL != bc->jit_code)
+		munmap(bc->jit_code, JIT_CODE_SIZE);
+#endif
+	free(bc);
+}
+
+/** @brief read an opcode byte from the current block or memory */
 static __inline uint8_t RD_OP(z80_cpu_t *cpu)
 {
-	uint8_t data = RD_MEM(dPC);
+	uint32_t o = PC - bc_pc;
+	uint8_t data;
+	if (o < bc_len)
+		data = bc_code[o];
+	else
+		data = RD_MEM(dPC);
 	PC++;
 	return data;
 }
 
-/** @brief read an argument byte from memory */
+/** @brief read the first opcode byte of an instruction */
+static __inline uint8_t FETCH_OP(z80_cpu_t *cpu)
+{
+	if (z80_blocks && (uint32_t)(PC - bc_pc) >= bc_len)
+		bc_lookup(cpu);
+	/* skip the rest of the time slice when the CPU is idling */
+	if (z80_idle && 0 == cpu->irq && (idle_map[PC / 8] & (1 << (PC % 8))))
+		if (z80_cc < SLICE_END && !HOOKED) {
+			/* R counts the skipped opcode fetches, one per 4 cycles as in HALT() */
+			cpu->r += (SLICE_END - z80_cc) / 4;
+			z80_cc = SLICE_END;
+		}
+	return RD_OP(cpu);
+}
+
+/** @brief read an argument byte from the current block or memory */
 static __inline uint8_t RD_ARGB(z80_cpu_t *cpu)
 {
-	uint8_t data = RD_MEM(dPC);
+	uint32_t o = PC - bc_pc;
+	uint8_t data;
+	if (o < bc_len)
+		data = bc_code[o];
+	else
+		data = RD_MEM(dPC);
 	PC++;
 	return data;
 }
 
-/** @brief read an argument word from memory */
+/** @brief read an argument word from the current block or memory */
 static __inline uint16_t RD_ARGW(z80_cpu_t *cpu)
 {
-	uint16_t data = RD_MEM(dPC);
-	PC++;
-	data = data + 256 * RD_MEM(dPC);
-	PC++;
+	uint16_t data = RD_ARGB(cpu);
+	data = data + 256 * RD_ARGB(cpu);
 	return data;
 }
 
@@ -809,11 +1487,144 @@ static const uint8_t flags_szhf_dec[256] = {
 	F_SZHV_DEC(0xfc), F_SZHV_DEC(0xfd), F_SZHV_DEC(0xfe), F_SZHV_DEC(0xff)
 };
 
+/** @brief flags of an addition */
+#define	F_ADD(a,val,res) (flags_sz[(uint8_t)(res)] | (((res) >> 8) & CF) | \
+	(((a) ^ (res) ^ (val)) & HF) | \
+	((((val) ^ (a) ^ 0x80) & ((val) ^ (res)) & 0x80) >> 5))
+
+/** @brief flags of a subtraction */
+#define	F_SUB(a,val,res) (flags_sz[(uint8_t)(res)] | (((res) >> 8) & CF) | NF | \
+	(((a) ^ (res) ^ (val)) & HF) | \
+	((((val) ^ (a)) & ((a) ^ (res)) & 0x80) >> 5))
+
+#if	Z80_LAZY_FLAGS
+/*
+ * Lazy flags: the 8 bit ALU operations which replace all of F (or all but
+ * the carry) do not compute F. They record the kind of operation, the
+ * operands and the result instead, and F is computed from these when it is
+ * read (conditional jumps and calls, PUSH AF, z80_get_reg(Z80_AF), ...).
+ * Most of the time the next ALU operation replaces F before it is read.
+ *
+ * With Z80_LAZY_FLAGS 2 every operation also computes F eagerly, and each
+ * read of F compares the lazily computed value with the eager one.
+ */
+enum {
+	LF_NONE,	/* F is valid */
+	LF_ADD,		/* ADD, ADC */
+	LF_SUB,		/* SUB, SBC, CP */
+	LF_AND,		/* AND */
+	LF_LOG,		/* XOR, OR */
+	LF_INC,		/* INC (lf_a is the carry flag) */
+	LF_DEC		/* DEC (lf_a is the carry flag) */
+};
+
+/** @brief compute F from the pending lazy flags */
+static __inline uint8_t lf_compute(z80_cpu_t *cpu)
+{
+	const uint32_t a = cpu->lf_a;
+	const uint32_t val = cpu->lf_val;
+	const uint32_t res = cpu->lf_res;
+
+	switch (cpu->lf_op) {
+	case LF_ADD:
+		return F_ADD(a, val, res);
+	case LF_SUB:
+		return F_SUB(a, val, res);
+	case LF_AND:
+		return flags_szph[res];
+	case LF_LOG:
+		return flags_szp[res];
+	case LF_INC:
+		return a | flags_szhf_inc[res];
+	case LF_DEC:
+		return a | flags_szhf_dec[res];
+	}
+	return F_RAW;
+}
+
+/** @brief compute pending lazy flags and return a pointer to F */
+static __inline uint8_t *LF_FLAGS(z80_cpu_t *cpu)
+{
+	if (LF_NONE != cpu->lf_op) {
+		F_RAW = lf_compute(cpu);
+#if	Z80_LAZY_FLAGS > 1
+		if (F_RAW != cpu->lf_f) {
+			fprintf(stderr, "lazy flags: op:%u a:%02x val:%02x res:%x"
+				" F:%02x eager F:%02x PC:%04x\n",
+				cpu->lf_op, cpu->lf_a, cpu->lf_val, cpu->lf_res,
+				F_RAW, cpu->lf_f, PC);
+			abort();
+		}
+#endif
+		cpu->lf_op = LF_NONE;
+	}
+	return &F_RAW;
+}
+
+/** @brief return the carry flag without computing the other pending flags */
+static __inline uint8_t LF_CARRY(z80_cpu_t *cpu)
+{
+	uint8_t cf;
+
+	switch (cpu->lf_op) {
+	case LF_ADD:
+	case LF_SUB:
+		cf = (cpu->lf_res >> 8) & CF;
+		break;
+	case LF_AND:
+	case LF_LOG:
+		cf = 0;
+		break;
+	case LF_INC:
+	case LF_DEC:
+		cf = cpu->lf_a;
+		break;
+	default:
+		cf = F_RAW & CF;
+	}
+#if	Z80_LAZY_FLAGS > 1
+	if (cf != ((LF_NONE != cpu->lf_op ? cpu->lf_f : F_RAW) & CF)) {
+		fprintf(stderr, "lazy flags: op:%u carry:%u eager F:%02x PC:%04x\n",
+			cpu->lf_op, cf, cpu->lf_f, PC);
+		abort();
+	}
+#endif
+	return cf;
+}
+
+#if	Z80_LAZY_FLAGS > 1
+#define	LF_SET(op,a,val,res,flags) do { \
+	cpu->lf_f = (flags); \
+	cpu->lf_op = op; \
+	cpu->lf_a = a; \
+	cpu->lf_val = val; \
+	cpu->lf_res = res; \
+} while (0)
+#else
+#define	LF_SET(op,a,val,res,flags) do { \
+	cpu->lf_op = op; \
+	cpu->lf_a = a; \
+	cpu->lf_val = val; \
+	cpu->lf_res = res; \
+} while (0)
+#endif
+
+/** @brief carry flag */
+#define	CARRY		LF_CARRY(cpu)
+/** @brief compute pending lazy flags before F is accessed as part of AF */
+#define	LF_SYNC()	LF_FLAGS(cpu)
+#else
+#define	LF_SET(op,a,val,res,flags) F = (flags)
+#define	CARRY		(F & CF)
+#define	LF_SYNC()
+#endif
+
 /** @brief increment 8 bit value */
 static __inline uint8_t INC(z80_cpu_t *cpu, uint8_t val)
 {
 	uint8_t res = val + 1;
-	F = (F & CF) | flags_szhf_inc[res];
+	uint8_t cf = CARRY;
+	LF_SET(LF_INC, cf, 0, res, cf | flags_szhf_inc[res]);
 	return res;
 }
 
@@ -821,7 +1632,8 @@ static __inline uint8_t INC(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t DEC(z80_cpu_t *cpu, uint8_t val)
 {
 	uint8_t res = val - 1;
-	F = (F & CF) | flags_szhf_dec[res];
+	uint8_t cf = CARRY;
+	LF_SET(LF_DEC, cf, 0, res, cf | flags_szhf_dec[res]);
 	return res;
 }
 
@@ -829,19 +1641,15 @@ static __inline uint8_t DEC(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t ADD(z80_cpu_t *cpu, uint8_t val)
 {
 	uint32_t res = A + val;
-	F = flags_sz[(uint8_t)res] | ((res >> 8) & CF) |
-		((A ^ res ^ val) & HF) |
-		(((val ^ A ^ 0x80) & (val ^ res) & 0x80) >> 5);
+	LF_SET(LF_ADD, A, val, res, F_ADD(A, val, res));
 	return (uint8_t)res;
 }
 
 /** @brief add with carry to accumulator */
 static __inline uint8_t ADC(z80_cpu_t *cpu, uint8_t val)
 {
-	uint32_t res = A + val + (F & CF);
-	F = flags_sz[(uint8_t)res] | ((res >> 8) & CF) |
-		((A ^ res ^ val) & HF) |
-		(((val ^ A ^ 0x80) & (val ^ res) & 0x80) >> 5);
+	uint32_t res = A + val + CARRY;
+	LF_SET(LF_ADD, A, val, res, F_ADD(A, val, res));
 	return (uint8_t)res;
 }
 
@@ -849,19 +1657,15 @@ static __inline uint8_t ADC(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t SUB(z80_cpu_t *cpu, uint8_t val)
 {
 	uint32_t res = A - val;
-	F = flags_sz[(uint8_t)res] | ((res >> 8) & CF) | NF |
-		((A ^ res ^ val) & HF) |
-		(((val ^ A) & (A ^ res) & 0x80) >> 5);
+	LF_SET(LF_SUB, A, val, res, F_SUB(A, val, res));
 	return (uint8_t)res;
 }
 
 /** @brief subtract with carry from accumulator */
 static __inline uint8_t SBC(z80_cpu_t *cpu, uint8_t val)
 {
-	uint32_t res = A - val - (F & CF);
-	F = flags_sz[(uint8_t)res] | ((res >> 8) & CF) | NF |
-		((A ^ res ^ val) & HF) |
-		(((val ^ A) & (A ^ res) & 0x80) >> 5);
+	uint32_t res = A - val - CARRY;
+	LF_SET(LF_SUB, A, val, res, F_SUB(A, val, res));
 	return (uint8_t)res;
 }
 
@@ -869,7 +1673,7 @@ static __inline uint8_t SBC(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t AND(z80_cpu_t *cpu, uint8_t val)
 {
 	uint8_t res = A & val;
-	F = flags_szph[res];
+	LF_SET(LF_AND, 0, 0, res, flags_szph[res]);
 	return res;
 }
 
@@ -877,7 +1681,7 @@ static __inline uint8_t AND(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t XOR(z80_cpu_t *cpu, uint8_t val)
 {
 	uint8_t res = A ^ val;
-	F = flags_szp[res];
+	LF_SET(LF_LOG, 0, 0, res, flags_szp[res]);
 	return res;
 }
 
@@ -885,7 +1689,7 @@ static __inline uint8_t XOR(z80_cpu_t *cpu, uint8_t val)
 static __inline uint8_t OR(z80_cpu_t *cpu, uint8_t val)
 {
 	uint8_t res = A | val;
-	F = flags_szp[res];
+	LF_SET(LF_LOG, 0, 0, res, flags_szp[res]);
 	return res;
 }
 
@@ -893,9 +1697,7 @@ static __inline uint8_t OR(z80_cpu_t *cpu, uint8_t val)
 static __inline void CP(z80_cpu_t *cpu, uint8_t val)
 {
 	uint32_t res = A - val;
-	F = flags_sz[(uint8_t)res] | ((res >> 8) & CF) | NF |
-		((A ^ res ^ val) & HF) |
-		(((val ^ A) & (A ^ res) & 0x80) >> 5);
+	LF_SET(LF_SUB, A, val, res, F_SUB(A, val, res));
 }
 
 static __inline uint16_t ADD16(z80_cpu_t *cpu, uint32_t reg, uint32_t val)
@@ -1190,6 +1992,211 @@ static __inline void OUTD(z80_cpu_t *cpu)
 	F |= flags_p[(tmp & 0x07) ^ B];
 }
 
+/**
+ * @brief skip the remaining HALT cycles of the time slice
+ *
+ * HALT re-executes itself until an interrupt is taken, which costs
+ * 4 cycles and increments R each time. Instead of going through the
+ * fetch and decode path, all iterations up to the end of the time
+ * slice (i.e. up to the next timer event) are accounted for at once,
+ * unless they must be seen one by one because something is HOOKED.
+ */
+static __inline void HALT(z80_cpu_t *cpu)
+{
+	const int cc = cc_op[0x76];
+	int n;
+
+	if (z80_cc >= SLICE_END || 0 != cpu->irq || NULL == machine->rd_ptr[PC >> L1SHIFT] || HOOKED)
+		return;
+	n = (SLICE_END - z80_cc + cc - 1) / cc;
+	z80_cc += n * cc;
+	cpu->r += n;
+}
+
+/**
+ * @brief return non zero if a block instruction at pc may repeat without re-fetching
+ *
+ * The repeated iterations of LDIR, CPIR, INIR, OTIR and their decrementing
+ * counterparts are run in a loop instead of rewinding the PC and going
+ * through the fetch and decode path. That is possible as long as the
+ * time slice is not used up, no interrupt is pending, nothing is HOOKED
+ * and the opcode bytes are still there, in pages that can be read without
+ * side effects.
+ */
+static __inline int REPEAT(z80_cpu_t *cpu, uint32_t pc, uint8_t op)
+{
+	uint32_t pc1 = (pc + 1) % MEMSIZE;
+	return z80_cc < SLICE_END && 0 == cpu->irq && !HOOKED &&
+		NULL != machine->rd_ptr[pc >> L1SHIFT] &&
+		NULL != machine->rd_ptr[pc1 >> L1SHIFT] &&
+		0xed == machine->rd_ptr[pc >> L1SHIFT][pc & L1MASK] &&
+		op == machine->rd_ptr[pc1 >> L1SHIFT][pc1 & L1MASK];
+}
+
+/** @brief repeat LDI or LDD (LDIR or LDDR with PC pointing to the ED prefix) */
+static void LDXR(z80_cpu_t *cpu, uint8_t op)
+{
+	const uint32_t pc = PC;
+	const int cc = cc_op[0xed] + cc_ed[op];
+	const int cc_rep = cc + cc_ex[op];
+	const int inc = 0xb0 == op;
+	uint8_t *src, *dst;
+	uint32_t n, d0, d1, i;
+	uint8_t io;
+
+	while (REPEAT(cpu, pc, op)) {
+		/* number of iterations fitting into the time slice */
+		n = (SLICE_END - z80_cc + cc_rep - 1) / cc_rep;
+		if (n > BC)
+			n = BC;
+		/* stay inside the source and destination pages */
+		if (inc) {
+			if (n > L1MASK + 1 - (HL & L1MASK))
+				n = L1MASK + 1 - (HL & L1MASK);
+			if (n > L1MASK + 1 - (DE & L1MASK))
+				n = L1MASK + 1 - (DE & L1MASK);
+			d0 = (uint16_t)(pc - DE);
+			d1 = (uint16_t)(pc + 1 - DE);
+		} else {
+			if (n > (HL & L1MASK) + 1)
+				n = (HL & L1MASK) + 1;
+			if (n > (DE & L1MASK) + 1)
+				n = (DE & L1MASK) + 1;
+			d0 = (uint16_t)(DE - pc);
+			d1 = (uint16_t)(DE - pc - 1);
+		}
+		/* stop before overwriting the opcode itself */
+		if (n > d0)
+			n = d0;
+		if (n > d1)
+			n = d1;
+		if (0 == n)
+			return;
+
+		src = machine->rd_ptr[HL >> L1SHIFT];
+		dst = machine->wr_ptr[DE >> L1SHIFT];
+		if (n < 2 || NULL == src || NULL == dst) {
+			/* single iteration through the memory handlers */
+			cpu->r += 1;
+			z80_cc += cc;
+			if (inc)
+				LDI(cpu);
+			else
+				LDD(cpu);
+			if (0 == BC) {
+				PC = pc + 2;
+				return;
+			}
+			z80_cc += cc_ex[op];
+			continue;
+		}
+
+		src += HL & L1MASK;
+		dst += DE & L1MASK;
+		if (inc) {
+			if (dst > src && dst < src + n) {
+				/* overlapping ranges replicate the source bytes */
+				for (i = 0; i < n; i++)
+					dst[i] = src[i];
+			} else {
+				memmove(dst, src, n);
+			}
+			io = dst[n - 1];
+			HL += n;
+			DE += n;
+		} else {
+			if (dst < src && dst + n > src) {
+				for (i = 0; i < n; i++)
+					*(dst - i) = *(src - i);
+			} else {
+				memmove(dst - n + 1, src - n + 1, n);
+			}
+			io = *(dst - n + 1);
+			HL -= n;
+			DE -= n;
+		}
+		BC -= n;
+		cpu->r += n;
+		z80_cc += n * cc_rep;
+		F = F & (SF | ZF | CF);
+		if ((A + io) & 0x02)
+			F |= YF; /* bit 1 -> flag 5 */
+		if ((A + io) & 0x08)
+			F |= XF; /* bit 3 -> flag 3 */
+		if (0 == BC) {
+			/* the last iteration does not take the extra cycles */
+			z80_cc -= cc_ex[op];
+			PC = pc + 2;
+			return;
+		}
+		F |= PF;
+	}
+}
+
+/** @brief repeat CPI or CPD (CPIR or CPDR with PC pointing to the ED prefix) */
+static void CPXR(z80_cpu_t *cpu, uint8_t op)
+{
+	const uint32_t pc = PC;
+	const int cc = cc_op[0xed] + cc_ed[op];
+
+	while (REPEAT(cpu, pc, op)) {
+		cpu->r += 1;
+		z80_cc += cc;
+		if (0xb1 == op)
+			CPI(cpu);
+		else
+			CPD(cpu);
+		if (0 == BC || 0 != (F & ZF)) {
+			PC = pc + 2;
+			return;
+		}
+		z80_cc += cc_ex[op];
+		MP = pc + 1;
+	}
+}
+
+/** @brief repeat INI or IND (INIR or INDR with PC pointing to the ED prefix) */
+static void INXR(z80_cpu_t *cpu, uint8_t op)
+{
+	const uint32_t pc = PC;
+	const int cc = cc_op[0xed] + cc_ed[op];
+
+	while (REPEAT(cpu, pc, op)) {
+		cpu->r += 1;
+		z80_cc += cc;
+		if (0xb2 == op)
+			INI(cpu);
+		else
+			IND(cpu);
+		if (0 == B) {
+			PC = pc + 2;
+			return;
+		}
+		z80_cc += cc_ex[op];
+	}
+}
+
+/** @brief repeat OUTI or OUTD (OTIR or OTDR with PC pointing to the ED prefix) */
+static void OTXR(z80_cpu_t *cpu, uint8_t op)
+{
+	const uint32_t pc = PC;
+	const int cc = cc_op[0xed] + cc_ed[op];
+
+	while (REPEAT(cpu, pc, op)) {
+		cpu->r += 1;
+		z80_cc += cc;
+		if (0xb3 == op)
+			OUTI(cpu);
+		else
+			OUTD(cpu);
+		if (0 == B) {
+			PC = pc + 2;
+			return;
+		}
+		z80_cc += cc_ex[op];
+	}
+}
+
 /** @brief push a register pair to the stack */
 static __inline void PUSH(z80_cpu_t *cpu, push_pop_t which)
 {
@@ -1292,6 +2299,8 @@ static __inline void POP(z80_cpu_t *cpu, push_pop_t which)
 int z80_interrupt(z80_cpu_t *cpu, int type)
 {
 	cpu->irq = type;
+	/* end the time slice so that the next fetch sees the request */
+	machine->cycles = z80_cc;
 	return 0;
 }
 
@@ -1303,6 +2312,7 @@ uint32_t z80_get_reg(z80_cpu_t *cpu, uint32_t id)
 	case Z80_SP:
 		return SP;
 	case Z80_AF:
+		LF_SYNC();
 		return AF;
 	case Z80_BC:
 		return BC;
@@ -1342,161 +2352,1595 @@ uint32_t z80_get_reg(z80_cpu_t *cpu, uint32_t id)
 	return (uint32_t)-1;
 }
 
-int z80_execute(z80_cpu_t *cpu)
-{
-	uint8_t op;
-	uint8_t m;
+#if	Z80_JIT
+/*
+ * JIT: basic blocks of the block cache which are entered often are
+ * translated to x86-64 code. While a translated block runs, AF, BC, DE,
+ * HL and SP live in host registers (RBX points to the machine). Memory is
+ * accessed through the pages' direct pointers, and through the rd_mem and
+ * wr_mem handlers only for pages without one. The translation ends at the
+ * first instruction it does not handle, and the interpreter takes over
+ * from there.
+ *
+ * Every instruction accessing memory first adds the cycles so far to
+ * z80_cc, so the handlers see the same cycle count as they would with the
+ * interpreter. After it the block exits if a handler ended the time slice,
+ * raised an interrupt request or invalidated the block. A block is only
+ * entered if all but its last instruction start before the end of the
+ * time slice, just like the interpreter would run them.
+ */
+
+/** @brief x86-64 registers */
+enum {
+	J_RAX, J_RCX, J_RDX, J_RBX, J_RSP, J_RBP, J_RSI, J_RDI,
+	J_R8, J_R9, J_R10, J_R11, J_R12, J_R13, J_R14, J_R15
+};
 
-	z80_cc = z80_dma;
-	z80_dma = 0;
+/** @brief no index register in a memory operand */
+#define	J_NONE	J_RSP
+
+/** @brief host registers of the machine and the Z80 register pairs */
+#define	J_M	J_RBX
+#define	J_AF	J_RBP
+#define	J_BC	J_R12
+#define	J_DE	J_R13
+#define	J_HL	J_R14
+#define	J_SP	J_R15
+
+/** @brief x86-64 condition codes */
+enum {
+	JCC_O, JCC_NO, JCC_B, JCC_AE, JCC_E, JCC_NE, JCC_BE, JCC_A,
+	JCC_S, JCC_NS, JCC_P, JCC_NP, JCC_L, JCC_GE, JCC_LE, JCC_G
+};
 
-fetch_xx:
-	switch (cpu->irq) {
-	case 0:	/* no interrupt pending */
-		break;
-	case 1:	/* NMI */
-		if (0x76 == mem[PC])
-			PC++;
-		PUSH(cpu, REG_PC);
-		PC = 0x0066;
-		cpu->iff = cpu->iff & 2;	/* reser IFF1, keep IFF2 */
-		change_pc(dPC);
-		cpu->irq = 0;
-		break;
-	case 2:	/* IRQ */
-		if (0 == (cpu->iff & 1))
-			break;
-		if (0x76 == mem[PC])
-			PC++;
-		PUSH(cpu, REG_PC);
-		PC = 0x0038;
-		cpu->iff = 0;			/* reset IFF1 and IFF2 */
-		change_pc(dPC);
-		cpu->irq = 0;
-		break;
-	}
-	op = RD_OP(cpu);
-	cpu->r += 1;
+/** @brief x86-64 ALU operations (/digit of the immediate forms) */
+enum {
+	JOP_ADD, JOP_OR, JOP_ADC, JOP_SBB, JOP_AND, JOP_SUB, JOP_XOR, JOP_CMP
+};
 
-decode_xx:
-	switch (op) {
-	case 0x00:	/* NOP			*/
-		{
-			z80_cc += cc_op[0x00];
-		}
-		break;
+/** @brief x86-64 shift operations (/digit of the immediate forms) */
+enum {
+	JSH_ROL, JSH_ROR, JSH_RCL, JSH_RCR, JSH_SHL, JSH_SHR, JSH_SAL, JSH_SAR
+};
 
-	case 0x01:	/* LD	BC,nnnn		*/
-		{
-			z80_cc += cc_op[0x01];
-			BC = RD_ARGW(cpu);
-		}
-		break;
+/** @brief offset of a field (given by its accessor macro) in the machine_t */
+#define	J_OFS(field)	((int32_t)((uint8_t *)&(field) - (uint8_t *)machine))
 
-	case 0x02:	/* LD	(BC),A		*/
-		{
-			z80_cc += cc_op[0x02];
-			WR_MEM(dBC, A);
-		}
-		break;
+/** @brief offset of a z80_cpu_t field in the machine_t */
+#define	J_CPU(field)	((int32_t)offsetof(machine_t, cpu.field))
 
-	case 0x03:	/* INC	BC		*/
-		{
-			z80_cc += cc_op[0x03];
-			BC++;
-		}
-		break;
+/** @brief exit PC value meaning the PC is in EAX */
+#define	J_PC_EAX	0xffffffff
 
-	case 0x04:	/* INC	B		*/
-		{
-			z80_cc += cc_op[0x04];
-			B = INC(cpu, B);
-		}
-		break;
+/** @brief maximum number of exits of a block (two per instruction and one) */
+#define	JIT_EXITS	(2 * BC_MAXLEN + 1)
 
-	case 0x05:	/* DEC	B		*/
+typedef struct {
+	/** @brief offset of the jump to the exit */
+	uint32_t at;
+	/** @brief Z80 PC after the exit (or J_PC_EAX) */
+	uint32_t pc;
+	/** @brief cycles not yet added to z80_cc */
+	uint32_t cc;
+	/** @brief number of instructions run (for the R register) */
+	uint32_t n;
+	/** @brief non zero if the exit leaves the current block */
+	int leave;
+}	jit_exit_t;
+
+typedef struct {
+	/** @brief code buffer */
+	uint8_t *code;
+	/** @brief bytes emitted */
+	uint32_t len;
+	/** @brief size of the code buffer */
+	uint32_t size;
+	/** @brief non zero if the code buffer or the exits overflowed */
+	int fail;
+	/** @brief exits to emit after the code */
+	jit_exit_t exit[JIT_EXITS];
+	/** @brief number of exits */
+	uint32_t nexit;
+	/** @brief cycles of the instructions translated so far */
+	uint32_t cc;
+	/** @brief cycles added to z80_cc so far */
+	uint32_t synced;
+	/** @brief number of instructions translated so far */
+	uint32_t n;
+}	jit_t;
+
+/** @brief host register of the 8 bit Z80 registers B, C, D, E, H, L, -, A */
+static const int jit_r8[8] = {
+	J_BC, J_BC, J_DE, J_DE, J_HL, J_HL, J_RAX, J_AF
+};
+
+/** @brief host register of the Z80 register pairs BC, DE, HL, SP */
+static const int jit_rp[4] = {
+	J_BC, J_DE, J_HL, J_SP
+};
+
+/** @brief host register of the Z80 register pairs BC, DE, HL, AF (PUSH/POP) */
+static const int jit_qq[4] = {
+	J_BC, J_DE, J_HL, J_AF
+};
+
+/** @brief flag tested by the conditions NZ, Z, NC, C, PO, PE, P, M */
+static const uint8_t jit_cond[8] = {
+	ZF, ZF, CF, CF, PF, PF, SF, SF
+};
+
+/** @brief emit a byte */
+static void j_b(jit_t *j, uint32_t b)
+{
+	if (j->len >= j->size) {
+		j->fail = 1;
+		return;
+	}
+	j->code[j->len++] = (uint8_t)b;
+}
+
+/** @brief emit a 32 bit little endian value */
+static void j_d(jit_t *j, uint32_t d)
+{
+	j_b(j, d);
+	j_b(j, d >> 8);
+	j_b(j, d >> 16);
+	j_b(j, d >> 24);
+}
+
+/** @brief emit a REX prefix if one is needed (or forced for byte registers) */
+static void j_rex(jit_t *j, int w, int reg, int index, int base, int force)
+{
+	uint32_t rex = (w ? 8 : 0) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+	if (rex || force)
+		j_b(j, 0x40 | rex);
+}
+
+/** @brief emit an opcode of one or two (0x0f xx) bytes */
+static void j_opcode(jit_t *j, uint32_t op)
+{
+	if (op > 0xff)
+		j_b(j, op >> 8);
+	j_b(j, op);
+}
+
+/** @brief emit an instruction with a register and a register operand */
+static void j_rr(jit_t *j, uint32_t op, int w, int b8, int reg, int rm)
+{
+	j_rex(j, w, reg, J_NONE, rm, b8 && ((reg >= 4 && reg < 8) || (rm >= 4 && rm < 8)));
+	j_opcode(j, op);
+	j_b(j, 0xc0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/** @brief emit an instruction with a register and a memory operand [base+index*(1<<scale)+disp] */
+static void j_mem(jit_t *j, uint32_t op, int w, int b8, int reg, int base, int index, int scale, int32_t disp)
+{
+	int mod = (0 == disp && J_RBP != (base & 7)) ? 0 :
+		(disp >= -128 && disp <= 127) ? 1 : 2;
+
+	j_rex(j, w, reg, index, base, b8 && reg >= 4 && reg < 8);
+	j_opcode(j, op);
+	if (J_NONE == index && J_RSP != (base & 7)) {
+		j_b(j, mod << 6 | (reg & 7) << 3 | (base & 7));
+	} else {
+		j_b(j, mod << 6 | (reg & 7) << 3 | 4);
+		j_b(j, scale << 6 | (index & 7) << 3 | (base & 7));
+	}
+	if (1 == mod)
+		j_b(j, disp);
+	else if (2 == mod)
+		j_d(j, disp);
+}
+
+/** @brief emit an instruction with a memory operand [rbx+disp] */
+static void j_m(jit_t *j, uint32_t op, int w, int b8, int reg, int32_t disp)
+{
+	j_mem(j, op, w, b8, reg, J_M, J_NONE, 0, disp);
+}
+
+/** @brief emit an ALU operation of a 32 bit register and an immediate */
+static void j_ri(jit_t *j, int alu, int rm, int32_t imm)
+{
+	if (imm >= -128 && imm <= 127) {
+		j_rr(j, 0x83, 0, 0, alu, rm);
+		j_b(j, imm);
+	} else {
+		j_rr(j, 0x81, 0, 0, alu, rm);
+		j_d(j, imm);
+	}
+}
+
+/** @brief emit a shift of a 32 bit register by an immediate */
+static void j_shift(jit_t *j, int sh, int rm, int n)
+{
+	j_rr(j, 0xc1, 0, 0, sh, rm);
+	j_b(j, n);
+}
+
+/** @brief emit mov r32,imm32 */
+static void j_mov_ri(jit_t *j, int rm, uint32_t imm)
+{
+	j_rex(j, 0, 0, J_NONE, rm, 0);
+	j_b(j, 0xb8 + (rm & 7));
+	j_d(j, imm);
+}
+
+/** @brief emit mov r64,imm64 */
+static void j_mov_rq(jit_t *j, int rm, uint64_t imm)
+{
+	j_rex(j, 1, 0, J_NONE, rm, 0);
+	j_b(j, 0xb8 + (rm & 7));
+	j_d(j, (uint32_t)imm);
+	j_d(j, (uint32_t)(imm >> 32));
+}
+
+/** @brief emit mov dst,src (32 bit) */
+static void j_mov(jit_t *j, int dst, int src)
+{
+	j_rr(j, 0x89, 0, 0, src, dst);
+}
+
+/** @brief emit an ALU operation dst,src (32 bit) */
+static void j_alu_rr(jit_t *j, int alu, int dst, int src)
+{
+	j_rr(j, alu << 3 | 0x01, 0, 0, src, dst);
+}
+
+/** @brief emit test r32,imm32 */
+static void j_test(jit_t *j, int rm, uint32_t imm)
+{
+	j_rr(j, 0xf7, 0, 0, 0, rm);
+	j_d(j, imm);
+}
+
+/** @brief emit mov word [rbx+disp],imm16 */
+static void j_store16_imm(jit_t *j, int32_t disp, uint32_t imm)
+{
+	j_b(j, 0x66);
+	j_m(j, 0xc7, 0, 0, 0, disp);
+	j_b(j, imm);
+	j_b(j, imm >> 8);
+}
+
+/** @brief emit mov word [rbx+disp],r16 */
+static void j_store16(jit_t *j, int32_t disp, int src)
+{
+	j_b(j, 0x66);
+	j_m(j, 0x89, 0, 0, src, disp);
+}
+
+/** @brief emit a conditional jump, return the offset of its displacement */
+static uint32_t j_jcc(jit_t *j, int cc)
+{
+	j_b(j, 0x0f);
+	j_b(j, 0x80 | cc);
+	j_d(j, 0);
+	return j->len - 4;
+}
+
+/** @brief emit a jump, return the offset of its displacement */
+static uint32_t j_jmp(jit_t *j)
+{
+	j_b(j, 0xe9);
+	j_d(j, 0);
+	return j->len - 4;
+}
+
+/** @brief make the jump with the displacement at offset 'at' go to offset 'to' */
+static void j_target(jit_t *j, uint32_t at, uint32_t to)
+{
+	uint32_t rel = to - (at + 4);
+
+	if (j->fail)
+		return;
+	j->code[at + 0] = (uint8_t)rel;
+	j->code[at + 1] = (uint8_t)(rel >> 8);
+	j->code[at + 2] = (uint8_t)(rel >> 16);
+	j->code[at + 3] = (uint8_t)(rel >> 24);
+}
+
+/** @brief make the jump with the displacement at offset 'at' go to here */
+static void j_here(jit_t *j, uint32_t at)
+{
+	j_target(j, at, j->len);
+}
+
+/** @brief load the 8 bit Z80 register r (not (HL)) into dst */
+static void j_get8(jit_t *j, int dst, int r)
+{
+	if (r & 1 && 7 != r) {
+		j_rr(j, 0x0fb6, 0, 1, dst, jit_r8[r]);	/* movzx dst,low */
+	} else {
+		j_mov(j, dst, jit_r8[r]);
+		j_shift(j, JSH_SHR, dst, 8);
+	}
+}
+
+/** @brief store src (0-255, clobbered) in the high byte of a register pair */
+static void j_seth(jit_t *j, int rp, int src)
+{
+	j_ri(j, JOP_AND, rp, 0x00ff);
+	j_shift(j, JSH_SHL, src, 8);
+	j_alu_rr(j, JOP_OR, rp, src);
+}
+
+/** @brief store src (0-255) in the low byte of a register pair */
+static void j_setl(jit_t *j, int rp, int src)
+{
+	j_ri(j, JOP_AND, rp, 0xff00);
+	j_alu_rr(j, JOP_OR, rp, src);
+}
+
+/** @brief store src (0-255, clobbered) in the 8 bit Z80 register r (not (HL)) */
+static void j_set8(jit_t *j, int r, int src)
+{
+	if (r & 1 && 7 != r)
+		j_setl(j, jit_r8[r], src);
+	else
+		j_seth(j, jit_r8[r], src);
+}
+
+/** @brief load F into dst */
+static void j_getf(jit_t *j, int dst)
+{
+	j_rr(j, 0x0fb6, 0, 1, dst, J_AF);
+}
+
+/** @brief load table[idx] into dst (clobbers R8) */
+static void j_table(jit_t *j, int dst, int idx, const uint8_t *table)
+{
+	j_mov_rq(j, J_R8, (uint64_t)(uintptr_t)table);
+	j_mem(j, 0x0fb6, 0, 0, dst, J_R8, idx, 0, 0);
+}
+
+/** @brief zero extend a 32 bit register from 16 bits */
+static void j_word(jit_t *j, int rm)
+{
+	j_rr(j, 0x0fb7, 0, 0, rm, rm);
+}
+
+/** @brief add the cycles of the instructions so far to z80_cc */
+static void j_sync(jit_t *j)
+{
+	int32_t cc = j->cc - j->synced;
+
+	if (0 == cc)
+		return;
+	if (cc <= 127) {
+		j_m(j, 0x83, 0, 0, JOP_ADD, J_OFS(z80_cc));
+		j_b(j, cc);
+	} else {
+		j_m(j, 0x81, 0, 0, JOP_ADD, J_OFS(z80_cc));
+		j_d(j, cc);
+	}
+	j->synced = j->cc;
+}
+
+/** @brief jump to an exit continuing at pc (or the PC in EAX) */
+static void j_exit(jit_t *j, uint32_t pc, int leave)
+{
+	jit_exit_t *x;
+
+	if (j->nexit >= JIT_EXITS) {
+		j->fail = 1;
+		return;
+	}
+	x = &j->exit[j->nexit++];
+	x->at = j_jmp(j);
+	x->pc = pc;
+	x->cc = j->cc - j->synced;
+	x->n = j->n;
+	x->leave = leave;
+}
+
+/** @brief read the byte at the address in ECX into EAX */
+static void j_rd(jit_t *j)
+{
+	uint32_t slow, done;
+
+	j_mov(j, J_RDX, J_RCX);
+	j_shift(j, JSH_SHR, J_RDX, L1SHIFT);
+	j_mem(j, 0x8b, 1, 0, J_RSI, J_M, J_RDX, 3, J_OFS(machine->rd_ptr[0]));
+	j_rr(j, 0x85, 1, 0, J_RSI, J_RSI);
+	slow = j_jcc(j, JCC_E);
+	j_ri(j, JOP_AND, J_RCX, L1MASK);
+	j_mem(j, 0x0fb6, 0, 0, J_RAX, J_RSI, J_RCX, 0, 0);
+	done = j_jmp(j);
+	j_here(j, slow);
+	j_mov(j, J_RDI, J_RCX);
+	j_mem(j, 0xff, 0, 0, 2, J_M, J_RDX, 3, J_OFS(machine->rd_mem[0]));
+	j_rr(j, 0x0fb6, 0, 1, J_RAX, J_RAX);
+	j_here(j, done);
+}
+
+/** @brief write the byte in EAX to the address in ECX */
+static void j_wr(jit_t *j)
+{
+	uint32_t slow, done;
+
+	j_mov(j, J_RDX, J_RCX);
+	j_shift(j, JSH_SHR, J_RDX, L1SHIFT);
+	j_mem(j, 0x8b, 1, 0, J_RSI, J_M, J_RDX, 3, J_OFS(machine->wr_ptr[0]));
+	j_rr(j, 0x85, 1, 0, J_RSI, J_RSI);
+	slow = j_jcc(j, JCC_E);
+	j_ri(j, JOP_AND, J_RCX, L1MASK);
+	j_mem(j, 0x88, 0, 1, J_RAX, J_RSI, J_RCX, 0, 0);
+	done = j_jmp(j);
+	j_here(j, slow);
+	j_mov(j, J_RDI, J_RCX);
+	j_mov(j, J_RSI, J_RAX);
+	j_mem(j, 0xff, 0, 0, 2, J_M, J_RDX, 3, J_OFS(machine->wr_mem[0]));
+	j_here(j, done);
+}
+
+/** @brief read the byte at (HL) into EAX */
+static void j_rd_hl(jit_t *j)
+{
+	j_mov(j, J_RCX, J_HL);
+	j_rd(j);
+}
+
+/** @brief write the byte in EAX to (HL) */
+static void j_wr_hl(jit_t *j)
+{
+	j_mov(j, J_RCX, J_HL);
+	j_wr(j);
+}
+
+/** @brief exit to pc if a handler ended the time slice, raised an interrupt or invalidated the block */
+static void j_check(jit_t *j, uint32_t pc)
+{
+	uint32_t irq, end, ok;
+
+	j_m(j, 0x80, 0, 0, JOP_CMP, J_CPU(irq));
+	j_b(j, 0);
+	irq = j_jcc(j, JCC_NE);
+	j_m(j, 0x8b, 0, 0, J_RAX, J_OFS(z80_cc));
+	j_m(j, 0x3b, 0, 0, J_RAX, J_OFS(machine->cycles));
+	end = j_jcc(j, JCC_GE);
+	j_m(j, 0x83, 0, 0, JOP_CMP, J_OFS(bc_len));
+	j_b(j, 0);
+	ok = j_jcc(j, JCC_NE);
+	j_here(j, irq);
+	j_here(j, end);
+	j_exit(j, pc, 0);
+	j_here(j, ok);
+}
+
+/** @brief push a register pair (or the value imm if rp is negative) */
+static void j_push(jit_t *j, int rp, uint32_t imm)
+{
+	j_ri(j, JOP_SUB, J_SP, 1);
+	j_word(j, J_SP);
+	j_mov(j, J_RCX, J_SP);
+	if (rp < 0) {
+		j_mov_ri(j, J_RAX, (imm >> 8) & 0xff);
+	} else {
+		j_mov(j, J_RAX, rp);
+		j_shift(j, JSH_SHR, J_RAX, 8);
+	}
+	j_wr(j);
+	j_ri(j, JOP_SUB, J_SP, 1);
+	j_word(j, J_SP);
+	j_mov(j, J_RCX, J_SP);
+	if (rp < 0)
+		j_mov_ri(j, J_RAX, imm & 0xff);
+	else
+		j_rr(j, 0x0fb6, 0, 1, J_RAX, rp);
+	j_wr(j);
+}
+
+/** @brief pop the byte at (SP) into EAX */
+static void j_pop8(jit_t *j)
+{
+	j_mov(j, J_RCX, J_SP);
+	j_rd(j);
+	j_ri(j, JOP_ADD, J_SP, 1);
+	j_word(j, J_SP);
+}
+
+/** @brief pop the PC into MP and EAX */
+static void j_pop_pc(jit_t *j)
+{
+	j_pop8(j);
+	j_m(j, 0x88, 0, 1, J_RAX, J_CPU(mp));
+	j_pop8(j);
+	j_m(j, 0x88, 0, 1, J_RAX, J_CPU(mp) + 1);
+	j_m(j, 0x0fb7, 0, 0, J_RAX, J_CPU(mp));
+}
+
+/** @brief jump over the following code if condition c (NZ, Z, ... M) is false */
+static uint32_t j_cond(jit_t *j, int c)
+{
+	j_test(j, J_AF, jit_cond[c]);
+	return j_jcc(j, (c & 1) ? JCC_E : JCC_NE);
+}
+
+/** @brief 8 bit ALU operation (ADD, ADC, SUB, SBC, AND, XOR, OR, CP) of A and ECX */
+static void j_alu8(jit_t *j, int op)
+{
+	j_get8(j, J_RAX, 7);
+	switch (op) {
+	case 0: case 1: case 2: case 3: case 7:
+		j_mov(j, J_RDX, J_RAX);
+		j_alu_rr(j, (op & 2) || 7 == op ? JOP_SUB : JOP_ADD, J_RDX, J_RCX);
+		if (1 == op || 3 == op) {
+			j_getf(j, J_RSI);
+			j_ri(j, JOP_AND, J_RSI, CF);
+			j_alu_rr(j, 3 == op ? JOP_SUB : JOP_ADD, J_RDX, J_RSI);
+		}
+		/* flags_sz[res] | ((res >> 8) & CF) */
+		j_rr(j, 0x0fb6, 0, 1, J_RSI, J_RDX);
+		j_table(j, J_RSI, J_RSI, flags_sz);
+		j_mov(j, J_RDI, J_RDX);
+		j_shift(j, JSH_SHR, J_RDI, 8);
+		j_ri(j, JOP_AND, J_RDI, CF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+		/* (a ^ res ^ val) & HF */
+		j_mov(j, J_RDI, J_RAX);
+		j_alu_rr(j, JOP_XOR, J_RDI, J_RDX);
+		j_alu_rr(j, JOP_XOR, J_RDI, J_RCX);
+		j_ri(j, JOP_AND, J_RDI, HF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+		/* overflow */
+		j_mov(j, J_RDI, J_RCX);
+		j_alu_rr(j, JOP_XOR, J_RDI, J_RAX);
+		if (op < 2) {
+			j_ri(j, JOP_XOR, J_RDI, 0x80);
+			j_mov(j, J_R9, J_RCX);
+		} else {
+			j_mov(j, J_R9, J_RAX);
+		}
+		j_alu_rr(j, JOP_XOR, J_R9, J_RDX);
+		j_alu_rr(j, JOP_AND, J_RDI, J_R9);
+		j_ri(j, JOP_AND, J_RDI, 0x80);
+		j_shift(j, JSH_SHR, J_RDI, 5);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+		if (op >= 2)
+			j_ri(j, JOP_OR, J_RSI, NF);
+		j_setl(j, J_AF, J_RSI);
+		if (7 != op) {
+			j_rr(j, 0x0fb6, 0, 1, J_RDX, J_RDX);
+			j_seth(j, J_AF, J_RDX);
+		}
+		break;
+	case 4: case 5: case 6:
+		j_alu_rr(j, 4 == op ? JOP_AND : 5 == op ? JOP_XOR : JOP_OR, J_RAX, J_RCX);
+		j_table(j, J_RSI, J_RAX, 4 == op ? flags_szph : flags_szp);
+		j_setl(j, J_AF, J_RSI);
+		j_seth(j, J_AF, J_RAX);
+		break;
+	}
+}
+
+/** @brief INC or DEC of EAX (0-255) with the flags */
+static void j_incdec(jit_t *j, int dec)
+{
+	j_ri(j, dec ? JOP_SUB : JOP_ADD, J_RAX, 1);
+	j_ri(j, JOP_AND, J_RAX, 0xff);
+	j_table(j, J_RSI, J_RAX, dec ? flags_szhf_dec : flags_szhf_inc);
+	j_getf(j, J_RDI);
+	j_ri(j, JOP_AND, J_RDI, CF);
+	j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+	j_setl(j, J_AF, J_RSI);
+}
+
+/** @brief CB rotate or shift (RLC, RRC, RL, RR, SLA, SRA, SLL, SRL) of EAX with the flags */
+static void j_rot(jit_t *j, int op)
+{
+	j_mov(j, J_RCX, J_RAX);
+	if (op & 1)
+		j_ri(j, JOP_AND, J_RCX, CF);		/* carry out of bit 0 */
+	else
+		j_shift(j, JSH_SHR, J_RCX, 7);		/* carry out of bit 7 */
+	switch (op) {
+	case 0:	/* RLC */
+		j_shift(j, JSH_SHL, J_RAX, 1);
+		j_alu_rr(j, JOP_OR, J_RAX, J_RCX);
+		break;
+	case 1:	/* RRC */
+		j_shift(j, JSH_SHR, J_RAX, 1);
+		j_mov(j, J_RDX, J_RCX);
+		j_shift(j, JSH_SHL, J_RDX, 7);
+		j_alu_rr(j, JOP_OR, J_RAX, J_RDX);
+		break;
+	case 2:	/* RL */
+		j_shift(j, JSH_SHL, J_RAX, 1);
+		j_getf(j, J_RDX);
+		j_ri(j, JOP_AND, J_RDX, CF);
+		j_alu_rr(j, JOP_OR, J_RAX, J_RDX);
+		break;
+	case 3:	/* RR */
+		j_shift(j, JSH_SHR, J_RAX, 1);
+		j_getf(j, J_RDX);
+		j_ri(j, JOP_AND, J_RDX, CF);
+		j_shift(j, JSH_SHL, J_RDX, 7);
+		j_alu_rr(j, JOP_OR, J_RAX, J_RDX);
+		break;
+	case 4:	/* SLA */
+		j_shift(j, JSH_SHL, J_RAX, 1);
+		break;
+	case 5:	/* SRA */
+		j_mov(j, J_RDX, J_RAX);
+		j_ri(j, JOP_AND, J_RDX, 0x80);
+		j_shift(j, JSH_SHR, J_RAX, 1);
+		j_alu_rr(j, JOP_OR, J_RAX, J_RDX);
+		break;
+	case 6:	/* SLL */
+		j_shift(j, JSH_SHL, J_RAX, 1);
+		j_ri(j, JOP_OR, J_RAX, 1);
+		break;
+	case 7:	/* SRL */
+		j_shift(j, JSH_SHR, J_RAX, 1);
+		break;
+	}
+	j_ri(j, JOP_AND, J_RAX, 0xff);
+	j_table(j, J_RSI, J_RAX, flags_szp);
+	j_alu_rr(j, JOP_OR, J_RSI, J_RCX);
+	j_setl(j, J_AF, J_RSI);
+}
+
+/** @brief CB operation (rotate/shift, BIT, RES, SET) on EAX, hl if the operand is (HL) */
+static void j_cb(jit_t *j, uint32_t op, int hl)
+{
+	uint32_t b = (op >> 3) & 7;
+
+	switch (op >> 6) {
+	case 0:
+		j_rot(j, b);
+		break;
+	case 1:	/* BIT b */
+		j_ri(j, JOP_AND, J_RAX, 1 << b);
+		j_table(j, J_RSI, J_RAX, flags_sz_bit);
+		j_getf(j, J_RDX);
+		j_ri(j, JOP_AND, J_RDX, CF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDX);
+		if (hl)
+			j_m(j, 0x0fb6, 0, 0, J_RDX, J_CPU(mp) + 1);	/* MPH */
+		else
+			j_mov(j, J_RDX, J_RAX);
+		j_ri(j, JOP_AND, J_RDX, YF | XF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDX);
+		j_setl(j, J_AF, J_RSI);
+		break;
+	case 2:	/* RES b */
+		j_ri(j, JOP_AND, J_RAX, 0xff & ~(1 << b));
+		break;
+	case 3:	/* SET b */
+		j_ri(j, JOP_OR, J_RAX, 1 << b);
+		break;
+	}
+}
+
+/** @brief ADD HL,rr (op 0), ADC HL,rr (op 1) or SBC HL,rr (op 2) */
+static void j_alu16(jit_t *j, int op, int rp)
+{
+	j_mov(j, J_RAX, J_HL);
+	j_mov(j, J_RCX, rp);
+	j_mov(j, J_RDX, J_RAX);
+	j_alu_rr(j, 2 == op ? JOP_SUB : JOP_ADD, J_RDX, J_RCX);
+	if (op) {
+		j_getf(j, J_RSI);
+		j_ri(j, JOP_AND, J_RSI, CF);
+		j_alu_rr(j, 2 == op ? JOP_SUB : JOP_ADD, J_RDX, J_RSI);
+	}
+	/* MP = HL + 1 */
+	j_mem(j, 0x8d, 0, 0, J_RSI, J_RAX, J_NONE, 0, 1);
+	j_store16(j, J_CPU(mp), J_RSI);
+	/* ((reg ^ res ^ val) >> 8) & HF */
+	j_mov(j, J_RSI, J_RAX);
+	j_alu_rr(j, JOP_XOR, J_RSI, J_RDX);
+	j_alu_rr(j, JOP_XOR, J_RSI, J_RCX);
+	j_shift(j, JSH_SHR, J_RSI, 8);
+	j_ri(j, JOP_AND, J_RSI, HF);
+	/* (res >> 16) & CF */
+	j_mov(j, J_RDI, J_RDX);
+	j_shift(j, JSH_SHR, J_RDI, 16);
+	j_ri(j, JOP_AND, J_RDI, CF);
+	j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+	/* (res >> 8) & (YF | XF) or (SF | YF | XF) */
+	j_mov(j, J_RDI, J_RDX);
+	j_shift(j, JSH_SHR, J_RDI, 8);
+	j_ri(j, JOP_AND, J_RDI, op ? SF | YF | XF : YF | XF);
+	j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+	if (0 == op) {
+		j_getf(j, J_RDI);
+		j_ri(j, JOP_AND, J_RDI, SF | ZF | PF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+	} else {
+		/* (res & 0xffff) ? 0 : ZF */
+		j_alu_rr(j, JOP_XOR, J_RDI, J_RDI);
+		j_test(j, J_RDX, 0xffff);
+		j_rr(j, 0x0f90 | JCC_E, 0, 1, 0, J_RDI);
+		j_shift(j, JSH_SHL, J_RDI, 6);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+		/* overflow */
+		j_mov(j, J_RDI, J_RCX);
+		j_alu_rr(j, JOP_XOR, J_RDI, J_RAX);
+		if (1 == op) {
+			j_ri(j, JOP_XOR, J_RDI, 0x8000);
+			j_mov(j, J_R9, J_RCX);
+		} else {
+			j_mov(j, J_R9, J_RAX);
+		}
+		j_alu_rr(j, JOP_XOR, J_R9, J_RDX);
+		j_alu_rr(j, JOP_AND, J_RDI, J_R9);
+		j_ri(j, JOP_AND, J_RDI, 0x8000);
+		j_shift(j, JSH_SHR, J_RDI, 13);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RDI);
+		if (2 == op)
+			j_ri(j, JOP_OR, J_RSI, NF);
+	}
+	j_setl(j, J_AF, J_RSI);
+	j_rr(j, 0x0fb7, 0, 0, J_HL, J_RDX);
+}
+
+/** @brief translate the instruction at code[] (address pc), return its length or 0 if it is not handled */
+static uint32_t jit_op(jit_t *j, const uint8_t *code, uint32_t pc)
+{
+	uint32_t op = code[0];
+	uint32_t nn = code[1] | (code[2] << 8);
+	uint32_t r = (op >> 3) & 7;
+	uint32_t rr = op & 7;
+	uint32_t next, skip, cc, synced;
+
+	switch (op) {
+	case 0x00:	/* NOP */
+		return 1;
+
+	case 0x01: case 0x11: case 0x21: case 0x31:	/* LD rr,nnnn */
+		j_mov_ri(j, jit_rp[op >> 4], nn);
+		return 3;
+
+	case 0x02: case 0x12:	/* LD (BC),A / LD (DE),A */
+		j_sync(j);
+		j_get8(j, J_RAX, 7);
+		j_mov(j, J_RCX, jit_rp[op >> 4]);
+		j_wr(j);
+		j_check(j, (pc + 1) & 0xffff);
+		return 1;
+
+	case 0x0a: case 0x1a:	/* LD A,(BC) / LD A,(DE) */
+		j_sync(j);
+		j_mov(j, J_RCX, jit_rp[op >> 4]);
+		j_rd(j);
+		j_set8(j, 7, J_RAX);
+		j_check(j, (pc + 1) & 0xffff);
+		return 1;
+
+	case 0x03: case 0x13: case 0x23: case 0x33:	/* INC rr */
+	case 0x0b: case 0x1b: case 0x2b: case 0x3b:	/* DEC rr */
+		j_ri(j, op & 8 ? JOP_SUB : JOP_ADD, jit_rp[op >> 4], 1);
+		j_word(j, jit_rp[op >> 4]);
+		return 1;
+
+	case 0x09: case 0x19: case 0x29: case 0x39:	/* ADD HL,rr */
+		j_alu16(j, 0, jit_rp[op >> 4]);
+		return 1;
+
+	case 0x04: case 0x0c: case 0x14: case 0x1c:
+	case 0x24: case 0x2c: case 0x3c:		/* INC r */
+	case 0x05: case 0x0d: case 0x15: case 0x1d:
+	case 0x25: case 0x2d: case 0x3d:		/* DEC r */
+		j_get8(j, J_RAX, r);
+		j_incdec(j, op & 1);
+		j_set8(j, r, J_RAX);
+		return 1;
+
+	case 0x34: case 0x35:	/* INC (HL) / DEC (HL) */
+		j_sync(j);
+		j_rd_hl(j);
+		j_incdec(j, op & 1);
+		j_wr_hl(j);
+		j_check(j, (pc + 1) & 0xffff);
+		return 1;
+
+	case 0x06: case 0x0e: case 0x16: case 0x1e:
+	case 0x26: case 0x2e: case 0x3e:		/* LD r,nn */
+		j_mov_ri(j, J_RAX, code[1]);
+		j_set8(j, r, J_RAX);
+		return 2;
+
+	case 0x36:	/* LD (HL),nn */
+		j_sync(j);
+		j_mov_ri(j, J_RAX, code[1]);
+		j_wr_hl(j);
+		j_check(j, (pc + 2) & 0xffff);
+		return 2;
+
+	case 0x07:	/* RLCA */
+	case 0x0f:	/* RRCA */
+	case 0x17:	/* RLA */
+	case 0x1f:	/* RRA */
+		j_getf(j, J_R10);
+		j_get8(j, J_RAX, 7);
+		j_rot(j, r);
+		/* keep S, Z and P/V, take Y, X and C of the result */
+		j_ri(j, JOP_AND, J_RSI, YF | XF | CF);
+		j_ri(j, JOP_AND, J_R10, SF | ZF | PF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_R10);
+		j_setl(j, J_AF, J_RSI);
+		j_seth(j, J_AF, J_RAX);
+		return 1;
+
+	case 0x2f:	/* CPL */
+		j_ri(j, JOP_XOR, J_AF, 0xff00);
+		j_get8(j, J_RAX, 7);
+		j_ri(j, JOP_AND, J_RAX, YF | XF);
+		j_ri(j, JOP_OR, J_RAX, HF | NF);
+		j_getf(j, J_RSI);
+		j_ri(j, JOP_AND, J_RSI, SF | ZF | PF | CF);
+		j_alu_rr(j, JOP_OR, J_RSI, J_RAX);
+		j_setl(j, J_AF, J_RSI);
+		return 1;
+
+	case 0x37:	/* SCF */
+	case 0x3f:	/* CCF */
+		j_get8(j, J_RAX, 7);
+		j_ri(j, JOP_AND, J_RAX, YF | XF);
+		j_getf(j, J_RSI);
+		if (0x37 == op) {
+			j_ri(j, JOP_AND, J_RSI, SF | ZF | PF);
+			j_ri(j, JOP_OR, J_RSI, CF);
+		} else {
+			j_mov(j, J_RDI, J_RSI);
+			j_ri(j, JOP_AND, J_RDI, CF);
+			j_shift(j, JSH_SHL, J_RDI, 4);
+			j_alu_rr(j, JOP_OR, J_RAX, J_RDI);
+			j_ri(j, JOP_AND, J_RSI, SF | ZF | PF | CF);
+			j_ri(j, JOP_XOR, J_RSI, CF);
+		}
+		j_alu_rr(j, JOP_OR, J_RSI, J_RAX);
+		j_setl(j, J_AF, J_RSI);
+		return 1;
+
+	case 0x10:	/* DJNZ rel8 */
+		next = (pc + 2) & 0xffff;
+		j_ri(j, JOP_SUB, J_BC, 0x100);
+		j_word(j, J_BC);
+		j_test(j, J_BC, 0xff00);
+		skip = j_jcc(j, JCC_E);
+		goto jr_taken;
+
+	case 0x18:	/* JR rel8 */
+		next = (pc + 2 + (int8_t)code[1]) & 0xffff;
+		j_store16_imm(j, J_CPU(mp), next);
+		j_exit(j, next, 1);
+		return 2;
+
+	case 0x20: case 0x28: case 0x30: case 0x38:	/* JR cc,rel8 */
+		skip = j_cond(j, r & 3);
+	jr_taken:
+		cc = j->cc;
+		j->cc += cc_ex[op];
+		next = (pc + 2 + (int8_t)code[1]) & 0xffff;
+		j_store16_imm(j, J_CPU(mp), next);
+		j_exit(j, next, 1);
+		j->cc = cc;
+		j_here(j, skip);
+		return 2;
+
+	case 0x22:	/* LD (nnnn),HL */
+		j_store16_imm(j, J_CPU(mp), (nn + 1) & 0xffff);
+		j_sync(j);
+		j_mov_ri(j, J_RCX, nn);
+		j_rr(j, 0x0fb6, 0, 1, J_RAX, J_HL);
+		j_wr(j);
+		j_mov_ri(j, J_RCX, (nn + 1) & 0xffff);
+		j_mov(j, J_RAX, J_HL);
+		j_shift(j, JSH_SHR, J_RAX, 8);
+		j_wr(j);
+		j_check(j, (pc + 3) & 0xffff);
+		return 3;
+
+	case 0x2a:	/* LD HL,(nnnn) */
+		j_store16_imm(j, J_CPU(mp), (nn + 1) & 0xffff);
+		j_sync(j);
+		j_mov_ri(j, J_RCX, nn);
+		j_rd(j);
+		j_setl(j, J_HL, J_RAX);
+		j_mov_ri(j, J_RCX, (nn + 1) & 0xffff);
+		j_rd(j);
+		j_seth(j, J_HL, J_RAX);
+		j_check(j, (pc + 3) & 0xffff);
+		return 3;
+
+	case 0x32:	/* LD (nnnn),A */
+		j_sync(j);
+		j_mov_ri(j, J_RCX, nn);
+		j_get8(j, J_RAX, 7);
+		j_wr(j);
+		/* MP = (nnnn + 1) & 0xff | A << 8 */
+		j_mov(j, J_RAX, J_AF);
+		j_ri(j, JOP_AND, J_RAX, 0xff00);
+		j_ri(j, JOP_OR, J_RAX, (nn + 1) & 0xff);
+		j_store16(j, J_CPU(mp), J_RAX);
+		j_check(j, (pc + 3) & 0xffff);
+		return 3;
+
+	case 0x3a:	/* LD A,(nnnn) */
+		j_store16_imm(j, J_CPU(mp), (nn + 1) & 0xffff);
+		j_sync(j);
+		j_mov_ri(j, J_RCX, nn);
+		j_rd(j);
+		j_set8(j, 7, J_RAX);
+		j_check(j, (pc + 3) & 0xffff);
+		return 3;
+
+	case 0x76:	/* HALT */
+		return 0;
+
+	case 0xc0: case 0xc8: case 0xd0: case 0xd8:
+	case 0xe0: case 0xe8: case 0xf0: case 0xf8:	/* RET cc */
+		skip = j_cond(j, r);
+		cc = j->cc;
+		synced = j->synced;
+		j->cc += cc_ex[op];
+		j_sync(j);
+		j_pop_pc(j);
+		j_exit(j, J_PC_EAX, 1);
+		j->cc = cc;
+		j->synced = synced;
+		j_here(j, skip);
+		return 1;
+
+	case 0xc9:	/* RET */
+		j_sync(j);
+		j_pop_pc(j);
+		j_exit(j, J_PC_EAX, 1);
+		return 1;
+
+	case 0xc1: case 0xd1: case 0xe1: case 0xf1:	/* POP qq */
+		j_sync(j);
+		j_pop8(j);
+		j_setl(j, jit_qq[(op >> 4) & 3], J_RAX);
+		j_pop8(j);
+		j_seth(j, jit_qq[(op >> 4) & 3], J_RAX);
+		j_check(j, (pc + 1) & 0xffff);
+		return 1;
+
+	case 0xc5: case 0xd5: case 0xe5: case 0xf5:	/* PUSH qq */
+		j_sync(j);
+		j_push(j, jit_qq[(op >> 4) & 3], 0);
+		j_check(j, (pc + 1) & 0xffff);
+		return 1;
+
+	case 0xc3:	/* JP nnnn */
+		j_store16_imm(j, J_CPU(mp), nn);
+		j_exit(j, nn, 1);
+		return 3;
+
+	case 0xc2: case 0xca: case 0xd2: case 0xda:
+	case 0xe2: case 0xea: case 0xf2: case 0xfa:	/* JP cc,nnnn */
+		j_store16_imm(j, J_CPU(mp), nn);
+		skip = j_cond(j, r);
+		j_exit(j, nn, 1);
+		j_here(j, skip);
+		return 3;
+
+	case 0xcd:	/* CALL nnnn */
+		j_store16_imm(j, J_CPU(mp), nn);
+		j_sync(j);
+		j_push(j, -1, (pc + 3) & 0xffff);
+		j_exit(j, nn, 1);
+		return 3;
+
+	case 0xc4: case 0xcc: case 0xd4: case 0xdc:
+	case 0xe4: case 0xec: case 0xf4: case 0xfc:	/* CALL cc,nnnn */
+		j_store16_imm(j, J_CPU(mp), nn);
+		skip = j_cond(j, r);
+		cc = j->cc;
+		synced = j->synced;
+		j->cc += cc_ex[op];
+		j_sync(j);
+		j_push(j, -1, (pc + 3) & 0xffff);
+		j_exit(j, nn, 1);
+		j->cc = cc;
+		j->synced = synced;
+		j_here(j, skip);
+		return 3;
+
+	case 0xc7: case 0xcf: case 0xd7: case 0xdf:
+	case 0xe7: case 0xef: case 0xf7: case 0xff:	/* RST n */
+		j_sync(j);
+		j_push(j, -1, (pc + 1) & 0xffff);
+		j_store16_imm(j, J_CPU(mp), op & 0x38);
+		j_exit(j, op & 0x38, 1);
+		return 1;
+
+	case 0xc6: case 0xce: case 0xd6: case 0xde:
+	case 0xe6: case 0xee: case 0xf6: case 0xfe:	/* ALU A,nn */
+		j_mov_ri(j, J_RCX, code[1]);
+		j_alu8(j, r);
+		return 2;
+
+	case 0xcb:	/* CB prefix */
+		op = code[1];
+		rr = op & 7;
+		if (6 == rr) {
+			j_sync(j);
+			j_rd_hl(j);
+			j_cb(j, op, 1);
+			if (0x40 != (op & 0xc0))
+				j_wr_hl(j);
+			j_check(j, (pc + 2) & 0xffff);
+		} else {
+			j_get8(j, J_RAX, rr);
+			j_cb(j, op, 0);
+			if (0x40 != (op & 0xc0))
+				j_set8(j, rr, J_RAX);
+		}
+		return 2;
+
+	case 0xe9:	/* JP (HL) */
+		j_mov(j, J_RAX, J_HL);
+		j_exit(j, J_PC_EAX, 1);
+		return 1;
+
+	case 0xeb:	/* EX DE,HL */
+		j_mov(j, J_RAX, J_DE);
+		j_mov(j, J_DE, J_HL);
+		j_mov(j, J_HL, J_RAX);
+		return 1;
+
+	case 0xed:	/* ED prefix */
+		op = code[1];
+		switch (op) {
+		case 0x42: case 0x52: case 0x62: case 0x72:	/* SBC HL,rr */
+			j_alu16(j, 2, jit_rp[(op >> 4) & 3]);
+			return 2;
+		case 0x4a: case 0x5a: case 0x6a: case 0x7a:	/* ADC HL,rr */
+			j_alu16(j, 1, jit_rp[(op >> 4) & 3]);
+			return 2;
+		}
+		return 0;
+
+	case 0xf9:	/* LD SP,HL */
+		j_mov(j, J_SP, J_HL);
+		return 1;
+	}
+
+	if (0x40 == (op & 0xc0)) {	/* LD r,r' */
+		if (6 == rr) {
+			j_sync(j);
+			j_rd_hl(j);
+			j_set8(j, r, J_RAX);
+			j_check(j, (pc + 1) & 0xffff);
+		} else if (6 == r) {
+			j_sync(j);
+			j_get8(j, J_RAX, rr);
+			j_wr_hl(j);
+			j_check(j, (pc + 1) & 0xffff);
+		} else if (r != rr) {
+			j_get8(j, J_RAX, rr);
+			j_set8(j, r, J_RAX);
+		}
+		return 1;
+	}
+
+	if (0x80 == (op & 0xc0)) {	/* ALU A,r */
+		if (6 == rr) {
+			j_sync(j);
+			j_rd_hl(j);
+			j_mov(j, J_RCX, J_RAX);
+			j_alu8(j, r);
+			j_check(j, (pc + 1) & 0xffff);
+		} else {
+			j_get8(j, J_RCX, rr);
+			j_alu8(j, r);
+		}
+		return 1;
+	}
+	return 0;
+}
+
+/** @brief translate a basic block, return 0 on success */
+static int jit_compile(z80_block_t *blk)
+{
+	struct z80_bc_s *bc = machine->bc;
+	jit_t j;
+	jit_exit_t *x;
+	uint32_t o, n, pc, len, nexit, cc, last, count, epilogue, i;
+	static const int regs[6] = { J_RBX, J_RBP, J_R12, J_R13, J_R14, J_R15 };
+	static const int32_t pairs[5] = {
+		J_CPU(af), J_CPU(bc), J_CPU(de), J_CPU(hl), J_CPU(sp)
+	};
+	static const int hosts[5] = { J_AF, J_BC, J_DE, J_HL, J_SP };
+
+	j.code = bc->jit_code + bc->jit_used;
+	j.size = JIT_CODE_SIZE - bc->jit_used;
+	j.len = 0;
+	j.fail = 0;
+	j.nexit = 0;
+	j.cc = 0;
+	j.synced = 0;
+	j.n = 0;
+
+	/* prologue: save the callee saved registers, load the Z80 registers */
+	for (i = 0; i < 6; i++) {
+		j_rex(&j, 0, 0, J_NONE, regs[i], 0);
+		j_b(&j, 0x50 + (regs[i] & 7));
+	}
+	j_rr(&j, 0x83, 1, 0, JOP_SUB, J_RSP);
+	j_b(&j, 8);
+	j_rr(&j, 0x8b, 1, 0, J_M, J_RDI);
+	for (i = 0; i < 5; i++)
+		j_m(&j, 0x0fb7, 0, 0, hosts[i], pairs[i]);
+
+	for (o = 0, last = 0, count = 0; o < blk->len; o += n) {
+		pc = (blk->pc + o) & 0xffff;
+		/* leave idle loops to the interpreter */
+		if (z80_idle && (idle_map[pc / 8] & (1 << (pc % 8))))
+			break;
+		len = j.len;
+		nexit = j.nexit;
+		cc = j.cc;
+		j.n++;
+		j.cc += 0xcb == blk->code[o] ? cc_cb[blk->code[o + 1]] :
+			0xed == blk->code[o] ? cc_ed[blk->code[o + 1]] :
+			cc_op[blk->code[o]];
+		n = jit_op(&j, &blk->code[o], pc);
+		if (0 == n) {
+			j.len = len;
+			j.nexit = nexit;
+			j.cc = cc;
+			j.n--;
+			break;
+		}
+		last = cc;
+		count++;
+	}
+	if (0 == count)
+		return -1;
+	j_exit(&j, (blk->pc + o) & 0xffff, 0);
+
+	/* epilogue: EAX = PC, ECX = cycles, EDX = instructions */
+	epilogue = j.len;
+	j_store16(&j, J_CPU(pc), J_RAX);
+	j_m(&j, 0x01, 0, 0, J_RCX, J_OFS(z80_cc));
+	j_m(&j, 0x00, 0, 1, J_RDX, J_CPU(r));
+	for (i = 0; i < 5; i++)
+		j_store16(&j, pairs[i], hosts[i]);
+	j_rr(&j, 0x83, 1, 0, JOP_ADD, J_RSP);
+	j_b(&j, 8);
+	for (i = 6; i-- > 0; /* */) {
+		j_rex(&j, 0, 0, J_NONE, regs[i], 0);
+		j_b(&j, 0x58 + (regs[i] & 7));
+	}
+	j_b(&j, 0xc3);
+
+	for (i = 0; i < j.nexit; i++) {
+		x = &j.exit[i];
+		j_here(&j, x->at);
+		if (J_PC_EAX != x->pc)
+			j_mov_ri(&j, J_RAX, x->pc);
+		j_mov_ri(&j, J_RCX, x->cc);
+		j_mov_ri(&j, J_RDX, x->n);
+		if (x->leave) {
+			/* make the next fetch look up the block at the new PC */
+			j_m(&j, 0xc7, 0, 0, 0, J_OFS(bc_len));
+			j_d(&j, 0);
+		}
+		j_target(&j, j_jmp(&j), epilogue);
+	}
+
+	if (j.fail) {
+		/* out of code space: start over */
+		z80_bc_flush();
+		return -1;
+	}
+	blk->jit = (void (*)(machine_t *))(void *)j.code;
+	blk->jit_cc = last;
+	bc->jit_used += (j.len + 15) & ~15;
+	return 0;
+}
+
+/** @brief run the translated code of the block at PC, return 0 if there is none */
+static int jit_execute(z80_cpu_t *cpu)
+{
+	z80_block_t *blk;
+
+	blk = bc_lookup(cpu);
+	if (NULL == blk || NULL != z80_prof || NULL != z80_trace)
+		return 0;
+	/* leave pages with breakpoints to the interpreter */
+	if (z80_bp_pages & ((1ull << (blk->pc >> L1SHIFT)) |
+		(1ull << ((blk->pc + blk->len - 1) >> L1SHIFT))))
+		return 0;
+	if (z80_idle && (idle_map[PC / 8] & (1 << (PC % 8))))
+		return 0;
+	if (NULL == blk->jit) {
+		if (++blk->hits != z80_jit)
+			return 0;
+		if (jit_compile(blk) < 0)
+			return 0;
+	}
+	/* all but the last instruction must start in this time slice */
+	if (z80_cc + blk->jit_cc >= machine->cycles)
+		return 0;
+	(*blk->jit)(machine);
+	return 1;
+}
+#endif
+
+int z80_execute(z80_cpu_t *cpu)
+{
+	const int hook = HOOKED;
+#if	Z80_THREADED
+	const int step = hook || z80_jit;
+#endif
+	uint8_t op;
+	uint8_t m = 0;
+#if	Z80_THREADED
+	static const void * const op_xx[0x100] = {
+		OP_ADDR(xx,0x00),OP_ADDR(xx,0x01),OP_ADDR(xx,0x02),OP_ADDR(xx,0x03),OP_ADDR(xx,0x04),OP_ADDR(xx,0x05),OP_ADDR(xx,0x06),OP_ADDR(xx,0x07),
+		OP_ADDR(xx,0x08),OP_ADDR(xx,0x09),OP_ADDR(xx,0x0a),OP_ADDR(xx,0x0b),OP_ADDR(xx,0x0c),OP_ADDR(xx,0x0d),OP_ADDR(xx,0x0e),OP_ADDR(xx,0x0f),
+		OP_ADDR(xx,0x10),OP_ADDR(xx,0x11),OP_ADDR(xx,0x12),OP_ADDR(xx,0x13),OP_ADDR(xx,0x14),OP_ADDR(xx,0x15),OP_ADDR(xx,0x16),OP_ADDR(xx,0x17),
+		OP_ADDR(xx,0x18),OP_ADDR(xx,0x19),OP_ADDR(xx,0x1a),OP_ADDR(xx,0x1b),OP_ADDR(xx,0x1c),OP_ADDR(xx,0x1d),OP_ADDR(xx,0x1e),OP_ADDR(xx,0x1f),
+		OP_ADDR(xx,0x20),OP_ADDR(xx,0x21),OP_ADDR(xx,0x22),OP_ADDR(xx,0x23),OP_ADDR(xx,0x24),OP_ADDR(xx,0x25),OP_ADDR(xx,0x26),OP_ADDR(xx,0x27),
+		OP_ADDR(xx,0x28),OP_ADDR(xx,0x29),OP_ADDR(xx,0x2a),OP_ADDR(xx,0x2b),OP_ADDR(xx,0x2c),OP_ADDR(xx,0x2d),OP_ADDR(xx,0x2e),OP_ADDR(xx,0x2f),
+		OP_ADDR(xx,0x30),OP_ADDR(xx,0x31),OP_ADDR(xx,0x32),OP_ADDR(xx,0x33),OP_ADDR(xx,0x34),OP_ADDR(xx,0x35),OP_ADDR(xx,0x36),OP_ADDR(xx,0x37),
+		OP_ADDR(xx,0x38),OP_ADDR(xx,0x39),OP_ADDR(xx,0x3a),OP_ADDR(xx,0x3b),OP_ADDR(xx,0x3c),OP_ADDR(xx,0x3d),OP_ADDR(xx,0x3e),OP_ADDR(xx,0x3f),
+		OP_ADDR(xx,0x40),OP_ADDR(xx,0x41),OP_ADDR(xx,0x42),OP_ADDR(xx,0x43),OP_ADDR(xx,0x44),OP_ADDR(xx,0x45),OP_ADDR(xx,0x46),OP_ADDR(xx,0x47),
+		OP_ADDR(xx,0x48),OP_ADDR(xx,0x49),OP_ADDR(xx,0x4a),OP_ADDR(xx,0x4b),OP_ADDR(xx,0x4c),OP_ADDR(xx,0x4d),OP_ADDR(xx,0x4e),OP_ADDR(xx,0x4f),
+		OP_ADDR(xx,0x50),OP_ADDR(xx,0x51),OP_ADDR(xx,0x52),OP_ADDR(xx,0x53),OP_ADDR(xx,0x54),OP_ADDR(xx,0x55),OP_ADDR(xx,0x56),OP_ADDR(xx,0x57),
+		OP_ADDR(xx,0x58),OP_ADDR(xx,0x59),OP_ADDR(xx,0x5a),OP_ADDR(xx,0x5b),OP_ADDR(xx,0x5c),OP_ADDR(xx,0x5d),OP_ADDR(xx,0x5e),OP_ADDR(xx,0x5f),
+		OP_ADDR(xx,0x60),OP_ADDR(xx,0x61),OP_ADDR(xx,0x62),OP_ADDR(xx,0x63),OP_ADDR(xx,0x64),OP_ADDR(xx,0x65),OP_ADDR(xx,0x66),OP_ADDR(xx,0x67),
+		OP_ADDR(xx,0x68),OP_ADDR(xx,0x69),OP_ADDR(xx,0x6a),OP_ADDR(xx,0x6b),OP_ADDR(xx,0x6c),OP_ADDR(xx,0x6d),OP_ADDR(xx,0x6e),OP_ADDR(xx,0x6f),
+		OP_ADDR(xx,0x70),OP_ADDR(xx,0x71),OP_ADDR(xx,0x72),OP_ADDR(xx,0x73),OP_ADDR(xx,0x74),OP_ADDR(xx,0x75),OP_ADDR(xx,0x76),OP_ADDR(xx,0x77),
+		OP_ADDR(xx,0x78),OP_ADDR(xx,0x79),OP_ADDR(xx,0x7a),OP_ADDR(xx,0x7b),OP_ADDR(xx,0x7c),OP_ADDR(xx,0x7d),OP_ADDR(xx,0x7e),OP_ADDR(xx,0x7f),
+		OP_ADDR(xx,0x80),OP_ADDR(xx,0x81),OP_ADDR(xx,0x82),OP_ADDR(xx,0x83),OP_ADDR(xx,0x84),OP_ADDR(xx,0x85),OP_ADDR(xx,0x86),OP_ADDR(xx,0x87),
+		OP_ADDR(xx,0x88),OP_ADDR(xx,0x89),OP_ADDR(xx,0x8a),OP_ADDR(xx,0x8b),OP_ADDR(xx,0x8c),OP_ADDR(xx,0x8d),OP_ADDR(xx,0x8e),OP_ADDR(xx,0x8f),
+		OP_ADDR(xx,0x90),OP_ADDR(xx,0x91),OP_ADDR(xx,0x92),OP_ADDR(xx,0x93),OP_ADDR(xx,0x94),OP_ADDR(xx,0x95),OP_ADDR(xx,0x96),OP_ADDR(xx,0x97),
+		OP_ADDR(xx,0x98),OP_ADDR(xx,0x99),OP_ADDR(xx,0x9a),OP_ADDR(xx,0x9b),OP_ADDR(xx,0x9c),OP_ADDR(xx,0x9d),OP_ADDR(xx,0x9e),OP_ADDR(xx,0x9f),
+		OP_ADDR(xx,0xa0),OP_ADDR(xx,0xa1),OP_ADDR(xx,0xa2),OP_ADDR(xx,0xa3),OP_ADDR(xx,0xa4),OP_ADDR(xx,0xa5),OP_ADDR(xx,0xa6),OP_ADDR(xx,0xa7),
+		OP_ADDR(xx,0xa8),OP_ADDR(xx,0xa9),OP_ADDR(xx,0xaa),OP_ADDR(xx,0xab),OP_ADDR(xx,0xac),OP_ADDR(xx,0xad),OP_ADDR(xx,0xae),OP_ADDR(xx,0xaf),
+		OP_ADDR(xx,0xb0),OP_ADDR(xx,0xb1),OP_ADDR(xx,0xb2),OP_ADDR(xx,0xb3),OP_ADDR(xx,0xb4),OP_ADDR(xx,0xb5),OP_ADDR(xx,0xb6),OP_ADDR(xx,0xb7),
+		OP_ADDR(xx,0xb8),OP_ADDR(xx,0xb9),OP_ADDR(xx,0xba),OP_ADDR(xx,0xbb),OP_ADDR(xx,0xbc),OP_ADDR(xx,0xbd),OP_ADDR(xx,0xbe),OP_ADDR(xx,0xbf),
+		OP_ADDR(xx,0xc0),OP_ADDR(xx,0xc1),OP_ADDR(xx,0xc2),OP_ADDR(xx,0xc3),OP_ADDR(xx,0xc4),OP_ADDR(xx,0xc5),OP_ADDR(xx,0xc6),OP_ADDR(xx,0xc7),
+		OP_ADDR(xx,0xc8),OP_ADDR(xx,0xc9),OP_ADDR(xx,0xca),OP_ADDR(xx,0xcb),OP_ADDR(xx,0xcc),OP_ADDR(xx,0xcd),OP_ADDR(xx,0xce),OP_ADDR(xx,0xcf),
+		OP_ADDR(xx,0xd0),OP_ADDR(xx,0xd1),OP_ADDR(xx,0xd2),OP_ADDR(xx,0xd3),OP_ADDR(xx,0xd4),OP_ADDR(xx,0xd5),OP_ADDR(xx,0xd6),OP_ADDR(xx,0xd7),
+		OP_ADDR(xx,0xd8),OP_ADDR(xx,0xd9),OP_ADDR(xx,0xda),OP_ADDR(xx,0xdb),OP_ADDR(xx,0xdc),OP_ADDR(xx,0xdd),OP_ADDR(xx,0xde),OP_ADDR(xx,0xdf),
+		OP_ADDR(xx,0xe0),OP_ADDR(xx,0xe1),OP_ADDR(xx,0xe2),OP_ADDR(xx,0xe3),OP_ADDR(xx,0xe4),OP_ADDR(xx,0xe5),OP_ADDR(xx,0xe6),OP_ADDR(xx,0xe7),
+		OP_ADDR(xx,0xe8),OP_ADDR(xx,0xe9),OP_ADDR(xx,0xea),OP_ADDR(xx,0xeb),OP_ADDR(xx,0xec),OP_ADDR(xx,0xed),OP_ADDR(xx,0xee),OP_ADDR(xx,0xef),
+		OP_ADDR(xx,0xf0),OP_ADDR(xx,0xf1),OP_ADDR(xx,0xf2),OP_ADDR(xx,0xf3),OP_ADDR(xx,0xf4),OP_ADDR(xx,0xf5),OP_ADDR(xx,0xf6),OP_ADDR(xx,0xf7),
+		OP_ADDR(xx,0xf8),OP_ADDR(xx,0xf9),OP_ADDR(xx,0xfa),OP_ADDR(xx,0xfb),OP_ADDR(xx,0xfc),OP_ADDR(xx,0xfd),OP_ADDR(xx,0xfe),OP_ADDR(xx,0xff)
+	};
+	static const void * const op_cb[0x100] = {
+		OP_ADDR(cb,0x00),OP_ADDR(cb,0x01),OP_ADDR(cb,0x02),OP_ADDR(cb,0x03),OP_ADDR(cb,0x04),OP_ADDR(cb,0x05),OP_ADDR(cb,0x06),OP_ADDR(cb,0x07),
+		OP_ADDR(cb,0x08),OP_ADDR(cb,0x09),OP_ADDR(cb,0x0a),OP_ADDR(cb,0x0b),OP_ADDR(cb,0x0c),OP_ADDR(cb,0x0d),OP_ADDR(cb,0x0e),OP_ADDR(cb,0x0f),
+		OP_ADDR(cb,0x10),OP_ADDR(cb,0x11),OP_ADDR(cb,0x12),OP_ADDR(cb,0x13),OP_ADDR(cb,0x14),OP_ADDR(cb,0x15),OP_ADDR(cb,0x16),OP_ADDR(cb,0x17),
+		OP_ADDR(cb,0x18),OP_ADDR(cb,0x19),OP_ADDR(cb,0x1a),OP_ADDR(cb,0x1b),OP_ADDR(cb,0x1c),OP_ADDR(cb,0x1d),OP_ADDR(cb,0x1e),OP_ADDR(cb,0x1f),
+		OP_ADDR(cb,0x20),OP_ADDR(cb,0x21),OP_ADDR(cb,0x22),OP_ADDR(cb,0x23),OP_ADDR(cb,0x24),OP_ADDR(cb,0x25),OP_ADDR(cb,0x26),OP_ADDR(cb,0x27),
+		OP_ADDR(cb,0x28),OP_ADDR(cb,0x29),OP_ADDR(cb,0x2a),OP_ADDR(cb,0x2b),OP_ADDR(cb,0x2c),OP_ADDR(cb,0x2d),OP_ADDR(cb,0x2e),OP_ADDR(cb,0x2f),
+		OP_ADDR(cb,0x30),OP_ADDR(cb,0x31),OP_ADDR(cb,0x32),OP_ADDR(cb,0x33),OP_ADDR(cb,0x34),OP_ADDR(cb,0x35),OP_ADDR(cb,0x36),OP_ADDR(cb,0x37),
+		OP_ADDR(cb,0x38),OP_ADDR(cb,0x39),OP_ADDR(cb,0x3a),OP_ADDR(cb,0x3b),OP_ADDR(cb,0x3c),OP_ADDR(cb,0x3d),OP_ADDR(cb,0x3e),OP_ADDR(cb,0x3f),
+		OP_ADDR(cb,0x40),OP_ADDR(cb,0x41),OP_ADDR(cb,0x42),OP_ADDR(cb,0x43),OP_ADDR(cb,0x44),OP_ADDR(cb,0x45),OP_ADDR(cb,0x46),OP_ADDR(cb,0x47),
+		OP_ADDR(cb,0x48),OP_ADDR(cb,0x49),OP_ADDR(cb,0x4a),OP_ADDR(cb,0x4b),OP_ADDR(cb,0x4c),OP_ADDR(cb,0x4d),OP_ADDR(cb,0x4e),OP_ADDR(cb,0x4f),
+		OP_ADDR(cb,0x50),OP_ADDR(cb,0x51),OP_ADDR(cb,0x52),OP_ADDR(cb,0x53),OP_ADDR(cb,0x54),OP_ADDR(cb,0x55),OP_ADDR(cb,0x56),OP_ADDR(cb,0x57),
+		OP_ADDR(cb,0x58),OP_ADDR(cb,0x59),OP_ADDR(cb,0x5a),OP_ADDR(cb,0x5b),OP_ADDR(cb,0x5c),OP_ADDR(cb,0x5d),OP_ADDR(cb,0x5e),OP_ADDR(cb,0x5f),
+		OP_ADDR(cb,0x60),OP_ADDR(cb,0x61),OP_ADDR(cb,0x62),OP_ADDR(cb,0x63),OP_ADDR(cb,0x64),OP_ADDR(cb,0x65),OP_ADDR(cb,0x66),OP_ADDR(cb,0x67),
+		OP_ADDR(cb,0x68),OP_ADDR(cb,0x69),OP_ADDR(cb,0x6a),OP_ADDR(cb,0x6b),OP_ADDR(cb,0x6c),OP_ADDR(cb,0x6d),OP_ADDR(cb,0x6e),OP_ADDR(cb,0x6f),
+		OP_ADDR(cb,0x70),OP_ADDR(cb,0x71),OP_ADDR(cb,0x72),OP_ADDR(cb,0x73),OP_ADDR(cb,0x74),OP_ADDR(cb,0x75),OP_ADDR(cb,0x76),OP_ADDR(cb,0x77),
+		OP_ADDR(cb,0x78),OP_ADDR(cb,0x79),OP_ADDR(cb,0x7a),OP_ADDR(cb,0x7b),OP_ADDR(cb,0x7c),OP_ADDR(cb,0x7d),OP_ADDR(cb,0x7e),OP_ADDR(cb,0x7f),
+		OP_ADDR(cb,0x80),OP_ADDR(cb,0x81),OP_ADDR(cb,0x82),OP_ADDR(cb,0x83),OP_ADDR(cb,0x84),OP_ADDR(cb,0x85),OP_ADDR(cb,0x86),OP_ADDR(cb,0x87),
+		OP_ADDR(cb,0x88),OP_ADDR(cb,0x89),OP_ADDR(cb,0x8a),OP_ADDR(cb,0x8b),OP_ADDR(cb,0x8c),OP_ADDR(cb,0x8d),OP_ADDR(cb,0x8e),OP_ADDR(cb,0x8f),
+		OP_ADDR(cb,0x90),OP_ADDR(cb,0x91),OP_ADDR(cb,0x92),OP_ADDR(cb,0x93),OP_ADDR(cb,0x94),OP_ADDR(cb,0x95),OP_ADDR(cb,0x96),OP_ADDR(cb,0x97),
+		OP_ADDR(cb,0x98),OP_ADDR(cb,0x99),OP_ADDR(cb,0x9a),OP_ADDR(cb,0x9b),OP_ADDR(cb,0x9c),OP_ADDR(cb,0x9d),OP_ADDR(cb,0x9e),OP_ADDR(cb,0x9f),
+		OP_ADDR(cb,0xa0),OP_ADDR(cb,0xa1),OP_ADDR(cb,0xa2),OP_ADDR(cb,0xa3),OP_ADDR(cb,0xa4),OP_ADDR(cb,0xa5),OP_ADDR(cb,0xa6),OP_ADDR(cb,0xa7),
+		OP_ADDR(cb,0xa8),OP_ADDR(cb,0xa9),OP_ADDR(cb,0xaa),OP_ADDR(cb,0xab),OP_ADDR(cb,0xac),OP_ADDR(cb,0xad),OP_ADDR(cb,0xae),OP_ADDR(cb,0xaf),
+		OP_ADDR(cb,0xb0),OP_ADDR(cb,0xb1),OP_ADDR(cb,0xb2),OP_ADDR(cb,0xb3),OP_ADDR(cb,0xb4),OP_ADDR(cb,0xb5),OP_ADDR(cb,0xb6),OP_ADDR(cb,0xb7),
+		OP_ADDR(cb,0xb8),OP_ADDR(cb,0xb9),OP_ADDR(cb,0xba),OP_ADDR(cb,0xbb),OP_ADDR(cb,0xbc),OP_ADDR(cb,0xbd),OP_ADDR(cb,0xbe),OP_ADDR(cb,0xbf),
+		OP_ADDR(cb,0xc0),OP_ADDR(cb,0xc1),OP_ADDR(cb,0xc2),OP_ADDR(cb,0xc3),OP_ADDR(cb,0xc4),OP_ADDR(cb,0xc5),OP_ADDR(cb,0xc6),OP_ADDR(cb,0xc7),
+		OP_ADDR(cb,0xc8),OP_ADDR(cb,0xc9),OP_ADDR(cb,0xca),OP_ADDR(cb,0xcb),OP_ADDR(cb,0xcc),OP_ADDR(cb,0xcd),OP_ADDR(cb,0xce),OP_ADDR(cb,0xcf),
+		OP_ADDR(cb,0xd0),OP_ADDR(cb,0xd1),OP_ADDR(cb,0xd2),OP_ADDR(cb,0xd3),OP_ADDR(cb,0xd4),OP_ADDR(cb,0xd5),OP_ADDR(cb,0xd6),OP_ADDR(cb,0xd7),
+		OP_ADDR(cb,0xd8),OP_ADDR(cb,0xd9),OP_ADDR(cb,0xda),OP_ADDR(cb,0xdb),OP_ADDR(cb,0xdc),OP_ADDR(cb,0xdd),OP_ADDR(cb,0xde),OP_ADDR(cb,0xdf),
+		OP_ADDR(cb,0xe0),OP_ADDR(cb,0xe1),OP_ADDR(cb,0xe2),OP_ADDR(cb,0xe3),OP_ADDR(cb,0xe4),OP_ADDR(cb,0xe5),OP_ADDR(cb,0xe6),OP_ADDR(cb,0xe7),
+		OP_ADDR(cb,0xe8),OP_ADDR(cb,0xe9),OP_ADDR(cb,0xea),OP_ADDR(cb,0xeb),OP_ADDR(cb,0xec),OP_ADDR(cb,0xed),OP_ADDR(cb,0xee),OP_ADDR(cb,0xef),
+		OP_ADDR(cb,0xf0),OP_ADDR(cb,0xf1),OP_ADDR(cb,0xf2),OP_ADDR(cb,0xf3),OP_ADDR(cb,0xf4),OP_ADDR(cb,0xf5),OP_ADDR(cb,0xf6),OP_ADDR(cb,0xf7),
+		OP_ADDR(cb,0xf8),OP_ADDR(cb,0xf9),OP_ADDR(cb,0xfa),OP_ADDR(cb,0xfb),OP_ADDR(cb,0xfc),OP_ADDR(cb,0xfd),OP_ADDR(cb,0xfe),OP_ADDR(cb,0xff)
+	};
+	static const void * const op_ed[0x100] = {
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,0x40),OP_ADDR(ed,0x41),OP_ADDR(ed,0x42),OP_ADDR(ed,0x43),OP_ADDR(ed,0x44),OP_ADDR(ed,0x45),OP_ADDR(ed,0x46),OP_ADDR(ed,0x47),
+		OP_ADDR(ed,0x48),OP_ADDR(ed,0x49),OP_ADDR(ed,0x4a),OP_ADDR(ed,0x4b),OP_ADDR(ed,0x4c),OP_ADDR(ed,0x4d),OP_ADDR(ed,0x4e),OP_ADDR(ed,0x4f),
+		OP_ADDR(ed,0x50),OP_ADDR(ed,0x51),OP_ADDR(ed,0x52),OP_ADDR(ed,0x53),OP_ADDR(ed,0x54),OP_ADDR(ed,0x55),OP_ADDR(ed,0x56),OP_ADDR(ed,0x57),
+		OP_ADDR(ed,0x58),OP_ADDR(ed,0x59),OP_ADDR(ed,0x5a),OP_ADDR(ed,0x5b),OP_ADDR(ed,0x5c),OP_ADDR(ed,0x5d),OP_ADDR(ed,0x5e),OP_ADDR(ed,0x5f),
+		OP_ADDR(ed,0x60),OP_ADDR(ed,0x61),OP_ADDR(ed,0x62),OP_ADDR(ed,0x63),OP_ADDR(ed,0x64),OP_ADDR(ed,0x65),OP_ADDR(ed,0x66),OP_ADDR(ed,0x67),
+		OP_ADDR(ed,0x68),OP_ADDR(ed,0x69),OP_ADDR(ed,0x6a),OP_ADDR(ed,0x6b),OP_ADDR(ed,0x6c),OP_ADDR(ed,0x6d),OP_ADDR(ed,0x6e),OP_ADDR(ed,0x6f),
+		OP_ADDR(ed,0x70),OP_ADDR(ed,0x71),OP_ADDR(ed,0x72),OP_ADDR(ed,0x73),OP_ADDR(ed,0x74),OP_ADDR(ed,0x75),OP_ADDR(ed,0x76),OP_ADDR(ed,default),
+		OP_ADDR(ed,0x78),OP_ADDR(ed,0x79),OP_ADDR(ed,0x7a),OP_ADDR(ed,0x7b),OP_ADDR(ed,0x7c),OP_ADDR(ed,0x7d),OP_ADDR(ed,0x7e),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,0xa0),OP_ADDR(ed,0xa1),OP_ADDR(ed,0xa2),OP_ADDR(ed,0xa3),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,0xa8),OP_ADDR(ed,0xa9),OP_ADDR(ed,0xaa),OP_ADDR(ed,0xab),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,0xb0),OP_ADDR(ed,0xb1),OP_ADDR(ed,0xb2),OP_ADDR(ed,0xb3),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,0xb8),OP_ADDR(ed,0xb9),OP_ADDR(ed,0xba),OP_ADDR(ed,0xbb),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),
+		OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default),OP_ADDR(ed,default)
+	};
+	static const void * const op_dd[0x100] = {
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0x09),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0x19),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0x21),OP_ADDR(dd,0x22),OP_ADDR(dd,0x23),OP_ADDR(dd,0x24),OP_ADDR(dd,0x25),OP_ADDR(dd,0x26),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0x29),OP_ADDR(dd,0x2a),OP_ADDR(dd,0x2b),OP_ADDR(dd,0x2c),OP_ADDR(dd,0x2d),OP_ADDR(dd,0x2e),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x34),OP_ADDR(dd,0x35),OP_ADDR(dd,0x36),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0x39),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x44),OP_ADDR(dd,0x45),OP_ADDR(dd,0x46),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x4c),OP_ADDR(dd,0x4d),OP_ADDR(dd,0x4e),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x54),OP_ADDR(dd,0x55),OP_ADDR(dd,0x56),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x5c),OP_ADDR(dd,0x5d),OP_ADDR(dd,0x5e),OP_ADDR(dd,default),
+		OP_ADDR(dd,0x60),OP_ADDR(dd,0x61),OP_ADDR(dd,0x62),OP_ADDR(dd,0x63),OP_ADDR(dd,0x64),OP_ADDR(dd,0x65),OP_ADDR(dd,0x66),OP_ADDR(dd,0x67),
+		OP_ADDR(dd,0x68),OP_ADDR(dd,0x69),OP_ADDR(dd,0x6a),OP_ADDR(dd,0x6b),OP_ADDR(dd,0x6c),OP_ADDR(dd,0x6d),OP_ADDR(dd,0x6e),OP_ADDR(dd,0x6f),
+		OP_ADDR(dd,0x70),OP_ADDR(dd,0x71),OP_ADDR(dd,0x72),OP_ADDR(dd,0x73),OP_ADDR(dd,0x74),OP_ADDR(dd,0x75),OP_ADDR(dd,default),OP_ADDR(dd,0x77),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x7c),OP_ADDR(dd,0x7d),OP_ADDR(dd,0x7e),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x84),OP_ADDR(dd,0x85),OP_ADDR(dd,0x86),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x8c),OP_ADDR(dd,0x8d),OP_ADDR(dd,0x8e),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x94),OP_ADDR(dd,0x95),OP_ADDR(dd,0x96),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0x9c),OP_ADDR(dd,0x9d),OP_ADDR(dd,0x9e),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xa4),OP_ADDR(dd,0xa5),OP_ADDR(dd,0xa6),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xac),OP_ADDR(dd,0xad),OP_ADDR(dd,0xae),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xb4),OP_ADDR(dd,0xb5),OP_ADDR(dd,0xb6),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xbc),OP_ADDR(dd,0xbd),OP_ADDR(dd,0xbe),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xcb),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xdd),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0xe1),OP_ADDR(dd,default),OP_ADDR(dd,0xe3),OP_ADDR(dd,default),OP_ADDR(dd,0xe5),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0xe9),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xed),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),
+		OP_ADDR(dd,default),OP_ADDR(dd,0xf9),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,default),OP_ADDR(dd,0xfd),OP_ADDR(dd,default),OP_ADDR(dd,default)
+	};
+	static const void * const op_fd[0x100] = {
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0x09),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0x19),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0x21),OP_ADDR(fd,0x22),OP_ADDR(fd,0x23),OP_ADDR(fd,0x24),OP_ADDR(fd,0x25),OP_ADDR(fd,0x26),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0x29),OP_ADDR(fd,0x2a),OP_ADDR(fd,0x2b),OP_ADDR(fd,0x2c),OP_ADDR(fd,0x2d),OP_ADDR(fd,0x2e),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x34),OP_ADDR(fd,0x35),OP_ADDR(fd,0x36),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0x39),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x44),OP_ADDR(fd,0x45),OP_ADDR(fd,0x46),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x4c),OP_ADDR(fd,0x4d),OP_ADDR(fd,0x4e),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x54),OP_ADDR(fd,0x55),OP_ADDR(fd,0x56),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x5c),OP_ADDR(fd,0x5d),OP_ADDR(fd,0x5e),OP_ADDR(fd,default),
+		OP_ADDR(fd,0x60),OP_ADDR(fd,0x61),OP_ADDR(fd,0x62),OP_ADDR(fd,0x63),OP_ADDR(fd,0x64),OP_ADDR(fd,0x65),OP_ADDR(fd,0x66),OP_ADDR(fd,0x67),
+		OP_ADDR(fd,0x68),OP_ADDR(fd,0x69),OP_ADDR(fd,0x6a),OP_ADDR(fd,0x6b),OP_ADDR(fd,0x6c),OP_ADDR(fd,0x6d),OP_ADDR(fd,0x6e),OP_ADDR(fd,0x6f),
+		OP_ADDR(fd,0x70),OP_ADDR(fd,0x71),OP_ADDR(fd,0x72),OP_ADDR(fd,0x73),OP_ADDR(fd,0x74),OP_ADDR(fd,0x75),OP_ADDR(fd,default),OP_ADDR(fd,0x77),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x7c),OP_ADDR(fd,0x7d),OP_ADDR(fd,0x7e),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x84),OP_ADDR(fd,0x85),OP_ADDR(fd,0x86),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x8c),OP_ADDR(fd,0x8d),OP_ADDR(fd,0x8e),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x94),OP_ADDR(fd,0x95),OP_ADDR(fd,0x96),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0x9c),OP_ADDR(fd,0x9d),OP_ADDR(fd,0x9e),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xa4),OP_ADDR(fd,0xa5),OP_ADDR(fd,0xa6),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xac),OP_ADDR(fd,0xad),OP_ADDR(fd,0xae),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xb4),OP_ADDR(fd,0xb5),OP_ADDR(fd,0xb6),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xbc),OP_ADDR(fd,0xbd),OP_ADDR(fd,0xbe),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xcb),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xdd),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0xe1),OP_ADDR(fd,default),OP_ADDR(fd,0xe3),OP_ADDR(fd,default),OP_ADDR(fd,0xe5),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0xe9),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xed),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),
+		OP_ADDR(fd,default),OP_ADDR(fd,0xf9),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,default),OP_ADDR(fd,0xfd),OP_ADDR(fd,default),OP_ADDR(fd,default)
+	};
+	static const void * const op_xycb[0x100] = {
+		OP_ADDR(xycb,0x00),OP_ADDR(xycb,0x01),OP_ADDR(xycb,0x02),OP_ADDR(xycb,0x03),OP_ADDR(xycb,0x04),OP_ADDR(xycb,0x05),OP_ADDR(xycb,0x06),OP_ADDR(xycb,0x07),
+		OP_ADDR(xycb,0x08),OP_ADDR(xycb,0x09),OP_ADDR(xycb,0x0a),OP_ADDR(xycb,0x0b),OP_ADDR(xycb,0x0c),OP_ADDR(xycb,0x0d),OP_ADDR(xycb,0x0e),OP_ADDR(xycb,0x0f),
+		OP_ADDR(xycb,0x10),OP_ADDR(xycb,0x11),OP_ADDR(xycb,0x12),OP_ADDR(xycb,0x13),OP_ADDR(xycb,0x14),OP_ADDR(xycb,0x15),OP_ADDR(xycb,0x16),OP_ADDR(xycb,0x17),
+		OP_ADDR(xycb,0x18),OP_ADDR(xycb,0x19),OP_ADDR(xycb,0x1a),OP_ADDR(xycb,0x1b),OP_ADDR(xycb,0x1c),OP_ADDR(xycb,0x1d),OP_ADDR(xycb,0x1e),OP_ADDR(xycb,0x1f),
+		OP_ADDR(xycb,0x20),OP_ADDR(xycb,0x21),OP_ADDR(xycb,0x22),OP_ADDR(xycb,0x23),OP_ADDR(xycb,0x24),OP_ADDR(xycb,0x25),OP_ADDR(xycb,0x26),OP_ADDR(xycb,0x27),
+		OP_ADDR(xycb,0x28),OP_ADDR(xycb,0x29),OP_ADDR(xycb,0x2a),OP_ADDR(xycb,0x2b),OP_ADDR(xycb,0x2c),OP_ADDR(xycb,0x2d),OP_ADDR(xycb,0x2e),OP_ADDR(xycb,0x2f),
+		OP_ADDR(xycb,0x30),OP_ADDR(xycb,0x31),OP_ADDR(xycb,0x32),OP_ADDR(xycb,0x33),OP_ADDR(xycb,0x34),OP_ADDR(xycb,0x35),OP_ADDR(xycb,0x36),OP_ADDR(xycb,0x37),
+		OP_ADDR(xycb,0x38),OP_ADDR(xycb,0x39),OP_ADDR(xycb,0x3a),OP_ADDR(xycb,0x3b),OP_ADDR(xycb,0x3c),OP_ADDR(xycb,0x3d),OP_ADDR(xycb,0x3e),OP_ADDR(xycb,0x3f),
+		OP_ADDR(xycb,0x40),OP_ADDR(xycb,0x41),OP_ADDR(xycb,0x42),OP_ADDR(xycb,0x43),OP_ADDR(xycb,0x44),OP_ADDR(xycb,0x45),OP_ADDR(xycb,0x46),OP_ADDR(xycb,0x47),
+		OP_ADDR(xycb,0x48),OP_ADDR(xycb,0x49),OP_ADDR(xycb,0x4a),OP_ADDR(xycb,0x4b),OP_ADDR(xycb,0x4c),OP_ADDR(xycb,0x4d),OP_ADDR(xycb,0x4e),OP_ADDR(xycb,0x4f),
+		OP_ADDR(xycb,0x50),OP_ADDR(xycb,0x51),OP_ADDR(xycb,0x52),OP_ADDR(xycb,0x53),OP_ADDR(xycb,0x54),OP_ADDR(xycb,0x55),OP_ADDR(xycb,0x56),OP_ADDR(xycb,0x57),
+		OP_ADDR(xycb,0x58),OP_ADDR(xycb,0x59),OP_ADDR(xycb,0x5a),OP_ADDR(xycb,0x5b),OP_ADDR(xycb,0x5c),OP_ADDR(xycb,0x5d),OP_ADDR(xycb,0x5e),OP_ADDR(xycb,0x5f),
+		OP_ADDR(xycb,0x60),OP_ADDR(xycb,0x61),OP_ADDR(xycb,0x62),OP_ADDR(xycb,0x63),OP_ADDR(xycb,0x64),OP_ADDR(xycb,0x65),OP_ADDR(xycb,0x66),OP_ADDR(xycb,0x67),
+		OP_ADDR(xycb,0x68),OP_ADDR(xycb,0x69),OP_ADDR(xycb,0x6a),OP_ADDR(xycb,0x6b),OP_ADDR(xycb,0x6c),OP_ADDR(xycb,0x6d),OP_ADDR(xycb,0x6e),OP_ADDR(xycb,0x6f),
+		OP_ADDR(xycb,0x70),OP_ADDR(xycb,0x71),OP_ADDR(xycb,0x72),OP_ADDR(xycb,0x73),OP_ADDR(xycb,0x74),OP_ADDR(xycb,0x75),OP_ADDR(xycb,0x76),OP_ADDR(xycb,0x77),
+		OP_ADDR(xycb,0x78),OP_ADDR(xycb,0x79),OP_ADDR(xycb,0x7a),OP_ADDR(xycb,0x7b),OP_ADDR(xycb,0x7c),OP_ADDR(xycb,0x7d),OP_ADDR(xycb,0x7e),OP_ADDR(xycb,0x7f),
+		OP_ADDR(xycb,0x80),OP_ADDR(xycb,0x81),OP_ADDR(xycb,0x82),OP_ADDR(xycb,0x83),OP_ADDR(xycb,0x84),OP_ADDR(xycb,0x85),OP_ADDR(xycb,0x86),OP_ADDR(xycb,0x87),
+		OP_ADDR(xycb,0x88),OP_ADDR(xycb,0x89),OP_ADDR(xycb,0x8a),OP_ADDR(xycb,0x8b),OP_ADDR(xycb,0x8c),OP_ADDR(xycb,0x8d),OP_ADDR(xycb,0x8e),OP_ADDR(xycb,0x8f),
+		OP_ADDR(xycb,0x90),OP_ADDR(xycb,0x91),OP_ADDR(xycb,0x92),OP_ADDR(xycb,0x93),OP_ADDR(xycb,0x94),OP_ADDR(xycb,0x95),OP_ADDR(xycb,0x96),OP_ADDR(xycb,0x97),
+		OP_ADDR(xycb,0x98),OP_ADDR(xycb,0x99),OP_ADDR(xycb,0x9a),OP_ADDR(xycb,0x9b),OP_ADDR(xycb,0x9c),OP_ADDR(xycb,0x9d),OP_ADDR(xycb,0x9e),OP_ADDR(xycb,0x9f),
+		OP_ADDR(xycb,0xa0),OP_ADDR(xycb,0xa1),OP_ADDR(xycb,0xa2),OP_ADDR(xycb,0xa3),OP_ADDR(xycb,0xa4),OP_ADDR(xycb,0xa5),OP_ADDR(xycb,0xa6),OP_ADDR(xycb,0xa7),
+		OP_ADDR(xycb,0xa8),OP_ADDR(xycb,0xa9),OP_ADDR(xycb,0xaa),OP_ADDR(xycb,0xab),OP_ADDR(xycb,0xac),OP_ADDR(xycb,0xad),OP_ADDR(xycb,0xae),OP_ADDR(xycb,0xaf),
+		OP_ADDR(xycb,0xb0),OP_ADDR(xycb,0xb1),OP_ADDR(xycb,0xb2),OP_ADDR(xycb,0xb3),OP_ADDR(xycb,0xb4),OP_ADDR(xycb,0xb5),OP_ADDR(xycb,0xb6),OP_ADDR(xycb,0xb7),
+		OP_ADDR(xycb,0xb8),OP_ADDR(xycb,0xb9),OP_ADDR(xycb,0xba),OP_ADDR(xycb,0xbb),OP_ADDR(xycb,0xbc),OP_ADDR(xycb,0xbd),OP_ADDR(xycb,0xbe),OP_ADDR(xycb,0xbf),
+		OP_ADDR(xycb,0xc0),OP_ADDR(xycb,0xc1),OP_ADDR(xycb,0xc2),OP_ADDR(xycb,0xc3),OP_ADDR(xycb,0xc4),OP_ADDR(xycb,0xc5),OP_ADDR(xycb,0xc6),OP_ADDR(xycb,0xc7),
+		OP_ADDR(xycb,0xc8),OP_ADDR(xycb,0xc9),OP_ADDR(xycb,0xca),OP_ADDR(xycb,0xcb),OP_ADDR(xycb,0xcc),OP_ADDR(xycb,0xcd),OP_ADDR(xycb,0xce),OP_ADDR(xycb,0xcf),
+		OP_ADDR(xycb,0xd0),OP_ADDR(xycb,0xd1),OP_ADDR(xycb,0xd2),OP_ADDR(xycb,0xd3),OP_ADDR(xycb,0xd4),OP_ADDR(xycb,0xd5),OP_ADDR(xycb,0xd6),OP_ADDR(xycb,0xd7),
+		OP_ADDR(xycb,0xd8),OP_ADDR(xycb,0xd9),OP_ADDR(xycb,0xda),OP_ADDR(xycb,0xdb),OP_ADDR(xycb,0xdc),OP_ADDR(xycb,0xdd),OP_ADDR(xycb,0xde),OP_ADDR(xycb,0xdf),
+		OP_ADDR(xycb,0xe0),OP_ADDR(xycb,0xe1),OP_ADDR(xycb,0xe2),OP_ADDR(xycb,0xe3),OP_ADDR(xycb,0xe4),OP_ADDR(xycb,0xe5),OP_ADDR(xycb,0xe6),OP_ADDR(xycb,0xe7),
+		OP_ADDR(xycb,0xe8),OP_ADDR(xycb,0xe9),OP_ADDR(xycb,0xea),OP_ADDR(xycb,0xeb),OP_ADDR(xycb,0xec),OP_ADDR(xycb,0xed),OP_ADDR(xycb,0xee),OP_ADDR(xycb,0xef),
+		OP_ADDR(xycb,0xf0),OP_ADDR(xycb,0xf1),OP_ADDR(xycb,0xf2),OP_ADDR(xycb,0xf3),OP_ADDR(xycb,0xf4),OP_ADDR(xycb,0xf5),OP_ADDR(xycb,0xf6),OP_ADDR(xycb,0xf7),
+		OP_ADDR(xycb,0xf8),OP_ADDR(xycb,0xf9),OP_ADDR(xycb,0xfa),OP_ADDR(xycb,0xfb),OP_ADDR(xycb,0xfc),OP_ADDR(xycb,0xfd),OP_ADDR(xycb,0xfe),OP_ADDR(xycb,0xff)
+	};
+#endif
+
+	z80_cc = z80_dma;
+	z80_dma = 0;
+
+fetch_xx:
+	switch (cpu->irq) {
+	case 0:	/* no interrupt pending */
+		break;
+	case 1:	/* NMI */
+		if (0x76 == machine->mem[PC])
+			PC++;
+		PUSH(cpu, REG_PC);
+		PC = 0x0066;
+		cpu->iff = cpu->iff & 2;	/* reser IFF1, keep IFF2 */
+		change_pc(dPC);
+		cpu->irq = 0;
+		break;
+	case 2:	/* IRQ */
+		if (0 == (cpu->iff & 1))
+			break;
+		if (0x76 == machine->mem[PC])
+			PC++;
+		PUSH(cpu, REG_PC);
+		PC = 0x0038;
+		cpu->iff = 0;			/* reset IFF1 and IFF2 */
+		change_pc(dPC);
+		cpu->irq = 0;
+		break;
+	}
+#if	Z80_JIT
+	if (JIT_PENDING && jit_execute(cpu))
+		goto next_op;
+#endif
+	if (hook)
+		hook_fetch(cpu);
+	op = FETCH_OP(cpu);
+	cpu->r += 1;
+#if	Z80_THREADED
+	if (step) {
+		machine->cycles_step = machine->cycles;
+		machine->cycles = Z80_STEP;
+	}
+#endif
+
+decode_xx:
+	DISPATCH(xx, op) {
+	OP(xx,0x00):	/* NOP			*/
+		{
+			z80_cc += cc_op[0x00];
+		}
+		NEXT_OP;
+
+	OP(xx,0x01):	/* LD	BC,nnnn		*/
+		{
+			z80_cc += cc_op[0x01];
+			BC = RD_ARGW(cpu);
+		}
+		NEXT_OP;
+
+	OP(xx,0x02):	/* LD	(BC),A		*/
+		{
+			z80_cc += cc_op[0x02];
+			WR_MEM(dBC, A);
+		}
+		NEXT_OP;
+
+	OP(xx,0x03):	/* INC	BC		*/
+		{
+			z80_cc += cc_op[0x03];
+			BC++;
+		}
+		NEXT_OP;
+
+	OP(xx,0x04):	/* INC	B		*/
+		{
+			z80_cc += cc_op[0x04];
+			B = INC(cpu, B);
+		}
+		NEXT_OP;
+
+	OP(xx,0x05):	/* DEC	B		*/
 		{
 			z80_cc += cc_op[0x05];
 			B = DEC(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x06:	/* LD	B,nn		*/
+	OP(xx,0x06):	/* LD	B,nn		*/
 		{
 			z80_cc += cc_op[0x06];
 			B = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x07:	/* RLCA			*/
+	OP(xx,0x07):	/* RLCA			*/
 		{
 			z80_cc += cc_op[0x07];
 			A = (A << 1) | (A >> 7);
 			F = (F & (SF | ZF | PF)) | (A & (YF | XF | CF));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x08:	/* EX	AF,AF'		*/
+	OP(xx,0x08):	/* EX	AF,AF'		*/
 		{
 			z80_cc += cc_op[0x08];
+			LF_SYNC();
 			dAF ^= dAF2;
 			dAF2 ^= dAF;
 			dAF ^= dAF2;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x09:	/* ADD	HL,BC		*/
+	OP(xx,0x09):	/* ADD	HL,BC		*/
 		{
 			z80_cc += cc_op[0x09];
 			HL = ADD16(cpu, dHL, dBC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0a:	/* LD	A,(BC)		*/
+	OP(xx,0x0a):	/* LD	A,(BC)		*/
 		{
 			z80_cc += cc_op[0x0a];
 			A = RD_MEM(dBC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0b:	/* DEC	BC		*/
+	OP(xx,0x0b):	/* DEC	BC		*/
 		{
 			z80_cc += cc_op[0x0b];
 			BC--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0c:	/* INC	C		*/
+	OP(xx,0x0c):	/* INC	C		*/
 		{
 			z80_cc += cc_op[0x0c];
 			C = INC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0d:	/* DEC	C		*/
+	OP(xx,0x0d):	/* DEC	C		*/
 		{
 			z80_cc += cc_op[0x0d];
 			C = DEC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0e:	/* LD	C,nn		*/
+	OP(xx,0x0e):	/* LD	C,nn		*/
 		{
 			z80_cc += cc_op[0x0e];
 			C = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0f:	/* RRCA			*/
+	OP(xx,0x0f):	/* RRCA			*/
 		{
 			z80_cc += cc_op[0x0f];
 			F = (F & (SF | ZF | PF)) | (A & CF);
 			A = (A >> 1) | (A << 7);
 			F |= (A & (YF | XF));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x10:	/* DJNZ	rel8		*/
+	OP(xx,0x10):	/* DJNZ	rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x10];
@@ -1506,51 +3950,51 @@ decode_xx:
 				MP = PC;
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0x11:	/* LD	DE,nnnn		*/
+	OP(xx,0x11):	/* LD	DE,nnnn		*/
 		{
 			z80_cc += cc_op[0x11];
 			DE = RD_ARGW(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x12:	/* LD	(DE),A		*/
+	OP(xx,0x12):	/* LD	(DE),A		*/
 		{
 			z80_cc += cc_op[0x12];
 			WR_MEM(dDE, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x13:	/* INC	DE		*/
+	OP(xx,0x13):	/* INC	DE		*/
 		{
 			z80_cc += cc_op[0x13];
 			DE++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x14:	/* INC	D		*/
+	OP(xx,0x14):	/* INC	D		*/
 		{
 			z80_cc += cc_op[0x14];
 			D = INC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x15:	/* DEC	D		*/
+	OP(xx,0x15):	/* DEC	D		*/
 		{
 			z80_cc += cc_op[0x15];
 			D = DEC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x16:	/* LD	D,nn		*/
+	OP(xx,0x16):	/* LD	D,nn		*/
 		{
 			z80_cc += cc_op[0x16];
 			D = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x17:	/* RLA			*/
+	OP(xx,0x17):	/* RLA			*/
 		{
 			uint8_t res = (A << 1) | (F & CF);
 			uint8_t cf = (A & 0x80) ? CF : 0;
@@ -1558,60 +4002,60 @@ decode_xx:
 			A = res;
 			F = (F & (SF | ZF | PF)) | (res & (YF | XF)) | cf;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x18:	/* JR	rel8		*/
+	OP(xx,0x18):	/* JR	rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x18];
 			PC += rel;
 			MP = PC;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x19:	/* ADD	HL,DE		*/
+	OP(xx,0x19):	/* ADD	HL,DE		*/
 		{
 			z80_cc += cc_op[0x19];
 			HL = ADD16(cpu, dHL, dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1a:	/* LD	A,(DE)		*/
+	OP(xx,0x1a):	/* LD	A,(DE)		*/
 		{
 			z80_cc += cc_op[0x1a];
 			A = RD_MEM(dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1b:	/* DEC	DE		*/
+	OP(xx,0x1b):	/* DEC	DE		*/
 		{
 			z80_cc += cc_op[0x1b];
 			DE--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1c:	/* INC	E		*/
+	OP(xx,0x1c):	/* INC	E		*/
 		{
 			z80_cc += cc_op[0x1c];
 			E = INC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1d:	/* DEC	E		*/
+	OP(xx,0x1d):	/* DEC	E		*/
 		{
 			z80_cc += cc_op[0x1d];
 			E = DEC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1e:	/* LD	E,nn		*/
+	OP(xx,0x1e):	/* LD	E,nn		*/
 		{
 			z80_cc += cc_op[0x1e];
 			E = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1f:	/* RRA			*/
+	OP(xx,0x1f):	/* RRA			*/
 		{
 			uint8_t res = (A >> 1) | ((F & CF) << 7);
 			uint8_t cf = (A & 0x01) ? CF : 0;
@@ -1619,9 +4063,9 @@ decode_xx:
 			A = res;
 			F = (F & (SF | ZF | PF)) | (res & (YF | XF)) | cf;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x20:	/* JR	NZ,rel8		*/
+	OP(xx,0x20):	/* JR	NZ,rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x20];
@@ -1631,16 +4075,16 @@ decode_xx:
 				MP = PC;
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0x21:	/* LD	HL,nnnn		*/
+	OP(xx,0x21):	/* LD	HL,nnnn		*/
 		{
 			z80_cc += cc_op[0x21];
 			HL = RD_ARGW(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x22:	/* LD	(nnnn),HL	*/
+	OP(xx,0x22):	/* LD	(nnnn),HL	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0x22];
@@ -1648,37 +4092,37 @@ decode_xx:
 			MP++;
 			WR_MEM(dMP, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x23:	/* INC	HL		*/
+	OP(xx,0x23):	/* INC	HL		*/
 		{
 			z80_cc += cc_op[0x23];
 			HL++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x24:	/* INC	H		*/
+	OP(xx,0x24):	/* INC	H		*/
 		{
 			z80_cc += cc_op[0x24];
 			H = INC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x25:	/* DEC	H		*/
+	OP(xx,0x25):	/* DEC	H		*/
 		{
 			z80_cc += cc_op[0x25];
 			H = DEC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x26:	/* LD	H,nn		*/
+	OP(xx,0x26):	/* LD	H,nn		*/
 		{
 			z80_cc += cc_op[0x26];
 			H = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x27:	/* DAA			*/
+	OP(xx,0x27):	/* DAA			*/
 		{
 			uint8_t cf = F & CF;
 			uint8_t nf = F & NF;
@@ -1712,9 +4156,9 @@ decode_xx:
 			if (nf ? hf && lo <= 5 : lo >= 10)
 				F |= HF;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x28:	/* JR	Z,rel8		*/
+	OP(xx,0x28):	/* JR	Z,rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x28];
@@ -1724,16 +4168,16 @@ decode_xx:
 				MP = PC;
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0x29:	/* ADD	HL,HL		*/
+	OP(xx,0x29):	/* ADD	HL,HL		*/
 		{
 			z80_cc += cc_op[0x29];
 			HL = ADD16(cpu, dHL, dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2a:	/* LD	HL,(nnnn)	*/
+	OP(xx,0x2a):	/* LD	HL,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0x2a];
@@ -1741,46 +4185,46 @@ decode_xx:
 			MP++;
 			H = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2b:	/* DEC	HL		*/
+	OP(xx,0x2b):	/* DEC	HL		*/
 		{
 			z80_cc += cc_op[0x2b];
 			HL--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2c:	/* INC	L		*/
+	OP(xx,0x2c):	/* INC	L		*/
 		{
 			z80_cc += cc_op[0x2c];
 			L = INC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2d:	/* DEC	L		*/
+	OP(xx,0x2d):	/* DEC	L		*/
 		{
 			z80_cc += cc_op[0x2d];
 			L = DEC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2e:	/* LD	L,nn		*/
+	OP(xx,0x2e):	/* LD	L,nn		*/
 		{
 			z80_cc += cc_op[0x2e];
 			L = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2f:	/* CPL			*/
+	OP(xx,0x2f):	/* CPL			*/
 		{
 			z80_cc += cc_op[0x2f];
 			A ^= 0xff;
 			F = (F & (SF | ZF | PF | CF)) |
 				HF | NF | (A & (YF | XF));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x30:	/* JR	NC,rel8		*/
+	OP(xx,0x30):	/* JR	NC,rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x30];
@@ -1790,16 +4234,16 @@ decode_xx:
 				MP = PC;
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0x31:	/* LD	SP,nnnn		*/
+	OP(xx,0x31):	/* LD	SP,nnnn		*/
 		{
 			z80_cc += cc_op[0x31];
 			SP = RD_ARGW(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x32:	/* LD	(nnnn),A	*/
+	OP(xx,0x32):	/* LD	(nnnn),A	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0x32];
@@ -1807,44 +4251,44 @@ decode_xx:
 			MP++;
 			MPH = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x33:	/* INC	SP		*/
+	OP(xx,0x33):	/* INC	SP		*/
 		{
 			z80_cc += cc_op[0x33];
 			SP++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x34:	/* INC	(HL)		*/
+	OP(xx,0x34):	/* INC	(HL)		*/
 		{
 			z80_cc += cc_op[0x34];
 			WR_MEM(dHL, INC(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x35:	/* DEC	(HL)		*/
+	OP(xx,0x35):	/* DEC	(HL)		*/
 		{
 			z80_cc += cc_op[0x35];
 			WR_MEM(dHL, DEC(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x36:	/* LD	(HL),nn		*/
+	OP(xx,0x36):	/* LD	(HL),nn		*/
 		{
 			z80_cc += cc_op[0x36];
 			WR_MEM(dHL, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x37:	/* SCF			*/
+	OP(xx,0x37):	/* SCF			*/
 		{
 			z80_cc += cc_op[0x37];
 			F = (F & (SF | ZF | PF)) | CF | (A & (YF | XF));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x38:	/* JR	C,rel8		*/
+	OP(xx,0x38):	/* JR	C,rel8		*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_op[0x38];
@@ -1854,957 +4298,958 @@ decode_xx:
 				MP = PC;
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0x39:	/* ADD	HL,SP		*/
+	OP(xx,0x39):	/* ADD	HL,SP		*/
 		{
 			z80_cc += cc_op[0x39];
 			HL = ADD16(cpu, dHL, dSP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3a:	/* LD	A,(nnnn)	*/
+	OP(xx,0x3a):	/* LD	A,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0x3a];
 			A = RD_MEM(MP);
 			MP++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3b:	/* DEC	SP		*/
+	OP(xx,0x3b):	/* DEC	SP		*/
 		{
 			z80_cc += cc_op[0x3b];
 			SP--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3c:	/* INC	A		*/
+	OP(xx,0x3c):	/* INC	A		*/
 		{
 			z80_cc += cc_op[0x3c];
 			A = INC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3d:	/* DEC	A		*/
+	OP(xx,0x3d):	/* DEC	A		*/
 		{
 			z80_cc += cc_op[0x3d];
 			A = DEC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3e:	/* LD	A,nn		*/
+	OP(xx,0x3e):	/* LD	A,nn		*/
 		{
 			z80_cc += cc_op[0x3e];
 			A = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3f:	/* CCF			*/
+	OP(xx,0x3f):	/* CCF			*/
 		{
 			z80_cc += cc_op[0x3f];
 			F = ((F & ( SF | ZF | PF | CF)) |
 				((F & CF) << 4) | (A & (YF | XF))) ^ CF;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x40:	/* LD	B,B		*/
+	OP(xx,0x40):	/* LD	B,B		*/
 		{
 			z80_cc += cc_op[0x40];
 			B = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x41:	/* LD	B,C		*/
+	OP(xx,0x41):	/* LD	B,C		*/
 		{
 			z80_cc += cc_op[0x41];
 			B = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x42:	/* LD	B,D		*/
+	OP(xx,0x42):	/* LD	B,D		*/
 		{
 			z80_cc += cc_op[0x42];
 			B = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x43:	/* LD	B,E		*/
+	OP(xx,0x43):	/* LD	B,E		*/
 		{
 			z80_cc += cc_op[0x43];
 			B = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x44:	/* LD	B,H		*/
+	OP(xx,0x44):	/* LD	B,H		*/
 		{
 			z80_cc += cc_op[0x44];
 			B = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x45:	/* LD	B,L		*/
+	OP(xx,0x45):	/* LD	B,L		*/
 		{
 			z80_cc += cc_op[0x45];
 			B = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x46:	/* LD	B,(HL)		*/
+	OP(xx,0x46):	/* LD	B,(HL)		*/
 		{
 			z80_cc += cc_op[0x46];
 			B = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x47:	/* LD	B,A		*/
+	OP(xx,0x47):	/* LD	B,A		*/
 		{
 			z80_cc += cc_op[0x47];
 			B = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x48:	/* LD	C,B		*/
+	OP(xx,0x48):	/* LD	C,B		*/
 		{
 			z80_cc += cc_op[0x48];
 			C = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x49:	/* LD	C,C		*/
+	OP(xx,0x49):	/* LD	C,C		*/
 		{
 			z80_cc += cc_op[0x49];
 			C = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4a:	/* LD	C,D		*/
+	OP(xx,0x4a):	/* LD	C,D		*/
 		{
 			z80_cc += cc_op[0x4a];
 			C = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4b:	/* LD	C,E		*/
+	OP(xx,0x4b):	/* LD	C,E		*/
 		{
 			z80_cc += cc_op[0x4b];
 			C = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4c:	/* LD	C,H		*/
+	OP(xx,0x4c):	/* LD	C,H		*/
 		{
 			z80_cc += cc_op[0x4c];
 			C = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4d:	/* LD	C,L		*/
+	OP(xx,0x4d):	/* LD	C,L		*/
 		{
 			z80_cc += cc_op[0x4d];
 			C = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4e:	/* LD	C,(HL)		*/
+	OP(xx,0x4e):	/* LD	C,(HL)		*/
 		{
 			z80_cc += cc_op[0x4e];
 			C = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4f:	/* LD	C,A		*/
+	OP(xx,0x4f):	/* LD	C,A		*/
 		{
 			z80_cc += cc_op[0x4f];
 			C = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x50:	/* LD	D,B		*/
+	OP(xx,0x50):	/* LD	D,B		*/
 		{
 			z80_cc += cc_op[0x50];
 			D = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x51:	/* LD	D,C		*/
+	OP(xx,0x51):	/* LD	D,C		*/
 		{
 			z80_cc += cc_op[0x51];
 			D = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x52:	/* LD	D,D		*/
+	OP(xx,0x52):	/* LD	D,D		*/
 		{
 			z80_cc += cc_op[0x52];
 			D = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x53:	/* LD	D,E		*/
+	OP(xx,0x53):	/* LD	D,E		*/
 		{
 			z80_cc += cc_op[0x53];
 			D = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x54:	/* LD	D,H		*/
+	OP(xx,0x54):	/* LD	D,H		*/
 		{
 			z80_cc += cc_op[0x54];
 			D = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x55:	/* LD	D,L		*/
+	OP(xx,0x55):	/* LD	D,L		*/
 		{
 			z80_cc += cc_op[0x55];
 			D = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x56:	/* LD	D,(HL)		*/
+	OP(xx,0x56):	/* LD	D,(HL)		*/
 		{
 			z80_cc += cc_op[0x56];
 			D = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x57:	/* LD	D,A		*/
+	OP(xx,0x57):	/* LD	D,A		*/
 		{
 			z80_cc += cc_op[0x57];
 			D = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x58:	/* LD	E,B		*/
+	OP(xx,0x58):	/* LD	E,B		*/
 		{
 			z80_cc += cc_op[0x58];
 			E = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x59:	/* LD	E,C		*/
+	OP(xx,0x59):	/* LD	E,C		*/
 		{
 			z80_cc += cc_op[0x59];
 			E = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5a:	/* LD	E,D		*/
+	OP(xx,0x5a):	/* LD	E,D		*/
 		{
 			z80_cc += cc_op[0x5a];
 			E = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5b:	/* LD	E,E		*/
+	OP(xx,0x5b):	/* LD	E,E		*/
 		{
 			z80_cc += cc_op[0x5b];
 			E = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5c:	/* LD	E,H		*/
+	OP(xx,0x5c):	/* LD	E,H		*/
 		{
 			z80_cc += cc_op[0x5c];
 			E = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5d:	/* LD	E,L		*/
+	OP(xx,0x5d):	/* LD	E,L		*/
 		{
 			z80_cc += cc_op[0x5d];
 			E = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5e:	/* LD	E,(HL)		*/
+	OP(xx,0x5e):	/* LD	E,(HL)		*/
 		{
 			z80_cc += cc_op[0x5e];
 			E = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5f:	/* LD	E,A		*/
+	OP(xx,0x5f):	/* LD	E,A		*/
 		{
 			z80_cc += cc_op[0x5f];
 			E = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* LD	H,B		*/
+	OP(xx,0x60):	/* LD	H,B		*/
 		{
 			z80_cc += cc_op[0x60];
 			H = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x61:	/* LD	H,C		*/
+	OP(xx,0x61):	/* LD	H,C		*/
 		{
 			z80_cc += cc_op[0x61];
 			H = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x62:	/* LD	H,D		*/
+	OP(xx,0x62):	/* LD	H,D		*/
 		{
 			z80_cc += cc_op[0x62];
 			H = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x63:	/* LD	H,E		*/
+	OP(xx,0x63):	/* LD	H,E		*/
 		{
 			z80_cc += cc_op[0x63];
 			H = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x64:	/* LD	H,H		*/
+	OP(xx,0x64):	/* LD	H,H		*/
 		{
 			z80_cc += cc_op[0x64];
 			H = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x65:	/* LD	H,L		*/
+	OP(xx,0x65):	/* LD	H,L		*/
 		{
 			z80_cc += cc_op[0x65];
 			H = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x66:	/* LD	H,(HL)		*/
+	OP(xx,0x66):	/* LD	H,(HL)		*/
 		{
 			z80_cc += cc_op[0x66];
 			H = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x67:	/* LD	H,A		*/
+	OP(xx,0x67):	/* LD	H,A		*/
 		{
 			z80_cc += cc_op[0x67];
 			H = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* LD	L,B		*/
+	OP(xx,0x68):	/* LD	L,B		*/
 		{
 			z80_cc += cc_op[0x68];
 			L = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x69:	/* LD	L,C		*/
+	OP(xx,0x69):	/* LD	L,C		*/
 		{
 			z80_cc += cc_op[0x69];
 			L = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6a:	/* LD	L,D		*/
+	OP(xx,0x6a):	/* LD	L,D		*/
 		{
 			z80_cc += cc_op[0x6a];
 			L = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6b:	/* LD	L,E		*/
+	OP(xx,0x6b):	/* LD	L,E		*/
 		{
 			z80_cc += cc_op[0x6b];
 			L = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6c:	/* LD	L,H		*/
+	OP(xx,0x6c):	/* LD	L,H		*/
 		{
 			z80_cc += cc_op[0x6c];
 			L = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6d:	/* LD	L,L		*/
+	OP(xx,0x6d):	/* LD	L,L		*/
 		{
 			z80_cc += cc_op[0x6d];
 			L = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6e:	/* LD	L,(HL)		*/
+	OP(xx,0x6e):	/* LD	L,(HL)		*/
 		{
 			z80_cc += cc_op[0x6e];
 			L = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6f:	/* LD	L,A		*/
+	OP(xx,0x6f):	/* LD	L,A		*/
 		{
 			z80_cc += cc_op[0x6f];
 			L = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* LD	(HL),B		*/
+	OP(xx,0x70):	/* LD	(HL),B		*/
 		{
 			z80_cc += cc_op[0x70];
 			WR_MEM(dHL, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x71:	/* LD	(HL),C		*/
+	OP(xx,0x71):	/* LD	(HL),C		*/
 		{
 			z80_cc += cc_op[0x71];
 			WR_MEM(dHL, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x72:	/* LD	(HL),D		*/
+	OP(xx,0x72):	/* LD	(HL),D		*/
 		{
 			z80_cc += cc_op[0x72];
 			WR_MEM(dHL, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x73:	/* LD	(HL),E		*/
+	OP(xx,0x73):	/* LD	(HL),E		*/
 		{
 			z80_cc += cc_op[0x73];
 			WR_MEM(dHL, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x74:	/* LD	(HL),H		*/
+	OP(xx,0x74):	/* LD	(HL),H		*/
 		{
 			z80_cc += cc_op[0x74];
 			WR_MEM(dHL, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x75:	/* LD	(HL),L		*/
+	OP(xx,0x75):	/* LD	(HL),L		*/
 		{
 			z80_cc += cc_op[0x75];
 			WR_MEM(dHL, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x76:	/* HALT			*/
+	OP(xx,0x76):	/* HALT			*/
 		{
 			z80_cc += cc_op[0x76];
 			PC--;
+			HALT(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x77:	/* LD	(HL),A		*/
+	OP(xx,0x77):	/* LD	(HL),A		*/
 		{
 			z80_cc += cc_op[0x77];
 			WR_MEM(dHL, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x78:	/* LD	A,B		*/
+	OP(xx,0x78):	/* LD	A,B		*/
 		{
 			z80_cc += cc_op[0x78];
 			A = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x79:	/* LD	A,C		*/
+	OP(xx,0x79):	/* LD	A,C		*/
 		{
 			z80_cc += cc_op[0x79];
 			A = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7a:	/* LD	A,D		*/
+	OP(xx,0x7a):	/* LD	A,D		*/
 		{
 			z80_cc += cc_op[0x7a];
 			A = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7b:	/* LD	A,E		*/
+	OP(xx,0x7b):	/* LD	A,E		*/
 		{
 			z80_cc += cc_op[0x7b];
 			A = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7c:	/* LD	A,H		*/
+	OP(xx,0x7c):	/* LD	A,H		*/
 		{
 			z80_cc += cc_op[0x7c];
 			A = H;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7d:	/* LD	A,L		*/
+	OP(xx,0x7d):	/* LD	A,L		*/
 		{
 			z80_cc += cc_op[0x7d];
 			A = L;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7e:	/* LD	A,(HL)		*/
+	OP(xx,0x7e):	/* LD	A,(HL)		*/
 		{
 			z80_cc += cc_op[0x7e];
 			A = RD_MEM(dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7f:	/* LD	A,A		*/
+	OP(xx,0x7f):	/* LD	A,A		*/
 		{
 			z80_cc += cc_op[0x7f];
 			A = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x80:	/* ADD	A,B		*/
+	OP(xx,0x80):	/* ADD	A,B		*/
 		{
 			z80_cc += cc_op[0x80];
 			A = ADD(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x81:	/* ADD	A,C		*/
+	OP(xx,0x81):	/* ADD	A,C		*/
 		{
 			z80_cc += cc_op[0x81];
 			A = ADD(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x82:	/* ADD	A,D		*/
+	OP(xx,0x82):	/* ADD	A,D		*/
 		{
 			z80_cc += cc_op[0x82];
 			A = ADD(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x83:	/* ADD	A,E		*/
+	OP(xx,0x83):	/* ADD	A,E		*/
 		{
 			z80_cc += cc_op[0x83];
 			A = ADD(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x84:	/* ADD	A,H		*/
+	OP(xx,0x84):	/* ADD	A,H		*/
 		{
 			z80_cc += cc_op[0x84];
 			A = ADD(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x85:	/* ADD	A,L		*/
+	OP(xx,0x85):	/* ADD	A,L		*/
 		{
 			z80_cc += cc_op[0x85];
 			A = ADD(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x86:	/* ADD	A,(HL)		*/
+	OP(xx,0x86):	/* ADD	A,(HL)		*/
 		{
 			z80_cc += cc_op[0x86];
 			A = ADD(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x87:	/* ADD	A,A		*/
+	OP(xx,0x87):	/* ADD	A,A		*/
 		{
 			z80_cc += cc_op[0x87];
 			A = ADD(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x88:	/* ADC	A,B		*/
+	OP(xx,0x88):	/* ADC	A,B		*/
 		{
 			z80_cc += cc_op[0x88];
 			A = ADC(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x89:	/* ADC	A,C		*/
+	OP(xx,0x89):	/* ADC	A,C		*/
 		{
 			z80_cc += cc_op[0x89];
 			A = ADC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8a:	/* ADC	A,D		*/
+	OP(xx,0x8a):	/* ADC	A,D		*/
 		{
 			z80_cc += cc_op[0x8a];
 			A = ADC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8b:	/* ADC	A,E		*/
+	OP(xx,0x8b):	/* ADC	A,E		*/
 		{
 			z80_cc += cc_op[0x8b];
 			A = ADC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8c:	/* ADC	A,H		*/
+	OP(xx,0x8c):	/* ADC	A,H		*/
 		{
 			z80_cc += cc_op[0x8c];
 			A = ADC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8d:	/* ADC	A,L		*/
+	OP(xx,0x8d):	/* ADC	A,L		*/
 		{
 			z80_cc += cc_op[0x8d];
 			A = ADC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8e:	/* ADC	A,(HL)		*/
+	OP(xx,0x8e):	/* ADC	A,(HL)		*/
 		{
 			z80_cc += cc_op[0x8e];
 			A = ADC(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8f:	/* ADC	A,A		*/
+	OP(xx,0x8f):	/* ADC	A,A		*/
 		{
 			z80_cc += cc_op[0x8f];
 			A = ADC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x90:	/* SUB	B		*/
+	OP(xx,0x90):	/* SUB	B		*/
 		{
 			z80_cc += cc_op[0x90];
 			A = SUB(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x91:	/* SUB	C		*/
+	OP(xx,0x91):	/* SUB	C		*/
 		{
 			z80_cc += cc_op[0x91];
 			A = SUB(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x92:	/* SUB	D		*/
+	OP(xx,0x92):	/* SUB	D		*/
 		{
 			z80_cc += cc_op[0x92];
 			A = SUB(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x93:	/* SUB	E		*/
+	OP(xx,0x93):	/* SUB	E		*/
 		{
 			z80_cc += cc_op[0x93];
 			A = SUB(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x94:	/* SUB	H		*/
+	OP(xx,0x94):	/* SUB	H		*/
 		{
 			z80_cc += cc_op[0x94];
 			A = SUB(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x95:	/* SUB	L		*/
+	OP(xx,0x95):	/* SUB	L		*/
 		{
 			z80_cc += cc_op[0x95];
 			A = SUB(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x96:	/* SUB	(HL)		*/
+	OP(xx,0x96):	/* SUB	(HL)		*/
 		{
 			z80_cc += cc_op[0x96];
 			A = SUB(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x97:	/* SUB	A		*/
+	OP(xx,0x97):	/* SUB	A		*/
 		{
 			z80_cc += cc_op[0x97];
 			A = SUB(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x98:	/* SBC	A,B		*/
+	OP(xx,0x98):	/* SBC	A,B		*/
 		{
 			z80_cc += cc_op[0x98];
 			A = SBC(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x99:	/* SBC	A,C		*/
+	OP(xx,0x99):	/* SBC	A,C		*/
 		{
 			z80_cc += cc_op[0x99];
 			A = SBC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9a:	/* SBC	A,D		*/
+	OP(xx,0x9a):	/* SBC	A,D		*/
 		{
 			z80_cc += cc_op[0x9a];
 			A = SBC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9b:	/* SBC	A,E		*/
+	OP(xx,0x9b):	/* SBC	A,E		*/
 		{
 			z80_cc += cc_op[0x9b];
 			A = SBC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9c:	/* SBC	A,H		*/
+	OP(xx,0x9c):	/* SBC	A,H		*/
 		{
 			z80_cc += cc_op[0x9c];
 			A = SBC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9d:	/* SBC	A,L		*/
+	OP(xx,0x9d):	/* SBC	A,L		*/
 		{
 			z80_cc += cc_op[0x9d];
 			A = SBC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9e:	/* SBC	A,(HL)		*/
+	OP(xx,0x9e):	/* SBC	A,(HL)		*/
 		{
 			z80_cc += cc_op[0x9e];
 			A = SBC(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9f:	/* SBC	A,A		*/
+	OP(xx,0x9f):	/* SBC	A,A		*/
 		{
 			z80_cc += cc_op[0x9f];
 			A = SBC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa0:	/* AND	B		*/
+	OP(xx,0xa0):	/* AND	B		*/
 		{
 			z80_cc += cc_op[0xa0];
 			A = AND(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa1:	/* AND	C		*/
+	OP(xx,0xa1):	/* AND	C		*/
 		{
 			z80_cc += cc_op[0xa1];
 			A = AND(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa2:	/* AND	D		*/
+	OP(xx,0xa2):	/* AND	D		*/
 		{
 			z80_cc += cc_op[0xa2];
 			A = AND(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa3:	/* AND	E		*/
+	OP(xx,0xa3):	/* AND	E		*/
 		{
 			z80_cc += cc_op[0xa3];
 			A = AND(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa4:	/* AND	H		*/
+	OP(xx,0xa4):	/* AND	H		*/
 		{
 			z80_cc += cc_op[0xa4];
 			A = AND(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa5:	/* AND	L		*/
+	OP(xx,0xa5):	/* AND	L		*/
 		{
 			z80_cc += cc_op[0xa5];
 			A = AND(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa6:	/* AND	(HL)		*/
+	OP(xx,0xa6):	/* AND	(HL)		*/
 		{
 			z80_cc += cc_op[0xa6];
 			A = AND(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa7:	/* AND	A		*/
+	OP(xx,0xa7):	/* AND	A		*/
 		{
 			z80_cc += cc_op[0xa7];
 			A = AND(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa8:	/* XOR	B		*/
+	OP(xx,0xa8):	/* XOR	B		*/
 		{
 			z80_cc += cc_op[0xa8];
 			A = XOR(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa9:	/* XOR	C		*/
+	OP(xx,0xa9):	/* XOR	C		*/
 		{
 			z80_cc += cc_op[0xa9];
 			A = XOR(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaa:	/* XOR	D		*/
+	OP(xx,0xaa):	/* XOR	D		*/
 		{
 			z80_cc += cc_op[0xaa];
 			A = XOR(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xab:	/* XOR	E		*/
+	OP(xx,0xab):	/* XOR	E		*/
 		{
 			z80_cc += cc_op[0xab];
 			A = XOR(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xac:	/* XOR	H		*/
+	OP(xx,0xac):	/* XOR	H		*/
 		{
 			z80_cc += cc_op[0xac];
 			A = XOR(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xad:	/* XOR	L		*/
+	OP(xx,0xad):	/* XOR	L		*/
 		{
 			z80_cc += cc_op[0xad];
 			A = XOR(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xae:	/* XOR	(HL)		*/
+	OP(xx,0xae):	/* XOR	(HL)		*/
 		{
 			z80_cc += cc_op[0xae];
 			A = XOR(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaf:	/* XOR	A		*/
+	OP(xx,0xaf):	/* XOR	A		*/
 		{
 			z80_cc += cc_op[0xaf];
 			A = XOR(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb0:	/* OR	B		*/
+	OP(xx,0xb0):	/* OR	B		*/
 		{
 			z80_cc += cc_op[0xb0];
 			A = OR(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb1:	/* OR	C		*/
+	OP(xx,0xb1):	/* OR	C		*/
 		{
 			z80_cc += cc_op[0xb1];
 			A = OR(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb2:	/* OR	D		*/
+	OP(xx,0xb2):	/* OR	D		*/
 		{
 			z80_cc += cc_op[0xb2];
 			A = OR(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb3:	/* OR	E		*/
+	OP(xx,0xb3):	/* OR	E		*/
 		{
 			z80_cc += cc_op[0xb3];
 			A = OR(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb4:	/* OR	H		*/
+	OP(xx,0xb4):	/* OR	H		*/
 		{
 			z80_cc += cc_op[0xb4];
 			A = OR(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb5:	/* OR	L		*/
+	OP(xx,0xb5):	/* OR	L		*/
 		{
 			z80_cc += cc_op[0xb5];
 			A = OR(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb6:	/* OR	(HL)		*/
+	OP(xx,0xb6):	/* OR	(HL)		*/
 		{
 			z80_cc += cc_op[0xb6];
 			A = OR(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb7:	/* OR	A		*/
+	OP(xx,0xb7):	/* OR	A		*/
 		{
 			z80_cc += cc_op[0xb7];
 			A = OR(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb8:	/* CP	B		*/
+	OP(xx,0xb8):	/* CP	B		*/
 		{
 			z80_cc += cc_op[0xb8];
 			CP(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb9:	/* CP	C		*/
+	OP(xx,0xb9):	/* CP	C		*/
 		{
 			z80_cc += cc_op[0xb9];
 			CP(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xba:	/* CP	D		*/
+	OP(xx,0xba):	/* CP	D		*/
 		{
 			z80_cc += cc_op[0xba];
 			CP(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbb:	/* CP	E		*/
+	OP(xx,0xbb):	/* CP	E		*/
 		{
 			z80_cc += cc_op[0xbb];
 			CP(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbc:	/* CP	H		*/
+	OP(xx,0xbc):	/* CP	H		*/
 		{
 			z80_cc += cc_op[0xbc];
 			CP(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbd:	/* CP	L		*/
+	OP(xx,0xbd):	/* CP	L		*/
 		{
 			z80_cc += cc_op[0xbd];
 			CP(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbe:	/* CP	(HL)		*/
+	OP(xx,0xbe):	/* CP	(HL)		*/
 		{
 			z80_cc += cc_op[0xbe];
 			CP(cpu, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbf:	/* CP	A		*/
+	OP(xx,0xbf):	/* CP	A		*/
 		{
 			z80_cc += cc_op[0xbf];
 			CP(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc0:	/* RET	NZ		*/
+	OP(xx,0xc0):	/* RET	NZ		*/
 		{
 			z80_cc += cc_op[0xc0];
 			if (0 == (F & ZF)) {
@@ -2813,16 +5258,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc1:	/* POP	BC		*/
+	OP(xx,0xc1):	/* POP	BC		*/
 		{
 			z80_cc += cc_op[0xc1];
 			POP(cpu, REG_BC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc2:	/* JP	NZ,nnnn		*/
+	OP(xx,0xc2):	/* JP	NZ,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xc2];
@@ -2831,18 +5276,18 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc3:	/* JP	nnnn		*/
+	OP(xx,0xc3):	/* JP	nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xc3];
 			PC = MP;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc4:	/* CALL	NZ,nnnn		*/
+	OP(xx,0xc4):	/* CALL	NZ,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xc4];
@@ -2853,32 +5298,32 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc5:	/* PUSH	BC		*/
+	OP(xx,0xc5):	/* PUSH	BC		*/
 		{
 			z80_cc += cc_op[0xc5];
 			PUSH(cpu, REG_BC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc6:	/* ADD	A,nn		*/
+	OP(xx,0xc6):	/* ADD	A,nn		*/
 		{
 			z80_cc += cc_op[0xc6];
 			A = ADD(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc7:	/* RST	00H		*/
+	OP(xx,0xc7):	/* RST	00H		*/
 		{
 			z80_cc += cc_op[0xc7];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x00;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc8:	/* RET	Z		*/
+	OP(xx,0xc8):	/* RET	Z		*/
 		{
 			z80_cc += cc_op[0xc8];
 			if (0 != (F & ZF)) {
@@ -2887,17 +5332,17 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc9:	/* RET			*/
+	OP(xx,0xc9):	/* RET			*/
 		{
 			z80_cc += cc_op[0xc9];
 			POP(cpu, REG_PC);
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xca:	/* JP	Z,nnnn		*/
+	OP(xx,0xca):	/* JP	Z,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xca];
@@ -2906,16 +5351,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcb:	/* prefix CB xx 	*/
+	OP(xx,0xcb):	/* prefix CB xx 	*/
 		{
 			z80_cc += cc_op[0xcb];
 			goto fetch_cb_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcc:	/* CALL	Z,nnnn		*/
+	OP(xx,0xcc):	/* CALL	Z,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xcc];
@@ -2926,9 +5371,9 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcd:	/* CALL	nnnn		*/
+	OP(xx,0xcd):	/* CALL	nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xcd];
@@ -2936,25 +5381,25 @@ decode_xx:
 			PC = MP;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xce:	/* ADC	A,nn		*/
+	OP(xx,0xce):	/* ADC	A,nn		*/
 		{
 			z80_cc += cc_op[0xce];
 			A = ADC(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcf:	/* RST	08H		*/
+	OP(xx,0xcf):	/* RST	08H		*/
 		{
 			z80_cc += cc_op[0xcf];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x08;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd0:	/* RET	NC		*/
+	OP(xx,0xd0):	/* RET	NC		*/
 		{
 			z80_cc += cc_op[0xd0];
 			if (0 == (F & CF)) {
@@ -2963,16 +5408,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd1:	/* POP	DE		*/
+	OP(xx,0xd1):	/* POP	DE		*/
 		{
 			z80_cc += cc_op[0xd1];
 			POP(cpu, REG_DE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd2:	/* JP	NC,nnnn		*/
+	OP(xx,0xd2):	/* JP	NC,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xd2];
@@ -2981,9 +5426,9 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd3:	/* OUT	(nn),A		*/
+	OP(xx,0xd3):	/* OUT	(nn),A		*/
 		{
 			MP = RD_ARGB(cpu);
 			z80_cc += cc_op[0xd3];
@@ -2992,9 +5437,9 @@ decode_xx:
 			MP++;
 			MPH = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd4:	/* CALL	NC,nnnn		*/
+	OP(xx,0xd4):	/* CALL	NC,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xd4];
@@ -3005,32 +5450,32 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd5:	/* PUSH	DE		*/
+	OP(xx,0xd5):	/* PUSH	DE		*/
 		{
 			z80_cc += cc_op[0xd5];
 			PUSH(cpu, REG_DE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd6:	/* SUB	nn		*/
+	OP(xx,0xd6):	/* SUB	nn		*/
 		{
 			z80_cc += cc_op[0xd6];
 			A = SUB(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd7:	/* RST	10H		*/
+	OP(xx,0xd7):	/* RST	10H		*/
 		{
 			z80_cc += cc_op[0xd7];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x10;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd8:	/* RET	C		*/
+	OP(xx,0xd8):	/* RET	C		*/
 		{
 			z80_cc += cc_op[0xd8];
 			if (0 != (F & CF)) {
@@ -3039,18 +5484,18 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd9:	/* EXX			*/
+	OP(xx,0xd9):	/* EXX			*/
 		{
 			z80_cc += cc_op[0xd9];
 			dBC2 ^= dBC; dBC ^= dBC2; dBC2 ^= dBC;
 			dDE2 ^= dDE; dDE ^= dDE2; dDE2 ^= dDE;
 			dHL2 ^= dHL; dHL ^= dHL2; dHL2 ^= dHL;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xda:	/* JP	C,nnnn		*/
+	OP(xx,0xda):	/* JP	C,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xda];
@@ -3059,9 +5504,9 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdb:	/* IN	A,(nn)		*/
+	OP(xx,0xdb):	/* IN	A,(nn)		*/
 		{
 			MP = RD_ARGB(cpu);
 			z80_cc += cc_op[0xdb];
@@ -3069,9 +5514,9 @@ decode_xx:
 			A = RD_IO(dMP);
 			MP++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdc:	/* CALL	C,nnnn		*/
+	OP(xx,0xdc):	/* CALL	C,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xdc];
@@ -3082,32 +5527,32 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdd:	/* prefix DD xx (IX)	*/
+	OP(xx,0xdd):	/* prefix DD xx (IX)	*/
 		{
 			z80_cc += cc_op[0xdd];
 			goto fetch_dd_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xde:	/* SBC	A,nn		*/
+	OP(xx,0xde):	/* SBC	A,nn		*/
 		{
 			z80_cc += cc_op[0xde];
 			A = SBC(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdf:	/* RST	18H		*/
+	OP(xx,0xdf):	/* RST	18H		*/
 		{
 			z80_cc += cc_op[0xdf];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x18;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe0:	/* RET	PO		*/
+	OP(xx,0xe0):	/* RET	PO		*/
 		{
 			z80_cc += cc_op[0xe0];
 			if (0 == (F & PF)) {
@@ -3116,16 +5561,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe1:	/* POP	HL		*/
+	OP(xx,0xe1):	/* POP	HL		*/
 		{
 			z80_cc += cc_op[0xe1];
 			POP(cpu, REG_HL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe2:	/* JP	PO,nnnn		*/
+	OP(xx,0xe2):	/* JP	PO,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xe2];
@@ -3134,9 +5579,9 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe3:	/* EX	(SP),HL		*/
+	OP(xx,0xe3):	/* EX	(SP),HL		*/
 		{
 			z80_cc += cc_op[0xe3];
 			MPL = RD_MEM(dSP);
@@ -3148,9 +5593,9 @@ decode_xx:
 			SP--;
 			H = MPH;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe4:	/* CALL	PO,nnnn		*/
+	OP(xx,0xe4):	/* CALL	PO,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xe4];
@@ -3161,33 +5606,33 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe5:	/* PUSH	HL		*/
+	OP(xx,0xe5):	/* PUSH	HL		*/
 		{
 			z80_cc += cc_op[0xe5];
 			PUSH(cpu, REG_HL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe6:	/* AND	nn		*/
+	OP(xx,0xe6):	/* AND	nn		*/
 		{
 			z80_cc += cc_op[0xe6];
 			A = AND(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
 
-	case 0xe7:	/* RST	20H		*/
+	OP(xx,0xe7):	/* RST	20H		*/
 		{
 			z80_cc += cc_op[0xe7];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x20;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe8:	/* RET	PE		*/
+	OP(xx,0xe8):	/* RET	PE		*/
 		{
 			z80_cc += cc_op[0xe8];
 			if (0 != (F & PF)) {
@@ -3196,17 +5641,17 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe9:	/* JP	(HL)		*/
+	OP(xx,0xe9):	/* JP	(HL)		*/
 		{
 			z80_cc += cc_op[0xe9];
 			PC = HL;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xea:	/* JP	PE,nnnn		*/
+	OP(xx,0xea):	/* JP	PE,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xea];
@@ -3215,18 +5660,18 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xeb:	/* EX	DE,HL		*/
+	OP(xx,0xeb):	/* EX	DE,HL		*/
 		{
 			uint16_t tmp = DE;
 			z80_cc += cc_op[0xeb];
 			DE = HL;
 			HL = tmp;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xec:	/* CALL	PE,nnnn		*/
+	OP(xx,0xec):	/* CALL	PE,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xec];
@@ -3237,32 +5682,32 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xed:	/* prefix ED xx		*/
+	OP(xx,0xed):	/* prefix ED xx		*/
 		{
 			z80_cc += cc_op[0xed];
 			goto fetch_ed_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xee:	/* XOR	nn		*/
+	OP(xx,0xee):	/* XOR	nn		*/
 		{
 			z80_cc += cc_op[0xee];
 			A = XOR(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xef:	/* RST	28H		*/
+	OP(xx,0xef):	/* RST	28H		*/
 		{
 			z80_cc += cc_op[0xef];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x28;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf0:	/* RET	P		*/
+	OP(xx,0xf0):	/* RET	P		*/
 		{
 			z80_cc += cc_op[0xf0];
 			if (0 == (F & SF)) {
@@ -3271,16 +5716,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf1:	/* POP	AF		*/
+	OP(xx,0xf1):	/* POP	AF		*/
 		{
 			z80_cc += cc_op[0xf1];
 			POP(cpu, REG_AF);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf2:	/* JP	P,nnnn		*/
+	OP(xx,0xf2):	/* JP	P,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xf2];
@@ -3289,16 +5734,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf3:	/* DI			*/
+	OP(xx,0xf3):	/* DI			*/
 		{
 			z80_cc += cc_op[0xf3];
 			cpu->iff = 0;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf4:	/* CALL	P,nnnn		*/
+	OP(xx,0xf4):	/* CALL	P,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xf4];
@@ -3309,32 +5754,32 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf5:	/* PUSH	AF		*/
+	OP(xx,0xf5):	/* PUSH	AF		*/
 		{
 			z80_cc += cc_op[0xf5];
 			PUSH(cpu, REG_AF);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf6:	/* OR	nn		*/
+	OP(xx,0xf6):	/* OR	nn		*/
 		{
 			z80_cc += cc_op[0xf6];
 			A = OR(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf7:	/* RST	30H		*/
+	OP(xx,0xf7):	/* RST	30H		*/
 		{
 			z80_cc += cc_op[0xf7];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x30;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf8:	/* RET	M		*/
+	OP(xx,0xf8):	/* RET	M		*/
 		{
 			z80_cc += cc_op[0xf8];
 			if (0 != (F & SF)) {
@@ -3343,16 +5788,16 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf9:	/* LD	SP,HL */
+	OP(xx,0xf9):	/* LD	SP,HL */
 		{
 			z80_cc += cc_op[0xf9];
 			SP = HL;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfa:	/* JP	M,nnnn		*/
+	OP(xx,0xfa):	/* JP	M,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xfa];
@@ -3361,16 +5806,19 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfb:	/* EI			*/
+	OP(xx,0xfb):	/* EI			*/
 		{
 			z80_cc += cc_op[0xfb];
 			cpu->iff = 3;
+			/* a masked interrupt request may be taken now */
+			if (0 != cpu->irq)
+				machine->cycles = z80_cc;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfc:	/* CALL	M,nnnn		*/
+	OP(xx,0xfc):	/* CALL	M,nnnn		*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_op[0xfc];
@@ -3381,2016 +5829,2020 @@ decode_xx:
 				change_pc(dPC);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfd:	/* prefix FD xx (IY)	*/
+	OP(xx,0xfd):	/* prefix FD xx (IY)	*/
 		{
 			z80_cc += cc_op[0xfd];
 			goto fetch_fd_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfe:	/* CP	nn		*/
+	OP(xx,0xfe):	/* CP	nn		*/
 		{
 			z80_cc += cc_op[0xfe];
 			CP(cpu, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xff:	/* RST	38H		*/
+	OP(xx,0xff):	/* RST	38H		*/
 		{
 			z80_cc += cc_op[0xff];
 			PUSH(cpu, REG_PC);
 			MP = PC = 0x38;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 	}
-	if (z80_cc < cycles)
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 
 fetch_cb_xx:
 	op = RD_OP(cpu);
-	switch (op) {
-	case 0x00:	/* RLC	B		*/
+	DISPATCH(cb, op) {
+	OP(cb,0x00):	/* RLC	B		*/
 		{
 			z80_cc += cc_cb[0x00];
 			B = RLC(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x01:	/* RLC	C		*/
+	OP(cb,0x01):	/* RLC	C		*/
 		{
 			z80_cc += cc_cb[0x01];
 			C = RLC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x02:	/* RLC	D		*/
+	OP(cb,0x02):	/* RLC	D		*/
 		{
 			z80_cc += cc_cb[0x02];
 			D = RLC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x03:	/* RLC	E		*/
+	OP(cb,0x03):	/* RLC	E		*/
 		{
 			z80_cc += cc_cb[0x03];
 			E = RLC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x04:	/* RLC	H		*/
+	OP(cb,0x04):	/* RLC	H		*/
 		{
 			z80_cc += cc_cb[0x04];
 			H = RLC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x05:	/* RLC	L		*/
+	OP(cb,0x05):	/* RLC	L		*/
 		{
 			z80_cc += cc_cb[0x05];
 			L = RLC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x06:	/* RLC	(HL)		*/
+	OP(cb,0x06):	/* RLC	(HL)		*/
 		{
 			z80_cc += cc_cb[0x06];
 			WR_MEM(dHL, RLC(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x07:	/* RLC	A		*/
+	OP(cb,0x07):	/* RLC	A		*/
 		{
 			z80_cc += cc_cb[0x07];
 			A = RLC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x08:	/* RRC	B		*/
+	OP(cb,0x08):	/* RRC	B		*/
 		{
 			z80_cc += cc_cb[0x08];
 			B = RRC(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x09:	/* RRC	C		*/
+	OP(cb,0x09):	/* RRC	C		*/
 		{
 			z80_cc += cc_cb[0x09];
 			C = RRC(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0a:	/* RRC	D		*/
+	OP(cb,0x0a):	/* RRC	D		*/
 		{
 			z80_cc += cc_cb[0x0a];
 			D = RRC(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0b:	/* RRC	E		*/
+	OP(cb,0x0b):	/* RRC	E		*/
 		{
 			z80_cc += cc_cb[0x0b];
 			E = RRC(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0c:	/* RRC	H		*/
+	OP(cb,0x0c):	/* RRC	H		*/
 		{
 			z80_cc += cc_cb[0x0c];
 			H = RRC(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0d:	/* RRC	L		*/
+	OP(cb,0x0d):	/* RRC	L		*/
 		{
 			z80_cc += cc_cb[0x0d];
 			L = RRC(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0e:	/* RRC	(HL)		*/
+	OP(cb,0x0e):	/* RRC	(HL)		*/
 		{
 			z80_cc += cc_cb[0x0e];
 			WR_MEM(dHL, RRC(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0f:	/* RRC	A		*/
+	OP(cb,0x0f):	/* RRC	A		*/
 		{
 			z80_cc += cc_cb[0x0f];
 			A = RRC(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x10:	/* RL	B		*/
+	OP(cb,0x10):	/* RL	B		*/
 		{
 			z80_cc += cc_cb[0x10];
 			B = RL(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x11:	/* RL	C		*/
+	OP(cb,0x11):	/* RL	C		*/
 		{
 			z80_cc += cc_cb[0x11];
 			C = RL(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x12:	/* RL	D		*/
+	OP(cb,0x12):	/* RL	D		*/
 		{
 			z80_cc += cc_cb[0x12];
 			D = RL(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x13:	/* RL	E		*/
+	OP(cb,0x13):	/* RL	E		*/
 		{
 			z80_cc += cc_cb[0x13];
 			E = RL(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x14:	/* RL	H		*/
+	OP(cb,0x14):	/* RL	H		*/
 		{
 			z80_cc += cc_cb[0x14];
 			H = RL(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x15:	/* RL	L		*/
+	OP(cb,0x15):	/* RL	L		*/
 		{
 			z80_cc += cc_cb[0x15];
 			L = RL(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x16:	/* RL	(HL)		*/
+	OP(cb,0x16):	/* RL	(HL)		*/
 		{
 			z80_cc += cc_cb[0x16];
 			WR_MEM(dHL, RL(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x17:	/* RL	A		*/
+	OP(cb,0x17):	/* RL	A		*/
 		{
 			z80_cc += cc_cb[0x17];
 			A = RL(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x18:	/* RR	B		*/
+	OP(cb,0x18):	/* RR	B		*/
 		{
 			z80_cc += cc_cb[0x18];
 			B = RR(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x19:	/* RR	C		*/
+	OP(cb,0x19):	/* RR	C		*/
 		{
 			z80_cc += cc_cb[0x19];
 			C = RR(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1a:	/* RR	D		*/
+	OP(cb,0x1a):	/* RR	D		*/
 		{
 			z80_cc += cc_cb[0x1a];
 			D = RR(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1b:	/* RR	E		*/
+	OP(cb,0x1b):	/* RR	E		*/
 		{
 			z80_cc += cc_cb[0x1b];
 			E = RR(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1c:	/* RR	H		*/
+	OP(cb,0x1c):	/* RR	H		*/
 		{
 			z80_cc += cc_cb[0x1c];
 			H = RR(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1d:	/* RR	L		*/
+	OP(cb,0x1d):	/* RR	L		*/
 		{
 			z80_cc += cc_cb[0x1d];
 			L = RR(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1e:	/* RR	(HL)		*/
+	OP(cb,0x1e):	/* RR	(HL)		*/
 		{
 			z80_cc += cc_cb[0x1e];
 			WR_MEM(dHL, RR(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1f:	/* RR	A		*/
+	OP(cb,0x1f):	/* RR	A		*/
 		{
 			z80_cc += cc_cb[0x1f];
 			A = RR(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x20:	/* SLA	B		*/
+	OP(cb,0x20):	/* SLA	B		*/
 		{
 			z80_cc += cc_cb[0x20];
 			B = SLA(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x21:	/* SLA	C		*/
+	OP(cb,0x21):	/* SLA	C		*/
 		{
 			z80_cc += cc_cb[0x21];
 			C = SLA(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x22:	/* SLA	D		*/
+	OP(cb,0x22):	/* SLA	D		*/
 		{
 			z80_cc += cc_cb[0x22];
 			D = SLA(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x23:	/* SLA	E		*/
+	OP(cb,0x23):	/* SLA	E		*/
 		{
 			z80_cc += cc_cb[0x23];
 			E = SLA(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x24:	/* SLA	H		*/
+	OP(cb,0x24):	/* SLA	H		*/
 		{
 			z80_cc += cc_cb[0x24];
 			H = SLA(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x25:	/* SLA	L		*/
+	OP(cb,0x25):	/* SLA	L		*/
 		{
 			z80_cc += cc_cb[0x25];
 			L = SLA(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x26:	/* SLA	(HL)		*/
+	OP(cb,0x26):	/* SLA	(HL)		*/
 		{
 			z80_cc += cc_cb[0x26];
 			WR_MEM(dHL, SLA(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x27:	/* SLA	A		*/
+	OP(cb,0x27):	/* SLA	A		*/
 		{
 			z80_cc += cc_cb[0x27];
 			A = SLA(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x28:	/* SRA	B		*/
+	OP(cb,0x28):	/* SRA	B		*/
 		{
 			z80_cc += cc_cb[0x28];
 			B = SRA(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x29:	/* SRA	C		*/
+	OP(cb,0x29):	/* SRA	C		*/
 		{
 			z80_cc += cc_cb[0x29];
 			C = SRA(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2a:	/* SRA	D		*/
+	OP(cb,0x2a):	/* SRA	D		*/
 		{
 			z80_cc += cc_cb[0x2a];
 			D = SRA(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2b:	/* SRA	E		*/
+	OP(cb,0x2b):	/* SRA	E		*/
 		{
 			z80_cc += cc_cb[0x2b];
 			E = SRA(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2c:	/* SRA	H		*/
+	OP(cb,0x2c):	/* SRA	H		*/
 		{
 			z80_cc += cc_cb[0x2c];
 			H = SRA(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2d:	/* SRA	L		*/
+	OP(cb,0x2d):	/* SRA	L		*/
 		{
 			z80_cc += cc_cb[0x2d];
 			L = SRA(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2e:	/* SRA	(HL)		*/
+	OP(cb,0x2e):	/* SRA	(HL)		*/
 		{
 			z80_cc += cc_cb[0x2e];
 			WR_MEM(dHL, SRA(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2f:	/* SRA	A		*/
+	OP(cb,0x2f):	/* SRA	A		*/
 		{
 			z80_cc += cc_cb[0x2f];
 			A = SRA(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x30:	/* SLL	B		*/
+	OP(cb,0x30):	/* SLL	B		*/
 		{
 			z80_cc += cc_cb[0x30];
 			B = SLL(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x31:	/* SLL	C		*/
+	OP(cb,0x31):	/* SLL	C		*/
 		{
 			z80_cc += cc_cb[0x31];
 			C = SLL(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x32:	/* SLL	D		*/
+	OP(cb,0x32):	/* SLL	D		*/
 		{
 			z80_cc += cc_cb[0x32];
 			D = SLL(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x33:	/* SLL	E		*/
+	OP(cb,0x33):	/* SLL	E		*/
 		{
 			z80_cc += cc_cb[0x33];
 			E = SLL(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x34:	/* SLL	H		*/
+	OP(cb,0x34):	/* SLL	H		*/
 		{
 			z80_cc += cc_cb[0x34];
 			H = SLL(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x35:	/* SLL	L		*/
+	OP(cb,0x35):	/* SLL	L		*/
 		{
 			z80_cc += cc_cb[0x35];
 			L = SLL(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x36:	/* SLL	(HL)		*/
+	OP(cb,0x36):	/* SLL	(HL)		*/
 		{
 			z80_cc += cc_cb[0x36];
 			WR_MEM(dHL, SLL(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x37:	/* SLL	A		*/
+	OP(cb,0x37):	/* SLL	A		*/
 		{
 			z80_cc += cc_cb[0x37];
 			A = SLL(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x38:	/* SRL	B		*/
+	OP(cb,0x38):	/* SRL	B		*/
 		{
 			z80_cc += cc_cb[0x38];
 			B = SRL(cpu, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x39:	/* SRL	C		*/
+	OP(cb,0x39):	/* SRL	C		*/
 		{
 			z80_cc += cc_cb[0x39];
 			C = SRL(cpu, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3a:	/* SRL	D		*/
+	OP(cb,0x3a):	/* SRL	D		*/
 		{
 			z80_cc += cc_cb[0x3a];
 			D = SRL(cpu, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3b:	/* SRL	E		*/
+	OP(cb,0x3b):	/* SRL	E		*/
 		{
 			z80_cc += cc_cb[0x3b];
 			E = SRL(cpu, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3c:	/* SRL	H		*/
+	OP(cb,0x3c):	/* SRL	H		*/
 		{
 			z80_cc += cc_cb[0x3c];
 			H = SRL(cpu, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3d:	/* SRL	L		*/
+	OP(cb,0x3d):	/* SRL	L		*/
 		{
 			z80_cc += cc_cb[0x3d];
 			L = SRL(cpu, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3e:	/* SRL	(HL)		*/
+	OP(cb,0x3e):	/* SRL	(HL)		*/
 		{
 			z80_cc += cc_cb[0x3e];
 			WR_MEM(dHL, SRL(cpu, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3f:	/* SRL	A		*/
+	OP(cb,0x3f):	/* SRL	A		*/
 		{
 			z80_cc += cc_cb[0x3f];
 			A = SRL(cpu, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x40:	/* BIT	0,B		*/
+	OP(cb,0x40):	/* BIT	0,B		*/
 		{
 			z80_cc += cc_cb[0x40];
 			BIT(cpu, 0, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x41:	/* BIT	0,C		*/
+	OP(cb,0x41):	/* BIT	0,C		*/
 		{
 			z80_cc += cc_cb[0x41];
 			BIT(cpu, 0, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x42:	/* BIT	0,D		*/
+	OP(cb,0x42):	/* BIT	0,D		*/
 		{
 			z80_cc += cc_cb[0x42];
 			BIT(cpu, 0, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x43:	/* BIT	0,E		*/
+	OP(cb,0x43):	/* BIT	0,E		*/
 		{
 			z80_cc += cc_cb[0x43];
 			BIT(cpu, 0, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x44:	/* BIT	0,H		*/
+	OP(cb,0x44):	/* BIT	0,H		*/
 		{
 			z80_cc += cc_cb[0x44];
 			BIT(cpu, 0, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x45:	/* BIT	0,L		*/
+	OP(cb,0x45):	/* BIT	0,L		*/
 		{
 			z80_cc += cc_cb[0x45];
 			BIT(cpu, 0, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x46:	/* BIT	0,(HL)		*/
+	OP(cb,0x46):	/* BIT	0,(HL)		*/
 		{
 			z80_cc += cc_cb[0x46];
 			BIT_HL(cpu, 0, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x47:	/* BIT	0,A		*/
+	OP(cb,0x47):	/* BIT	0,A		*/
 		{
 			z80_cc += cc_cb[0x47];
 			BIT(cpu, 0, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x48:	/* BIT	1,B		*/
+	OP(cb,0x48):	/* BIT	1,B		*/
 		{
 			z80_cc += cc_cb[0x48];
 			BIT(cpu, 1, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x49:	/* BIT	1,C		*/
+	OP(cb,0x49):	/* BIT	1,C		*/
 		{
 			z80_cc += cc_cb[0x49];
 			BIT(cpu, 1, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4a:	/* BIT	1,D		*/
+	OP(cb,0x4a):	/* BIT	1,D		*/
 		{
 			z80_cc += cc_cb[0x4a];
 			BIT(cpu, 1, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4b:	/* BIT	1,E		*/
+	OP(cb,0x4b):	/* BIT	1,E		*/
 		{
 			z80_cc += cc_cb[0x4b];
 			BIT(cpu, 1, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4c:	/* BIT	1,H		*/
+	OP(cb,0x4c):	/* BIT	1,H		*/
 		{
 			z80_cc += cc_cb[0x4c];
 			BIT(cpu, 1, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4d:	/* BIT	1,L		*/
+	OP(cb,0x4d):	/* BIT	1,L		*/
 		{
 			z80_cc += cc_cb[0x4d];
 			BIT(cpu, 1, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4e:	/* BIT	1,(HL)		*/
+	OP(cb,0x4e):	/* BIT	1,(HL)		*/
 		{
 			z80_cc += cc_cb[0x4e];
 			BIT_HL(cpu, 1, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4f:	/* BIT	1,A		*/
+	OP(cb,0x4f):	/* BIT	1,A		*/
 		{
 			z80_cc += cc_cb[0x4f];
 			BIT(cpu, 1, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x50:	/* BIT	2,B		*/
+	OP(cb,0x50):	/* BIT	2,B		*/
 		{
 			z80_cc += cc_cb[0x50];
 			BIT(cpu, 2, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x51:	/* BIT	2,C		*/
+	OP(cb,0x51):	/* BIT	2,C		*/
 		{
 			z80_cc += cc_cb[0x51];
 			BIT(cpu, 2, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x52:	/* BIT	2,D		*/
+	OP(cb,0x52):	/* BIT	2,D		*/
 		{
 			z80_cc += cc_cb[0x52];
 			BIT(cpu, 2, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x53:	/* BIT	2,E		*/
+	OP(cb,0x53):	/* BIT	2,E		*/
 		{
 			z80_cc += cc_cb[0x53];
 			BIT(cpu, 2, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x54:	/* BIT	2,H		*/
+	OP(cb,0x54):	/* BIT	2,H		*/
 		{
 			z80_cc += cc_cb[0x54];
 			BIT(cpu, 2, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x55:	/* BIT	2,L		*/
+	OP(cb,0x55):	/* BIT	2,L		*/
 		{
 			z80_cc += cc_cb[0x55];
 			BIT(cpu, 2, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x56:	/* BIT	2,(HL)		*/
+	OP(cb,0x56):	/* BIT	2,(HL)		*/
 		{
 			z80_cc += cc_cb[0x56];
 			BIT_HL(cpu, 2, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x57:	/* BIT	2,A		*/
+	OP(cb,0x57):	/* BIT	2,A		*/
 		{
 			z80_cc += cc_cb[0x57];
 			BIT(cpu, 2, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x58:	/* BIT	3,B		*/
+	OP(cb,0x58):	/* BIT	3,B		*/
 		{
 			z80_cc += cc_cb[0x58];
 			BIT(cpu, 3, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x59:	/* BIT	3,C		*/
+	OP(cb,0x59):	/* BIT	3,C		*/
 		{
 			z80_cc += cc_cb[0x59];
 			BIT(cpu, 3, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5a:	/* BIT	3,D		*/
+	OP(cb,0x5a):	/* BIT	3,D		*/
 		{
 			z80_cc += cc_cb[0x5a];
 			BIT(cpu, 3, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5b:	/* BIT	3,E		*/
+	OP(cb,0x5b):	/* BIT	3,E		*/
 		{
 			z80_cc += cc_cb[0x5b];
 			BIT(cpu, 3, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5c:	/* BIT	3,H		*/
+	OP(cb,0x5c):	/* BIT	3,H		*/
 		{
 			z80_cc += cc_cb[0x5c];
 			BIT(cpu, 3, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5d:	/* BIT	3,L		*/
+	OP(cb,0x5d):	/* BIT	3,L		*/
 		{
 			z80_cc += cc_cb[0x5d];
 			BIT(cpu, 3, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5e:	/* BIT	3,(HL)		*/
+	OP(cb,0x5e):	/* BIT	3,(HL)		*/
 		{
 			z80_cc += cc_cb[0x5e];
 			BIT_HL(cpu, 3, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5f:	/* BIT	3,A		*/
+	OP(cb,0x5f):	/* BIT	3,A		*/
 		{
 			z80_cc += cc_cb[0x5f];
 			BIT(cpu, 3, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* BIT	4,B		*/
+	OP(cb,0x60):	/* BIT	4,B		*/
 		{
 			z80_cc += cc_cb[0x60];
 			BIT(cpu, 4, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x61:	/* BIT	4,C		*/
+	OP(cb,0x61):	/* BIT	4,C		*/
 		{
 			z80_cc += cc_cb[0x61];
 			BIT(cpu, 4, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x62:	/* BIT	4,D		*/
+	OP(cb,0x62):	/* BIT	4,D		*/
 		{
 			z80_cc += cc_cb[0x62];
 			BIT(cpu, 4, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x63:	/* BIT	4,E		*/
+	OP(cb,0x63):	/* BIT	4,E		*/
 		{
 			z80_cc += cc_cb[0x63];
 			BIT(cpu, 4, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x64:	/* BIT	4,H		*/
+	OP(cb,0x64):	/* BIT	4,H		*/
 		{
 			z80_cc += cc_cb[0x64];
 			BIT(cpu, 4, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x65:	/* BIT	4,L		*/
+	OP(cb,0x65):	/* BIT	4,L		*/
 		{
 			z80_cc += cc_cb[0x65];
 			BIT(cpu, 4, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x66:	/* BIT	4,(HL)		*/
+	OP(cb,0x66):	/* BIT	4,(HL)		*/
 		{
 			z80_cc += cc_cb[0x66];
 			BIT_HL(cpu, 4, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x67:	/* BIT	4,A		*/
+	OP(cb,0x67):	/* BIT	4,A		*/
 		{
 			z80_cc += cc_cb[0x67];
 			BIT(cpu, 4, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* BIT	5,B		*/
+	OP(cb,0x68):	/* BIT	5,B		*/
 		{
 			z80_cc += cc_cb[0x68];
 			BIT(cpu, 5, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x69:	/* BIT	5,C		*/
+	OP(cb,0x69):	/* BIT	5,C		*/
 		{
 			z80_cc += cc_cb[0x69];
 			BIT(cpu, 5, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6a:	/* BIT	5,D		*/
+	OP(cb,0x6a):	/* BIT	5,D		*/
 		{
 			z80_cc += cc_cb[0x6a];
 			BIT(cpu, 5, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6b:	/* BIT	5,E		*/
+	OP(cb,0x6b):	/* BIT	5,E		*/
 		{
 			z80_cc += cc_cb[0x6b];
 			BIT(cpu, 5, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6c:	/* BIT	5,H		*/
+	OP(cb,0x6c):	/* BIT	5,H		*/
 		{
 			z80_cc += cc_cb[0x6c];
 			BIT(cpu, 5, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6d:	/* BIT	5,L		*/
+	OP(cb,0x6d):	/* BIT	5,L		*/
 		{
 			z80_cc += cc_cb[0x6d];
 			BIT(cpu, 5, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6e:	/* BIT	5,(HL)		*/
+	OP(cb,0x6e):	/* BIT	5,(HL)		*/
 		{
 			z80_cc += cc_cb[0x6e];
 			BIT_HL(cpu, 5, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6f:	/* BIT	5,A		*/
+	OP(cb,0x6f):	/* BIT	5,A		*/
 		{
 			z80_cc += cc_cb[0x6f];
 			BIT(cpu, 5, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* BIT	6,B		*/
+	OP(cb,0x70):	/* BIT	6,B		*/
 		{
 			z80_cc += cc_cb[0x70];
 			BIT(cpu, 6, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x71:	/* BIT	6,C		*/
+	OP(cb,0x71):	/* BIT	6,C		*/
 		{
 			z80_cc += cc_cb[0x71];
 			BIT(cpu, 6, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x72:	/* BIT	6,D		*/
+	OP(cb,0x72):	/* BIT	6,D		*/
 		{
 			z80_cc += cc_cb[0x72];
 			BIT(cpu, 6, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x73:	/* BIT	6,E		*/
+	OP(cb,0x73):	/* BIT	6,E		*/
 		{
 			z80_cc += cc_cb[0x73];
 			BIT(cpu, 6, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x74:	/* BIT	6,H		*/
+	OP(cb,0x74):	/* BIT	6,H		*/
 		{
 			z80_cc += cc_cb[0x74];
 			BIT(cpu, 6, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x75:	/* BIT	6,L		*/
+	OP(cb,0x75):	/* BIT	6,L		*/
 		{
 			z80_cc += cc_cb[0x75];
 			BIT(cpu, 6, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x76:	/* BIT	6,(HL)		*/
+	OP(cb,0x76):	/* BIT	6,(HL)		*/
 		{
 			z80_cc += cc_cb[0x76];
 			BIT_HL(cpu, 6, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x77:	/* BIT	6,A		*/
+	OP(cb,0x77):	/* BIT	6,A		*/
 		{
 			z80_cc += cc_cb[0x77];
 			BIT(cpu, 6, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x78:	/* BIT	7,B		*/
+	OP(cb,0x78):	/* BIT	7,B		*/
 		{
 			z80_cc += cc_cb[0x78];
 			BIT(cpu, 7, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x79:	/* BIT	7,C		*/
+	OP(cb,0x79):	/* BIT	7,C		*/
 		{
 			z80_cc += cc_cb[0x79];
 			BIT(cpu, 7, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7a:	/* BIT	7,D		*/
+	OP(cb,0x7a):	/* BIT	7,D		*/
 		{
 			z80_cc += cc_cb[0x7a];
 			BIT(cpu, 7, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7b:	/* BIT	7,E		*/
+	OP(cb,0x7b):	/* BIT	7,E		*/
 		{
 			z80_cc += cc_cb[0x7b];
 			BIT(cpu, 7, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7c:	/* BIT	7,H		*/
+	OP(cb,0x7c):	/* BIT	7,H		*/
 		{
 			z80_cc += cc_cb[0x7c];
 			BIT(cpu, 7, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7d:	/* BIT	7,L		*/
+	OP(cb,0x7d):	/* BIT	7,L		*/
 		{
 			z80_cc += cc_cb[0x7d];
 			BIT(cpu, 7, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7e:	/* BIT	7,(HL)		*/
+	OP(cb,0x7e):	/* BIT	7,(HL)		*/
 		{
 			z80_cc += cc_cb[0x7e];
 			BIT_HL(cpu, 7, RD_MEM(dHL));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7f:	/* BIT	7,A		*/
+	OP(cb,0x7f):	/* BIT	7,A		*/
 		{
 			z80_cc += cc_cb[0x7f];
 			BIT(cpu, 7, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x80:	/* RES	0,B		*/
+	OP(cb,0x80):	/* RES	0,B		*/
 		{
 			z80_cc += cc_cb[0x80];
 			B = RES(cpu, 0, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x81:	/* RES	0,C		*/
+	OP(cb,0x81):	/* RES	0,C		*/
 		{
 			z80_cc += cc_cb[0x81];
 			C = RES(cpu, 0, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x82:	/* RES	0,D		*/
+	OP(cb,0x82):	/* RES	0,D		*/
 		{
 			z80_cc += cc_cb[0x82];
 			D = RES(cpu, 0, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x83:	/* RES	0,E		*/
+	OP(cb,0x83):	/* RES	0,E		*/
 		{
 			z80_cc += cc_cb[0x83];
 			E = RES(cpu, 0, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x84:	/* RES	0,H		*/
+	OP(cb,0x84):	/* RES	0,H		*/
 		{
 			z80_cc += cc_cb[0x84];
 			H = RES(cpu, 0, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x85:	/* RES	0,L		*/
+	OP(cb,0x85):	/* RES	0,L		*/
 		{
 			z80_cc += cc_cb[0x85];
 			L = RES(cpu, 0, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x86:	/* RES	0,(HL)		*/
+	OP(cb,0x86):	/* RES	0,(HL)		*/
 		{
 			z80_cc += cc_cb[0x86];
 			WR_MEM(dHL, RES(cpu, 0, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x87:	/* RES	0,A		*/
+	OP(cb,0x87):	/* RES	0,A		*/
 		{
 			z80_cc += cc_cb[0x87];
 			A = RES(cpu, 0, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x88:	/* RES	1,B		*/
+	OP(cb,0x88):	/* RES	1,B		*/
 		{
 			z80_cc += cc_cb[0x88];
 			B = RES(cpu, 1, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x89:	/* RES	1,C		*/
+	OP(cb,0x89):	/* RES	1,C		*/
 		{
 			z80_cc += cc_cb[0x89];
 			C = RES(cpu, 1, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8a:	/* RES	1,D		*/
+	OP(cb,0x8a):	/* RES	1,D		*/
 		{
 			z80_cc += cc_cb[0x8a];
 			D = RES(cpu, 1, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8b:	/* RES	1,E		*/
+	OP(cb,0x8b):	/* RES	1,E		*/
 		{
 			z80_cc += cc_cb[0x8b];
 			E = RES(cpu, 1, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8c:	/* RES	1,H		*/
+	OP(cb,0x8c):	/* RES	1,H		*/
 		{
 			z80_cc += cc_cb[0x8c];
 			H = RES(cpu, 1, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8d:	/* RES	1,L		*/
+	OP(cb,0x8d):	/* RES	1,L		*/
 		{
 			z80_cc += cc_cb[0x8d];
 			L = RES(cpu, 1, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8e:	/* RES	1,(HL)		*/
+	OP(cb,0x8e):	/* RES	1,(HL)		*/
 		{
 			z80_cc += cc_cb[0x8e];
 			WR_MEM(dHL, RES(cpu, 1, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8f:	/* RES	1,A		*/
+	OP(cb,0x8f):	/* RES	1,A		*/
 		{
 			z80_cc += cc_cb[0x8f];
 			A = RES(cpu, 1, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x90:	/* RES	2,B		*/
+	OP(cb,0x90):	/* RES	2,B		*/
 		{
 			z80_cc += cc_cb[0x90];
 			B = RES(cpu, 2, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x91:	/* RES	2,C		*/
+	OP(cb,0x91):	/* RES	2,C		*/
 		{
 			z80_cc += cc_cb[0x91];
 			C = RES(cpu, 2, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x92:	/* RES	2,D		*/
+	OP(cb,0x92):	/* RES	2,D		*/
 		{
 			z80_cc += cc_cb[0x92];
 			D = RES(cpu, 2, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x93:	/* RES	2,E		*/
+	OP(cb,0x93):	/* RES	2,E		*/
 		{
 			z80_cc += cc_cb[0x93];
 			E = RES(cpu, 2, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x94:	/* RES	2,H		*/
+	OP(cb,0x94):	/* RES	2,H		*/
 		{
 			z80_cc += cc_cb[0x94];
 			H = RES(cpu, 2, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x95:	/* RES	2,L		*/
+	OP(cb,0x95):	/* RES	2,L		*/
 		{
 			z80_cc += cc_cb[0x95];
 			L = RES(cpu, 2, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x96:	/* RES	2,(HL)		*/
+	OP(cb,0x96):	/* RES	2,(HL)		*/
 		{
 			z80_cc += cc_cb[0x96];
 			WR_MEM(dHL, RES(cpu, 2, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x97:	/* RES	2,A		*/
+	OP(cb,0x97):	/* RES	2,A		*/
 		{
 			z80_cc += cc_cb[0x97];
 			A = RES(cpu, 2, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x98:	/* RES	3,B		*/
+	OP(cb,0x98):	/* RES	3,B		*/
 		{
 			z80_cc += cc_cb[0x98];
 			B = RES(cpu, 3, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x99:	/* RES	3,C		*/
+	OP(cb,0x99):	/* RES	3,C		*/
 		{
 			z80_cc += cc_cb[0x99];
 			C = RES(cpu, 3, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9a:	/* RES	3,D		*/
+	OP(cb,0x9a):	/* RES	3,D		*/
 		{
 			z80_cc += cc_cb[0x9a];
 			D = RES(cpu, 3, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9b:	/* RES	3,E		*/
+	OP(cb,0x9b):	/* RES	3,E		*/
 		{
 			z80_cc += cc_cb[0x9b];
 			E = RES(cpu, 3, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9c:	/* RES	3,H		*/
+	OP(cb,0x9c):	/* RES	3,H		*/
 		{
 			z80_cc += cc_cb[0x9c];
 			H = RES(cpu, 3, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9d:	/* RES	3,L		*/
+	OP(cb,0x9d):	/* RES	3,L		*/
 		{
 			z80_cc += cc_cb[0x9d];
 			L = RES(cpu, 3, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9e:	/* RES	3,(HL)		*/
+	OP(cb,0x9e):	/* RES	3,(HL)		*/
 		{
 			z80_cc += cc_cb[0x9e];
 			WR_MEM(dHL, RES(cpu, 3, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9f:	/* RES	3,A		*/
+	OP(cb,0x9f):	/* RES	3,A		*/
 		{
 			z80_cc += cc_cb[0x9f];
 			A = RES(cpu, 3, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa0:	/* RES	4,B		*/
+	OP(cb,0xa0):	/* RES	4,B		*/
 		{
 			z80_cc += cc_cb[0xa0];
 			B = RES(cpu, 4, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa1:	/* RES	4,C		*/
+	OP(cb,0xa1):	/* RES	4,C		*/
 		{
 			z80_cc += cc_cb[0xa1];
 			C = RES(cpu, 4, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa2:	/* RES	4,D		*/
+	OP(cb,0xa2):	/* RES	4,D		*/
 		{
 			z80_cc += cc_cb[0xa2];
 			D = RES(cpu, 4, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa3:	/* RES	4,E		*/
+	OP(cb,0xa3):	/* RES	4,E		*/
 		{
 			z80_cc += cc_cb[0xa3];
 			E = RES(cpu, 4, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa4:	/* RES	4,H		*/
+	OP(cb,0xa4):	/* RES	4,H		*/
 		{
 			z80_cc += cc_cb[0xa4];
 			H = RES(cpu, 4, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa5:	/* RES	4,L		*/
+	OP(cb,0xa5):	/* RES	4,L		*/
 		{
 			z80_cc += cc_cb[0xa5];
 			L = RES(cpu, 4, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa6:	/* RES	4,(HL)		*/
+	OP(cb,0xa6):	/* RES	4,(HL)		*/
 		{
 			z80_cc += cc_cb[0xa6];
 			WR_MEM(dHL, RES(cpu, 4, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa7:	/* RES	4,A		*/
+	OP(cb,0xa7):	/* RES	4,A		*/
 		{
 			z80_cc += cc_cb[0xa7];
 			A = RES(cpu, 4, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa8:	/* RES	5,B		*/
+	OP(cb,0xa8):	/* RES	5,B		*/
 		{
 			z80_cc += cc_cb[0xa8];
 			B = RES(cpu, 5, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa9:	/* RES	5,C		*/
+	OP(cb,0xa9):	/* RES	5,C		*/
 		{
 			z80_cc += cc_cb[0xa9];
 			C = RES(cpu, 5, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaa:	/* RES	5,D		*/
+	OP(cb,0xaa):	/* RES	5,D		*/
 		{
 			z80_cc += cc_cb[0xaa];
 			D = RES(cpu, 5, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xab:	/* RES	5,E		*/
+	OP(cb,0xab):	/* RES	5,E		*/
 		{
 			z80_cc += cc_cb[0xab];
 			E = RES(cpu, 5, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xac:	/* RES	5,H		*/
+	OP(cb,0xac):	/* RES	5,H		*/
 		{
 			z80_cc += cc_cb[0xac];
 			H = RES(cpu, 5, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xad:	/* RES	5,L		*/
+	OP(cb,0xad):	/* RES	5,L		*/
 		{
 			z80_cc += cc_cb[0xad];
 			L = RES(cpu, 5, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xae:	/* RES	5,(HL)		*/
+	OP(cb,0xae):	/* RES	5,(HL)		*/
 		{
 			z80_cc += cc_cb[0xae];
 			WR_MEM(dHL, RES(cpu, 5, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaf:	/* RES	5,A		*/
+	OP(cb,0xaf):	/* RES	5,A		*/
 		{
 			z80_cc += cc_cb[0xaf];
 			A = RES(cpu, 5, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb0:	/* RES	6,B		*/
+	OP(cb,0xb0):	/* RES	6,B		*/
 		{
 			z80_cc += cc_cb[0xb0];
 			B = RES(cpu, 6, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb1:	/* RES	6,C		*/
+	OP(cb,0xb1):	/* RES	6,C		*/
 		{
 			z80_cc += cc_cb[0xb1];
 			C = RES(cpu, 6, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb2:	/* RES	6,D		*/
+	OP(cb,0xb2):	/* RES	6,D		*/
 		{
 			z80_cc += cc_cb[0xb2];
 			D = RES(cpu, 6, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb3:	/* RES	6,E		*/
+	OP(cb,0xb3):	/* RES	6,E		*/
 		{
 			z80_cc += cc_cb[0xb3];
 			E = RES(cpu, 6, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb4:	/* RES	6,H		*/
+	OP(cb,0xb4):	/* RES	6,H		*/
 		{
 			z80_cc += cc_cb[0xb4];
 			H = RES(cpu, 6, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb5:	/* RES	6,L		*/
+	OP(cb,0xb5):	/* RES	6,L		*/
 		{
 			z80_cc += cc_cb[0xb5];
 			L = RES(cpu, 6, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb6:	/* RES	6,(HL)		*/
+	OP(cb,0xb6):	/* RES	6,(HL)		*/
 		{
 			z80_cc += cc_cb[0xb6];
 			WR_MEM(dHL, RES(cpu, 6, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb7:	/* RES	6,A		*/
+	OP(cb,0xb7):	/* RES	6,A		*/
 		{
 			z80_cc += cc_cb[0xb7];
 			A = RES(cpu, 6, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb8:	/* RES	7,B		*/
+	OP(cb,0xb8):	/* RES	7,B		*/
 		{
 			z80_cc += cc_cb[0xb8];
 			B = RES(cpu, 7, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb9:	/* RES	7,C		*/
+	OP(cb,0xb9):	/* RES	7,C		*/
 		{
 			z80_cc += cc_cb[0xb9];
 			C = RES(cpu, 7, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xba:	/* RES	7,D		*/
+	OP(cb,0xba):	/* RES	7,D		*/
 		{
 			z80_cc += cc_cb[0xba];
 			D = RES(cpu, 7, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbb:	/* RES	7,E		*/
+	OP(cb,0xbb):	/* RES	7,E		*/
 		{
 			z80_cc += cc_cb[0xbb];
 			E = RES(cpu, 7, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbc:	/* RES	7,H		*/
+	OP(cb,0xbc):	/* RES	7,H		*/
 		{
 			z80_cc += cc_cb[0xbc];
 			H = RES(cpu, 7, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbd:	/* RES	7,L		*/
+	OP(cb,0xbd):	/* RES	7,L		*/
 		{
 			z80_cc += cc_cb[0xbd];
 			L = RES(cpu, 7, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbe:	/* RES	7,(HL)		*/
+	OP(cb,0xbe):	/* RES	7,(HL)		*/
 		{
 			z80_cc += cc_cb[0xbe];
 			WR_MEM(dHL, RES(cpu, 7, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbf:	/* RES	7,A		*/
+	OP(cb,0xbf):	/* RES	7,A		*/
 		{
 			z80_cc += cc_cb[0xbf];
 			A = RES(cpu, 7, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc0:	/* SET	0,B		*/
+	OP(cb,0xc0):	/* SET	0,B		*/
 		{
 			z80_cc += cc_cb[0xc0];
 			B = SET(cpu, 0, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc1:	/* SET	0,C		*/
+	OP(cb,0xc1):	/* SET	0,C		*/
 		{
 			z80_cc += cc_cb[0xc1];
 			C = SET(cpu, 0, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc2:	/* SET	0,D		*/
+	OP(cb,0xc2):	/* SET	0,D		*/
 		{
 			z80_cc += cc_cb[0xc2];
 			D = SET(cpu, 0, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc3:	/* SET	0,E		*/
+	OP(cb,0xc3):	/* SET	0,E		*/
 		{
 			z80_cc += cc_cb[0xc3];
 			E = SET(cpu, 0, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc4:	/* SET	0,H		*/
+	OP(cb,0xc4):	/* SET	0,H		*/
 		{
 			z80_cc += cc_cb[0xc4];
 			H = SET(cpu, 0, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc5:	/* SET	0,L		*/
+	OP(cb,0xc5):	/* SET	0,L		*/
 		{
 			z80_cc += cc_cb[0xc5];
 			L = SET(cpu, 0, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc6:	/* SET	0,(HL)		*/
+	OP(cb,0xc6):	/* SET	0,(HL)		*/
 		{
 			z80_cc += cc_cb[0xc6];
 			WR_MEM(dHL, SET(cpu, 0, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc7:	/* SET	0,A		*/
+	OP(cb,0xc7):	/* SET	0,A		*/
 		{
 			z80_cc += cc_cb[0xc7];
 			A = SET(cpu, 0, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc8:	/* SET	1,B		*/
+	OP(cb,0xc8):	/* SET	1,B		*/
 		{
 			z80_cc += cc_cb[0xc8];
 			B = SET(cpu, 1, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc9:	/* SET	1,C		*/
+	OP(cb,0xc9):	/* SET	1,C		*/
 		{
 			z80_cc += cc_cb[0xc9];
 			C = SET(cpu, 1, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xca:	/* SET	1,D		*/
+	OP(cb,0xca):	/* SET	1,D		*/
 		{
 			z80_cc += cc_cb[0xca];
 			D = SET(cpu, 1, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcb:	/* SET	1,E		*/
+	OP(cb,0xcb):	/* SET	1,E		*/
 		{
 			z80_cc += cc_cb[0xcb];
 			E = SET(cpu, 1, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcc:	/* SET	1,H		*/
+	OP(cb,0xcc):	/* SET	1,H		*/
 		{
 			z80_cc += cc_cb[0xcc];
 			H = SET(cpu, 1, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcd:	/* SET	1,L		*/
+	OP(cb,0xcd):	/* SET	1,L		*/
 		{
 			z80_cc += cc_cb[0xcd];
 			L = SET(cpu, 1, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xce:	/* SET	1,(HL)		*/
+	OP(cb,0xce):	/* SET	1,(HL)		*/
 		{
 			z80_cc += cc_cb[0xce];
 			WR_MEM(dHL, SET(cpu, 1, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcf:	/* SET	1,A		*/
+	OP(cb,0xcf):	/* SET	1,A		*/
 		{
 			z80_cc += cc_cb[0xcf];
 			A = SET(cpu, 1, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd0:	/* SET	2,B		*/
+	OP(cb,0xd0):	/* SET	2,B		*/
 		{
 			z80_cc += cc_cb[0xd0];
 			B = SET(cpu, 2, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd1:	/* SET	2,C		*/
+	OP(cb,0xd1):	/* SET	2,C		*/
 		{
 			z80_cc += cc_cb[0xd1];
 			C = SET(cpu, 2, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd2:	/* SET	2,D		*/
+	OP(cb,0xd2):	/* SET	2,D		*/
 		{
 			z80_cc += cc_cb[0xd2];
 			D = SET(cpu, 2, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd3:	/* SET	2,E		*/
+	OP(cb,0xd3):	/* SET	2,E		*/
 		{
 			z80_cc += cc_cb[0xd3];
 			E = SET(cpu, 2, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd4:	/* SET	2,H		*/
+	OP(cb,0xd4):	/* SET	2,H		*/
 		{
 			z80_cc += cc_cb[0xd4];
 			H = SET(cpu, 2, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd5:	/* SET	2,L		*/
+	OP(cb,0xd5):	/* SET	2,L		*/
 		{
 			z80_cc += cc_cb[0xd5];
 			L = SET(cpu, 2, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd6:	/* SET	2,(HL)		*/
+	OP(cb,0xd6):	/* SET	2,(HL)		*/
 		{
 			z80_cc += cc_cb[0xd6];
 			WR_MEM(dHL, SET(cpu, 2, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd7:	/* SET	2,A		*/
+	OP(cb,0xd7):	/* SET	2,A		*/
 		{
 			z80_cc += cc_cb[0xd7];
 			A = SET(cpu, 2, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd8:	/* SET	3,B		*/
+	OP(cb,0xd8):	/* SET	3,B		*/
 		{
 			z80_cc += cc_cb[0xd8];
 			B = SET(cpu, 3, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd9:	/* SET	3,C		*/
+	OP(cb,0xd9):	/* SET	3,C		*/
 		{
 			z80_cc += cc_cb[0xd9];
 			C = SET(cpu, 3, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xda:	/* SET	3,D		*/
+	OP(cb,0xda):	/* SET	3,D		*/
 		{
 			z80_cc += cc_cb[0xda];
 			D = SET(cpu, 3, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdb:	/* SET	3,E		*/
+	OP(cb,0xdb):	/* SET	3,E		*/
 		{
 			z80_cc += cc_cb[0xdb];
 			E = SET(cpu, 3, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdc:	/* SET	3,H		*/
+	OP(cb,0xdc):	/* SET	3,H		*/
 		{
 			z80_cc += cc_cb[0xdc];
 			H = SET(cpu, 3, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdd:	/* SET	3,L		*/
+	OP(cb,0xdd):	/* SET	3,L		*/
 		{
 			z80_cc += cc_cb[0xdd];
 			L = SET(cpu, 3, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xde:	/* SET	3,(HL)		*/
+	OP(cb,0xde):	/* SET	3,(HL)		*/
 		{
 			z80_cc += cc_cb[0xde];
 			WR_MEM(dHL, SET(cpu, 3, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdf:	/* SET	3,A		*/
+	OP(cb,0xdf):	/* SET	3,A		*/
 		{
 			z80_cc += cc_cb[0xdf];
 			A = SET(cpu, 3, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe0:	/* SET	4,B		*/
+	OP(cb,0xe0):	/* SET	4,B		*/
 		{
 			z80_cc += cc_cb[0xe0];
 			B = SET(cpu, 4, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe1:	/* SET	4,C		*/
+	OP(cb,0xe1):	/* SET	4,C		*/
 		{
 			z80_cc += cc_cb[0xe1];
 			C = SET(cpu, 4, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe2:	/* SET	4,D		*/
+	OP(cb,0xe2):	/* SET	4,D		*/
 		{
 			z80_cc += cc_cb[0xe2];
 			D = SET(cpu, 4, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe3:	/* SET	4,E		*/
+	OP(cb,0xe3):	/* SET	4,E		*/
 		{
 			z80_cc += cc_cb[0xe3];
 			E = SET(cpu, 4, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe4:	/* SET	4,H		*/
+	OP(cb,0xe4):	/* SET	4,H		*/
 		{
 			z80_cc += cc_cb[0xe4];
 			H = SET(cpu, 4, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe5:	/* SET	4,L		*/
+	OP(cb,0xe5):	/* SET	4,L		*/
 		{
 			z80_cc += cc_cb[0xe5];
 			L = SET(cpu, 4, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe6:	/* SET	4,(HL)		*/
+	OP(cb,0xe6):	/* SET	4,(HL)		*/
 		{
 			z80_cc += cc_cb[0xe6];
 			WR_MEM(dHL, SET(cpu, 4, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe7:	/* SET	4,A		*/
+	OP(cb,0xe7):	/* SET	4,A		*/
 		{
 			z80_cc += cc_cb[0xe7];
 			A = SET(cpu, 4, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe8:	/* SET	5,B		*/
+	OP(cb,0xe8):	/* SET	5,B		*/
 		{
 			z80_cc += cc_cb[0xe8];
 			B = SET(cpu, 5, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe9:	/* SET	5,C		*/
+	OP(cb,0xe9):	/* SET	5,C		*/
 		{
 			z80_cc += cc_cb[0xe9];
 			C = SET(cpu, 5, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xea:	/* SET	5,D		*/
+	OP(cb,0xea):	/* SET	5,D		*/
 		{
 			z80_cc += cc_cb[0xea];
 			D = SET(cpu, 5, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xeb:	/* SET	5,E		*/
+	OP(cb,0xeb):	/* SET	5,E		*/
 		{
 			z80_cc += cc_cb[0xeb];
 			E = SET(cpu, 5, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xec:	/* SET	5,H		*/
+	OP(cb,0xec):	/* SET	5,H		*/
 		{
 			z80_cc += cc_cb[0xec];
 			H = SET(cpu, 5, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xed:	/* SET	5,L		*/
+	OP(cb,0xed):	/* SET	5,L		*/
 		{
 			z80_cc += cc_cb[0xed];
 			L = SET(cpu, 5, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xee:	/* SET	5,(HL)		*/
+	OP(cb,0xee):	/* SET	5,(HL)		*/
 		{
 			z80_cc += cc_cb[0xee];
 			WR_MEM(dHL, SET(cpu, 5, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xef:	/* SET	5,A		*/
+	OP(cb,0xef):	/* SET	5,A		*/
 		{
 			z80_cc += cc_cb[0xef];
 			A = SET(cpu, 5, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf0:	/* SET	6,B		*/
+	OP(cb,0xf0):	/* SET	6,B		*/
 		{
 			z80_cc += cc_cb[0xf0];
 			B = SET(cpu, 6, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf1:	/* SET	6,C		*/
+	OP(cb,0xf1):	/* SET	6,C		*/
 		{
 			z80_cc += cc_cb[0xf1];
 			C = SET(cpu, 6, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf2:	/* SET	6,D		*/
+	OP(cb,0xf2):	/* SET	6,D		*/
 		{
 			z80_cc += cc_cb[0xf2];
 			D = SET(cpu, 6, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf3:	/* SET	6,E		*/
+	OP(cb,0xf3):	/* SET	6,E		*/
 		{
 			z80_cc += cc_cb[0xf3];
 			E = SET(cpu, 6, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf4:	/* SET	6,H		*/
+	OP(cb,0xf4):	/* SET	6,H		*/
 		{
 			z80_cc += cc_cb[0xf4];
 			H = SET(cpu, 6, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf5:	/* SET	6,L		*/
+	OP(cb,0xf5):	/* SET	6,L		*/
 		{
 			z80_cc += cc_cb[0xf5];
 			L = SET(cpu, 6, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf6:	/* SET	6,(HL)		*/
+	OP(cb,0xf6):	/* SET	6,(HL)		*/
 		{
 			z80_cc += cc_cb[0xf6];
 			WR_MEM(dHL, SET(cpu, 6, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf7:	/* SET	6,A		*/
+	OP(cb,0xf7):	/* SET	6,A		*/
 		{
 			z80_cc += cc_cb[0xf7];
 			A = SET(cpu, 6, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf8:	/* SET	7,B		*/
+	OP(cb,0xf8):	/* SET	7,B		*/
 		{
 			z80_cc += cc_cb[0xf8];
 			B = SET(cpu, 7, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf9:	/* SET	7,C		*/
+	OP(cb,0xf9):	/* SET	7,C		*/
 		{
 			z80_cc += cc_cb[0xf9];
 			C = SET(cpu, 7, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfa:	/* SET	7,D		*/
+	OP(cb,0xfa):	/* SET	7,D		*/
 		{
 			z80_cc += cc_cb[0xfa];
 			D = SET(cpu, 7, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfb:	/* SET	7,E		*/
+	OP(cb,0xfb):	/* SET	7,E		*/
 		{
 			z80_cc += cc_cb[0xfb];
 			E = SET(cpu, 7, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfc:	/* SET	7,H		*/
+	OP(cb,0xfc):	/* SET	7,H		*/
 		{
 			z80_cc += cc_cb[0xfc];
 			H = SET(cpu, 7, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfd:	/* SET	7,L		*/
+	OP(cb,0xfd):	/* SET	7,L		*/
 		{
 			z80_cc += cc_cb[0xfd];
 			L = SET(cpu, 7, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfe:	/* SET	7,(HL)		*/
+	OP(cb,0xfe):	/* SET	7,(HL)		*/
 		{
 			z80_cc += cc_cb[0xfe];
 			WR_MEM(dHL, SET(cpu, 7, RD_MEM(dHL)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xff:	/* SET	7,A		*/
+	OP(cb,0xff):	/* SET	7,A		*/
 		{
 			z80_cc += cc_cb[0xff];
 			A = SET(cpu, 7, A);
 		}
-		break;
+		NEXT_OP;
 	}
-	if (z80_cc < cycles)
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 
 fetch_ed_xx:
 	op = RD_OP(cpu);
-	switch (op) {
-	case 0x40:	/* IN	B,(C)		*/
+	DISPATCH(ed, op) {
+	OP(ed,0x40):	/* IN	B,(C)		*/
 		{
 			z80_cc += cc_ed[0x40];
 			B = RD_IO(dBC);
 			F = (F & CF) | flags_szp[B];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x48:	/* IN	C,(C)		*/
+	OP(ed,0x48):	/* IN	C,(C)		*/
 		{
 			z80_cc += cc_ed[0x48];
 			C = RD_IO(dBC);
 			F = (F & CF) | flags_szp[C];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x50:	/* IN	D,(C)	*/
+	OP(ed,0x50):	/* IN	D,(C)	*/
 		{
 			z80_cc += cc_ed[0x50];
 			D = RD_IO(dBC);
 			F = (F & CF) | flags_szp[D];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x58:	/* IN	E,(C)		*/
+	OP(ed,0x58):	/* IN	E,(C)		*/
 		{
 			z80_cc += cc_ed[0x58];
 			E = RD_IO(dBC);
 			F = (F & CF) | flags_szp[E];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* IN	H,(C)		*/
+	OP(ed,0x60):	/* IN	H,(C)		*/
 		{
 			z80_cc += cc_ed[0x60];
 			H = RD_IO(dBC);
 			F = (F & CF) | flags_szp[H];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* IN	L,(C)		*/
+	OP(ed,0x68):	/* IN	L,(C)		*/
 		{
 			z80_cc += cc_ed[0x68];
 			L = RD_IO(dBC);
 			F = (F & CF) | flags_szp[L];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* IN	0,(C)		*/
+	OP(ed,0x70):	/* IN	0,(C)		*/
 		{
 			uint8_t res = RD_IO(dBC);
 			z80_cc += cc_ed[0x70];
 			F = (F & CF) | flags_szp[res];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x78:	/* IN	A,(C)		*/
+	OP(ed,0x78):	/* IN	A,(C)		*/
 		{
 			z80_cc += cc_ed[0x78];
 			A = RD_IO(dBC);
 			MP = BC + 1;
 			F = (F & CF) | flags_szp[A];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x41:	/* OUT	(C),B		*/
+	OP(ed,0x41):	/* OUT	(C),B		*/
 		{
 			z80_cc += cc_ed[0x41];
 			WR_IO(dBC, B);
 			MP = BC + 1;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x49:	/* OUT	(C),C		*/
+	OP(ed,0x49):	/* OUT	(C),C		*/
 		{
 			z80_cc += cc_ed[0x49];
 			WR_IO(dBC, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x51:	/* OUT	(C),D		*/
+	OP(ed,0x51):	/* OUT	(C),D		*/
 		{
 			z80_cc += cc_ed[0x51];
 			WR_IO(dBC, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x59:	/* OUT	(C),E		*/
+	OP(ed,0x59):	/* OUT	(C),E		*/
 		{
 			z80_cc += cc_ed[0x59];
 			WR_IO(dBC, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x61:	/* OUT	(C),H		*/
+	OP(ed,0x61):	/* OUT	(C),H		*/
 		{
 			z80_cc += cc_ed[0x61];
 			WR_IO(dBC, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x69:	/* OUT	(C),L		*/
+	OP(ed,0x69):	/* OUT	(C),L		*/
 		{
 			z80_cc += cc_ed[0x69];
 			WR_IO(dBC, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x71:	/* OUT	(C),0		*/
+	OP(ed,0x71):	/* OUT	(C),0		*/
 		{
 			z80_cc += cc_ed[0x71];
 			WR_IO(dBC, 0);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x79:	/* OUT	(C),A		*/
+	OP(ed,0x79):	/* OUT	(C),A		*/
 		{
 			z80_cc += cc_ed[0x79];
 			WR_IO(dBC, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x42:	/* SBC	HL,BC		*/
+	OP(ed,0x42):	/* SBC	HL,BC		*/
 		{
 			z80_cc += cc_ed[0x42];
 			HL = SBC16(cpu, dHL, dBC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4a:	/* ADC	HL,BC		*/
+	OP(ed,0x4a):	/* ADC	HL,BC		*/
 		{
 			z80_cc += cc_ed[0x4a];
 			HL = ADC16(cpu, dHL, dBC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x52:	/* SBC	HL,DE	*/
+	OP(ed,0x52):	/* SBC	HL,DE	*/
 		{
 			z80_cc += cc_ed[0x52];
 			HL = SBC16(cpu, dHL, dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5a:	/* ADC	HL,DE		*/
+	OP(ed,0x5a):	/* ADC	HL,DE		*/
 		{
 			z80_cc += cc_ed[0x5a];
 			HL = ADC16(cpu, dHL, dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x62:	/* SBC	HL,HL		*/
+	OP(ed,0x62):	/* SBC	HL,HL		*/
 		{
 			z80_cc += cc_ed[0x62];
 			HL = SBC16(cpu, dHL, dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6a:	/* ADC	HL,HL		*/
+	OP(ed,0x6a):	/* ADC	HL,HL		*/
 		{
 			z80_cc += cc_ed[0x6a];
 			HL = ADC16(cpu, dHL, dHL);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x72:	/* SBC	HL,SP		*/
+	OP(ed,0x72):	/* SBC	HL,SP		*/
 		{
 			z80_cc += cc_ed[0x72];
 			HL = SBC16(cpu, dHL, dSP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7a:	/* ADC	HL,SP		*/
+	OP(ed,0x7a):	/* ADC	HL,SP		*/
 		{
 			z80_cc += cc_ed[0x7a];
 			HL = ADC16(cpu, dHL, dSP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x43:	/* LD	(nnnn),BC	*/
+	OP(ed,0x43):	/* LD	(nnnn),BC	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x43];
@@ -5398,9 +7850,9 @@ fetch_ed_xx:
 			MP++;
 			WR_MEM(dMP, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4b:	/* LD	BC,(nnnn)	*/
+	OP(ed,0x4b):	/* LD	BC,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x4b];
@@ -5408,9 +7860,9 @@ fetch_ed_xx:
 			MP++;
 			B = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x53:	/* LD	(nnnn),DE	*/
+	OP(ed,0x53):	/* LD	(nnnn),DE	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x53];
@@ -5418,9 +7870,9 @@ fetch_ed_xx:
 			MP++;
 			WR_MEM(dMP, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5b:	/* LD	DE,(nnnn)	*/
+	OP(ed,0x5b):	/* LD	DE,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x5b];
@@ -5428,9 +7880,9 @@ fetch_ed_xx:
 			MP++;
 			D = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x63:	/* LD	(nnnn),HL	*/
+	OP(ed,0x63):	/* LD	(nnnn),HL	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x63];
@@ -5438,9 +7890,9 @@ fetch_ed_xx:
 			MP++;
 			WR_MEM(dMP, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6b:	/* LD	HL,(nnnn)	*/
+	OP(ed,0x6b):	/* LD	HL,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x6b];
@@ -5448,9 +7900,9 @@ fetch_ed_xx:
 			MP++;
 			H = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x73:	/* LD	(nnnn),SP	*/
+	OP(ed,0x73):	/* LD	(nnnn),SP	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x73];
@@ -5458,9 +7910,9 @@ fetch_ed_xx:
 			MP++;
 			WR_MEM(dMP, SPH);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7b:	/* LD	SP,(nnnn)	*/
+	OP(ed,0x7b):	/* LD	SP,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_ed[0x7b];
@@ -5468,16 +7920,16 @@ fetch_ed_xx:
 			MP++;
 			SPH = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x44:	/* NEG			*/
-	case 0x4c:	/* NEG(*)		*/
-	case 0x54:	/* NEG(*)		*/
-	case 0x5c:	/* NEG(*)		*/
-	case 0x64:	/* NEG(*)		*/
-	case 0x6c:	/* NEG(*)		*/
-	case 0x74:	/* NEG(*)		*/
-	case 0x7c:	/* NEG(*)		*/
+	OP(ed,0x44):	/* NEG			*/
+	OP(ed,0x4c):	/* NEG(*)		*/
+	OP(ed,0x54):	/* NEG(*)		*/
+	OP(ed,0x5c):	/* NEG(*)		*/
+	OP(ed,0x64):	/* NEG(*)		*/
+	OP(ed,0x6c):	/* NEG(*)		*/
+	OP(ed,0x74):	/* NEG(*)		*/
+	OP(ed,0x7c):	/* NEG(*)		*/
 		{
 			uint32_t val = A;
 			uint32_t res = 0 - val;
@@ -5488,91 +7940,95 @@ fetch_ed_xx:
 				((val & res & 0x80) >> 5);
 			A = (uint8_t)res;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x45:	/* RETN			*/
-	case 0x55:	/* RETN(*)		*/
-	case 0x65:	/* RETN(*)		*/
-	case 0x75:	/* RETN(*)		*/
+	OP(ed,0x45):	/* RETN			*/
+	OP(ed,0x55):	/* RETN(*)		*/
+	OP(ed,0x65):	/* RETN(*)		*/
+	OP(ed,0x75):	/* RETN(*)		*/
 		{
 			z80_cc += cc_ed[0x45];
 			POP(cpu, REG_PC);
 			change_pc(dPC);
 			cpu->iff |= cpu->iff >> 1;
+			if (0 != cpu->irq)
+				machine->cycles = z80_cc;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4d:	/* RETI			*/
-	case 0x5d:	/* RETI(*)		*/
-	case 0x6d:	/* RETI(*)		*/
-	case 0x7d:	/* RETI(*)		*/
+	OP(ed,0x4d):	/* RETI			*/
+	OP(ed,0x5d):	/* RETI(*)		*/
+	OP(ed,0x6d):	/* RETI(*)		*/
+	OP(ed,0x7d):	/* RETI(*)		*/
 		{
 			z80_cc += cc_ed[0x4d];
 			POP(cpu, REG_PC);
 			change_pc(dPC);
 			cpu->iff |= cpu->iff >> 1;
+			if (0 != cpu->irq)
+				machine->cycles = z80_cc;
 			/* FIXME: daisy chain controller callback */
 		}
-		break;
+		NEXT_OP;
 
-	case 0x46:	/* IM	0		*/
-	case 0x4e:	/* IM	0(*)		*/
-	case 0x66:	/* IM	0(*)		*/
-	case 0x6e:	/* IM	0(*)		*/
+	OP(ed,0x46):	/* IM	0		*/
+	OP(ed,0x4e):	/* IM	0(*)		*/
+	OP(ed,0x66):	/* IM	0(*)		*/
+	OP(ed,0x6e):	/* IM	0(*)		*/
 		{
 			z80_cc += cc_ed[0x46];
 			cpu->im = 0;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x56:	/* IM	1		*/
-	case 0x76:	/* IM	1(*)		*/
+	OP(ed,0x56):	/* IM	1		*/
+	OP(ed,0x76):	/* IM	1(*)		*/
 		{
 			z80_cc += cc_ed[0x56];
 			cpu->im = 1;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5e:	/* IM	2		*/
-	case 0x7e:	/* IM	2(*)		*/
+	OP(ed,0x5e):	/* IM	2		*/
+	OP(ed,0x7e):	/* IM	2(*)		*/
 		{
 			z80_cc += cc_ed[0x5e];
 			cpu->im = 2;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x47:	/* LD	I,A		*/
+	OP(ed,0x47):	/* LD	I,A		*/
 		{
 			z80_cc += cc_ed[0x47];
 			cpu->iv = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4f:	/* LD	R,A		*/
+	OP(ed,0x4f):	/* LD	R,A		*/
 		{
 			z80_cc += cc_ed[0x4f];
 			cpu->r = A;
 			cpu->r7 = A & 0x80;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x57:	/* LD	A,I		*/
+	OP(ed,0x57):	/* LD	A,I		*/
 		{
 			z80_cc += cc_ed[0x57];
 			A = cpu->iv;
 			F = (F & CF) | flags_sz[A] | ((cpu->iff & 2) ? PF : 0);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5f:	/* LD	A,R		*/
+	OP(ed,0x5f):	/* LD	A,R		*/
 		{
 			z80_cc += cc_ed[0x5f];
 			A = (cpu->r & 0x7f) | cpu->r7;
 			F = (F & CF) | flags_sz[A] | ((cpu->iff & 2) ? PF : 0);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x67:	/* RRD	(HL)		*/
+	OP(ed,0x67):	/* RRD	(HL)		*/
 		{
 			uint8_t n = RD_MEM(dHL);
 			z80_cc += cc_ed[0x67];
@@ -5581,9 +8037,9 @@ fetch_ed_xx:
 			A = (A & 0xf0) | (n & 0x0f);
 			F = (F & CF) | flags_szp[A];
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6f:	/* RLD	(HL)		*/
+	OP(ed,0x6f):	/* RLD	(HL)		*/
 		{
 			uint8_t n = RD_MEM(dHL);
 			z80_cc += cc_ed[0x6f];
@@ -5592,65 +8048,65 @@ fetch_ed_xx:
 			A = (A & 0xf0) | (n >> 4);
 			F = (F & CF) | flags_szp[A];
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa0:	/* LDI			*/
+	OP(ed,0xa0):	/* LDI			*/
 		{
 			z80_cc += cc_ed[0xa0];
 			LDI(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa1:	/* CPI			*/
+	OP(ed,0xa1):	/* CPI			*/
 		{
 			z80_cc += cc_ed[0xa1];
 			CPI(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa2:	/* INI			*/
+	OP(ed,0xa2):	/* INI			*/
 		{
 			z80_cc += cc_ed[0xa2];
 			INI(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa3:	/* OUTI			*/
+	OP(ed,0xa3):	/* OUTI			*/
 		{
 			z80_cc += cc_ed[0xa3];
 			OUTI(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa8:	/* LDD			*/
+	OP(ed,0xa8):	/* LDD			*/
 		{
 			z80_cc += cc_ed[0xa8];
 			LDD(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa9:	/* CPD			*/
+	OP(ed,0xa9):	/* CPD			*/
 		{
 			z80_cc += cc_ed[0xa9];
 			CPD(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaa:	/* IND			*/
+	OP(ed,0xaa):	/* IND			*/
 		{
 			z80_cc += cc_ed[0xaa];
 			IND(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xab:	/* OUTD			*/
+	OP(ed,0xab):	/* OUTD			*/
 		{
 			z80_cc += cc_ed[0xab];
 			OUTD(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb0:	/* LDIR			*/
+	OP(ed,0xb0):	/* LDIR			*/
 		{
 			z80_cc += cc_ed[0xb0];
 			LDI(cpu);
@@ -5658,11 +8114,12 @@ fetch_ed_xx:
 				z80_cc += cc_ex[0xb0];
 				MP = PC - 1;
 				PC -= 2;
+				LDXR(cpu, 0xb0);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb1:	/* CPIR			*/
+	OP(ed,0xb1):	/* CPIR			*/
 		{
 			z80_cc += cc_ed[0xb1];
 			CPI(cpu);
@@ -5670,33 +8127,36 @@ fetch_ed_xx:
 				z80_cc += cc_ex[0xb1];
 				MP = PC - 1;
 				PC -= 2;
+				CPXR(cpu, 0xb1);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb2:	/* INIR			*/
+	OP(ed,0xb2):	/* INIR			*/
 		{
 			z80_cc += cc_ed[0xb2];
 			INI(cpu);
 			if (0 != B) {
 				z80_cc += cc_ex[0xb2];
 				PC -= 2;
+				INXR(cpu, 0xb2);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb3:	/* OTIR			*/
+	OP(ed,0xb3):	/* OTIR			*/
 		{
 			z80_cc += cc_ed[0xb3];
 			OUTI(cpu);
 			if (0 != B) {
 				z80_cc += cc_ex[0xb3];
 				PC -= 2;
+				OTXR(cpu, 0xb3);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb8:	/* LDDR			*/
+	OP(ed,0xb8):	/* LDDR			*/
 		{
 			z80_cc += cc_ed[0xb8];
 			LDD(cpu);
@@ -5704,11 +8164,12 @@ fetch_ed_xx:
 				z80_cc += cc_ex[0xb8];
 				MP = PC - 1;
 				PC -= 2;
+				LDXR(cpu, 0xb8);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb9:	/* CPDR			*/
+	OP(ed,0xb9):	/* CPDR			*/
 		{
 			z80_cc += cc_ed[0xb9];
 			CPD(cpu);
@@ -5716,67 +8177,72 @@ fetch_ed_xx:
 				z80_cc += cc_ex[0xb9];
 				MP = PC - 1;
 				PC -= 2;
+				CPXR(cpu, 0xb9);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xba:	/* INDR			*/
+	OP(ed,0xba):	/* INDR			*/
 		{
 			z80_cc += cc_ed[0xba];
 			IND(cpu);
 			if (0 != B) {
 				z80_cc += cc_ex[0xba];
 				PC -= 2;
+				INXR(cpu, 0xba);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbb:	/* OTDR			*/
+	OP(ed,0xbb):	/* OTDR			*/
 		{
 			z80_cc += cc_ed[0xbb];
 			OUTD(cpu);
 			if (0 != B) {
 				z80_cc += cc_ex[0xbb];
 				PC -= 2;
+				OTXR(cpu, 0xbb);
 			}
 		}
-		break;
+		NEXT_OP;
 
-	default:
+	OP_DEFAULT(ed):
 		/* illegal ED xx opcode */
 		z80_cc += cc_ed[op];
 	}
-	if (z80_cc < cycles)
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 
 fetch_dd_xx:
 	op = RD_ARGB(cpu);
-	switch (op) {
+	DISPATCH(dd, op) {
 
-	case 0x09:	/* ADD	IX,BC		*/
+	OP(dd,0x09):	/* ADD	IX,BC		*/
 		{
 			z80_cc += cc_xy[0x09];
 			IX = ADD16(cpu, dIX, dBC);
 		}
-		break;
+		NEXT_OP;
 
 
-	case 0x19:	/* ADD	IX,DE		*/
+	OP(dd,0x19):	/* ADD	IX,DE		*/
 		{
 			z80_cc += cc_xy[0x19];
 			IX = ADD16(cpu, dIX, dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x21:	/* LD	IX,nnnn		*/
+	OP(dd,0x21):	/* LD	IX,nnnn		*/
 		{
 			z80_cc += cc_xy[0x21];
 			IX = RD_ARGW(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x22:	/* LD	(nnnn),IX	*/
+	OP(dd,0x22):	/* LD	(nnnn),IX	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_xy[0x22];
@@ -5784,44 +8250,44 @@ fetch_dd_xx:
 			MP++;
 			WR_MEM(dMP, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x23:	/* INC	IX		*/
+	OP(dd,0x23):	/* INC	IX		*/
 		{
 			z80_cc += cc_xy[0x23];
 			IX++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x24:	/* INC	HX		*/
+	OP(dd,0x24):	/* INC	HX		*/
 		{
 			z80_cc += cc_xy[0x24];
 			HX = INC(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x25:	/* DEC	HX		*/
+	OP(dd,0x25):	/* DEC	HX		*/
 		{
 			z80_cc += cc_xy[0x25];
 			HX = DEC(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x26:	/* LD	HX,nn		*/
+	OP(dd,0x26):	/* LD	HX,nn		*/
 		{
 			z80_cc += cc_xy[0x26];
 			HX = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x29:	/* ADD	IX,IX		*/
+	OP(dd,0x29):	/* ADD	IX,IX		*/
 		{
 			z80_cc += cc_xy[0x29];
 			IX = ADD16(cpu, dIX, dIX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2a:	/* LD	IX,(nnnn)	*/
+	OP(dd,0x2a):	/* LD	IX,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_xy[0x2a];
@@ -5829,549 +8295,549 @@ fetch_dd_xx:
 			MP++;
 			HX = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2b:	/* DEC	IX		*/
+	OP(dd,0x2b):	/* DEC	IX		*/
 		{
 			z80_cc += cc_xy[0x2b];
 			IX--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2c:	/* INC	LX		*/
+	OP(dd,0x2c):	/* INC	LX		*/
 		{
 			z80_cc += cc_xy[0x2c];
 			LX = INC(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2d:	/* DEC	LX		*/
+	OP(dd,0x2d):	/* DEC	LX		*/
 		{
 			z80_cc += cc_xy[0x2d];
 			LX = DEC(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2e:	/* LD	LX,nn		*/
+	OP(dd,0x2e):	/* LD	LX,nn		*/
 		{
 			z80_cc += cc_xy[0x2e];
 			LX = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x34:	/* INC	(IX+rel)	*/
+	OP(dd,0x34):	/* INC	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x34];
 			WR_MEM(dEA, INC(cpu, RD_MEM(dEA)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x35:	/* DEC	(IX+rel)	*/
+	OP(dd,0x35):	/* DEC	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x35];
 			WR_MEM(dEA, DEC(cpu, RD_MEM(dEA)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x36:	/* LD	(IX+rel),nn	*/
+	OP(dd,0x36):	/* LD	(IX+rel),nn	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x36];
 			WR_MEM(dEA, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x39:	/* ADD	IX,SP		*/
+	OP(dd,0x39):	/* ADD	IX,SP		*/
 		{
 			z80_cc += cc_xy[0x39];
 			IX = ADD16(cpu, dIX, dSP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x44:	/* LD	B,HX		*/
+	OP(dd,0x44):	/* LD	B,HX		*/
 		{
 			z80_cc += cc_xy[0x44];
 			B = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x45:	/* LD	B,LX		*/
+	OP(dd,0x45):	/* LD	B,LX		*/
 		{
 			z80_cc += cc_xy[0x45];
 			B = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x46:	/* LD	B,(IX+rel)	*/
+	OP(dd,0x46):	/* LD	B,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x46];
 			B = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4c:	/* LD	C,HX		*/
+	OP(dd,0x4c):	/* LD	C,HX		*/
 		{
 			z80_cc += cc_xy[0x4c];
 			C = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4d:	/* LD	C,LX		*/
+	OP(dd,0x4d):	/* LD	C,LX		*/
 		{
 			z80_cc += cc_xy[0x4d];
 			C = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4e:	/* LD	C,(IX+rel)	*/
+	OP(dd,0x4e):	/* LD	C,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x4e];
 			C = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x54:	/* LD	D,HX		*/
+	OP(dd,0x54):	/* LD	D,HX		*/
 		{
 			z80_cc += cc_xy[0x54];
 			D = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x55:	/* LD	D,LX		*/
+	OP(dd,0x55):	/* LD	D,LX		*/
 		{
 			z80_cc += cc_xy[0x55];
 			D = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x56:	/* LD	D,(IX+rel)	*/
+	OP(dd,0x56):	/* LD	D,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x56];
 			D = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5c:	/* LD	E,HX		*/
+	OP(dd,0x5c):	/* LD	E,HX		*/
 		{
 			z80_cc += cc_xy[0x5c];
 			E = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5d:	/* LD	E,LX		*/
+	OP(dd,0x5d):	/* LD	E,LX		*/
 		{
 			z80_cc += cc_xy[0x5d];
 			E = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5e:	/* LD	E,(IX+rel)	*/
+	OP(dd,0x5e):	/* LD	E,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x5e];
 			E = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* LD	HX,B		*/
+	OP(dd,0x60):	/* LD	HX,B		*/
 		{
 			z80_cc += cc_xy[0x60];
 			HX = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x61:	/* LD	HX,C		*/
+	OP(dd,0x61):	/* LD	HX,C		*/
 		{
 			z80_cc += cc_xy[0x61];
 			HX = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x62:	/* LD	HX,D		*/
+	OP(dd,0x62):	/* LD	HX,D		*/
 		{
 			z80_cc += cc_xy[0x62];
 			HX = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x63:	/* LD	HX,E		*/
+	OP(dd,0x63):	/* LD	HX,E		*/
 		{
 			z80_cc += cc_xy[0x63];
 			HX = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x64:	/* LD	HX,HX		*/
+	OP(dd,0x64):	/* LD	HX,HX		*/
 		{
 			z80_cc += cc_xy[0x64];
 			HX = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x65:	/* LD	HX,LX		*/
+	OP(dd,0x65):	/* LD	HX,LX		*/
 		{
 			z80_cc += cc_xy[0x65];
 			HX = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x66:	/* LD	H,(IX+rel)	*/
+	OP(dd,0x66):	/* LD	H,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x66];
 			H = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x67:	/* LD	HX,A		*/
+	OP(dd,0x67):	/* LD	HX,A		*/
 		{
 			z80_cc += cc_xy[0x67];
 			HX = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* LD	LX,B		*/
+	OP(dd,0x68):	/* LD	LX,B		*/
 		{
 			z80_cc += cc_xy[0x68];
 			LX = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x69:	/* LD	LX,C		*/
+	OP(dd,0x69):	/* LD	LX,C		*/
 		{
 			z80_cc += cc_xy[0x69];
 			LX = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6a:	/* LD	LX,D		*/
+	OP(dd,0x6a):	/* LD	LX,D		*/
 		{
 			z80_cc += cc_xy[0x6a];
 			LX = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6b:	/* LD	LX,E		*/
+	OP(dd,0x6b):	/* LD	LX,E		*/
 		{
 			z80_cc += cc_xy[0x6b];
 			LX = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6c:	/* LD	LX,HX		*/
+	OP(dd,0x6c):	/* LD	LX,HX		*/
 		{
 			z80_cc += cc_xy[0x6c];
 			LX = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6d:	/* LD	LX,LX		*/
+	OP(dd,0x6d):	/* LD	LX,LX		*/
 		{
 			z80_cc += cc_xy[0x6d];
 			LX = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6e:	/* LD	L,(IX+rel)	*/
+	OP(dd,0x6e):	/* LD	L,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x6e];
 			L = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6f:	/* LD	LX,A		*/
+	OP(dd,0x6f):	/* LD	LX,A		*/
 		{
 			z80_cc += cc_xy[0x6f];
 			LX = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* LD	(IX+rel),B	*/
+	OP(dd,0x70):	/* LD	(IX+rel),B	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x70];
 			WR_MEM(dEA, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x71:	/* LD	(IX+rel),C	*/
+	OP(dd,0x71):	/* LD	(IX+rel),C	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x71];
 			WR_MEM(dEA, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x72:	/* LD	(IX+rel),D	*/
+	OP(dd,0x72):	/* LD	(IX+rel),D	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x72];
 			WR_MEM(dEA, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x73:	/* LD	(IX+rel),E	*/
+	OP(dd,0x73):	/* LD	(IX+rel),E	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x73];
 			WR_MEM(dEA, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x74:	/* LD	(IX+rel),H	*/
+	OP(dd,0x74):	/* LD	(IX+rel),H	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x74];
 			WR_MEM(dEA, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x75:	/* LD	(IX+rel),L	*/
+	OP(dd,0x75):	/* LD	(IX+rel),L	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x75];
 			WR_MEM(dEA, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x77:	/* LD	(IX+rel),A	*/
+	OP(dd,0x77):	/* LD	(IX+rel),A	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x77];
 			WR_MEM(dEA, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7c:	/* LD	A,HX		*/
+	OP(dd,0x7c):	/* LD	A,HX		*/
 		{
 			z80_cc += cc_xy[0x7c];
 			A = HX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7d:	/* LD	A,LX		*/
+	OP(dd,0x7d):	/* LD	A,LX		*/
 		{
 			z80_cc += cc_xy[0x7d];
 			A = LX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7e:	/* LD	A,(IX+rel)	*/
+	OP(dd,0x7e):	/* LD	A,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x7e];
 			A = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x84:	/* ADD	A,HX		*/
+	OP(dd,0x84):	/* ADD	A,HX		*/
 		{
 			z80_cc += cc_xy[0x84];
 			A = ADD(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x85:	/* ADD	A,LX		*/
+	OP(dd,0x85):	/* ADD	A,LX		*/
 		{
 			z80_cc += cc_xy[0x85];
 			A = ADD(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x86:	/* ADD	A,(IX+rel)	*/
+	OP(dd,0x86):	/* ADD	A,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x86];
 			A = ADD(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8c:	/* ADC	A,HX		*/
+	OP(dd,0x8c):	/* ADC	A,HX		*/
 		{
 			z80_cc += cc_xy[0x8c];
 			A = ADC(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8d:	/* ADC	A,LX		*/
+	OP(dd,0x8d):	/* ADC	A,LX		*/
 		{
 			z80_cc += cc_xy[0x8d];
 			A = ADC(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8e:	/* ADC	A,(IX+rel)	*/
+	OP(dd,0x8e):	/* ADC	A,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x8e];
 			A = ADC(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x94:	/* SUB	HX		*/
+	OP(dd,0x94):	/* SUB	HX		*/
 		{
 			z80_cc += cc_xy[0x94];
 			A = SUB(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x95:	/* SUB	LX		*/
+	OP(dd,0x95):	/* SUB	LX		*/
 		{
 			z80_cc += cc_xy[0x95];
 			A = SUB(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x96:	/* SUB	(IX+rel)	*/
+	OP(dd,0x96):	/* SUB	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x96];
 			A = SUB(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9c:	/* SBC	A,HX		*/
+	OP(dd,0x9c):	/* SBC	A,HX		*/
 		{
 			z80_cc += cc_xy[0x9c];
 			A = SBC(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9d:	/* SBC	A,LX		*/
+	OP(dd,0x9d):	/* SBC	A,LX		*/
 		{
 			z80_cc += cc_xy[0x9d];
 			A = SBC(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9e:	/* SBC	A,(IX+rel)	*/
+	OP(dd,0x9e):	/* SBC	A,(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0x9e];
 			A = SBC(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa4:	/* AND	HX		*/
+	OP(dd,0xa4):	/* AND	HX		*/
 		{
 			z80_cc += cc_xy[0xa4];
 			A = AND(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa5:	/* AND	LX		*/
+	OP(dd,0xa5):	/* AND	LX		*/
 		{
 			z80_cc += cc_xy[0xa5];
 			A = AND(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa6:	/* AND	(IX+rel)	*/
+	OP(dd,0xa6):	/* AND	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0xa6];
 			A = AND(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xac:	/* XOR	HX		*/
+	OP(dd,0xac):	/* XOR	HX		*/
 		{
 			z80_cc += cc_xy[0xac];
 			A = XOR(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xad:	/* XOR	LX		*/
+	OP(dd,0xad):	/* XOR	LX		*/
 		{
 			z80_cc += cc_xy[0xad];
 			A = XOR(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xae:	/* XOR	(IX+rel)	*/
+	OP(dd,0xae):	/* XOR	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0xae];
 			A = XOR(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb4:	/* OR	HX		*/
+	OP(dd,0xb4):	/* OR	HX		*/
 		{
 			z80_cc += cc_xy[0xb4];
 			A = OR(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb5:	/* OR	LX		*/
+	OP(dd,0xb5):	/* OR	LX		*/
 		{
 			z80_cc += cc_xy[0xb5];
 			A = OR(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb6:	/* OR	(IX+rel)	*/
+	OP(dd,0xb6):	/* OR	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0xb6];
 			A = OR(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbc:	/* CP	HX		*/
+	OP(dd,0xbc):	/* CP	HX		*/
 		{
 			z80_cc += cc_xy[0xbc];
 			CP(cpu, HX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbd:	/* CP	LX		*/
+	OP(dd,0xbd):	/* CP	LX		*/
 		{
 			z80_cc += cc_xy[0xbd];
 			CP(cpu, LX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbe:	/* CP	(IX+rel)	*/
+	OP(dd,0xbe):	/* CP	(IX+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IX + rel;
 			z80_cc += cc_xy[0xbe];
 			CP(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcb:	/* prefix DD CB xx 	*/
+	OP(dd,0xcb):	/* prefix DD CB xx 	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_xy[0xcb];
@@ -6379,26 +8845,26 @@ fetch_dd_xx:
 			m = RD_MEM(dEA);	
 			goto fetch_xy_cb_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdd:	/* prefix DD xx (IX)	*/
+	OP(dd,0xdd):	/* prefix DD xx (IX)	*/
 		{
 			z80_cc += cc_xy[0xdd];
-			if (z80_cc < cycles) {
+			if (z80_cc < SLICE_END) {
 				goto fetch_dd_xx;
 			}
 			PC--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe1:	/* POP	IX		*/
+	OP(dd,0xe1):	/* POP	IX		*/
 		{
 			z80_cc += cc_xy[0xe1];
 			POP(cpu, REG_IX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe3:	/* EX	(SP),IX		*/
+	OP(dd,0xe3):	/* EX	(SP),IX		*/
 		{
 			z80_cc += cc_xy[0xe3];
 			MPL = RD_MEM(dSP);
@@ -6410,83 +8876,85 @@ fetch_dd_xx:
 			SP--;
 			HX = MPH;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe5:	/* PUSH	IX		*/
+	OP(dd,0xe5):	/* PUSH	IX		*/
 		{
 			z80_cc += cc_xy[0xe5];
 			PUSH(cpu, REG_IX);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe9:	/* JP	(IX)		*/
+	OP(dd,0xe9):	/* JP	(IX)		*/
 		{
 			z80_cc += cc_xy[0xe9];
 			PC = IX;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xed:	/* prefix ED xx		*/
+	OP(dd,0xed):	/* prefix ED xx		*/
 		{
 			z80_cc += cc_xy[0xed];
 			goto fetch_ed_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf9:	/* LD	SP,IX */
+	OP(dd,0xf9):	/* LD	SP,IX */
 		{
 			z80_cc += cc_xy[0xf9];
 			SP = IX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfd:	/* prefix FD xx (IY)	*/
+	OP(dd,0xfd):	/* prefix FD xx (IY)	*/
 		{
 			z80_cc += cc_xy[0xfd];
-			if (z80_cc < cycles) {
+			if (z80_cc < SLICE_END) {
 				goto fetch_fd_xx;
 			}
 			PC--;
 		}
-		break;
+		NEXT_OP;
 
-	default:	/* ignore DD prefix */
+	OP_DEFAULT(dd):	/* ignore DD prefix */
 		z80_cc += cc_xy[op];
 		goto decode_xx;
 	}
-	if (z80_cc < cycles)
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 
 
 fetch_fd_xx:
 	op = RD_ARGB(cpu);
-	switch (op) {
+	DISPATCH(fd, op) {
 
-	case 0x09:	/* ADD	IY,BC		*/
+	OP(fd,0x09):	/* ADD	IY,BC		*/
 		{
 			z80_cc += cc_xy[0x09];
 			IY = ADD16(cpu, dIY, dBC);
 		}
-		break;
+		NEXT_OP;
 
 
-	case 0x19:	/* ADD	IY,DE		*/
+	OP(fd,0x19):	/* ADD	IY,DE		*/
 		{
 			z80_cc += cc_xy[0x19];
 			IY = ADD16(cpu, dIY, dDE);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x21:	/* LD	IY,nnnn		*/
+	OP(fd,0x21):	/* LD	IY,nnnn		*/
 		{
 			z80_cc += cc_xy[0x21];
 			IY = RD_ARGW(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x22:	/* LD	(nnnn),IY	*/
+	OP(fd,0x22):	/* LD	(nnnn),IY	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_xy[0x22];
@@ -6494,44 +8962,44 @@ fetch_fd_xx:
 			MP++;
 			WR_MEM(dMP, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x23:	/* INC	IY		*/
+	OP(fd,0x23):	/* INC	IY		*/
 		{
 			z80_cc += cc_xy[0x23];
 			IY++;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x24:	/* INC	HY		*/
+	OP(fd,0x24):	/* INC	HY		*/
 		{
 			z80_cc += cc_xy[0x24];
 			HY = INC(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x25:	/* DEC	HY		*/
+	OP(fd,0x25):	/* DEC	HY		*/
 		{
 			z80_cc += cc_xy[0x25];
 			HY = DEC(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x26:	/* LD	HY,nn		*/
+	OP(fd,0x26):	/* LD	HY,nn		*/
 		{
 			z80_cc += cc_xy[0x26];
 			HY = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x29:	/* ADD	IY,IY		*/
+	OP(fd,0x29):	/* ADD	IY,IY		*/
 		{
 			z80_cc += cc_xy[0x29];
 			IY = ADD16(cpu, dIY, dIY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2a:	/* LD	IY,(nnnn)	*/
+	OP(fd,0x2a):	/* LD	IY,(nnnn)	*/
 		{
 			MP = RD_ARGW(cpu);
 			z80_cc += cc_xy[0x2a];
@@ -6539,549 +9007,549 @@ fetch_fd_xx:
 			MP++;
 			HY = RD_MEM(dMP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2b:	/* DEC	IY		*/
+	OP(fd,0x2b):	/* DEC	IY		*/
 		{
 			z80_cc += cc_xy[0x2b];
 			IY--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2c:	/* INC	LY		*/
+	OP(fd,0x2c):	/* INC	LY		*/
 		{
 			z80_cc += cc_xy[0x2c];
 			LY = INC(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2d:	/* DEC	LY		*/
+	OP(fd,0x2d):	/* DEC	LY		*/
 		{
 			z80_cc += cc_xy[0x2d];
 			LY = DEC(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2e:	/* LD	LY,nn		*/
+	OP(fd,0x2e):	/* LD	LY,nn		*/
 		{
 			z80_cc += cc_xy[0x2e];
 			LY = RD_ARGB(cpu);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x34:	/* INC	(IY+rel)	*/
+	OP(fd,0x34):	/* INC	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x34];
 			WR_MEM(dEA, INC(cpu, RD_MEM(dEA)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x35:	/* DEC	(IY+rel)	*/
+	OP(fd,0x35):	/* DEC	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x35];
 			WR_MEM(dEA, DEC(cpu, RD_MEM(dEA)));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x36:	/* LD	(IY+rel),nn	*/
+	OP(fd,0x36):	/* LD	(IY+rel),nn	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x36];
 			WR_MEM(dEA, RD_ARGB(cpu));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x39:	/* ADD	IY,SP		*/
+	OP(fd,0x39):	/* ADD	IY,SP		*/
 		{
 			z80_cc += cc_xy[0x39];
 			IY = ADD16(cpu, dIY, dSP);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x44:	/* LD	B,HY		*/
+	OP(fd,0x44):	/* LD	B,HY		*/
 		{
 			z80_cc += cc_xy[0x44];
 			B = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x45:	/* LD	B,LY		*/
+	OP(fd,0x45):	/* LD	B,LY		*/
 		{
 			z80_cc += cc_xy[0x45];
 			B = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x46:	/* LD	B,(IY+rel)	*/
+	OP(fd,0x46):	/* LD	B,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x46];
 			B = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4c:	/* LD	C,HY		*/
+	OP(fd,0x4c):	/* LD	C,HY		*/
 		{
 			z80_cc += cc_xy[0x4c];
 			C = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4d:	/* LD	C,LY		*/
+	OP(fd,0x4d):	/* LD	C,LY		*/
 		{
 			z80_cc += cc_xy[0x4d];
 			C = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x4e:	/* LD	C,(IY+rel)	*/
+	OP(fd,0x4e):	/* LD	C,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x4e];
 			C = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x54:	/* LD	D,HY		*/
+	OP(fd,0x54):	/* LD	D,HY		*/
 		{
 			z80_cc += cc_xy[0x54];
 			D = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x55:	/* LD	D,LY		*/
+	OP(fd,0x55):	/* LD	D,LY		*/
 		{
 			z80_cc += cc_xy[0x55];
 			D = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x56:	/* LD	D,(IY+rel)	*/
+	OP(fd,0x56):	/* LD	D,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x56];
 			D = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5c:	/* LD	E,HY		*/
+	OP(fd,0x5c):	/* LD	E,HY		*/
 		{
 			z80_cc += cc_xy[0x5c];
 			E = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5d:	/* LD	E,LY		*/
+	OP(fd,0x5d):	/* LD	E,LY		*/
 		{
 			z80_cc += cc_xy[0x5d];
 			E = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x5e:	/* LD	E,(IY+rel)	*/
+	OP(fd,0x5e):	/* LD	E,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x5e];
 			E = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* LD	HY,B		*/
+	OP(fd,0x60):	/* LD	HY,B		*/
 		{
 			z80_cc += cc_xy[0x60];
 			HY = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x61:	/* LD	HY,C		*/
+	OP(fd,0x61):	/* LD	HY,C		*/
 		{
 			z80_cc += cc_xy[0x61];
 			HY = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x62:	/* LD	HY,D		*/
+	OP(fd,0x62):	/* LD	HY,D		*/
 		{
 			z80_cc += cc_xy[0x62];
 			HY = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x63:	/* LD	HY,E		*/
+	OP(fd,0x63):	/* LD	HY,E		*/
 		{
 			z80_cc += cc_xy[0x63];
 			HY = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x64:	/* LD	HY,HY		*/
+	OP(fd,0x64):	/* LD	HY,HY		*/
 		{
 			z80_cc += cc_xy[0x64];
 			HY = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x65:	/* LD	HY,LY		*/
+	OP(fd,0x65):	/* LD	HY,LY		*/
 		{
 			z80_cc += cc_xy[0x65];
 			HY = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x66:	/* LD	H,(IY+rel)	*/
+	OP(fd,0x66):	/* LD	H,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x66];
 			H = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x67:	/* LD	HY,A		*/
+	OP(fd,0x67):	/* LD	HY,A		*/
 		{
 			z80_cc += cc_xy[0x67];
 			HY = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* LD	LY,B		*/
+	OP(fd,0x68):	/* LD	LY,B		*/
 		{
 			z80_cc += cc_xy[0x68];
 			LY = B;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x69:	/* LD	LY,C		*/
+	OP(fd,0x69):	/* LD	LY,C		*/
 		{
 			z80_cc += cc_xy[0x69];
 			LY = C;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6a:	/* LD	LY,D		*/
+	OP(fd,0x6a):	/* LD	LY,D		*/
 		{
 			z80_cc += cc_xy[0x6a];
 			LY = D;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6b:	/* LD	LY,E		*/
+	OP(fd,0x6b):	/* LD	LY,E		*/
 		{
 			z80_cc += cc_xy[0x6b];
 			LY = E;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6c:	/* LD	LY,HY		*/
+	OP(fd,0x6c):	/* LD	LY,HY		*/
 		{
 			z80_cc += cc_xy[0x6c];
 			LY = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6d:	/* LD	LY,LY		*/
+	OP(fd,0x6d):	/* LD	LY,LY		*/
 		{
 			z80_cc += cc_xy[0x6d];
 			LY = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6e:	/* LD	L,(IY+rel)	*/
+	OP(fd,0x6e):	/* LD	L,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x6e];
 			L = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x6f:	/* LD	LY,A		*/
+	OP(fd,0x6f):	/* LD	LY,A		*/
 		{
 			z80_cc += cc_xy[0x6f];
 			LY = A;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* LD	(IY+rel),B	*/
+	OP(fd,0x70):	/* LD	(IY+rel),B	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x70];
 			WR_MEM(dEA, B);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x71:	/* LD	(IY+rel),C	*/
+	OP(fd,0x71):	/* LD	(IY+rel),C	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x71];
 			WR_MEM(dEA, C);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x72:	/* LD	(IY+rel),D	*/
+	OP(fd,0x72):	/* LD	(IY+rel),D	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x72];
 			WR_MEM(dEA, D);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x73:	/* LD	(IY+rel),E	*/
+	OP(fd,0x73):	/* LD	(IY+rel),E	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x73];
 			WR_MEM(dEA, E);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x74:	/* LD	(IY+rel),H	*/
+	OP(fd,0x74):	/* LD	(IY+rel),H	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x74];
 			WR_MEM(dEA, H);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x75:	/* LD	(IY+rel),L	*/
+	OP(fd,0x75):	/* LD	(IY+rel),L	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x75];
 			WR_MEM(dEA, L);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x77:	/* LD	(IY+rel),A	*/
+	OP(fd,0x77):	/* LD	(IY+rel),A	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x77];
 			WR_MEM(dEA, A);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7c:	/* LD	A,HY		*/
+	OP(fd,0x7c):	/* LD	A,HY		*/
 		{
 			z80_cc += cc_xy[0x7c];
 			A = HY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7d:	/* LD	A,LY		*/
+	OP(fd,0x7d):	/* LD	A,LY		*/
 		{
 			z80_cc += cc_xy[0x7d];
 			A = LY;
 		}
-		break;
+		NEXT_OP;
 
-	case 0x7e:	/* LD	A,(IY+rel)	*/
+	OP(fd,0x7e):	/* LD	A,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x7e];
 			A = RD_MEM(dEA);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x84:	/* ADD	A,HY		*/
+	OP(fd,0x84):	/* ADD	A,HY		*/
 		{
 			z80_cc += cc_xy[0x84];
 			A = ADD(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x85:	/* ADD	A,LY		*/
+	OP(fd,0x85):	/* ADD	A,LY		*/
 		{
 			z80_cc += cc_xy[0x85];
 			A = ADD(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x86:	/* ADD	A,(IY+rel)	*/
+	OP(fd,0x86):	/* ADD	A,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x86];
 			A = ADD(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8c:	/* ADC	A,HY		*/
+	OP(fd,0x8c):	/* ADC	A,HY		*/
 		{
 			z80_cc += cc_xy[0x8c];
 			A = ADC(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8d:	/* ADC	A,LY		*/
+	OP(fd,0x8d):	/* ADC	A,LY		*/
 		{
 			z80_cc += cc_xy[0x8d];
 			A = ADC(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8e:	/* ADC	A,(IY+rel)	*/
+	OP(fd,0x8e):	/* ADC	A,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x8e];
 			A = ADC(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x94:	/* SUB	HY		*/
+	OP(fd,0x94):	/* SUB	HY		*/
 		{
 			z80_cc += cc_xy[0x94];
 			A = SUB(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x95:	/* SUB	LY		*/
+	OP(fd,0x95):	/* SUB	LY		*/
 		{
 			z80_cc += cc_xy[0x95];
 			A = SUB(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x96:	/* SUB	(IY+rel)	*/
+	OP(fd,0x96):	/* SUB	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x96];
 			A = SUB(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9c:	/* SBC	A,HY		*/
+	OP(fd,0x9c):	/* SBC	A,HY		*/
 		{
 			z80_cc += cc_xy[0x9c];
 			A = SBC(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9d:	/* SBC	A,LY		*/
+	OP(fd,0x9d):	/* SBC	A,LY		*/
 		{
 			z80_cc += cc_xy[0x9d];
 			A = SBC(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9e:	/* SBC	A,(IY+rel)	*/
+	OP(fd,0x9e):	/* SBC	A,(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0x9e];
 			A = SBC(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa4:	/* AND	HY		*/
+	OP(fd,0xa4):	/* AND	HY		*/
 		{
 			z80_cc += cc_xy[0xa4];
 			A = AND(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa5:	/* AND	LY		*/
+	OP(fd,0xa5):	/* AND	LY		*/
 		{
 			z80_cc += cc_xy[0xa5];
 			A = AND(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa6:	/* AND	(IY+rel)	*/
+	OP(fd,0xa6):	/* AND	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0xa6];
 			A = AND(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xac:	/* XOR	HY		*/
+	OP(fd,0xac):	/* XOR	HY		*/
 		{
 			z80_cc += cc_xy[0xac];
 			A = XOR(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xad:	/* XOR	LY		*/
+	OP(fd,0xad):	/* XOR	LY		*/
 		{
 			z80_cc += cc_xy[0xad];
 			A = XOR(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xae:	/* XOR	(IY+rel)	*/
+	OP(fd,0xae):	/* XOR	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0xae];
 			A = XOR(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb4:	/* OR	HY		*/
+	OP(fd,0xb4):	/* OR	HY		*/
 		{
 			z80_cc += cc_xy[0xb4];
 			A = OR(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb5:	/* OR	LY		*/
+	OP(fd,0xb5):	/* OR	LY		*/
 		{
 			z80_cc += cc_xy[0xb5];
 			A = OR(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb6:	/* OR	(IY+rel)	*/
+	OP(fd,0xb6):	/* OR	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0xb6];
 			A = OR(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbc:	/* CP	HY		*/
+	OP(fd,0xbc):	/* CP	HY		*/
 		{
 			z80_cc += cc_xy[0xbc];
 			CP(cpu, HY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbd:	/* CP	LY		*/
+	OP(fd,0xbd):	/* CP	LY		*/
 		{
 			z80_cc += cc_xy[0xbd];
 			CP(cpu, LY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbe:	/* CP	(IY+rel)	*/
+	OP(fd,0xbe):	/* CP	(IY+rel)	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			MP = EA = IY + rel;
 			z80_cc += cc_xy[0xbe];
 			CP(cpu, RD_MEM(dEA));
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcb:	/* prefix FD CB xx 	*/
+	OP(fd,0xcb):	/* prefix FD CB xx 	*/
 		{
 			int8_t rel = RD_ARGB(cpu);
 			z80_cc += cc_xy[0xcb];
@@ -7089,26 +9557,26 @@ fetch_fd_xx:
 			m = RD_MEM(dEA);	
 			goto fetch_xy_cb_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdd:	/* prefix DD xx (IX)	*/
+	OP(fd,0xdd):	/* prefix DD xx (IX)	*/
 		{
 			z80_cc += cc_xy[0xdd];
-			if (z80_cc < cycles) {
+			if (z80_cc < SLICE_END) {
 				goto fetch_dd_xx;
 			}
 			PC--;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe1:	/* POP	IY		*/
+	OP(fd,0xe1):	/* POP	IY		*/
 		{
 			z80_cc += cc_xy[0xe1];
 			POP(cpu, REG_IY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe3:	/* EX	(SP),IY		*/
+	OP(fd,0xe3):	/* EX	(SP),IY		*/
 		{
 			z80_cc += cc_xy[0xe3];
 			MPL = RD_MEM(dSP);
@@ -7120,1709 +9588,1720 @@ fetch_fd_xx:
 			SP--;
 			HY = MPH;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe5:	/* PUSH	IY		*/
+	OP(fd,0xe5):	/* PUSH	IY		*/
 		{
 			z80_cc += cc_xy[0xe5];
 			PUSH(cpu, REG_IY);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe9:	/* JP	(IY)		*/
+	OP(fd,0xe9):	/* JP	(IY)		*/
 		{
 			z80_cc += cc_xy[0xe9];
 			PC = IY;
 			change_pc(dPC);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xed:	/* prefix ED xx		*/
+	OP(fd,0xed):	/* prefix ED xx		*/
 		{
 			z80_cc += cc_xy[0xed];
 			goto fetch_ed_xx;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf9:	/* LD	SP,IY */
+	OP(fd,0xf9):	/* LD	SP,IY */
 		{
 			z80_cc += cc_xy[0xf9];
 			SP = IX;
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfd:	/* prefix FD xx (IY)	*/
+	OP(fd,0xfd):	/* prefix FD xx (IY)	*/
 		{
 			z80_cc += cc_xy[0xfd];
-			if (z80_cc < cycles) {
+			if (z80_cc < SLICE_END) {
 				goto fetch_fd_xx;
 			}
 			PC--;
 		}
-		break;
+		NEXT_OP;
 
-	default:	/* ignore FD prefix */
+	OP_DEFAULT(fd):	/* ignore FD prefix */
 		z80_cc += cc_xy[op];
 		goto decode_xx;
 	}
-	if (z80_cc < cycles)
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 
 fetch_xy_cb_xx:
 	op = RD_OP(cpu);
-	switch (op) {
-	case 0x00:	/* RLC	B=(IX/Y+rel)	*/
+	DISPATCH(xycb, op) {
+	OP(xycb,0x00):	/* RLC	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x00];
 			B = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x01:	/* RLC	C=(IX/Y+rel)	*/
+	OP(xycb,0x01):	/* RLC	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x01];
 			C = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x02:	/* RLC	D=(IX/Y+rel)	*/
+	OP(xycb,0x02):	/* RLC	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x02];
 			D = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x03:	/* RLC	E=(IX/Y+rel)	*/
+	OP(xycb,0x03):	/* RLC	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x03];
 			E = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x04:	/* RLC	H=(IX/Y+rel)	*/
+	OP(xycb,0x04):	/* RLC	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x04];
 			H = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x05:	/* RLC	L=(IX/Y+rel)	*/
+	OP(xycb,0x05):	/* RLC	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x05];
 			L = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x06:	/* RLC	(IX/Y+rel)	*/
+	OP(xycb,0x06):	/* RLC	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x06];
 			m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x07:	/* RLC	A=(IX/Y+rel)	*/
+	OP(xycb,0x07):	/* RLC	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x07];
 			A = m = RLC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x08:	/* RRC	B=(IX/Y+rel)	*/
+	OP(xycb,0x08):	/* RRC	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x08];
 			B = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x09:	/* RRC	C=(IX/Y+rel)	*/
+	OP(xycb,0x09):	/* RRC	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x09];
 			C = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0a:	/* RRC	D=(IX/Y+rel)	*/
+	OP(xycb,0x0a):	/* RRC	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0a];
 			D = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0b:	/* RRC	E=(IX/Y+rel)	*/
+	OP(xycb,0x0b):	/* RRC	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0b];
 			E = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0c:	/* RRC	H=(IX/Y+rel)	*/
+	OP(xycb,0x0c):	/* RRC	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0c];
 			H = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0d:	/* RRC	L=(IX/Y+rel)	*/
+	OP(xycb,0x0d):	/* RRC	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0d];
 			L = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0e:	/* RRC	(IX/Y+rel)	*/
+	OP(xycb,0x0e):	/* RRC	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0e];
 			m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x0f:	/* RRC	A=(IX/Y+rel)	*/
+	OP(xycb,0x0f):	/* RRC	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x0f];
 			A = m = RRC(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x10:	/* RL	B=(IX/Y+rel)	*/
+	OP(xycb,0x10):	/* RL	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x10];
 			B = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x11:	/* RL	C=(IX/Y+rel)	*/
+	OP(xycb,0x11):	/* RL	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x11];
 			C = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x12:	/* RL	D=(IX/Y+rel)	*/
+	OP(xycb,0x12):	/* RL	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x12];
 			D = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x13:	/* RL	E=(IX/Y+rel)	*/
+	OP(xycb,0x13):	/* RL	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x13];
 			E = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x14:	/* RL	H=(IX/Y+rel)	*/
+	OP(xycb,0x14):	/* RL	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x14];
 			H = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x15:	/* RL	L=(IX/Y+rel)	*/
+	OP(xycb,0x15):	/* RL	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x15];
 			L = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x16:	/* RL	(IX/Y+rel)	*/
+	OP(xycb,0x16):	/* RL	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x16];
 			m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x17:	/* RL	A=(IX/Y+rel)	*/
+	OP(xycb,0x17):	/* RL	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x17];
 			A = m = RL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x18:	/* RR	B=(IX/Y+rel)	*/
+	OP(xycb,0x18):	/* RR	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x18];
 			B = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x19:	/* RR	C=(IX/Y+rel)	*/
+	OP(xycb,0x19):	/* RR	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x19];
 			C = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1a:	/* RR	D=(IX/Y+rel)	*/
+	OP(xycb,0x1a):	/* RR	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1a];
 			D = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1b:	/* RR	E=(IX/Y+rel)	*/
+	OP(xycb,0x1b):	/* RR	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1b];
 			E = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1c:	/* RR	H=(IX/Y+rel)	*/
+	OP(xycb,0x1c):	/* RR	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1c];
 			H = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1d:	/* RR	L=(IX/Y+rel)	*/
+	OP(xycb,0x1d):	/* RR	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1d];
 			L = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1e:	/* RR	(IX/Y+rel)	*/
+	OP(xycb,0x1e):	/* RR	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1e];
 			m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x1f:	/* RR	A=(IX/Y+rel)	*/
+	OP(xycb,0x1f):	/* RR	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x1f];
 			A = m = RR(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x20:	/* SLA	B=(IX/Y+rel)	*/
+	OP(xycb,0x20):	/* SLA	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x20];
 			B = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x21:	/* SLA	C=(IX/Y+rel)	*/
+	OP(xycb,0x21):	/* SLA	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x21];
 			C = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x22:	/* SLA	D=(IX/Y+rel)	*/
+	OP(xycb,0x22):	/* SLA	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x22];
 			D = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x23:	/* SLA	E=(IX/Y+rel)	*/
+	OP(xycb,0x23):	/* SLA	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x23];
 			E = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x24:	/* SLA	H=(IX/Y+rel)	*/
+	OP(xycb,0x24):	/* SLA	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x24];
 			H = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x25:	/* SLA	L=(IX/Y+rel)	*/
+	OP(xycb,0x25):	/* SLA	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x25];
 			L = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x26:	/* SLA	(IX/Y+rel)	*/
+	OP(xycb,0x26):	/* SLA	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x26];
 			m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x27:	/* SLA	A=(IX/Y+rel)	*/
+	OP(xycb,0x27):	/* SLA	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x27];
 			A = m = SLA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x28:	/* SRA	B=(IX/Y+rel)	*/
+	OP(xycb,0x28):	/* SRA	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x28];
 			B = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x29:	/* SRA	C=(IX/Y+rel)	*/
+	OP(xycb,0x29):	/* SRA	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x29];
 			C = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2a:	/* SRA	D=(IX/Y+rel)	*/
+	OP(xycb,0x2a):	/* SRA	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2a];
 			D = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2b:	/* SRA	E=(IX/Y+rel)	*/
+	OP(xycb,0x2b):	/* SRA	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2b];
 			E = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2c:	/* SRA	H=(IX/Y+rel)	*/
+	OP(xycb,0x2c):	/* SRA	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2c];
 			H = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2d:	/* SRA	L=(IX/Y+rel)	*/
+	OP(xycb,0x2d):	/* SRA	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2d];
 			L = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2e:	/* SRA	(IX/Y+rel)	*/
+	OP(xycb,0x2e):	/* SRA	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2e];
 			m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x2f:	/* SRA	A=(IX/Y+rel)	*/
+	OP(xycb,0x2f):	/* SRA	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x2f];
 			A = m = SRA(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x30:	/* SLL	B=(IX/Y+rel)	*/
+	OP(xycb,0x30):	/* SLL	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x30];
 			B = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x31:	/* SLL	C=(IX/Y+rel)	*/
+	OP(xycb,0x31):	/* SLL	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x31];
 			C = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x32:	/* SLL	D=(IX/Y+rel)	*/
+	OP(xycb,0x32):	/* SLL	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x32];
 			D = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x33:	/* SLL	E=(IX/Y+rel)	*/
+	OP(xycb,0x33):	/* SLL	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x33];
 			E = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x34:	/* SLL	H=(IX/Y+rel)	*/
+	OP(xycb,0x34):	/* SLL	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x34];
 			H = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x35:	/* SLL	L=(IX/Y+rel)	*/
+	OP(xycb,0x35):	/* SLL	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x35];
 			L = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x36:	/* SLL	(IX/Y+rel)	*/
+	OP(xycb,0x36):	/* SLL	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x36];
 			m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x37:	/* SLL	A=(IX/Y+rel)	*/
+	OP(xycb,0x37):	/* SLL	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x37];
 			A = m = SLL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x38:	/* SRL	B=(IX/Y+rel)	*/
+	OP(xycb,0x38):	/* SRL	B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x38];
 			B = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x39:	/* SRL	C=(IX/Y+rel)	*/
+	OP(xycb,0x39):	/* SRL	C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x39];
 			C = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3a:	/* SRL	D=(IX/Y+rel)	*/
+	OP(xycb,0x3a):	/* SRL	D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3a];
 			D = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3b:	/* SRL	E=(IX/Y+rel)	*/
+	OP(xycb,0x3b):	/* SRL	E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3b];
 			E = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3c:	/* SRL	H=(IX/Y+rel)	*/
+	OP(xycb,0x3c):	/* SRL	H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3c];
 			H = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3d:	/* SRL	L=(IX/Y+rel)	*/
+	OP(xycb,0x3d):	/* SRL	L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3d];
 			L = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3e:	/* SRL	(IX/Y+rel)	*/
+	OP(xycb,0x3e):	/* SRL	(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3e];
 			m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x3f:	/* SRL	A=(IX/Y+rel)	*/
+	OP(xycb,0x3f):	/* SRL	A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x3f];
 			A = m = SRL(cpu, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x40:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x41:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x42:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x43:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x44:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x45:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x46:	/* BIT	0,(IX/Y+rel)	*/
-	case 0x47:	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x40):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x41):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x42):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x43):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x44):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x45):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x46):	/* BIT	0,(IX/Y+rel)	*/
+	OP(xycb,0x47):	/* BIT	0,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x40];
 			BIT_XY(cpu, 0, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x48:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x49:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4a:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4b:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4c:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4d:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4e:	/* BIT	1,(IX/Y+rel)	*/
-	case 0x4f:	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x48):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x49):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4a):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4b):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4c):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4d):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4e):	/* BIT	1,(IX/Y+rel)	*/
+	OP(xycb,0x4f):	/* BIT	1,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x48];
 			BIT_XY(cpu, 1, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x50:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x51:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x52:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x53:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x54:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x55:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x56:	/* BIT	2,(IX/Y+rel)	*/
-	case 0x57:	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x50):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x51):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x52):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x53):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x54):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x55):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x56):	/* BIT	2,(IX/Y+rel)	*/
+	OP(xycb,0x57):	/* BIT	2,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x50];
 			BIT_XY(cpu, 2, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x58:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x59:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5a:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5b:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5c:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5d:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5e:	/* BIT	3,(IX/Y+rel)	*/
-	case 0x5f:	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x58):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x59):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5a):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5b):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5c):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5d):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5e):	/* BIT	3,(IX/Y+rel)	*/
+	OP(xycb,0x5f):	/* BIT	3,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x58];
 			BIT_XY(cpu, 3, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x60:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x61:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x62:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x63:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x64:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x65:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x66:	/* BIT	4,(IX/Y+rel)	*/
-	case 0x67:	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x60):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x61):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x62):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x63):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x64):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x65):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x66):	/* BIT	4,(IX/Y+rel)	*/
+	OP(xycb,0x67):	/* BIT	4,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x60];
 			BIT_XY(cpu, 4, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x68:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x69:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6a:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6b:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6c:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6d:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6e:	/* BIT	5,(IX/Y+rel)	*/
-	case 0x6f:	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x68):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x69):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6a):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6b):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6c):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6d):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6e):	/* BIT	5,(IX/Y+rel)	*/
+	OP(xycb,0x6f):	/* BIT	5,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x68];
 			BIT_XY(cpu, 5, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x70:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x71:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x72:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x73:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x74:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x75:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x76:	/* BIT	6,(IX/Y+rel)	*/
-	case 0x77:	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x70):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x71):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x72):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x73):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x74):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x75):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x76):	/* BIT	6,(IX/Y+rel)	*/
+	OP(xycb,0x77):	/* BIT	6,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x70];
 			BIT_XY(cpu, 6, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x78:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x79:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7a:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7b:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7c:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7d:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7e:	/* BIT	7,(IX/Y+rel)	*/
-	case 0x7f:	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x78):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x79):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7a):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7b):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7c):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7d):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7e):	/* BIT	7,(IX/Y+rel)	*/
+	OP(xycb,0x7f):	/* BIT	7,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x78];
 			BIT_XY(cpu, 7, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x80:	/* RES	0,B=(IX/Y+rel)	*/
+	OP(xycb,0x80):	/* RES	0,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x80];
 			B = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x81:	/* RES	0,C=(IX/Y+rel)	*/
+	OP(xycb,0x81):	/* RES	0,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x81];
 			C = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x82:	/* RES	0,D=(IX/Y+rel)	*/
+	OP(xycb,0x82):	/* RES	0,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x82];
 			D = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x83:	/* RES	0,E=(IX/Y+rel)	*/
+	OP(xycb,0x83):	/* RES	0,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x83];
 			E = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x84:	/* RES	0,H=(IX/Y+rel)	*/
+	OP(xycb,0x84):	/* RES	0,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x84];
 			H = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x85:	/* RES	0,L=(IX/Y+rel)	*/
+	OP(xycb,0x85):	/* RES	0,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x85];
 			L = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x86:	/* RES	0,(IX/Y+rel)	*/
+	OP(xycb,0x86):	/* RES	0,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x86];
 			m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x87:	/* RES	0,A=(IX/Y+rel)	*/
+	OP(xycb,0x87):	/* RES	0,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x87];
 			A = m = RES(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x88:	/* RES	1,B=(IX/Y+rel)	*/
+	OP(xycb,0x88):	/* RES	1,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x88];
 			B = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x89:	/* RES	1,C=(IX/Y+rel)	*/
+	OP(xycb,0x89):	/* RES	1,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x89];
 			C = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8a:	/* RES	1,D=(IX/Y+rel)	*/
+	OP(xycb,0x8a):	/* RES	1,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8a];
 			D = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8b:	/* RES	1,E=(IX/Y+rel)	*/
+	OP(xycb,0x8b):	/* RES	1,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8b];
 			E = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8c:	/* RES	1,H=(IX/Y+rel)	*/
+	OP(xycb,0x8c):	/* RES	1,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8c];
 			H = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8d:	/* RES	1,L=(IX/Y+rel)	*/
+	OP(xycb,0x8d):	/* RES	1,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8d];
 			L = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8e:	/* RES	1,(IX/Y+rel)	*/
+	OP(xycb,0x8e):	/* RES	1,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8e];
 			m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x8f:	/* RES	1,A=(IX/Y+rel)	*/
+	OP(xycb,0x8f):	/* RES	1,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x8f];
 			A = m = RES(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x90:	/* RES	2,B=(IX/Y+rel)	*/
+	OP(xycb,0x90):	/* RES	2,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x90];
 			B = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x91:	/* RES	2,C=(IX/Y+rel)	*/
+	OP(xycb,0x91):	/* RES	2,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x91];
 			C = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x92:	/* RES	2,D=(IX/Y+rel)	*/
+	OP(xycb,0x92):	/* RES	2,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x92];
 			D = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x93:	/* RES	2,E=(IX/Y+rel)	*/
+	OP(xycb,0x93):	/* RES	2,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x93];
 			E = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x94:	/* RES	2,H=(IX/Y+rel)	*/
+	OP(xycb,0x94):	/* RES	2,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x94];
 			H = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x95:	/* RES	2,L=(IX/Y+rel)	*/
+	OP(xycb,0x95):	/* RES	2,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x95];
 			L = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x96:	/* RES	2,(IX/Y+rel)	*/
+	OP(xycb,0x96):	/* RES	2,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x96];
 			m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x97:	/* RES	2,A=(IX/Y+rel)	*/
+	OP(xycb,0x97):	/* RES	2,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x97];
 			A = m = RES(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x98:	/* RES	3,B=(IX/Y+rel)	*/
+	OP(xycb,0x98):	/* RES	3,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x98];
 			B = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x99:	/* RES	3,C=(IX/Y+rel)	*/
+	OP(xycb,0x99):	/* RES	3,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x99];
 			C = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9a:	/* RES	3,D=(IX/Y+rel)	*/
+	OP(xycb,0x9a):	/* RES	3,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9a];
 			D = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9b:	/* RES	3,E=(IX/Y+rel)	*/
+	OP(xycb,0x9b):	/* RES	3,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9b];
 			E = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9c:	/* RES	3,H=(IX/Y+rel)	*/
+	OP(xycb,0x9c):	/* RES	3,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9c];
 			H = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9d:	/* RES	3,L=(IX/Y+rel)	*/
+	OP(xycb,0x9d):	/* RES	3,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9d];
 			L = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9e:	/* RES	3,(IX/Y+rel)	*/
+	OP(xycb,0x9e):	/* RES	3,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9e];
 			m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0x9f:	/* RES	3,A=(IX/Y+rel)	*/
+	OP(xycb,0x9f):	/* RES	3,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0x9f];
 			A = m = RES(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa0:	/* RES	4,B=(IX/Y+rel)	*/
+	OP(xycb,0xa0):	/* RES	4,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa0];
 			B = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa1:	/* RES	4,C=(IX/Y+rel)	*/
+	OP(xycb,0xa1):	/* RES	4,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa1];
 			C = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa2:	/* RES	4,D=(IX/Y+rel)	*/
+	OP(xycb,0xa2):	/* RES	4,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa2];
 			D = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa3:	/* RES	4,E=(IX/Y+rel)	*/
+	OP(xycb,0xa3):	/* RES	4,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa3];
 			E = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa4:	/* RES	4,H=(IX/Y+rel)	*/
+	OP(xycb,0xa4):	/* RES	4,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa4];
 			H = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa5:	/* RES	4,L=(IX/Y+rel)	*/
+	OP(xycb,0xa5):	/* RES	4,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa5];
 			L = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa6:	/* RES	4,(IX/Y+rel)	*/
+	OP(xycb,0xa6):	/* RES	4,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa6];
 			m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa7:	/* RES	4,A=(IX/Y+rel)	*/
+	OP(xycb,0xa7):	/* RES	4,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa7];
 			A = m = RES(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa8:	/* RES	5,B=(IX/Y+rel)	*/
+	OP(xycb,0xa8):	/* RES	5,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa8];
 			B = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xa9:	/* RES	5,C=(IX/Y+rel)	*/
+	OP(xycb,0xa9):	/* RES	5,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xa9];
 			C = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaa:	/* RES	5,D=(IX/Y+rel)	*/
+	OP(xycb,0xaa):	/* RES	5,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xaa];
 			D = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xab:	/* RES	5,E=(IX/Y+rel)	*/
+	OP(xycb,0xab):	/* RES	5,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xab];
 			E = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xac:	/* RES	5,H=(IX/Y+rel)	*/
+	OP(xycb,0xac):	/* RES	5,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xac];
 			H = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xad:	/* RES	5,L=(IX/Y+rel)	*/
+	OP(xycb,0xad):	/* RES	5,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xad];
 			L = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xae:	/* RES	5,(IX/Y+rel)	*/
+	OP(xycb,0xae):	/* RES	5,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xae];
 			m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xaf:	/* RES	5,A=(IX/Y+rel)	*/
+	OP(xycb,0xaf):	/* RES	5,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xaf];
 			A = m = RES(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb0:	/* RES	6,B=(IX/Y+rel)	*/
+	OP(xycb,0xb0):	/* RES	6,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb0];
 			B = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb1:	/* RES	6,C=(IX/Y+rel)	*/
+	OP(xycb,0xb1):	/* RES	6,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb1];
 			C = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb2:	/* RES	6,D=(IX/Y+rel)	*/
+	OP(xycb,0xb2):	/* RES	6,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb2];
 			D = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb3:	/* RES	6,E=(IX/Y+rel)	*/
+	OP(xycb,0xb3):	/* RES	6,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb3];
 			E = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb4:	/* RES	6,H=(IX/Y+rel)	*/
+	OP(xycb,0xb4):	/* RES	6,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb4];
 			H = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb5:	/* RES	6,L=(IX/Y+rel)	*/
+	OP(xycb,0xb5):	/* RES	6,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb5];
 			L = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb6:	/* RES	6,(IX/Y+rel)	*/
+	OP(xycb,0xb6):	/* RES	6,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb6];
 			m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb7:	/* RES	6,A=(IX/Y+rel)	*/
+	OP(xycb,0xb7):	/* RES	6,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb7];
 			A = m = RES(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb8:	/* RES	7,B=(IX/Y+rel)	*/
+	OP(xycb,0xb8):	/* RES	7,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb8];
 			B = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xb9:	/* RES	7,C=(IX/Y+rel)	*/
+	OP(xycb,0xb9):	/* RES	7,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xb9];
 			C = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xba:	/* RES	7,D=(IX/Y+rel)	*/
+	OP(xycb,0xba):	/* RES	7,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xba];
 			D = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbb:	/* RES	7,E=(IX/Y+rel)	*/
+	OP(xycb,0xbb):	/* RES	7,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xbb];
 			E = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbc:	/* RES	7,H=(IX/Y+rel)	*/
+	OP(xycb,0xbc):	/* RES	7,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xbc];
 			H = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbd:	/* RES	7,L=(IX/Y+rel)	*/
+	OP(xycb,0xbd):	/* RES	7,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xbd];
 			L = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbe:	/* RES	7,(IX/Y+rel)	*/
+	OP(xycb,0xbe):	/* RES	7,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xbe];
 			m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xbf:	/* RES	7,A=(IX/Y+rel)	*/
+	OP(xycb,0xbf):	/* RES	7,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xbf];
 			A = m = RES(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc0:	/* SET	0,B=(IX/Y+rel)	*/
+	OP(xycb,0xc0):	/* SET	0,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc0];
 			B = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc1:	/* SET	0,C=(IX/Y+rel)	*/
+	OP(xycb,0xc1):	/* SET	0,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc1];
 			C = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc2:	/* SET	0,D=(IX/Y+rel)	*/
+	OP(xycb,0xc2):	/* SET	0,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc2];
 			D = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc3:	/* SET	0,E=(IX/Y+rel)	*/
+	OP(xycb,0xc3):	/* SET	0,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc3];
 			E = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc4:	/* SET	0,H=(IX/Y+rel)	*/
+	OP(xycb,0xc4):	/* SET	0,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc4];
 			H = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc5:	/* SET	0,L=(IX/Y+rel)	*/
+	OP(xycb,0xc5):	/* SET	0,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc5];
 			L = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc6:	/* SET	0,(IX/Y+rel)	*/
+	OP(xycb,0xc6):	/* SET	0,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc6];
 			m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc7:	/* SET	0,A=(IX/Y+rel)	*/
+	OP(xycb,0xc7):	/* SET	0,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc7];
 			A = m = SET(cpu, 0, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc8:	/* SET	1,B=(IX/Y+rel)	*/
+	OP(xycb,0xc8):	/* SET	1,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc8];
 			B = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xc9:	/* SET	1,C=(IX/Y+rel)	*/
+	OP(xycb,0xc9):	/* SET	1,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xc9];
 			C = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xca:	/* SET	1,D=(IX/Y+rel)	*/
+	OP(xycb,0xca):	/* SET	1,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xca];
 			D = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcb:	/* SET	1,E=(IX/Y+rel)	*/
+	OP(xycb,0xcb):	/* SET	1,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xcb];
 			E = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcc:	/* SET	1,H=(IX/Y+rel)	*/
+	OP(xycb,0xcc):	/* SET	1,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xcc];
 			H = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcd:	/* SET	1,L=(IX/Y+rel)	*/
+	OP(xycb,0xcd):	/* SET	1,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xcd];
 			L = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xce:	/* SET	1,(IX/Y+rel)	*/
+	OP(xycb,0xce):	/* SET	1,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xce];
 			m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xcf:	/* SET	1,A=(IX/Y+rel)	*/
+	OP(xycb,0xcf):	/* SET	1,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xcf];
 			A = m = SET(cpu, 1, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd0:	/* SET	2,B=(IX/Y+rel)	*/
+	OP(xycb,0xd0):	/* SET	2,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd0];
 			B = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd1:	/* SET	2,C=(IX/Y+rel)	*/
+	OP(xycb,0xd1):	/* SET	2,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd1];
 			C = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd2:	/* SET	2,D=(IX/Y+rel)	*/
+	OP(xycb,0xd2):	/* SET	2,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd2];
 			D = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd3:	/* SET	2,E=(IX/Y+rel)	*/
+	OP(xycb,0xd3):	/* SET	2,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd3];
 			E = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd4:	/* SET	2,H=(IX/Y+rel)	*/
+	OP(xycb,0xd4):	/* SET	2,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd4];
 			H = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd5:	/* SET	2,L=(IX/Y+rel)	*/
+	OP(xycb,0xd5):	/* SET	2,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd5];
 			L = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd6:	/* SET	2,(IX/Y+rel)	*/
+	OP(xycb,0xd6):	/* SET	2,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd6];
 			m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd7:	/* SET	2,A=(IX/Y+rel)	*/
+	OP(xycb,0xd7):	/* SET	2,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd7];
 			A = m = SET(cpu, 2, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd8:	/* SET	3,B=(IX/Y+rel)	*/
+	OP(xycb,0xd8):	/* SET	3,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd8];
 			B = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xd9:	/* SET	3,C=(IX/Y+rel)	*/
+	OP(xycb,0xd9):	/* SET	3,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xd9];
 			C = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xda:	/* SET	3,D=(IX/Y+rel)	*/
+	OP(xycb,0xda):	/* SET	3,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xda];
 			D = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdb:	/* SET	3,E=(IX/Y+rel)	*/
+	OP(xycb,0xdb):	/* SET	3,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xdb];
 			E = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdc:	/* SET	3,H=(IX/Y+rel)	*/
+	OP(xycb,0xdc):	/* SET	3,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xdc];
 			H = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdd:	/* SET	3,L=(IX/Y+rel)	*/
+	OP(xycb,0xdd):	/* SET	3,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xdd];
 			L = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xde:	/* SET	3,(IX/Y+rel)	*/
+	OP(xycb,0xde):	/* SET	3,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xde];
 			m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xdf:	/* SET	3,A=(IX/Y+rel)	*/
+	OP(xycb,0xdf):	/* SET	3,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xdf];
 			A = m = SET(cpu, 3, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe0:	/* SET	4,B=(IX/Y+rel)	*/
+	OP(xycb,0xe0):	/* SET	4,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe0];
 			B = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe1:	/* SET	4,C=(IX/Y+rel)	*/
+	OP(xycb,0xe1):	/* SET	4,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe1];
 			C = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe2:	/* SET	4,D=(IX/Y+rel)	*/
+	OP(xycb,0xe2):	/* SET	4,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe2];
 			D = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe3:	/* SET	4,E=(IX/Y+rel)	*/
+	OP(xycb,0xe3):	/* SET	4,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe3];
 			E = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe4:	/* SET	4,H=(IX/Y+rel)	*/
+	OP(xycb,0xe4):	/* SET	4,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe4];
 			H = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe5:	/* SET	4,L=(IX/Y+rel)	*/
+	OP(xycb,0xe5):	/* SET	4,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe5];
 			L = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe6:	/* SET	4,(IX/Y+rel)	*/
+	OP(xycb,0xe6):	/* SET	4,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe6];
 			m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe7:	/* SET	4,A=(IX/Y+rel)	*/
+	OP(xycb,0xe7):	/* SET	4,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe7];
 			A = m = SET(cpu, 4, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe8:	/* SET	5,B=(IX/Y+rel)	*/
+	OP(xycb,0xe8):	/* SET	5,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe8];
 			B = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xe9:	/* SET	5,C=(IX/Y+rel)	*/
+	OP(xycb,0xe9):	/* SET	5,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xe9];
 			C = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xea:	/* SET	5,D=(IX/Y+rel)	*/
+	OP(xycb,0xea):	/* SET	5,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xea];
 			D = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xeb:	/* SET	5,E=(IX/Y+rel)	*/
+	OP(xycb,0xeb):	/* SET	5,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xeb];
 			E = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xec:	/* SET	5,H=(IX/Y+rel)	*/
+	OP(xycb,0xec):	/* SET	5,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xec];
 			H = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xed:	/* SET	5,L=(IX/Y+rel)	*/
+	OP(xycb,0xed):	/* SET	5,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xed];
 			L = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xee:	/* SET	5,(IX/Y+rel)	*/
+	OP(xycb,0xee):	/* SET	5,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xee];
 			m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xef:	/* SET	5,A=(IX/Y+rel)	*/
+	OP(xycb,0xef):	/* SET	5,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xef];
 			A = m = SET(cpu, 5, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf0:	/* SET	6,B=(IX/Y+rel)	*/
+	OP(xycb,0xf0):	/* SET	6,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf0];
 			B = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf1:	/* SET	6,C=(IX/Y+rel)	*/
+	OP(xycb,0xf1):	/* SET	6,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf1];
 			C = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf2:	/* SET	6,D=(IX/Y+rel)	*/
+	OP(xycb,0xf2):	/* SET	6,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf2];
 			D = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf3:	/* SET	6,E=(IX/Y+rel)	*/
+	OP(xycb,0xf3):	/* SET	6,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf3];
 			E = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf4:	/* SET	6,H=(IX/Y+rel)	*/
+	OP(xycb,0xf4):	/* SET	6,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf4];
 			H = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf5:	/* SET	6,L=(IX/Y+rel)	*/
+	OP(xycb,0xf5):	/* SET	6,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf5];
 			L = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf6:	/* SET	6,(IX/Y+rel)	*/
+	OP(xycb,0xf6):	/* SET	6,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf6];
 			m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf7:	/* SET	6,A=(IX/Y+rel)	*/
+	OP(xycb,0xf7):	/* SET	6,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf7];
 			A = m = SET(cpu, 6, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf8:	/* SET	7,B=(IX/Y+rel)	*/
+	OP(xycb,0xf8):	/* SET	7,B=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf8];
 			B = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xf9:	/* SET	7,C=(IX/Y+rel)	*/
+	OP(xycb,0xf9):	/* SET	7,C=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xf9];
 			C = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfa:	/* SET	7,D=(IX/Y+rel)	*/
+	OP(xycb,0xfa):	/* SET	7,D=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xfa];
 			D = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfb:	/* SET	7,E=(IX/Y+rel)	*/
+	OP(xycb,0xfb):	/* SET	7,E=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xfb];
 			E = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfc:	/* SET	7,H=(IX/Y+rel)	*/
+	OP(xycb,0xfc):	/* SET	7,H=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xfc];
 			H = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfd:	/* SET	7,L=(IX/Y+rel)	*/
+	OP(xycb,0xfd):	/* SET	7,L=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xfd];
 			L = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xfe:	/* SET	7,(IX/Y+rel)	*/
+	OP(xycb,0xfe):	/* SET	7,(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xfe];
 			m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 
-	case 0xff:	/* SET	7,A=(IX/Y+rel)	*/
+	OP(xycb,0xff):	/* SET	7,A=(IX/Y+rel)	*/
 		{
 			z80_cc += cc_xy_cb[0xff];
 			A = m = SET(cpu, 7, m);
 			WR_MEM(dEA, m);
 		}
-		break;
+		NEXT_OP;
 	}
 
-	if (z80_cc < cycles)
+#if	Z80_THREADED || Z80_JIT
+next_op:
+#endif
+#if	Z80_THREADED
+	if (Z80_STEP == machine->cycles)
+		machine->cycles = machine->cycles_step;
+#endif
+	if (z80_cc < machine->cycles)
 		goto fetch_xx;
+	if (hook)
+		prof_close();
 	return z80_cc;
 }
 
@@ -8830,7 +11309,7 @@ void z80_dump_state(z80_cpu_t *cpu)
 {
 	char dasm[80];
 	uint32_t pc = PC;
-	uint32_t len = z80_dasm(dasm, pc, &mem[pc], &mem[pc]);
+	uint32_t len = z80_dasm(dasm, pc, &machine->mem[pc], &machine->mem[pc]);
 	uint32_t n;
 	len = len & 0xffff;
 	printf("%4.7fs BC:%04x DE:%04x HL:%04x A:%02x %c%c%c%c%c%c%c%c (HL):%02x SP:%04x PC:%04x ",
@@ -8843,10 +11322,10 @@ void z80_dump_state(z80_cpu_t *cpu)
 		F & PF ? 'P' : '-',
 		F & NF ? 'N' : '-',
 		F & CF ? 'C' : '-',
-		mem[HL], SP, PC);
+		machine->mem[HL], SP, PC);
 	for (n = 0; n < 4; n++) {
 		if (n < len)
-			printf(" %02x", mem[pc+n]);
+			printf(" %02x", machine->mem[pc+n]);
 		else
 			printf("   ");
 	}
@@ -0,0 +1,511 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * z80bench.c	Z80 CPU emulator benchmark
+ *
+ * Runs a few synthetic workloads on the Z80 core with a flat 64K RAM map
+ * and reports the emulated clock rate the host achieves for each of them.
+ * After the default number of cycles the state of memory and registers
+ * must match a known hash, so a faster core is also a correct one.
+ *
+ * With -z it runs a CP/M instruction exerciser like ZEXDOC or ZEXALL
+ * instead. The BDOS console output functions and the warm boot are
+ * trapped through OUT instructions, and the run fails if the exerciser
+ * reports an ERROR.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "z80.h"
+
+/** @brief cycles per call to z80_execute() */
+#define	SLICE	100000
+
+/** @brief default number of cycles to emulate per workload */
+#define	DEFAULT_CYCLES	200000000ull
+
+/** @brief number of time slices to set up in the timer benchmark */
+#define	TIMER_SLICES	10000000
+
+/** @brief maximum number of cycles to run a CP/M program */
+#define	CPM_CYCLES	200000000000ull
+
+/** @brief load address of CP/M programs */
+#define	CPM_TPA		0x0100
+
+/** @brief address of the BDOS entry (also the top of the TPA) */
+#define	CPM_BDOS	0xf000
+
+/** @brief I/O port trapping BDOS calls */
+#define	CPM_BDOS_PORT	0x00
+
+/** @brief I/O port trapping the warm boot */
+#define	CPM_BOOT_PORT	0x01
+
+typedef struct {
+	/** @brief short name of the workload */
+	const char *name;
+	/** @brief Z80 code loaded at address 0000 */
+	const uint8_t *code;
+	/** @brief size of the code */
+	size_t size;
+	/** @brief state_hash() after DEFAULT_CYCLES */
+	uint32_t hash;
+}	workload_t;
+
+/** @brief 8 bit ALU operations on registers */
+static const uint8_t wl_alu[] = {
+	0x06, 0x00,		/* 0000 LD   B,00h	*/
+	0x3e, 0x5a,		/* 0002 LD   A,5Ah	*/
+	0x80,			/* 0004 ADD  A,B	*/
+	0x89,			/* 0005 ADC  A,C	*/
+	0x92,			/* 0006 SUB  D		*/
+	0x9b,			/* 0007 SBC  A,E	*/
+	0xa4,			/* 0008 AND  H		*/
+	0xad,			/* 0009 XOR  L		*/
+	0xb1,			/* 000A OR   C		*/
+	0xb8,			/* 000B CP   B		*/
+	0x0c,			/* 000C INC  C		*/
+	0x15,			/* 000D DEC  D		*/
+	0x1c,			/* 000E INC  E		*/
+	0x2d,			/* 000F DEC  L		*/
+	0x24,			/* 0010 INC  H		*/
+	0x10, 0xf1,		/* 0011 DJNZ 0004h	*/
+	0xc3, 0x00, 0x00	/* 0013 JP   0000h	*/
+};
+
+/** @brief block moves up and down */
+static const uint8_t wl_ldir[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x11, 0x00, 0x90,	/* 0003 LD   DE,9000h	*/
+	0x01, 0x00, 0x10,	/* 0006 LD   BC,1000h	*/
+	0xed, 0xb0,		/* 0009 LDIR		*/
+	0x21, 0xff, 0x9f,	/* 000B LD   HL,9FFFh	*/
+	0x11, 0xff, 0x8f,	/* 000E LD   DE,8FFFh	*/
+	0x01, 0x00, 0x10,	/* 0011 LD   BC,1000h	*/
+	0xed, 0xb8,		/* 0014 LDDR		*/
+	0xc3, 0x00, 0x00	/* 0016 JP   0000h	*/
+};
+
+/** @brief screen clear style memory fill with an overlapping LDIR */
+static const uint8_t wl_fill[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x36, 0x20,		/* 0003 LD   (HL),20h	*/
+	0x11, 0x01, 0x80,	/* 0005 LD   DE,8001h	*/
+	0x01, 0xff, 0x0f,	/* 0008 LD   BC,0FFFh	*/
+	0xed, 0xb0,		/* 000B LDIR		*/
+	0x3c,			/* 000D INC  A		*/
+	0xc3, 0x00, 0x00	/* 000E JP   0000h	*/
+};
+
+/** @brief indexed memory accesses through IX and IY */
+static const uint8_t wl_ixiy[] = {
+	0xdd, 0x21, 0x00, 0x80,	/* 0000 LD   IX,8000h	*/
+	0xfd, 0x21, 0x00, 0x90,	/* 0004 LD   IY,9000h	*/
+	0x06, 0x00,		/* 0008 LD   B,00h	*/
+	0xdd, 0x7e, 0x00,	/* 000A LD   A,(IX+00h)	*/
+	0xfd, 0x86, 0x01,	/* 000D ADD  A,(IY+01h)	*/
+	0xdd, 0x77, 0x02,	/* 0010 LD   (IX+02h),A	*/
+	0xfd, 0x34, 0x03,	/* 0013 INC  (IY+03h)	*/
+	0xdd, 0x23,		/* 0016 INC  IX		*/
+	0xfd, 0x23,		/* 0018 INC  IY		*/
+	0x10, 0xee,		/* 001A DJNZ 000Ah	*/
+	0xc3, 0x00, 0x00	/* 001C JP   0000h	*/
+};
+
+/** @brief CB prefixed bit, rotate and shift operations */
+static const uint8_t wl_cbbit[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0xdd, 0x21, 0x00, 0x90,	/* 0003 LD   IX,9000h	*/
+	0x06, 0x00,		/* 0007 LD   B,00h	*/
+	0xcb, 0x41,		/* 0009 BIT  0,C	*/
+	0xcb, 0xc1,		/* 000B SET  0,C	*/
+	0xcb, 0x89,		/* 000D RES  1,C	*/
+	0xcb, 0x11,		/* 000F RL   C		*/
+	0xcb, 0x3a,		/* 0011 SRL  D		*/
+	0xcb, 0x46,		/* 0013 BIT  0,(HL)	*/
+	0xcb, 0xc6,		/* 0015 SET  0,(HL)	*/
+	0xcb, 0x0e,		/* 0017 RRC  (HL)	*/
+	0xdd, 0xcb, 0x01, 0x46,	/* 0019 BIT  0,(IX+01h)	*/
+	0xdd, 0xcb, 0x01, 0x16,	/* 001D RL   (IX+01h)	*/
+	0xdd, 0xcb, 0x02, 0xfe,	/* 0021 SET  7,(IX+02h)	*/
+	0x23,			/* 0025 INC  HL		*/
+	0x10, 0xe1,		/* 0026 DJNZ 0009h	*/
+	0xc3, 0x00, 0x00	/* 0028 JP   0000h	*/
+};
+
+/** @brief a BASIC interpreter like loop: fetch, compare, call, push and pop */
+static const uint8_t wl_basic[] = {
+	0x31, 0x00, 0xf0,	/* 0000 LD   SP,F000h	*/
+	0x21, 0x00, 0x80,	/* 0003 LD   HL,8000h	*/
+	0x06, 0x00,		/* 0006 LD   B,00h	*/
+	0x7e,			/* 0008 LD   A,(HL)	*/
+	0x23,			/* 0009 INC  HL		*/
+	0xfe, 0x3a,		/* 000A CP   3Ah	*/
+	0x28, 0x03,		/* 000C JR   Z,0011h	*/
+	0xcd, 0x16, 0x00,	/* 000E CALL 0016h	*/
+	0x10, 0xf5,		/* 0011 DJNZ 0008h	*/
+	0xc3, 0x03, 0x00,	/* 0013 JP   0003h	*/
+	0xc5,			/* 0016 PUSH BC		*/
+	0xe5,			/* 0017 PUSH HL		*/
+	0x4f,			/* 0018 LD   C,A	*/
+	0x2a, 0x00, 0x81,	/* 0019 LD   HL,(8100h)	*/
+	0x09,			/* 001C ADD  HL,BC	*/
+	0x22, 0x00, 0x81,	/* 001D LD   (8100h),HL	*/
+	0xe1,			/* 0020 POP  HL		*/
+	0xc1,			/* 0021 POP  BC		*/
+	0xc9			/* 0022 RET		*/
+};
+
+static const workload_t workloads[] = {
+	{ "alu",	wl_alu,		sizeof(wl_alu),		0x0ee05192 },
+	{ "ldir",	wl_ldir,	sizeof(wl_ldir),	0x8c18e76a },
+	{ "fill",	wl_fill,	sizeof(wl_fill),	0xded57312 },
+	{ "ixiy",	wl_ixiy,	sizeof(wl_ixiy),	0xd3866f64 },
+	{ "cbbit",	wl_cbbit,	sizeof(wl_cbbit),	0x0a9a063a },
+	{ "basic",	wl_basic,	sizeof(wl_basic),	0x2a5e4890 }
+};
+
+/** @brief page zero and BDOS of the CP/M harness */
+static const uint8_t cpm_page0[] = {
+	0xd3, CPM_BOOT_PORT,	/* 0000 OUT  (BOOT),A	*/
+	0x76,			/* 0002 HALT		*/
+	0x00, 0x00,		/* 0003 IOBYTE, drive	*/
+	0xc3, CPM_BDOS & 0xff, CPM_BDOS >> 8	/* 0005 JP   BDOS	*/
+};
+
+static const uint8_t cpm_bdos[] = {
+	0xd3, CPM_BDOS_PORT,	/* F000 OUT  (BDOS),A	*/
+	0xc9			/* F002 RET		*/
+};
+
+/** @brief console output of the CP/M program */
+static char cpm_out[65536];
+
+/** @brief length of the console output */
+static uint32_t cpm_len;
+
+/** @brief non zero after the CP/M program did a warm boot */
+static int cpm_exit;
+
+/** @brief read from RAM address */
+static uint8_t rd_ram(uint32_t offset)
+{
+	return machine->mem[offset];
+}
+
+/** @brief write to RAM memory address */
+static void wr_ram(uint32_t offset, uint8_t data)
+{
+	machine->mem[offset] = data;
+	Z80_BC_CHECK(offset);
+}
+
+/** @brief read from an I/O port */
+static uint8_t rd_port(uint32_t offset)
+{
+	return 0xff;
+}
+
+/** @brief print a character from the CP/M program and keep it for the error check */
+static void cpm_putc(uint8_t c)
+{
+	putchar(c);
+	if (cpm_len + 1 < sizeof(cpm_out))
+		cpm_out[cpm_len++] = c;
+}
+
+/** @brief write to an I/O port: the BDOS and warm boot traps of the CP/M harness */
+static void wr_port(uint32_t offset, uint8_t data)
+{
+	z80_cpu_t *cpu = &machine->cpu;
+	uint32_t de, n;
+
+	switch (offset & 0xff) {
+	case CPM_BDOS_PORT:
+		de = z80_get_reg(cpu, Z80_DE);
+		switch (z80_get_reg(cpu, Z80_BC) & 0xff) {
+		case 2:	/* console output */
+			cpm_putc(de & 0xff);
+			break;
+		case 9:	/* print string */
+			for (n = 0; n < MEMSIZE && '$' != machine->mem[de]; n++, de = (de + 1) % MEMSIZE)
+				cpm_putc(machine->mem[de]);
+			break;
+		}
+		fflush(stdout);
+		break;
+	case CPM_BOOT_PORT:
+		cpm_exit = 1;
+		machine->cycles = machine->cc;	/* end the time slice */
+		break;
+	}
+}
+
+/** @brief return the host time in microseconds */
+static uint64_t usecs(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000ull + tv.tv_usec;
+}
+
+/** @brief FNV-1a hash of the memory and CPU registers after a run */
+static uint32_t state_hash(z80_cpu_t *cpu)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t i;
+
+	for (i = 0; i < MEMSIZE; i++)
+		hash = (hash ^ machine->mem[i]) * 16777619u;
+	for (i = Z80_PC; i <= Z80_IRQ; i++)
+		hash = (hash ^ z80_get_reg(cpu, i)) * 16777619u;
+	return hash;
+}
+
+/** @brief run one workload for a number of cycles and print the results */
+static int bench(const workload_t *wl, uint64_t ncycles)
+{
+	z80_cpu_t *cpu = &machine->cpu;
+	uint64_t total, t0, t1;
+	uint32_t hash;
+	double secs;
+	int rc = 0;
+
+	memset(machine->mem, 0, sizeof(machine->mem));
+	memcpy(machine->mem, wl->code, wl->size);
+	z80_bc_flush();
+	z80_reset(cpu);
+	machine->cc = 0;
+	machine->dma = 0;
+
+	t0 = usecs();
+	for (total = 0; total < ncycles; /* */) {
+		machine->cycles = SLICE;
+		total += z80_execute(cpu);
+		machine->cc = 0;
+	}
+	t1 = usecs();
+
+	secs = (t1 - t0) / 1e6;
+	hash = state_hash(cpu);
+	if (DEFAULT_CYCLES == ncycles && hash != wl->hash)
+		rc = -1;
+	printf("%-13s %-6s %-6s %-8s %12llu cycles %8.3fs %9.2f MHz  hash:%08x%s\n",
+		z80_dispatch, machine->jit ? "jit" : machine->blocks ? "blocks" : "-",
+		NULL != machine->rd_ptr[0] ? "direct" : "func", wl->name, (unsigned long long)total, secs,
+		secs > 0 ? total / secs / 1e6 : 0.0, hash,
+		DEFAULT_CYCLES != ncycles ? "" : rc < 0 ? " FAIL" : " ok");
+	return rc;
+}
+
+/** @brief run a CP/M program until it exits and check its output for errors */
+static int bench_cpm(const char *filename)
+{
+	z80_cpu_t *cpu = &machine->cpu;
+	uint64_t total, t0, t1;
+	const char *name;
+	char base[32];
+	size_t size;
+	double secs;
+	FILE *fp;
+	int rc = 0;
+
+	fp = fopen(filename, "rb");
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	memset(machine->mem, 0, sizeof(machine->mem));
+	size = fread(&machine->mem[CPM_TPA], 1, CPM_BDOS - CPM_TPA, fp);
+	fclose(fp);
+	memcpy(machine->mem, cpm_page0, sizeof(cpm_page0));
+	memcpy(&machine->mem[CPM_BDOS], cpm_bdos, sizeof(cpm_bdos));
+	z80_bc_flush();
+	z80_reset(cpu);
+	cpu->pc.dword.d0 = CPM_TPA;
+	cpu->sp.dword.d0 = CPM_BDOS;
+	machine->cc = 0;
+	machine->dma = 0;
+	cpm_len = 0;
+	cpm_exit = 0;
+
+	t0 = usecs();
+	for (total = 0; 0 == cpm_exit && total < CPM_CYCLES; /* */) {
+		machine->cycles = SLICE;
+		total += z80_execute(cpu);
+		machine->cc = 0;
+		/* nothing will ever wake up a HALT with interrupts disabled */
+		if (0x76 == machine->mem[z80_get_reg(cpu, Z80_PC)] && 0 == z80_get_reg(cpu, Z80_IFF1))
+			break;
+	}
+	t1 = usecs();
+
+	cpm_out[cpm_len] = '\0';
+	if (0 == size || 0 == cpm_exit || NULL != strstr(cpm_out, "ERROR"))
+		rc = -1;
+	name = strrchr(filename, '/');
+	snprintf(base, sizeof(base), "%s", NULL != name ? name + 1 : filename);
+	if (NULL != strchr(base, '.'))
+		*strchr(base, '.') = '\0';
+	secs = (t1 - t0) / 1e6;
+	printf("\n%-13s %-6s %-6s %-8s %12llu cycles %8.3fs %9.2f MHz  %s\n",
+		z80_dispatch, machine->jit ? "jit" : machine->blocks ? "blocks" : "-",
+		NULL != machine->rd_ptr[0] ? "direct" : "func", base, (unsigned long long)total, secs,
+		secs > 0 ? total / secs / 1e6 : 0.0, rc < 0 ? "FAIL" : "ok");
+	return rc;
+}
+
+/** @brief disk controller like data timer, re-armed from its callback */
+static tmr_t *data_timer;
+
+/** @brief callback for the periodic timers */
+static void tmr_periodic(uint32_t param)
+{
+	/* no op */
+}
+
+/** @brief callback for the one shot data timer */
+static void tmr_data(uint32_t param)
+{
+	tmr_adjust(data_timer, tmr_double_to_time(TIME_IN_USEC(32)), param, time_zero);
+}
+
+/** @brief measure the cost of setting up time slices with ntimers timers */
+static void bench_timers(int ntimers)
+{
+	tmr_t *timer[MAX_TMR];
+	uint64_t t0, t1;
+	double secs;
+	int i, n;
+
+	if (ntimers < 4)
+		ntimers = 4;
+	if (ntimers > MAX_TMR)
+		ntimers = MAX_TMR;
+	tmr_set_clock(2216800.0);
+	machine->cc = 0;
+
+	/* the timers of a Colour Genie with an active disk transfer */
+	timer[0] = tmr_alloc(tmr_periodic, tmr_double_to_time(TIME_IN_MSEC(20)),
+		0, tmr_double_to_time(TIME_IN_MSEC(20)));
+	timer[1] = tmr_alloc(tmr_periodic, tmr_double_to_time(TIME_IN_MSEC(25)),
+		0, tmr_double_to_time(TIME_IN_MSEC(25)));
+	timer[2] = tmr_alloc(tmr_periodic, tmr_double_to_time(TIME_IN_HZ(8000)),
+		0, tmr_double_to_time(TIME_IN_HZ(8000)));
+	timer[3] = data_timer = tmr_alloc(tmr_data, tmr_double_to_time(TIME_IN_USEC(32)),
+		0, time_zero);
+	/* fill up with idle timers and slower periodic timers */
+	for (i = 4; i < ntimers; i++) {
+		if (i & 1)
+			timer[i] = tmr_alloc(tmr_periodic, time_never, i, time_never);
+		else
+			timer[i] = tmr_alloc(tmr_periodic, tmr_double_to_time(TIME_IN_USEC(100 * i)),
+				i, tmr_double_to_time(TIME_IN_USEC(100 * i)));
+	}
+
+	t0 = usecs();
+	for (n = 0; n < TIMER_SLICES; n++) {
+		tmr_t *slice = tmr_next_event();
+		tmr_time_t dt = slice->expire - time_now();
+		tmr_expire(dt > 0 ? dt : 1);
+	}
+	t1 = usecs();
+
+	for (i = 0; i < ntimers; i++)
+		tmr_remove(timer[i]);
+
+	secs = (t1 - t0) / 1e6;
+	printf("%-8s %2d timers %12d slices %8.3fs %9.2f ns/slice  time:%.6fs\n",
+		"timer", ntimers, TIMER_SLICES, secs,
+		secs * 1e9 / TIMER_SLICES, tmr_time_to_double(time_now()));
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t ncycles = DEFAULT_CYCLES;
+	const char *only = NULL;
+	const char *cpm = NULL;
+	int handlers = 0;
+	int blocks = 0;
+	int jit = 0;
+	int ntimers = 0;
+	int rc = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] == '-') {
+			switch (argv[i][1]) {
+			case 'n':
+				if (i + 1 < argc) {
+					i++;
+					ncycles = strtoull(argv[i], NULL, 0);
+				}
+				break;
+			case 'b':
+				blocks = 1;
+				break;
+			case 'j':
+				blocks = jit = 1;
+				break;
+			case 'm':
+				handlers = 1;
+				break;
+			case 't':
+				if (i + 1 < argc) {
+					i++;
+					ntimers = strtol(argv[i], NULL, 0);
+				}
+				break;
+			case 'z':
+				if (i + 1 < argc) {
+					i++;
+					cpm = argv[i];
+				}
+				break;
+			case 'h':
+				printf("usage: %s [-b] [-j] [-m] [-n cycles] [-t timers] [-z file.com] [workload]\n", argv[0]);
+				printf("-b  enable the basic block cache\n");
+				printf("-j  enable the basic block cache and the JIT\n");
+				printf("-m  access memory through the handlers only\n");
+				printf("-t  measure the time slice setup with a number of timers\n");
+				printf("-z  run a CP/M exerciser (e.g. zexdoc.com) instead of the workloads\n");
+				printf("the workloads are checked against known hashes after the default cycles\n");
+				return 0;
+			}
+			continue;
+		}
+		only = argv[i];
+	}
+
+	if (ntimers > 0) {
+		bench_timers(ntimers);
+		return 0;
+	}
+
+	for (i = 0; i < L1SIZE; i++) {
+		machine->rd_mem[i] = rd_ram;
+		machine->wr_mem[i] = wr_ram;
+		machine->rd_ptr[i] = handlers ? NULL : &machine->mem[i << L1SHIFT];
+		machine->wr_ptr[i] = handlers ? NULL : &machine->mem[i << L1SHIFT];
+		machine->rd_io[i] = rd_port;
+		machine->wr_io[i] = wr_port;
+	}
+	if (blocks)
+		z80_bc_enable(0, MEMSIZE);
+	if (jit && z80_jit_enable(Z80_JIT_HOT) < 0) {
+		printf("%-13s JIT not available, skipped\n", z80_dispatch);
+		return 0;
+	}
+
+	if (NULL != cpm)
+		return bench_cpm(cpm) < 0 ? 1 : 0;
+
+	for (i = 0; i < sizeof(workloads)/sizeof(workloads[0]); i++) {
+		if (NULL != only && strcmp(only, workloads[i].name))
+			continue;
+		if (bench(&workloads[i], ncycles) < 0)
+			rc = 1;
+	}
+	return rc;
+}
@@ -0,0 +1,406 @@
+/* ed:set tabstop=8 noexpandtab: */
+/**************************************************************************
+ *
+ * z80run.c	Run a batch of emulator jobs headless and collect results
+ *
+ * Each line of the job file describes one run:
+ *
+ *	machine image keys cycles
+ *
+ * where machine is the emulator binary (trs80 or cgenie), image is a
+ * floppy disk (mounted as drive 0) or cassette image (*.cas), keys is
+ * a key script and cycles is the number of CPU cycles to run.
+ * A '-' stands for no image or no key script.
+ *
+ * The jobs run in a pool of worker processes. The emulators can run
+ * several machines on threads of one process (see trs80test), but a
+ * crashing job must not take the other jobs with it, so processes,
+ * not threads, are the unit of parallelism.
+ *
+ * With -C cycles every job saves a checkpoint (a save state) each number
+ * of cycles, and a job which crashed or did not print a result is run
+ * once more, resuming from its last checkpoint.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ **************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define	MAX_FIELD	256
+
+typedef struct job_s {
+	/** @brief job number (line number in the job file) */
+	uint32_t num;
+	/** @brief machine binary name */
+	char machine[MAX_FIELD];
+	/** @brief image filename or "-" */
+	char image[MAX_FIELD];
+	/** @brief key script filename or "-" */
+	char keys[MAX_FIELD];
+	/** @brief cycle budget */
+	uint64_t budget;
+	/** @brief process id while running */
+	pid_t pid;
+	/** @brief temporary file receiving the job's stdout */
+	FILE *out;
+	/** @brief time when the job was started */
+	struct timeval start;
+	/** @brief wall clock time in seconds, summed over a run and its resumption */
+	double wall;
+	/** @brief cycles actually run */
+	uint64_t cycles;
+	/** @brief hash of the final screen */
+	uint32_t screen;
+	/** @brief wait status */
+	int status;
+	/** @brief non zero if a result line was found */
+	int valid;
+	/** @brief checkpoint filename */
+	char state[FILENAME_MAX];
+	/** @brief non zero if the job was restarted from its checkpoint */
+	int resumed;
+}	job_t;
+
+static const char *bindir = "bin";
+static uint64_t checkpoint;
+static job_t *jobs;
+static uint32_t njobs;
+
+/** @brief load the job file */
+static int load_jobs(const char *filename)
+{
+	char line[4 * MAX_FIELD], budget[MAX_FIELD];
+	uint32_t lnum = 0;
+	job_t *job, *tmp;
+	FILE *fp;
+
+	fp = strcmp(filename, "-") ? fopen(filename, "r") : stdin;
+	if (NULL == fp) {
+		perror(filename);
+		return -1;
+	}
+	while (NULL != fgets(line, sizeof(line), fp)) {
+		lnum++;
+		if ('#' == line[0] || '\n' == line[0])
+			continue;
+		tmp = realloc(jobs, (njobs + 1) * sizeof(job_t));
+		if (NULL == tmp) {
+			perror("realloc()");
+			return -1;
+		}
+		jobs = tmp;
+		job = &jobs[njobs];
+		memset(job, 0, sizeof(*job));
+		if (4 != sscanf(line, "%255s %255s %255s %255s",
+			job->machine, job->image, job->keys, budget)) {
+			fprintf(stderr, "%s:%u: expected 'machine image keys cycles'\n",
+				filename, lnum);
+			continue;
+		}
+		job->num = lnum;
+		job->budget = strtoull(budget, NULL, 0);
+		if (0 == job->budget) {
+			fprintf(stderr, "%s:%u: invalid cycle budget '%s'\n",
+				filename, lnum, budget);
+			continue;
+		}
+		njobs++;
+	}
+	if (fp != stdin)
+		fclose(fp);
+	return 0;
+}
+
+/** @brief return non zero if filename ends with ext */
+static int has_ext(const char *filename, const char *ext)
+{
+	size_t len = strlen(filename), elen = strlen(ext);
+	return len > elen && !strcasecmp(filename + len - elen, ext);
+}
+
+/** @brief fork and exec the emulator for a job */
+static int start_job(job_t *job)
+{
+	char path[FILENAME_MAX], budget[32], every[32];
+	char *argv[24];
+	int argc = 0;
+	int fd;
+
+	job->out = tmpfile();
+	if (NULL == job->out) {
+		perror("tmpfile()");
+		return -1;
+	}
+	snprintf(path, sizeof(path), "%s/%s", bindir, job->machine);
+	snprintf(budget, sizeof(budget), "%llu", (unsigned long long)job->budget);
+	argv[argc++] = path;
+	argv[argc++] = "-n";
+	argv[argc++] = "-f";
+	argv[argc++] = "-s";
+	argv[argc++] = "1";
+	argv[argc++] = "-c";
+	argv[argc++] = budget;
+	if (strcmp(job->keys, "-")) {
+		argv[argc++] = "-k";
+		argv[argc++] = job->keys;
+	}
+	if (strcmp(job->image, "-")) {
+		argv[argc++] = has_ext(job->image, ".cas") ? "-cas" : "-fd0";
+		argv[argc++] = job->image;
+	}
+	if (0 != checkpoint) {
+		snprintf(every, sizeof(every), "%llu", (unsigned long long)checkpoint);
+		argv[argc++] = "-ss";
+		argv[argc++] = job->state;
+		argv[argc++] = "-cp";
+		argv[argc++] = every;
+		if (job->resumed) {
+			argv[argc++] = "-ls";
+			argv[argc++] = job->state;
+		}
+	}
+	argv[argc] = NULL;
+
+	/* a resumed job must not keep the result of the failed run */
+	job->cycles = 0;
+	job->screen = 0;
+	job->valid = 0;
+	gettimeofday(&job->start, NULL);
+	job->pid = fork();
+	if (job->pid < 0) {
+		perror("fork()");
+		fclose(job->out);
+		job->out = NULL;
+		job->pid = 0;
+		return -1;
+	}
+	if (0 == job->pid) {
+		dup2(fileno(job->out), STDOUT_FILENO);
+		fd = open("/dev/null", O_WRONLY);
+		if (fd >= 0)
+			dup2(fd, STDERR_FILENO);
+		execv(path, argv);
+		_exit(127);
+	}
+	return 0;
+}
+
+/** @brief collect the result of a finished job */
+static void finish_job(job_t *job, int status)
+{
+	struct timeval end;
+	unsigned long long cc;
+	unsigned int screen;
+	char line[256];
+
+	gettimeofday(&end, NULL);
+	job->wall += (end.tv_sec - job->start.tv_sec) +
+		(end.tv_usec - job->start.tv_usec) / 1e6;
+	job->status = status;
+	job->pid = 0;
+	rewind(job->out);
+	while (NULL != fgets(line, sizeof(line), job->out)) {
+		if (2 == sscanf(line, "result: cycles=%llu screen=%x", &cc, &screen)) {
+			job->cycles = cc;
+			job->screen = screen;
+			job->valid = 1;
+		}
+	}
+	fclose(job->out);
+	job->out = NULL;
+}
+
+/** @brief describe the exit status of a job */
+static const char *job_status(job_t *job)
+{
+	static char buff[32];
+
+	if (WIFSIGNALED(job->status)) {
+		snprintf(buff, sizeof(buff), "signal %d", WTERMSIG(job->status));
+		return buff;
+	}
+	if (WIFEXITED(job->status) && 0 != WEXITSTATUS(job->status)) {
+		snprintf(buff, sizeof(buff), "exit %d", WEXITSTATUS(job->status));
+		return buff;
+	}
+	if (!job->valid)
+		return "no result";
+	return "ok";
+}
+
+/** @brief write a string as a JSON string */
+static void json_str(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (/* */; *str; str++) {
+		if ('"' == *str || '\\' == *str)
+			fputc('\\', fp);
+		fputc(*str, fp);
+	}
+	fputc('"', fp);
+}
+
+/** @brief write the results of all jobs */
+static void report(FILE *fp, int json)
+{
+	uint32_t i;
+	job_t *job;
+
+	if (json)
+		fprintf(fp, "[\n");
+	else
+		fprintf(fp, "job,machine,image,keys,budget,cycles,screen,wall,status\n");
+	for (i = 0; i < njobs; i++) {
+		job = &jobs[i];
+		if (json) {
+			fprintf(fp, "  {\"job\": %u, \"machine\": ", job->num);
+			json_str(fp, job->machine);
+			fprintf(fp, ", \"image\": ");
+			json_str(fp, job->image);
+			fprintf(fp, ", \"keys\": ");
+			json_str(fp, job->keys);
+			fprintf(fp, ", \"budget\": %llu, \"cycles\": %llu,"
+				" \"screen\": \"%08x\", \"wall\": %.3f, \"status\": ",
+				(unsigned long long)job->budget,
+				(unsigned long long)job->cycles,
+				job->screen, job->wall);
+			json_str(fp, job_status(job));
+			fprintf(fp, "}%s\n", i + 1 < njobs ? "," : "");
+		} else {
+			fprintf(fp, "%u,%s,%s,%s,%llu,%llu,%08x,%.3f,%s\n",
+				job->num, job->machine, job->image, job->keys,
+				(unsigned long long)job->budget,
+				(unsigned long long)job->cycles,
+				job->screen, job->wall, job_status(job));
+		}
+	}
+	if (json)
+		fprintf(fp, "]\n");
+}
+
+static void usage(int argc, char **argv)
+{
+	char *program = strrchr(argv[0], '/');
+	program = program ? program + 1 : argv[0];
+	fprintf(stderr, "usage: %s [options] jobfile\n", program);
+	fprintf(stderr, "options can be one or more of:\n");
+	fprintf(stderr, "-j n     run n jobs in parallel (default: number of CPUs)\n");
+	fprintf(stderr, "-o file  write the results to file (default: stdout)\n");
+	fprintf(stderr, "-J       write JSON instead of CSV\n");
+	fprintf(stderr, "-b dir   directory of the emulator binaries (default: bin)\n");
+	fprintf(stderr, "-C n     checkpoint jobs every n cycles and restart failed jobs once\n");
+	fprintf(stderr, "each line of the jobfile is: machine image keys cycles\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *jobfile = NULL;
+	const char *outfile = NULL;
+	const char *tmpdir;
+	uint32_t next, done, running, i;
+	long workers;
+	int json = 0;
+	int status;
+	pid_t pid;
+	FILE *fp;
+
+	workers = sysconf(_SC_NPROCESSORS_ONLN);
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			workers = strtol(argv[++i], NULL, 0);
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			outfile = argv[++i];
+		} else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			bindir = argv[++i];
+		} else if (!strcmp(argv[i], "-C") && i + 1 < argc) {
+			checkpoint = strtoull(argv[++i], NULL, 0);
+		} else if (!strcmp(argv[i], "-J")) {
+			json = 1;
+		} else if ('-' == argv[i][0] && '\0' != argv[i][1]) {
+			usage(argc, argv);
+			return 1;
+		} else {
+			jobfile = argv[i];
+		}
+	}
+	if (NULL == jobfile) {
+		usage(argc, argv);
+		return 1;
+	}
+	if (workers < 1)
+		workers = 1;
+	if (load_jobs(jobfile) < 0)
+		return 1;
+	tmpdir = getenv("TMPDIR");
+	if (NULL == tmpdir)
+		tmpdir = "/tmp";
+	for (i = 0; i < njobs; i++)
+		snprintf(jobs[i].state, sizeof(jobs[i].state), "%s/z80run.%d.%u.state",
+			tmpdir, (int)getpid(), jobs[i].num);
+
+	for (next = 0, done = 0, running = 0; done < njobs; /* */) {
+		while (next < njobs && running < workers) {
+			if (start_job(&jobs[next]) < 0) {
+				jobs[next].status = 127 << 8;
+				done++;
+			} else {
+				running++;
+			}
+			next++;
+		}
+		pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			perror("waitpid()");
+			break;
+		}
+		for (i = 0; i < next; i++) {
+			if (pid != jobs[i].pid)
+				continue;
+			finish_job(&jobs[i], status);
+			fprintf(stderr, "job %u: %s %s\n", jobs[i].num,
+				jobs[i].machine, job_status(&jobs[i]));
+			if (0 != checkpoint && !jobs[i].resumed &&
+				(WIFSIGNALED(status) || !jobs[i].valid) &&
+				0 == access(jobs[i].state, R_OK)) {
+				fprintf(stderr, "job %u: resuming from the last checkpoint\n",
+					jobs[i].num);
+				jobs[i].resumed = 1;
+				if (0 == start_job(&jobs[i]))
+					break;
+			}
+			if (0 != checkpoint)
+				remove(jobs[i].state);
+			running--;
+			done++;
+			break;
+		}
+	}
+
+	if (NULL != outfile) {
+		fp = fopen(outfile, "w");
+		if (NULL == fp) {
+			perror(outfile);
+			return 1;
+		}
+	} else {
+		fp = stdout;
+	}
+	report(fp, json);
+	if (fp != stdout)
+		fclose(fp);
+
+	for (i = 0; i < njobs; i++)
+		if (WIFSIGNALED(jobs[i].status) || !jobs[i].valid)
+			return 2;
+	return 0;
+}
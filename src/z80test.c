@@ -0,0 +1,286 @@
+/* ed:set tabstop=8 noexpandtab: */
+/***************************************************************************************
+ *
+ * z80test.c	Z80 CPU emulator checks
+ *
+ * Runs small programs on the Z80 core with a flat 64K RAM map and checks
+ * what the instruction hooks see. The core fast-forwards HALT and the
+ * repeated iterations of the block instructions, but while a trace hook,
+ * a breakpoint or the profiler is active every single execution must
+ * still be reported, and the profile must charge each one its cycles.
+ *
+ * Each check runs with and without the basic block cache. The program
+ * exits with status 1 if any check fails.
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ ***************************************************************************************/
+#include "z80.h"
+
+/** @brief cycles per call to z80_execute() */
+#define	SLICE	100000
+
+/** @brief number of iterations of the 16 bit counted block instructions */
+#define	COUNT	1000
+
+/** @brief number of iterations of the 8 bit counted block instructions */
+#define	COUNT8	200
+
+typedef struct {
+	/** @brief short name of the check */
+	const char *name;
+	/** @brief Z80 code loaded at address 0000 */
+	const uint8_t *code;
+	/** @brief size of the code */
+	size_t size;
+	/** @brief address of the instruction to count */
+	uint32_t pc;
+	/** @brief cycles to run (0 to run until the program HALTs) */
+	int budget;
+	/** @brief expected number of executions of the instruction at pc */
+	uint64_t count;
+	/** @brief expected cycles of all executions of the instruction at pc */
+	uint64_t cc;
+}	check_t;
+
+/** @brief copy COUNT bytes up */
+static const uint8_t ck_ldir[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x11, 0x00, 0x90,	/* 0003 LD   DE,9000h	*/
+	0x01, COUNT & 0xff, COUNT >> 8,	/* 0006 LD   BC,COUNT	*/
+	0xed, 0xb0,		/* 0009 LDIR		*/
+	0x76			/* 000B HALT		*/
+};
+
+/** @brief copy COUNT bytes down */
+static const uint8_t ck_lddr[] = {
+	0x21, 0xff, 0x8f,	/* 0000 LD   HL,8FFFh	*/
+	0x11, 0xff, 0x9f,	/* 0003 LD   DE,9FFFh	*/
+	0x01, COUNT & 0xff, COUNT >> 8,	/* 0006 LD   BC,COUNT	*/
+	0xed, 0xb8,		/* 0009 LDDR		*/
+	0x76			/* 000B HALT		*/
+};
+
+/** @brief search COUNT bytes of zeroes for a value which is not there */
+static const uint8_t ck_cpir[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x01, COUNT & 0xff, COUNT >> 8,	/* 0003 LD   BC,COUNT	*/
+	0x3e, 0x55,		/* 0006 LD   A,55h	*/
+	0xed, 0xb1,		/* 0008 CPIR		*/
+	0x76			/* 000A HALT		*/
+};
+
+/** @brief read COUNT8 bytes from a port */
+static const uint8_t ck_inir[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x01, 0x10, COUNT8,	/* 0003 LD   BC,COUNT8*256+10h */
+	0xed, 0xb2,		/* 0006 INIR		*/
+	0x76			/* 0008 HALT		*/
+};
+
+/** @brief write COUNT8 bytes to a port */
+static const uint8_t ck_otir[] = {
+	0x21, 0x00, 0x80,	/* 0000 LD   HL,8000h	*/
+	0x01, 0x10, COUNT8,	/* 0003 LD   BC,COUNT8*256+10h */
+	0xed, 0xb3,		/* 0006 OTIR		*/
+	0x76			/* 0008 HALT		*/
+};
+
+/** @brief spin in HALT with interrupts disabled */
+static const uint8_t ck_halt[] = {
+	0xf3,			/* 0000 DI		*/
+	0x76			/* 0001 HALT		*/
+};
+
+/* repeating block instructions take 21 cycles, the last iteration 16 */
+static const check_t checks[] = {
+	{ "ldir",	ck_ldir,	sizeof(ck_ldir),	0x0009,	0,	COUNT,	COUNT * 21 - 5 },
+	{ "lddr",	ck_lddr,	sizeof(ck_lddr),	0x0009,	0,	COUNT,	COUNT * 21 - 5 },
+	{ "cpir",	ck_cpir,	sizeof(ck_cpir),	0x0008,	0,	COUNT,	COUNT * 21 - 5 },
+	{ "inir",	ck_inir,	sizeof(ck_inir),	0x0006,	0,	COUNT8,	COUNT8 * 21 - 5 },
+	{ "otir",	ck_otir,	sizeof(ck_otir),	0x0006,	0,	COUNT8,	COUNT8 * 21 - 5 },
+	/* DI takes 4 cycles, then every HALT takes 4 */
+	{ "halt",	ck_halt,	sizeof(ck_halt),	0x0001,	4 + 4 * COUNT,	COUNT,	4 * COUNT }
+};
+
+/** @brief address of the instruction counted by trace_count() */
+static uint32_t count_pc;
+
+/** @brief executions seen by trace_count() or break_count() */
+static uint64_t count;
+
+/** @brief read from RAM address */
+static uint8_t rd_ram(uint32_t offset)
+{
+	return machine->mem[offset];
+}
+
+/** @brief write to RAM memory address */
+static void wr_ram(uint32_t offset, uint8_t data)
+{
+	machine->mem[offset] = data;
+	Z80_BC_CHECK(offset);
+}
+
+/** @brief read from an I/O port */
+static uint8_t rd_port(uint32_t offset)
+{
+	return 0xff;
+}
+
+/** @brief write to an I/O port */
+static void wr_port(uint32_t offset, uint8_t data)
+{
+}
+
+/** @brief trace hook counting the executions of the instruction at count_pc */
+static void trace_count(z80_cpu_t *cpu)
+{
+	if (count_pc == z80_get_reg(cpu, Z80_PC))
+		count++;
+}
+
+/** @brief breakpoint hit function counting the executions */
+static void break_count(uint32_t pc)
+{
+	count++;
+}
+
+/** @brief load a check's program and reset the CPU */
+static void setup(const check_t *ck)
+{
+	z80_cpu_t *cpu = &machine->cpu;
+
+	memset(machine->mem, 0, sizeof(machine->mem));
+	memcpy(machine->mem, ck->code, ck->size);
+	z80_bc_flush();
+	z80_reset(cpu);
+	machine->cc = 0;
+	machine->dma = 0;
+}
+
+/** @brief run a check's program for its cycles, or until it HALTs */
+static void run(const check_t *ck)
+{
+	z80_cpu_t *cpu = &machine->cpu;
+	int total = 0;
+
+	if (ck->budget > 0) {
+		machine->cycles = ck->budget;
+		z80_execute(cpu);
+		machine->cc = 0;
+		return;
+	}
+	while (0x76 != machine->mem[z80_get_reg(cpu, Z80_PC)] && total < 100 * SLICE) {
+		machine->cycles = SLICE;
+		total += z80_execute(cpu);
+		machine->cc = 0;
+	}
+}
+
+/** @brief print the result of a check and return -1 if it failed */
+static int result(const char *what, const check_t *ck, uint64_t n, int ok)
+{
+	printf("%-13s %-6s %-8s %-6s %8llu executions%s\n",
+		z80_dispatch, machine->blocks ? "blocks" : "-", what, ck->name,
+		(unsigned long long)n, ok ? " ok" : " FAIL");
+	return ok ? 0 : -1;
+}
+
+/** @brief count the executions of a check's instruction with the trace hook */
+static int check_trace(const check_t *ck)
+{
+	setup(ck);
+	count_pc = ck->pc;
+	count = 0;
+	z80_trace_hook(trace_count);
+	run(ck);
+	z80_trace_hook(NULL);
+	return result("trace", ck, count, count == ck->count);
+}
+
+/** @brief count the executions of a check's instruction with a breakpoint */
+static int check_break(const check_t *ck)
+{
+	setup(ck);
+	count = 0;
+	z80_break_set(ck->pc, break_count);
+	run(ck);
+	z80_break_clr(ck->pc);
+	return result("break", ck, count, count == ck->count);
+}
+
+/** @brief profile a check and compare the count and cycles of its instruction */
+static int check_profile(const check_t *ck)
+{
+	char filename[FILENAME_MAX], line[256];
+	unsigned long long cc = 0, n = 0, c, k;
+	const char *tmpdir;
+	uint32_t pc;
+	FILE *fp;
+
+	tmpdir = getenv("TMPDIR");
+	if (NULL == tmpdir)
+		tmpdir = "/tmp";
+	snprintf(filename, sizeof(filename), "%s/z80test.%d.prof", tmpdir, (int)getpid());
+
+	setup(ck);
+	if (z80_prof_enable() < 0)
+		return result("profile", ck, 0, 0);
+	run(ck);
+	if (z80_prof_write(filename) < 0)
+		return result("profile", ck, 0, 0);
+	/* start the next profile from scratch */
+	free(machine->prof);
+	machine->prof = NULL;
+
+	fp = fopen(filename, "r");
+	if (NULL == fp) {
+		perror(filename);
+		return result("profile", ck, 0, 0);
+	}
+	while (NULL != fgets(line, sizeof(line), fp)) {
+		if (3 == sscanf(line, "%x\tCODE\t%*f%% cc=%llu n=%llu", &pc, &c, &k) &&
+			pc == ck->pc) {
+			cc = c;
+			n = k;
+		}
+	}
+	fclose(fp);
+	remove(filename);
+	if (cc != ck->cc)
+		printf("%-13s %-6s %-8s %-6s %8llu cycles, expected %llu\n",
+			z80_dispatch, machine->blocks ? "blocks" : "-", "profile", ck->name,
+			cc, (unsigned long long)ck->cc);
+	return result("profile", ck, n, n == ck->count && cc == ck->cc);
+}
+
+int main(int argc, char **argv)
+{
+	int blocks;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < L1SIZE; i++) {
+		machine->rd_mem[i] = rd_ram;
+		machine->wr_mem[i] = wr_ram;
+		machine->rd_ptr[i] = &machine->mem[i << L1SHIFT];
+		machine->wr_ptr[i] = &machine->mem[i << L1SHIFT];
+		machine->rd_io[i] = rd_port;
+		machine->wr_io[i] = wr_port;
+	}
+
+	for (blocks = 0; blocks < 2; blocks++) {
+		if (blocks)
+			z80_bc_enable(0, MEMSIZE);
+		for (i = 0; i < sizeof(checks)/sizeof(checks[0]); i++) {
+			if (check_trace(&checks[i]) < 0)
+				rc = 1;
+			if (check_break(&checks[i]) < 0)
+				rc = 1;
+			if (check_profile(&checks[i]) < 0)
+				rc = 1;
+		}
+	}
+	return rc;
+}
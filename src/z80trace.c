@@ -0,0 +1,221 @@
+/* ed:set tabstop=8 noexpandtab: */
+/**************************************************************************
+ *
+ * z80trace.c	Decode an execution trace written with -trace
+ *
+ * Prints one line per instruction: the cycle count when it started,
+ * the PC, the opcode bytes, the disassembly and the registers after
+ * the instruction was executed.
+ *
+ *	z80trace [-a] [-s first] [-n count] file
+ *
+ * -a		also print the alternate registers, I, R, IFF and IM
+ * -s first	skip the first number of instructions
+ * -n count	stop after a number of instructions
+ *
+ * Copyright by Juergen Buchmueller <pullmoll@t-online.de>
+ *
+ **************************************************************************/
+#include <zlib.h>
+#include "z80dasm.h"
+#include "trace.h"
+
+/** @brief size of the input buffer */
+#define	INBUF_SIZE	65536
+
+typedef struct {
+	/** @brief input file */
+	gzFile gz;
+	/** @brief input buffer */
+	uint8_t buf[INBUF_SIZE];
+	/** @brief number of bytes in the buffer */
+	int size;
+	/** @brief read position in the buffer */
+	int pos;
+	/** @brief non zero at the end of the file */
+	int eof;
+}	input_t;
+
+/** @brief the decoder's view of the machine */
+typedef struct {
+	/** @brief cycle stamp */
+	uint64_t stamp;
+	/** @brief PC */
+	uint32_t pc;
+	/** @brief expected PC */
+	uint32_t pc_next;
+	/** @brief first opcode byte of the previous instruction */
+	uint32_t op;
+	/** @brief registers */
+	uint16_t reg[TRACE_REGS];
+	/** @brief opcode bytes last recorded for each PC */
+	uint8_t code[MEMSIZE][4];
+	/** @brief length of the instruction at each PC */
+	uint8_t len[MEMSIZE];
+}	decoder_t;
+
+static input_t in;
+static decoder_t dec;
+
+static int get_byte(void)
+{
+	if (in.pos >= in.size) {
+		if (in.eof)
+			return -1;
+		in.size = gzread(in.gz, in.buf, sizeof(in.buf));
+		in.pos = 0;
+		if (in.size <= 0) {
+			in.eof = 1;
+			return -1;
+		}
+	}
+	return in.buf[in.pos++];
+}
+
+static int get_varint(uint64_t *val)
+{
+	uint32_t shift = 0;
+	int c;
+
+	*val = 0;
+	do {
+		c = get_byte();
+		if (c < 0)
+			return -1;
+		*val |= (uint64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return 0;
+}
+
+static int get_word(uint16_t *val)
+{
+	int lsb = get_byte();
+	int msb = get_byte();
+	if (lsb < 0 || msb < 0)
+		return -1;
+	*val = (uint16_t)(lsb | (msb << 8));
+	return 0;
+}
+
+/** @brief read the next record, return -1 at the end of the trace */
+static int get_record(void)
+{
+	uint64_t mask, cc;
+	uint16_t pc;
+	uint32_t n, r;
+	char dasm[80];
+	int c;
+
+	if (get_varint(&mask) < 0 || get_varint(&cc) < 0)
+		return -1;
+	dec.stamp += cc;
+	dec.pc = dec.pc_next;
+	if (mask & TRACE_PC) {
+		if (get_word(&pc) < 0)
+			return -1;
+		dec.pc = pc;
+	}
+	if (mask & TRACE_CODE) {
+		for (n = 0; n < 4; n++) {
+			if ((c = get_byte()) < 0)
+				return -1;
+			dec.code[dec.pc][n] = (uint8_t)c;
+		}
+		dec.len[dec.pc] = (uint8_t)z80_dasm(dasm, dec.pc,
+			dec.code[dec.pc], dec.code[dec.pc]);
+	}
+	r = TRACE_R_NEXT(dec.reg[TRACE_IR], dec.op);
+	dec.reg[TRACE_IR] = (dec.reg[TRACE_IR] & 0xff00) | r;
+	for (n = 0; n < TRACE_REGS; n++)
+		if ((mask & TRACE_REG(n)) && get_word(&dec.reg[n]) < 0)
+			return -1;
+	dec.pc_next = (dec.pc + dec.len[dec.pc]) % MEMSIZE;
+	dec.op = dec.code[dec.pc][0];
+	return 0;
+}
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "usage: %s [-a] [-s first] [-n count] file\n", argv[0]);
+	fprintf(stderr, "-a          also print the alternate registers, I, R, IFF and IM\n");
+	fprintf(stderr, "-s first    skip the first number of instructions\n");
+	fprintf(stderr, "-n count    stop after a number of instructions\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *filename = NULL;
+	char magic[sizeof(TRACE_MAGIC)];
+	char dasm[80], hex[16];
+	uint64_t first = 0, count = (uint64_t)-1, n;
+	uint64_t stamp;
+	uint32_t pc, len, i;
+	const uint16_t *reg = dec.reg;
+	int all = 0;
+
+	for (i = 1; i < (uint32_t)argc; i++) {
+		if (!strcmp(argv[i], "-a"))
+			all = 1;
+		else if (!strcmp(argv[i], "-s") && i + 1 < (uint32_t)argc)
+			first = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-n") && i + 1 < (uint32_t)argc)
+			count = strtoull(argv[++i], NULL, 0);
+		else if (argv[i][0] != '-')
+			filename = argv[i];
+		else {
+			usage(argv);
+			return 1;
+		}
+	}
+	if (NULL == filename) {
+		usage(argv);
+		return 1;
+	}
+
+	in.gz = gzopen(filename, "rb");
+	if (NULL == in.gz) {
+		perror(filename);
+		return 1;
+	}
+	for (i = 0; i < strlen(TRACE_MAGIC); i++)
+		magic[i] = (char)get_byte();
+	magic[i] = '\0';
+	if (strcmp(magic, TRACE_MAGIC) || TRACE_VERSION != get_byte()) {
+		fprintf(stderr, "%s: not a trace file (version %d)\n",
+			filename, TRACE_VERSION);
+		gzclose(in.gz);
+		return 1;
+	}
+
+	/* each line needs the registers from the next record */
+	if (get_record() < 0) {
+		gzclose(in.gz);
+		return 0;
+	}
+	for (n = 0; n - first < count || n < first; n++) {
+		pc = dec.pc;
+		stamp = dec.stamp;
+		len = dec.len[pc];
+		if (get_record() < 0)
+			break;
+		if (n < first)
+			continue;
+		z80_dasm(dasm, pc, dec.code[pc], dec.code[pc]);
+		for (i = 0; i < len && i < 4; i++)
+			snprintf(hex + 3 * i, sizeof(hex) - 3 * i, "%02x ", dec.code[pc][i]);
+		hex[3 * i] = '\0';
+		printf("%12llu %04x: %-12s %-20s AF=%04x BC=%04x DE=%04x HL=%04x IX=%04x IY=%04x SP=%04x",
+			(unsigned long long)stamp, pc, hex, dasm,
+			reg[TRACE_AF], reg[TRACE_BC], reg[TRACE_DE], reg[TRACE_HL],
+			reg[TRACE_IX], reg[TRACE_IY], reg[TRACE_SP]);
+		if (all)
+			printf(" AF'=%04x BC'=%04x DE'=%04x HL'=%04x I=%02x R=%02x IFF=%u%u IM=%u",
+				reg[TRACE_AF2], reg[TRACE_BC2], reg[TRACE_DE2], reg[TRACE_HL2],
+				reg[TRACE_IR] >> 8, reg[TRACE_IR] & 0xff,
+				reg[TRACE_IFF] & 1, (reg[TRACE_IFF] >> 1) & 1, (reg[TRACE_IFF] >> 2) & 3);
+		printf("\n");
+	}
+	gzclose(in.gz);
+	return 0;
+}